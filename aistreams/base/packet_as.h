@@ -17,13 +17,19 @@
 #ifndef AISTREAMS_BASE_PACKET_AS_H_
 #define AISTREAMS_BASE_PACKET_AS_H_
 
+#include <atomic>
+#include <type_traits>
 #include <utility>
 
+#include "absl/synchronization/mutex.h"
+
+#include "aistreams/base/types/packet_types/packet_types.h"
 #include "aistreams/port/canonical_errors.h"
 #include "aistreams/port/logging.h"
 #include "aistreams/port/status.h"
 #include "aistreams/port/statusor.h"
 #include "aistreams/proto/packet.pb.h"
+#include "google/protobuf/arena.h"
 
 namespace aistreams {
 
@@ -42,14 +48,22 @@ namespace aistreams {
 //    make sure this is done correctly on your behalf.
 //
 // The usage of PacketAs is similar in spirit to StatusOr.
-// Every PacketAs adapts the given source packet to a value of type T on
-// construction. The adaptation is either successful or not, indicated by
-// whether ok() is true. If ok() is false, then you can query why the adaptation
-// was unsuccessful by the value of the Status object returned by status().
+// Every PacketAs adapts the given source packet to a value of type T. The
+// adaptation is either successful or not, indicated by whether ok() is true. If
+// ok() is false, then you can query why the adaptation was unsuccessful by the
+// value of the Status object returned by status().
+//
+// The adaptation is done lazily; i.e. the payload is only unpacked on the first
+// call to ok(), status(), or ValueOrDie(). Accessing only the packet metadata
+// is therefore cheap, and does not copy the header.
 //
 // You may access the packet metadata even when ok() is false. However, you may
 // only access the packet value only when ok() is true. Accessing the value when
 // ok() is false will CHECK-fail.
+//
+// The const methods of PacketAs are thread-safe; whichever of them runs first
+// does the adaptation while the others wait for it. The non-const methods, as
+// usual, require exclusive access.
 template <typename T>
 class PacketAs {
  public:
@@ -59,6 +73,16 @@ class PacketAs {
   // Constructs an instance by moving in the source packet.
   explicit PacketAs(Packet&&);
 
+  // Constructs an instance by moving in the source packet. The value is parsed
+  // into a message owned by `arena`, which must outlive this object. Only
+  // available when T is a protobuf message.
+  //
+  // Copies of an arena backed PacketAs do not use the arena; each holds its own
+  // copy of the value.
+  template <typename U = T,
+            typename std::enable_if<is_protobuf<U>::value>::type* = nullptr>
+  PacketAs(Packet&&, google::protobuf::Arena* arena);
+
   // Return the source packet's timestamp in microseconds.
   //
   // This is counted since the unix epoch is the source Packet is built using
@@ -67,12 +91,14 @@ class PacketAs {
   // provider.
   int64_t microseconds() const;
 
-  // Return a copy of the source packet's header.
-  PacketHeader header() const;
+  // Return a reference to the source packet's header.
+  //
+  // The reference remains valid for the lifetime of this object.
+  const PacketHeader& header() const;
 
   // Returns true if the value of the source packet is successfully adapted and
   // ready for access as a value of type T.
-  bool ok();
+  bool ok() const;
 
   // Returns the status of the packet adaptation.
   Status status() const;
@@ -88,64 +114,154 @@ class PacketAs {
   PacketAs();
 
   // PacketAs is copy constructable/assignable if T is.
-  PacketAs(const PacketAs<T>&) = default;
-  PacketAs<T>& operator=(const PacketAs<T>&) = default;
+  PacketAs(const PacketAs<T>&);
+  PacketAs<T>& operator=(const PacketAs<T>&);
 
   // PacketAs is move constructable/assignable if T is.
-  PacketAs(PacketAs<T>&&) = default;
-  PacketAs<T>& operator=(PacketAs<T>&&) = default;
+  PacketAs(PacketAs<T>&&);
+  PacketAs<T>& operator=(PacketAs<T>&&);
 
  private:
-  void Adapt();
-  void EnsureOk();
+  void Adapt() const;
+  void EnsureOk() const;
+  T* mutable_value() const;
+
+  // Whether Adapt() has already run. The members below are mutable so that the
+  // adaptation may be deferred until the first (possibly const) access;
+  // adapt_mu_ serializes that access so concurrent const callers stay safe.
+  mutable absl::Mutex adapt_mu_;
+  mutable std::atomic<bool> adapted_{false};
 
   // Status indicating whether the adaptation was successful and why if not.
-  Status status_;
+  mutable Status status_;
 
-  // This is a Packet that holds the same metadata as the source packet.
-  // However, its payload may differ and is likely empty.
-  Packet packet_;
+  // This is the source packet. Its header is never modified, but its payload is
+  // consumed by the adaptation and is likely empty afterwards.
+  mutable Packet packet_;
 
   // If ok() is true, this holds the source packet value adapted as a value of
   // type T. Otherwise, accessing this value is undefined behavior.
-  T value_;
+  //
+  // When arena_value_ is set, it is used in place of value_.
+  mutable T value_;
+  T* arena_value_ = nullptr;
 };
 
 // -----------------------------------------------------------
 // Implementation details.
 
 template <typename T>
-PacketAs<T>::PacketAs() {
+PacketAs<T>::PacketAs() : adapted_(true) {
   status_ = UnknownError("This is a default constructed PacketAs");
 }
 
 template <typename T>
-PacketAs<T>::PacketAs(const Packet& packet) : packet_(packet) {
-  Adapt();
+PacketAs<T>::PacketAs(const Packet& packet) : packet_(packet) {}
+
+template <typename T>
+PacketAs<T>::PacketAs(Packet&& packet) : packet_(std::move(packet)) {}
+
+template <typename T>
+template <typename U,
+          typename std::enable_if<is_protobuf<U>::value>::type*>
+PacketAs<T>::PacketAs(Packet&& packet, google::protobuf::Arena* arena)
+    : packet_(std::move(packet)) {
+  if (arena != nullptr) {
+    arena_value_ = google::protobuf::Arena::CreateMessage<T>(arena);
+  }
 }
 
 template <typename T>
-PacketAs<T>::PacketAs(Packet&& packet) : packet_(std::move(packet)) {
-  Adapt();
+PacketAs<T>::PacketAs(const PacketAs<T>& other) {
+  *this = other;
 }
 
-// Only call this during construction.
 template <typename T>
-void PacketAs<T>::Adapt() {
-  Packet hollow_packet;
-  *hollow_packet.mutable_header() = packet_.header();
-  status_ = Unpack(std::move(packet_), &value_);
-  packet_ = hollow_packet;
+PacketAs<T>& PacketAs<T>::operator=(const PacketAs<T>& other) {
+  if (this == &other) {
+    return *this;
+  }
+  // `other` may be adapted concurrently through its const methods.
+  absl::MutexLock lock(&other.adapt_mu_);
+  bool adapted = other.adapted_.load(std::memory_order_relaxed);
+  status_ = other.status_;
+  packet_ = other.packet_;
+
+  // Never share an arena owned value; the copy holds its own. A view must refer
+  // to the payload of this copy rather than that of `other`, so view it anew.
+  arena_value_ = nullptr;
+  if (adapted && status_.ok()) {
+    if (is_packet_view_type<T>::value) {
+      status_ = Unpack(packet_, &value_);
+    } else {
+      value_ = *other.mutable_value();
+    }
+  }
+  adapted_.store(adapted, std::memory_order_release);
+  return *this;
+}
+
+template <typename T>
+PacketAs<T>::PacketAs(PacketAs<T>&& other) {
+  *this = std::move(other);
+}
+
+// Moving requires exclusive access to `other`, so no locking is needed.
+template <typename T>
+PacketAs<T>& PacketAs<T>::operator=(PacketAs<T>&& other) {
+  if (this == &other) {
+    return *this;
+  }
+  bool adapted = other.adapted_.load(std::memory_order_relaxed);
+  status_ = std::move(other.status_);
+  packet_ = std::move(other.packet_);
+  arena_value_ = other.arena_value_;
+  other.arena_value_ = nullptr;
+  if (arena_value_ == nullptr && adapted && status_.ok()) {
+    // A short payload may not keep its address across the move, so a view is
+    // taken anew as for copies.
+    if (is_packet_view_type<T>::value) {
+      status_ = Unpack(packet_, &value_);
+    } else {
+      value_ = std::move(other.value_);
+    }
+  }
+  adapted_.store(adapted, std::memory_order_release);
+  return *this;
+}
+
+template <typename T>
+T* PacketAs<T>::mutable_value() const {
+  return arena_value_ != nullptr ? arena_value_ : &value_;
+}
+
+// Unpacking with move semantics only consumes the payload, so the header of
+// packet_ stays intact for header() and microseconds(). The payload itself is
+// left as the unpacking found it, since view types (e.g. absl::Span<const T>
+// for struct packets) keep referring to it.
+template <typename T>
+void PacketAs<T>::Adapt() const {
+  if (adapted_.load(std::memory_order_acquire)) {
+    return;
+  }
+  absl::MutexLock lock(&adapt_mu_);
+  if (adapted_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  status_ = Unpack(std::move(packet_), mutable_value());
+  adapted_.store(true, std::memory_order_release);
   return;
 }
 
 template <typename T>
-bool PacketAs<T>::ok() {
+bool PacketAs<T>::ok() const {
+  Adapt();
   return status_.ok();
 }
 
 template <typename T>
 Status PacketAs<T>::status() const {
+  Adapt();
   return status_;
 }
 
@@ -156,12 +272,12 @@ int64_t PacketAs<T>::microseconds() const {
 }
 
 template <typename T>
-PacketHeader PacketAs<T>::header() const {
+const PacketHeader& PacketAs<T>::header() const {
   return packet_.header();
 }
 
 template <typename T>
-void PacketAs<T>::EnsureOk() {
+void PacketAs<T>::EnsureOk() const {
   if (!ok()) {
     LOG(FATAL) << "The PacketAs was not successfully adapted: " << status_;
   }
@@ -171,25 +287,25 @@ void PacketAs<T>::EnsureOk() {
 template <typename T>
 const T& PacketAs<T>::ValueOrDie() const& {
   EnsureOk();
-  return value_;
+  return *mutable_value();
 }
 
 template <typename T>
 T& PacketAs<T>::ValueOrDie() & {
   EnsureOk();
-  return value_;
+  return *mutable_value();
 }
 
 template <typename T>
 const T&& PacketAs<T>::ValueOrDie() const&& {
   EnsureOk();
-  return std::move(value_);
+  return std::move(*mutable_value());
 }
 
 template <typename T>
 T&& PacketAs<T>::ValueOrDie() && {
   EnsureOk();
-  return std::move(value_);
+  return std::move(*mutable_value());
 }
 
 }  // namespace aistreams
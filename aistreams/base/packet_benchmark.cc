@@ -0,0 +1,126 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <utility>
+
+#include "aistreams/base/packet.h"
+#include "aistreams/base/types/raw_image.h"
+#include "aistreams/port/benchmark.h"
+#include "aistreams/port/logging.h"
+#include "aistreams/proto/packet.pb.h"
+#include "aistreams/proto/types/raw_image.pb.h"
+#include "google/protobuf/arena.h"
+
+namespace aistreams {
+namespace {
+
+// Frame sizes as (height, width): 720p, 1080p and 4K.
+void FrameSizes(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"height", "width"})
+      ->Args({720, 1280})
+      ->Args({1080, 1920})
+      ->Args({2160, 3840});
+}
+
+RawImage MakeRawImage(const benchmark::State& state) {
+  return RawImage(state.range(0), state.range(1), RAW_IMAGE_FORMAT_SRGB);
+}
+
+void BM_MakePacketCopyRawImage(benchmark::State& state) {
+  const RawImage raw_image = MakeRawImage(state);
+  for (auto _ : state) {
+    auto packet_statusor = MakePacket(raw_image);
+    benchmark::DoNotOptimize(packet_statusor);
+  }
+  state.SetBytesProcessed(state.iterations() * raw_image.size());
+}
+BENCHMARK(BM_MakePacketCopyRawImage)->Apply(FrameSizes);
+
+// Moves a RawImage into a packet and back out again, which copies no pixels.
+void BM_MakePacketMoveRawImage(benchmark::State& state) {
+  RawImage raw_image = MakeRawImage(state);
+  for (auto _ : state) {
+    Packet packet = MakePacket(std::move(raw_image)).ValueOrDie();
+    raw_image = PacketAs<RawImage>(std::move(packet)).ValueOrDie();
+  }
+}
+BENCHMARK(BM_MakePacketMoveRawImage)->Apply(FrameSizes);
+
+void BM_MakePacketString(benchmark::State& state) {
+  const std::string s(state.range(0), 'x');
+  for (auto _ : state) {
+    auto packet_statusor = MakePacket(s);
+    benchmark::DoNotOptimize(packet_statusor);
+  }
+  state.SetBytesProcessed(state.iterations() * s.size());
+}
+BENCHMARK(BM_MakePacketString)
+    ->ArgName("bytes")
+    ->Arg(0)
+    ->Arg(1 << 10)
+    ->Arg(1 << 16);
+
+void BM_MakeEosPacket(benchmark::State& state) {
+  for (auto _ : state) {
+    auto packet_statusor = MakeEosPacket("end of benchmark");
+    benchmark::DoNotOptimize(packet_statusor);
+  }
+}
+BENCHMARK(BM_MakeEosPacket);
+
+void BM_PacketAsCopyRawImage(benchmark::State& state) {
+  const Packet packet = MakePacket(MakeRawImage(state)).ValueOrDie();
+  for (auto _ : state) {
+    PacketAs<RawImage> packet_as(packet);
+    benchmark::DoNotOptimize(packet_as.ValueOrDie().data());
+  }
+  state.SetBytesProcessed(state.iterations() * packet.payload().size());
+}
+BENCHMARK(BM_PacketAsCopyRawImage)->Apply(FrameSizes);
+
+// PacketAs of a protobuf message parses the payload. The arena variant
+// allocates the message on an arena that is reset every iteration.
+void BM_PacketAsProtobuf(benchmark::State& state) {
+  RawImageDescriptor descriptor;
+  descriptor.set_format(RAW_IMAGE_FORMAT_SRGB);
+  descriptor.set_height(1080);
+  descriptor.set_width(1920);
+  const Packet packet = MakePacket(descriptor).ValueOrDie();
+  for (auto _ : state) {
+    PacketAs<RawImageDescriptor> packet_as((Packet(packet)));
+    benchmark::DoNotOptimize(packet_as.ValueOrDie().height());
+  }
+}
+BENCHMARK(BM_PacketAsProtobuf);
+
+void BM_PacketAsProtobufOnArena(benchmark::State& state) {
+  RawImageDescriptor descriptor;
+  descriptor.set_format(RAW_IMAGE_FORMAT_SRGB);
+  descriptor.set_height(1080);
+  descriptor.set_width(1920);
+  const Packet packet = MakePacket(descriptor).ValueOrDie();
+  google::protobuf::Arena arena;
+  for (auto _ : state) {
+    {
+      PacketAs<RawImageDescriptor> packet_as(Packet(packet), &arena);
+      benchmark::DoNotOptimize(packet_as.ValueOrDie().height());
+    }
+    arena.Reset();
+  }
+}
+BENCHMARK(BM_PacketAsProtobufOnArena);
+
+}  // namespace
+}  // namespace aistreams
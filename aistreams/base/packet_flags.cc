@@ -54,6 +54,7 @@ Status RestoreDefaultPacketFlags(Packet* p) {
     case PACKET_TYPE_PROTOBUF:
     case PACKET_TYPE_STRING:
     case PACKET_TYPE_GSTREAMER_BUFFER:
+    case PACKET_TYPE_STRUCT:
       SetPacketFlags(PacketFlags::kIsFrameHead | PacketFlags::kIsKeyFrame, p);
       break;
     case PACKET_TYPE_CONTROL_SIGNAL:
@@ -75,6 +75,7 @@ Status PacketReceiver::Initialize() {
   StreamChannel::Options stream_channel_options;
   stream_channel_options.connection_options = options_.connection_options;
   stream_channel_options.stream_name = options_.stream_name;
+  stream_channel_options.grpc_channel = options_.grpc_channel;
   // Set the timeout in connection options for unary-styled packet receiving.
   if (options_.receiver_mode == ReceiverMode::UnaryReceive &&
       options_.timeout > absl::ZeroDuration() &&
@@ -133,6 +134,7 @@ Status PacketReceiver::InitializeReceivePacket() {
     LOG(ERROR) << ctx_status_or.status();
     return InternalError("Failed to create a grpc client context");
   }
+  absl::MutexLock lock(&ctx_mu_);
   ctx_[ReceiverMode::StreamingReceive] = std::move(ctx_status_or).ValueOrDie();
   streaming_readers_[ReceiverMode::StreamingReceive] = stub_->ReceivePackets(
       ctx_[ReceiverMode::StreamingReceive].get(), streaming_request);
@@ -166,6 +168,7 @@ Status PacketReceiver::InitializeReplayStream() {
     LOG(ERROR) << ctx_status_or.status();
     return InternalError("Failed to create a grpc client context");
   }
+  absl::MutexLock lock(&ctx_mu_);
   ctx_[ReceiverMode::Replay] = std::move(ctx_status_or).ValueOrDie();
   streaming_readers_[ReceiverMode::Replay] = stub_->ReplayStream(
       ctx_[ReceiverMode::Replay].get(), replay_stream_request);
@@ -278,8 +281,16 @@ Status PacketReceiver::Receive(Packet* packet) {
   }
 }
 
+void PacketReceiver::Cancel() {
+  absl::MutexLock lock(&ctx_mu_);
+  for (auto& mode_and_ctx : ctx_) {
+    mode_and_ctx.second->TryCancel();
+  }
+}
+
 void PacketReceiver::DisposeUnusedClientReader() {
   auto dispose = [this](ReceiverMode mode) {
+    absl::MutexLock lock(&ctx_mu_);
     ctx_[mode]->TryCancel();
     streaming_readers_.erase(mode);
     ctx_.erase(mode);
@@ -17,6 +17,10 @@
 #ifndef AISTREAMS_BASE_PACKET_RECEIVER_H_
 #define AISTREAMS_BASE_PACKET_RECEIVER_H_
 
+#include <memory>
+#include <unordered_map>
+
+#include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
 #include "aistreams/base/connection_options.h"
 #include "aistreams/base/offset_options.h"
@@ -75,6 +79,9 @@ class PacketReceiver {
 
     // The receiver mode. Default receiver mode is the streaming receiver.
     ReceiverMode receiver_mode = ReceiverMode::StreamingReceive;
+
+    // An established channel to reuse. A new channel is created if null.
+    std::shared_ptr<grpc::Channel> grpc_channel = nullptr;
   };
 
   // Creates and initializes an instance that is ready for use.
@@ -96,6 +103,12 @@ class PacketReceiver {
   // you need both, run them in two distinct PacketReceivers.
   Status Subscribe(const PacketCallback&);
 
+  // Cancel the streaming rpcs, so that a Receive blocked in another thread
+  // returns with an error. Receiving afterwards is not possible.
+  //
+  // This has no effect on unary receives.
+  void Cancel();
+
   // Use Create instead of the bare constructors.
   PacketReceiver(const Options&);
   ~PacketReceiver() = default;
@@ -105,7 +118,9 @@ class PacketReceiver {
   ReceiverMode current_receiver_mode_;
   std::unique_ptr<StreamChannel> stream_channel_ = nullptr;
   std::unique_ptr<StreamServer::Stub> stub_ = nullptr;
-  std::unordered_map<ReceiverMode, std::unique_ptr<grpc::ClientContext>> ctx_;
+  absl::Mutex ctx_mu_;
+  std::unordered_map<ReceiverMode, std::unique_ptr<grpc::ClientContext>> ctx_
+      ABSL_GUARDED_BY(ctx_mu_);
   std::unordered_map<ReceiverMode, std::unique_ptr<grpc::ClientReader<Packet>>>
       streaming_readers_;
   // Number of packets that have been received via the unary endpoint.
@@ -3,6 +3,7 @@
 #include <thread>
 
 #include "absl/time/clock.h"
+#include "aistreams/base/util/grpc_helpers.h"
 #include "aistreams/mocks/mock_stream_service.h"
 #include "aistreams/port/canonical_errors.h"
 #include "aistreams/util/constants.h"
@@ -398,6 +399,73 @@ TEST_F(PacketReceiverTest, AutoPacketReceiverReceivesNoModeSwitch) {
           .code());
 }
 
+TEST_F(PacketReceiverTest, CancelInterruptsBlockedReceive) {
+  EXPECT_CALL(*stream_service_.get(), ReceivePackets(_, _, _))
+      .Times(1)
+      .WillOnce([&](grpc::ServerContext *context,
+                    const ReceivePacketsRequest *request,
+                    grpc::ServerWriter<Packet> *stream) {
+        stream->Write(MakePacket(0));
+        while (!context->IsCancelled()) {
+          absl::SleepFor(absl::Milliseconds(10));
+        }
+        return ::grpc::Status(::grpc::StatusCode::CANCELLED, "Cancelled");
+      });
+
+  PacketReceiver::Options options;
+  options.receiver_name = kConsumerName;
+  options.stream_name = kStreamName;
+  options.timeout = kTimeout;
+  options.receiver_mode = ReceiverMode::StreamingReceive;
+  options.connection_options.target_address = kStreamServerAddress;
+  options.connection_options.ssl_options.use_insecure_channel = true;
+  auto packet_receiver_status_or = PacketReceiver::Create(options);
+  EXPECT_OK(packet_receiver_status_or);
+  auto packet_receiver = std::move(packet_receiver_status_or).ValueOrDie();
+  Packet packet;
+  EXPECT_OK(packet_receiver->Receive(&packet));
+
+  // The next Receive blocks, as the server sends nothing more.
+  std::thread canceller([&packet_receiver] {
+    absl::SleepFor(absl::Milliseconds(100));
+    packet_receiver->Cancel();
+  });
+  absl::Time start = absl::Now();
+  EXPECT_FALSE(packet_receiver->Receive(&packet).ok());
+  EXPECT_LT(absl::Now() - start, kTimeout);
+  canceller.join();
+}
+
+TEST_F(PacketReceiverTest, ReceiversShareChannel) {
+  EXPECT_CALL(*stream_service_.get(), ReceivePackets(_, _, _))
+      .Times(2)
+      .WillRepeatedly([&](grpc::ServerContext *context,
+                          const ReceivePacketsRequest *request,
+                          grpc::ServerWriter<Packet> *stream) {
+        stream->Write(MakePacket(0));
+        return ::grpc::Status(::grpc::StatusCode::NOT_FOUND, "Not found");
+      });
+
+  PacketReceiver::Options options;
+  options.receiver_name = kConsumerName;
+  options.stream_name = kStreamName;
+  options.timeout = kTimeout;
+  options.receiver_mode = ReceiverMode::StreamingReceive;
+  options.connection_options.target_address = kStreamServerAddress;
+  options.connection_options.ssl_options.use_insecure_channel = true;
+  options.grpc_channel = CreateGrpcChannel(options.connection_options);
+  ASSERT_NE(options.grpc_channel, nullptr);
+  for (int i = 0; i < 2; ++i) {
+    auto packet_receiver_status_or = PacketReceiver::Create(options);
+    EXPECT_OK(packet_receiver_status_or);
+    auto packet_receiver = std::move(packet_receiver_status_or).ValueOrDie();
+    Packet packet;
+    EXPECT_OK(packet_receiver->Receive(&packet));
+    EXPECT_EQ(MakePacket(0).ShortDebugString(), packet.ShortDebugString());
+    EXPECT_EQ(StatusCode::kNotFound, packet_receiver->Receive(&packet).code());
+  }
+}
+
 }  // namespace
 
 }  // namespace aistreams
@@ -26,6 +26,15 @@ namespace aistreams {
 PacketSender::PacketSender(const Options& options) : options_(options) {}
 
 Status PacketSender::Initialize() {
+  const BatchOptions& batch_options = options_.batch_options;
+  if (batch_options.max_packets <= 0) {
+    return InvalidArgumentError(
+        "Given a non-positive maximum number of packets per batch");
+  }
+  if (batch_options.linger < absl::ZeroDuration()) {
+    return InvalidArgumentError("Given a negative linger duration");
+  }
+
   StreamChannel::Options stream_channel_options;
   stream_channel_options.connection_options = options_.connection_options;
   stream_channel_options.stream_name = options_.stream_name;
@@ -56,9 +65,17 @@ Status PacketSender::Initialize() {
   } else {
     LOG(INFO) << "Using unary rpc to send packets";
   }
+
+  if (IsBatching() && batch_options.linger > absl::ZeroDuration()) {
+    linger_thread_ = std::thread(&PacketSender::LingerLoop, this);
+  }
   return OkStatus();
 }
 
+bool PacketSender::IsBatching() const {
+  return streaming_writer_ != nullptr && options_.batch_options.max_packets > 1;
+}
+
 StatusOr<std::unique_ptr<PacketSender>> PacketSender::Create(
     const Options& options) {
   auto packet_sender = std::make_unique<PacketSender>(options);
@@ -93,7 +110,96 @@ Status PacketSender::StreamingSend(const Packet& packet) {
   return OkStatus();
 }
 
+Status PacketSender::BatchSend(Packet&& packet) {
+  {
+    absl::MutexLock lock(&batch_mu_);
+    AIS_RETURN_IF_ERROR(batch_status_);
+    if (batch_.empty()) {
+      batch_start_time_ = absl::Now();
+    }
+    batch_bytes_ += packet.ByteSizeLong();
+    batch_.push_back(std::move(packet));
+
+    const BatchOptions& batch_options = options_.batch_options;
+    if (batch_.size() < static_cast<size_t>(batch_options.max_packets) &&
+        (batch_options.max_bytes == 0 ||
+         batch_bytes_ < batch_options.max_bytes)) {
+      return OkStatus();
+    }
+  }
+  return FlushBatch();
+}
+
+// Swaps the current batch out and writes it without holding `batch_mu_`, so
+// that a slow server does not hold up the senders filling the next batch.
+Status PacketSender::FlushBatch() {
+  absl::MutexLock write_lock(&write_mu_);
+  std::vector<Packet> batch;
+  {
+    absl::MutexLock lock(&batch_mu_);
+    AIS_RETURN_IF_ERROR(batch_status_);
+    batch.swap(batch_);
+    batch_bytes_ = 0;
+  }
+  Status status = WriteBatch(batch);
+  if (!status.ok()) {
+    absl::MutexLock lock(&batch_mu_);
+    batch_status_ = status;
+  }
+  return status;
+}
+
+Status PacketSender::WriteBatch(const std::vector<Packet>& batch) {
+  // Only the last write goes out without the buffer hint, so that gRPC is free
+  // to coalesce the batch.
+  for (size_t i = 0; i < batch.size(); ++i) {
+    grpc::WriteOptions write_options;
+    if (i + 1 < batch.size()) {
+      write_options.set_buffer_hint();
+    }
+    if (!streaming_writer_->Write(batch[i], write_options)) {
+      return UnknownError("Failed to Write a batch into the RPC stream");
+    }
+  }
+  return OkStatus();
+}
+
+bool PacketSender::HasBatchOrStopsLingering() const {
+  return !batch_.empty() || stop_lingering_;
+}
+
+void PacketSender::LingerLoop() {
+  while (true) {
+    {
+      absl::MutexLock lock(&batch_mu_);
+      batch_mu_.Await(
+          absl::Condition(this, &PacketSender::HasBatchOrStopsLingering));
+      if (stop_lingering_) {
+        return;
+      }
+      absl::Time deadline = batch_start_time_ + options_.batch_options.linger;
+      if (batch_mu_.AwaitWithDeadline(absl::Condition(&stop_lingering_),
+                                      deadline)) {
+        return;
+      }
+
+      // The batch may have been sent and a new one started while waiting.
+      if (batch_.empty() ||
+          absl::Now() < batch_start_time_ + options_.batch_options.linger) {
+        continue;
+      }
+    }
+    Status status = FlushBatch();
+    if (!status.ok()) {
+      LOG(ERROR) << status;
+    }
+  }
+}
+
 Status PacketSender::Send(const Packet& packet) {
+  if (IsBatching()) {
+    return Send(Packet(packet));
+  }
   ::aistreams::trace::Instrument(const_cast<Packet&>(packet).mutable_header(),
                                  options_.trace_probability);
   if (streaming_writer_ == nullptr) {
@@ -103,8 +209,39 @@ Status PacketSender::Send(const Packet& packet) {
   }
 }
 
+Status PacketSender::Send(Packet&& packet) {
+  ::aistreams::trace::Instrument(packet.mutable_header(),
+                                 options_.trace_probability);
+  if (streaming_writer_ == nullptr) {
+    return UnarySend(packet);
+  }
+  if (!IsBatching()) {
+    return StreamingSend(packet);
+  }
+  return BatchSend(std::move(packet));
+}
+
+Status PacketSender::Flush() {
+  if (!IsBatching()) {
+    return OkStatus();
+  }
+  return FlushBatch();
+}
+
 PacketSender::~PacketSender() {
+  if (linger_thread_.joinable()) {
+    {
+      absl::MutexLock lock(&batch_mu_);
+      stop_lingering_ = true;
+    }
+    linger_thread_.join();
+  }
   if (streaming_writer_ != nullptr) {
+    Status status = Flush();
+    if (!status.ok()) {
+      LOG(ERROR) << "Could not send the last batch of packets during cleanup: "
+                 << status;
+    }
     if (!streaming_writer_->WritesDone()) {
       LOG(ERROR)
           << "Could not signal WritesDone() to gRPC server during cleanup";
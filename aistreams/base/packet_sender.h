@@ -17,6 +17,13 @@
 #ifndef AISTREAMS_BASE_PACKET_SENDER_H_
 #define AISTREAMS_BASE_PACKET_SENDER_H_
 
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "aistreams/base/connection_options.h"
 #include "aistreams/base/stream_channel.h"
 #include "aistreams/port/grpcpp.h"
@@ -31,6 +38,24 @@ namespace aistreams {
 // Use this class to send a packet to a stream.
 class PacketSender {
  public:
+  // Options for batching packets over the streaming rpc.
+  //
+  // Packets are held back until the batch holds `max_packets` packets or
+  // `max_bytes` bytes, or until its oldest packet has waited for `linger`.
+  // The whole batch is then written to the stream in one go, which lets gRPC
+  // coalesce the packets into as few network writes as it can.
+  struct BatchOptions {
+    // The maximum number of packets in a batch. 1 disables batching.
+    int max_packets = 1;
+
+    // The maximum number of bytes in a batch. 0 means no limit.
+    size_t max_bytes = 0;
+
+    // The longest time a packet is held back. Zero means that packets are only
+    // sent once the batch is full or Flush() is called.
+    absl::Duration linger = absl::ZeroDuration();
+  };
+
   // Options for configuring the packet sender.
   struct Options {
     // Options to configure the RPC connection.
@@ -52,13 +77,25 @@ class PacketSender {
     // `trace_probability` is set with a positive value, then packet sender
     // might update value for `trace_context` in the packet header.
     double trace_probability = 0;
+
+    // Options to batch packets. Batching does not apply to the unary rpc.
+    BatchOptions batch_options;
   };
 
   // Creates and initializes an instance that is ready for use.
   static StatusOr<std::unique_ptr<PacketSender>> Create(const Options&);
 
   // Send the given packet.
+  //
+  // When batching, the packet may only be written to the stream later. An
+  // error writing the batch is then returned by a later call to Send or Flush.
+  // Batching a packet given by const reference takes a copy of it; move it in
+  // to avoid the copy.
   Status Send(const Packet&);
+  Status Send(Packet&&);
+
+  // Write the packets held back in the current batch to the stream.
+  Status Flush();
 
   // Use Create instead of the bare constructors.
   PacketSender(const Options&);
@@ -72,9 +109,30 @@ class PacketSender {
   SendPacketsResponse streaming_response_;
   std::unique_ptr<grpc::ClientWriter<Packet>> streaming_writer_ = nullptr;
 
+  // Serializes batch writes to the stream, so that batches go out in order.
+  // It is held while writing; Send only waits for it to flush a full batch.
+  absl::Mutex write_mu_ ABSL_ACQUIRED_BEFORE(batch_mu_);
+
+  // The current batch.
+  absl::Mutex batch_mu_;
+  std::vector<Packet> batch_ ABSL_GUARDED_BY(batch_mu_);
+  size_t batch_bytes_ ABSL_GUARDED_BY(batch_mu_) = 0;
+  absl::Time batch_start_time_ ABSL_GUARDED_BY(batch_mu_);
+  Status batch_status_ ABSL_GUARDED_BY(batch_mu_);
+  bool stop_lingering_ ABSL_GUARDED_BY(batch_mu_) = false;
+  std::thread linger_thread_;
+
   Status Initialize();
+  bool IsBatching() const;
   Status StreamingSend(const Packet&);
   Status UnarySend(const Packet&);
+  Status BatchSend(Packet&&) ABSL_LOCKS_EXCLUDED(write_mu_, batch_mu_);
+  Status FlushBatch() ABSL_LOCKS_EXCLUDED(write_mu_, batch_mu_);
+  Status WriteBatch(const std::vector<Packet>&)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(write_mu_);
+  bool HasBatchOrStopsLingering() const
+      ABSL_SHARED_LOCKS_REQUIRED(batch_mu_);
+  void LingerLoop();
 };
 
 }  // namespace aistreams
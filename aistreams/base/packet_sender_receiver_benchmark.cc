@@ -0,0 +1,156 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <string>
+
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "aistreams/base/packet.h"
+#include "aistreams/base/packet_receiver.h"
+#include "aistreams/base/packet_sender.h"
+#include "aistreams/port/benchmark.h"
+#include "aistreams/port/grpcpp.h"
+#include "aistreams/port/logging.h"
+#include "aistreams/proto/packet.pb.h"
+#include "aistreams/proto/stream.grpc.pb.h"
+
+namespace aistreams {
+namespace {
+
+constexpr char kStreamName[] = "benchmark-stream";
+
+// A stream service that discards every packet sent to it, and that streams
+// copies of one packet to every receiver for as long as it keeps reading.
+class ThroughputStreamService : public StreamServer::Service {
+ public:
+  void set_packet(const Packet& packet) {
+    absl::MutexLock lock(&mu_);
+    packet_ = packet;
+  }
+
+  grpc::Status SendPackets(grpc::ServerContext* context,
+                           grpc::ServerReader<Packet>* stream,
+                           SendPacketsResponse* response) override {
+    Packet packet;
+    while (stream->Read(&packet)) {
+    }
+    return grpc::Status::OK;
+  }
+
+  grpc::Status ReceivePackets(grpc::ServerContext* context,
+                              const ReceivePacketsRequest* request,
+                              grpc::ServerWriter<Packet>* stream) override {
+    Packet packet;
+    {
+      absl::MutexLock lock(&mu_);
+      packet = packet_;
+    }
+    while (!context->IsCancelled() && stream->Write(packet)) {
+    }
+    return grpc::Status::OK;
+  }
+
+ private:
+  absl::Mutex mu_;
+  Packet packet_ ABSL_GUARDED_BY(mu_);
+};
+
+// A server for ThroughputStreamService on a free local port. It is started on
+// first use and shared by all of the benchmarks.
+class InProcessServer {
+ public:
+  static InProcessServer* Get() {
+    static InProcessServer* server = new InProcessServer();
+    return server;
+  }
+
+  ConnectionOptions connection_options() const {
+    ConnectionOptions options;
+    options.target_address = absl::StrCat("localhost:", port_);
+    options.ssl_options.use_insecure_channel = true;
+    return options;
+  }
+
+  ThroughputStreamService* service() { return &service_; }
+
+ private:
+  InProcessServer() {
+    grpc::ServerBuilder builder;
+    builder.AddListeningPort("localhost:0", grpc::InsecureServerCredentials(),
+                             &port_);
+    builder.RegisterService(&service_);
+    builder.SetMaxReceiveMessageSize(-1);
+    server_ = builder.BuildAndStart();
+    CHECK(server_ != nullptr && port_ != 0);
+  }
+
+  int port_ = 0;
+  ThroughputStreamService service_;
+  std::unique_ptr<grpc::Server> server_;
+};
+
+Packet MakeBytesPacket(int size) {
+  return MakePacket(std::string(size, 'x')).ValueOrDie();
+}
+
+// Sends packets of state.range(0) bytes in batches of state.range(1).
+void BM_PacketSenderSend(benchmark::State& state) {
+  PacketSender::Options options;
+  options.connection_options = InProcessServer::Get()->connection_options();
+  options.stream_name = kStreamName;
+  options.batch_options.max_packets = state.range(1);
+  auto sender = PacketSender::Create(options).ValueOrDie();
+  const Packet packet = MakeBytesPacket(state.range(0));
+  for (auto _ : state) {
+    CHECK(sender->Send(packet).ok());
+  }
+  CHECK(sender->Flush().ok());
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * packet.payload().size());
+}
+BENCHMARK(BM_PacketSenderSend)
+    ->ArgNames({"bytes", "batch"})
+    ->Args({1 << 10, 1})
+    ->Args({1 << 10, 16})
+    ->Args({1 << 16, 1})
+    ->Args({1 << 16, 16})
+    ->Args({1920 * 1080 * 3, 1})
+    ->UseRealTime();
+
+// Receives packets of state.range(0) bytes.
+void BM_PacketReceiverReceive(benchmark::State& state) {
+  InProcessServer::Get()->service()->set_packet(
+      MakeBytesPacket(state.range(0)));
+  PacketReceiver::Options options;
+  options.connection_options = InProcessServer::Get()->connection_options();
+  options.stream_name = kStreamName;
+  auto receiver = PacketReceiver::Create(options).ValueOrDie();
+  Packet packet;
+  for (auto _ : state) {
+    CHECK(receiver->Receive(&packet).ok());
+  }
+  receiver->Cancel();
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * packet.payload().size());
+}
+BENCHMARK(BM_PacketReceiverReceive)
+    ->ArgName("bytes")
+    ->Arg(1 << 10)
+    ->Arg(1 << 16)
+    ->Arg(1920 * 1080 * 3)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace aistreams
@@ -0,0 +1,182 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/base/packet_sender.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "aistreams/mocks/mock_stream_service.h"
+#include "aistreams/port/gtest.h"
+
+namespace aistreams {
+
+namespace {
+using ::aistreams::mocks::MockStreamService;
+using ::testing::_;
+using ::testing::Test;
+
+constexpr char kStreamName[] = "test-stream";
+
+class PacketSenderTest : public Test {
+ protected:
+  void SetUp() override {
+    stream_service_ = std::make_unique<MockStreamService>();
+    grpc::ServerBuilder builder;
+    // Let the server pick a free port.
+    builder.AddListeningPort("localhost:0", grpc::InsecureServerCredentials(),
+                             &port_);
+    builder.RegisterService(stream_service_.get());
+    builder.SetMaxReceiveMessageSize(-1);
+    stream_server_ = builder.BuildAndStart();
+    stream_server_worker_ = std::thread([this] { stream_server_->Wait(); });
+
+    // Record the payloads of the packets sent.
+    EXPECT_CALL(*stream_service_.get(), SendPackets(_, _, _))
+        .WillOnce([this](grpc::ServerContext* context,
+                         grpc::ServerReader<Packet>* stream,
+                         SendPacketsResponse* response) {
+          Packet packet;
+          while (stream->Read(&packet)) {
+            absl::MutexLock lock(&mu_);
+            payloads_.push_back(packet.payload());
+          }
+          return ::grpc::Status();
+        });
+  }
+
+  void TearDown() override {
+    stream_server_->Shutdown();
+    stream_server_worker_.join();
+  }
+
+  PacketSender::Options MakeOptions() const {
+    PacketSender::Options options;
+    options.stream_name = kStreamName;
+    options.connection_options.target_address =
+        absl::StrCat("localhost:", port_);
+    options.connection_options.ssl_options.use_insecure_channel = true;
+    return options;
+  }
+
+  static Packet MakePacket(int i) {
+    Packet packet;
+    packet.mutable_header()->mutable_type()->set_type_id(PACKET_TYPE_STRING);
+    packet.set_payload(std::to_string(i));
+    return packet;
+  }
+
+  // Waits until `count` packets have arrived. Returns false on timeout.
+  bool AwaitPayloads(int count) {
+    absl::MutexLock lock(&mu_);
+    awaited_count_ = count;
+    return mu_.AwaitWithTimeout(
+        absl::Condition(this, &PacketSenderTest::HasAwaitedPayloads),
+        absl::Seconds(5));
+  }
+
+  bool HasAwaitedPayloads() const ABSL_SHARED_LOCKS_REQUIRED(mu_) {
+    return payloads_.size() >= awaited_count_;
+  }
+
+  std::vector<std::string> payloads() {
+    absl::MutexLock lock(&mu_);
+    return payloads_;
+  }
+
+  int port_ = 0;
+  std::unique_ptr<grpc::Server> stream_server_ = nullptr;
+  std::unique_ptr<MockStreamService> stream_service_ = nullptr;
+  std::thread stream_server_worker_;
+
+  absl::Mutex mu_;
+  std::vector<std::string> payloads_ ABSL_GUARDED_BY(mu_);
+  size_t awaited_count_ ABSL_GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace
+
+TEST_F(PacketSenderTest, UnbatchedSend) {
+  auto packet_sender_status_or = PacketSender::Create(MakeOptions());
+  ASSERT_TRUE(packet_sender_status_or.ok());
+  auto packet_sender = std::move(packet_sender_status_or).ValueOrDie();
+  EXPECT_TRUE(packet_sender->Send(MakePacket(0)).ok());
+  EXPECT_TRUE(AwaitPayloads(1));
+  packet_sender.reset();
+  EXPECT_EQ(payloads(), std::vector<std::string>({"0"}));
+}
+
+TEST_F(PacketSenderTest, BatchedSend) {
+  auto options = MakeOptions();
+  options.batch_options.max_packets = 3;
+  auto packet_sender_status_or = PacketSender::Create(options);
+  ASSERT_TRUE(packet_sender_status_or.ok());
+  auto packet_sender = std::move(packet_sender_status_or).ValueOrDie();
+
+  // A full batch is sent right away.
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(packet_sender->Send(MakePacket(i)).ok());
+  }
+  EXPECT_TRUE(AwaitPayloads(3));
+
+  // A partial batch waits for a flush.
+  EXPECT_TRUE(packet_sender->Send(MakePacket(3)).ok());
+  EXPECT_TRUE(packet_sender->Flush().ok());
+  EXPECT_TRUE(AwaitPayloads(4));
+
+  // The last batch is sent on destruction.
+  EXPECT_TRUE(packet_sender->Send(MakePacket(4)).ok());
+  packet_sender.reset();
+  EXPECT_EQ(payloads(), std::vector<std::string>({"0", "1", "2", "3", "4"}));
+}
+
+TEST_F(PacketSenderTest, BatchedSendWithByteLimit) {
+  auto options = MakeOptions();
+  options.batch_options.max_packets = 100;
+  options.batch_options.max_bytes = 1;
+  auto packet_sender_status_or = PacketSender::Create(options);
+  ASSERT_TRUE(packet_sender_status_or.ok());
+  auto packet_sender = std::move(packet_sender_status_or).ValueOrDie();
+  EXPECT_TRUE(packet_sender->Send(MakePacket(0)).ok());
+  EXPECT_TRUE(AwaitPayloads(1));
+}
+
+TEST_F(PacketSenderTest, BatchedSendWithLinger) {
+  auto options = MakeOptions();
+  options.batch_options.max_packets = 100;
+  options.batch_options.linger = absl::Milliseconds(10);
+  auto packet_sender_status_or = PacketSender::Create(options);
+  ASSERT_TRUE(packet_sender_status_or.ok());
+  auto packet_sender = std::move(packet_sender_status_or).ValueOrDie();
+  EXPECT_TRUE(packet_sender->Send(MakePacket(0)).ok());
+  EXPECT_TRUE(AwaitPayloads(1));
+  EXPECT_TRUE(packet_sender->Send(MakePacket(1)).ok());
+  EXPECT_TRUE(AwaitPayloads(2));
+}
+
+TEST(PacketSenderOptionsTest, InvalidBatchOptions) {
+  PacketSender::Options options;
+  options.batch_options.max_packets = 0;
+  EXPECT_FALSE(PacketSender::Create(options).ok());
+
+  options.batch_options.max_packets = 1;
+  options.batch_options.linger = absl::Milliseconds(-1);
+  EXPECT_FALSE(PacketSender::Create(options).ok());
+}
+
+}  // namespace aistreams
@@ -16,6 +16,8 @@
 
 #include <memory>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "aistreams/base/types/eos.h"
 #include "aistreams/base/types/gstreamer_buffer.h"
@@ -29,6 +31,21 @@
 #include "aistreams/proto/types/control_signal.pb.h"
 #include "aistreams/proto/types/raw_image.pb.h"
 #include "aistreams/proto/types/raw_image_packet_type_descriptor.pb.h"
+#include "aistreams/proto/types/struct_packet_type_descriptor.pb.h"
+
+namespace {
+
+struct TestBox {
+  float x_min;
+  float y_min;
+  float x_max;
+  float y_max;
+  int32_t label;
+};
+
+}  // namespace
+
+AIS_REGISTER_STRUCT_PACKET_TYPE(TestBox, "aistreams.TestBox", 2);
 
 namespace aistreams {
 
@@ -235,6 +252,107 @@ TEST(PacketTest, ProtobufPacketTest) {
   }
 }
 
+TEST(PacketTest, PacketAsHeaderTest) {
+  {
+    std::string src("hey!");
+    auto packet_status_or = MakePacket(src);
+    EXPECT_TRUE(packet_status_or.ok());
+    Packet packet = std::move(packet_status_or).ValueOrDie();
+
+    // The header is available before and after the value is adapted.
+    PacketAs<std::string> packet_as(packet);
+    const PacketHeader& header = packet_as.header();
+    EXPECT_EQ(&header, &packet_as.header());
+    EXPECT_EQ(header.type().type_id(), PACKET_TYPE_STRING);
+    EXPECT_EQ(header.timestamp().seconds(),
+              packet.header().timestamp().seconds());
+    EXPECT_TRUE(packet_as.ok());
+    EXPECT_EQ(packet_as.ValueOrDie(), src);
+    EXPECT_EQ(header.type().type_id(), PACKET_TYPE_STRING);
+    EXPECT_EQ(packet_as.microseconds(),
+              packet.header().timestamp().seconds() * 1000000 +
+                  packet.header().timestamp().nanos() / 1000);
+  }
+  {
+    // Copies taken before adaptation adapt independently.
+    std::string src("hey!");
+    auto packet_status_or = MakePacket(src);
+    EXPECT_TRUE(packet_status_or.ok());
+    PacketAs<std::string> packet_as(std::move(packet_status_or).ValueOrDie());
+    PacketAs<std::string> packet_as_copy(packet_as);
+    EXPECT_EQ(std::move(packet_as).ValueOrDie(), src);
+    EXPECT_EQ(std::move(packet_as_copy).ValueOrDie(), src);
+  }
+  {
+    // Const accesses from several threads adapt the value exactly once.
+    std::string src("hey!");
+    auto packet_status_or = MakePacket(src);
+    EXPECT_TRUE(packet_status_or.ok());
+    const PacketAs<std::string> packet_as(
+        std::move(packet_status_or).ValueOrDie());
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; ++i) {
+      threads.emplace_back([&packet_as, &src]() {
+        EXPECT_TRUE(packet_as.ok());
+        EXPECT_EQ(packet_as.ValueOrDie(), src);
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+}
+
+TEST(PacketTest, PacketAsProtobufArenaTest) {
+  {
+    RawImageDescriptor src;
+    src.set_height(2);
+    src.set_width(3);
+    auto packet_status_or = MakePacket(src);
+    EXPECT_TRUE(packet_status_or.ok());
+
+    google::protobuf::Arena arena;
+    PacketAs<RawImageDescriptor> packet_as(
+        std::move(packet_status_or).ValueOrDie(), &arena);
+    EXPECT_TRUE(packet_as.ok());
+    const RawImageDescriptor& dst = packet_as.ValueOrDie();
+    EXPECT_EQ(dst.GetArena(), &arena);
+    EXPECT_EQ(dst.height(), 2);
+    EXPECT_EQ(dst.width(), 3);
+  }
+  {
+    std::string src("hey!");
+    auto packet_status_or = MakePacket(src);
+    EXPECT_TRUE(packet_status_or.ok());
+
+    google::protobuf::Arena arena;
+    PacketAs<RawImageDescriptor> packet_as(
+        std::move(packet_status_or).ValueOrDie(), &arena);
+    EXPECT_FALSE(packet_as.ok());
+    EXPECT_EQ(packet_as.header().type().type_id(), PACKET_TYPE_STRING);
+  }
+  {
+    // Copies hold their own value, which outlives the arena.
+    RawImageDescriptor src;
+    src.set_height(2);
+    auto packet_status_or = MakePacket(src);
+    EXPECT_TRUE(packet_status_or.ok());
+
+    PacketAs<RawImageDescriptor> packet_as_copy;
+    {
+      google::protobuf::Arena arena;
+      PacketAs<RawImageDescriptor> packet_as(
+          std::move(packet_status_or).ValueOrDie(), &arena);
+      EXPECT_TRUE(packet_as.ok());
+      packet_as_copy = packet_as;
+      packet_as.ValueOrDie().set_height(5);
+      EXPECT_EQ(packet_as_copy.ValueOrDie().GetArena(), nullptr);
+    }
+    EXPECT_TRUE(packet_as_copy.ok());
+    EXPECT_EQ(packet_as_copy.ValueOrDie().height(), 2);
+  }
+}
+
 TEST(PacketTest, MakePacketGstreamerBufferTest) {
   {
     std::string caps("video/x-raw");
@@ -302,6 +420,111 @@ TEST(PacketTest, PacketAsGstreamerBufferTest) {
   }
 }
 
+TEST(PacketTest, MakePacketStructTest) {
+  {
+    TestBox box{1, 2, 3, 4, 5};
+    auto packet_status_or = MakePacket(box);
+    EXPECT_TRUE(packet_status_or.ok());
+    auto packet = std::move(packet_status_or).ValueOrDie();
+    EXPECT_EQ(packet.header().type().type_id(), PACKET_TYPE_STRUCT);
+    EXPECT_EQ(packet.payload().size(), sizeof(TestBox));
+    EXPECT_TRUE(IsPacketFlagsSet(
+        PacketFlags::kIsFrameHead | PacketFlags::kIsKeyFrame, packet));
+
+    StructPacketTypeDescriptor struct_packet_type_desc;
+    EXPECT_TRUE(packet.header().type().type_descriptor().UnpackTo(
+        &struct_packet_type_desc));
+    EXPECT_EQ(struct_packet_type_desc.type_name(), "aistreams.TestBox");
+    EXPECT_EQ(struct_packet_type_desc.size(), sizeof(TestBox));
+    EXPECT_EQ(struct_packet_type_desc.version(), 2);
+  }
+  {
+    std::vector<TestBox> boxes = {{1, 2, 3, 4, 5}, {6, 7, 8, 9, 10}};
+    auto packet_status_or = MakePacket(absl::MakeConstSpan(boxes));
+    EXPECT_TRUE(packet_status_or.ok());
+    auto packet = std::move(packet_status_or).ValueOrDie();
+    EXPECT_EQ(packet.header().type().type_id(), PACKET_TYPE_STRUCT);
+    EXPECT_EQ(packet.payload().size(), 2 * sizeof(TestBox));
+  }
+}
+
+TEST(PacketTest, PacketAsStructTest) {
+  {
+    TestBox src{1, 2, 3, 4, 5};
+    auto packet_status_or = MakePacket(src);
+    EXPECT_TRUE(packet_status_or.ok());
+
+    PacketAs<TestBox> packet_as(std::move(packet_status_or).ValueOrDie());
+    EXPECT_TRUE(packet_as.ok());
+    TestBox dst = packet_as.ValueOrDie();
+    EXPECT_EQ(dst.x_min, src.x_min);
+    EXPECT_EQ(dst.y_max, src.y_max);
+    EXPECT_EQ(dst.label, src.label);
+  }
+  {
+    std::vector<TestBox> src = {{1, 2, 3, 4, 5}, {6, 7, 8, 9, 10}};
+    auto packet_status_or = MakePacket(absl::MakeConstSpan(src));
+    EXPECT_TRUE(packet_status_or.ok());
+
+    PacketAs<absl::Span<const TestBox>> packet_as(
+        std::move(packet_status_or).ValueOrDie());
+    EXPECT_TRUE(packet_as.ok());
+    absl::Span<const TestBox> dst = packet_as.ValueOrDie();
+    ASSERT_EQ(dst.size(), src.size());
+    for (size_t i = 0; i < dst.size(); ++i) {
+      EXPECT_EQ(dst[i].x_min, src[i].x_min);
+      EXPECT_EQ(dst[i].label, src[i].label);
+    }
+
+    // A copy views its own payload, so it outlives the original.
+    PacketAs<absl::Span<const TestBox>> packet_as_copy(packet_as);
+    packet_as = PacketAs<absl::Span<const TestBox>>();
+    ASSERT_TRUE(packet_as_copy.ok());
+    absl::Span<const TestBox> copy_dst = packet_as_copy.ValueOrDie();
+    ASSERT_EQ(copy_dst.size(), src.size());
+    EXPECT_NE(copy_dst.data(), dst.data());
+    EXPECT_EQ(copy_dst[1].x_min, src[1].x_min);
+
+    // A moved to instance views the payload it now holds.
+    PacketAs<absl::Span<const TestBox>> packet_as_moved(
+        std::move(packet_as_copy));
+    ASSERT_TRUE(packet_as_moved.ok());
+    ASSERT_EQ(packet_as_moved.ValueOrDie().size(), src.size());
+    EXPECT_EQ(packet_as_moved.ValueOrDie()[1].label, src[1].label);
+
+    // Multiple elements cannot be read out as a single struct.
+    auto packet_status_or_2 = MakePacket(absl::MakeConstSpan(src));
+    EXPECT_TRUE(packet_status_or_2.ok());
+    PacketAs<TestBox> single_packet_as(
+        std::move(packet_status_or_2).ValueOrDie());
+    EXPECT_FALSE(single_packet_as.ok());
+  }
+  {
+    // Mismatched struct metadata is rejected.
+    TestBox src{1, 2, 3, 4, 5};
+    auto packet_status_or = MakePacket(src);
+    EXPECT_TRUE(packet_status_or.ok());
+    Packet packet = std::move(packet_status_or).ValueOrDie();
+    StructPacketTypeDescriptor struct_packet_type_desc;
+    EXPECT_TRUE(packet.header().type().type_descriptor().UnpackTo(
+        &struct_packet_type_desc));
+    struct_packet_type_desc.set_version(1);
+    packet.mutable_header()
+        ->mutable_type()
+        ->mutable_type_descriptor()
+        ->PackFrom(struct_packet_type_desc);
+
+    PacketAs<TestBox> packet_as(std::move(packet));
+    EXPECT_FALSE(packet_as.ok());
+  }
+  {
+    std::string src("hey!");
+    auto packet_status_or = MakePacket(src);
+    PacketAs<TestBox> packet_as(std::move(packet_status_or).ValueOrDie());
+    EXPECT_FALSE(packet_as.ok());
+  }
+}
+
 TEST(PacketTest, MakePacketEosTest) {
   {
     std::string reason = "some reason";
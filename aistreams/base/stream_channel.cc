@@ -29,6 +29,11 @@ using ::aistreams::constants::kStreamMetadataKeyName;
 StreamChannel::StreamChannel(const Options& options) : options_(options) {}
 
 Status StreamChannel::Initialize() {
+  if (options_.grpc_channel != nullptr) {
+    grpc_channel_ = options_.grpc_channel;
+    return OkStatus();
+  }
+
   // Establish a grpc channel.
   grpc_channel_ = CreateGrpcChannel(options_.connection_options);
   if (grpc_channel_ == nullptr) {
@@ -41,6 +41,10 @@ class StreamChannel {
     // ingress. You can leave this empty if you are directly connecting to the
     // stream server.
     std::string stream_name;
+
+    // An established channel to reuse, e.g. one shared by the receivers of
+    // several streams on the same server. A new channel is created if null.
+    std::shared_ptr<grpc::Channel> grpc_channel = nullptr;
   };
 
   // Creates and initializes an instance that is ready for use.
@@ -17,6 +17,7 @@
 #ifndef AISTREAMS_BASE_TYPES_GSTREAMER_BUFFER_H_
 #define AISTREAMS_BASE_TYPES_GSTREAMER_BUFFER_H_
 
+#include <cstdint>
 #include <string>
 
 #include "absl/strings/string_view.h"
@@ -72,6 +73,25 @@ class GstreamerBuffer {
   // Returns the size of held data buffer.
   size_t size() const { return bytes_.size(); }
 
+  // Set whether the held data can be decoded on its own.
+  //
+  // This mirrors the absence of GST_BUFFER_FLAG_DELTA_UNIT on a GstBuffer.
+  // Data is considered a key frame unless set otherwise.
+  void set_is_key_frame(bool is_key_frame) { is_key_frame_ = is_key_frame; }
+
+  // Returns true if the held data can be decoded on its own.
+  bool is_key_frame() const { return is_key_frame_; }
+
+  // Set the presentation timestamp (PTS) of the held data in nanoseconds.
+  //
+  // This mirrors GST_BUFFER_PTS on a GstBuffer. A negative value means that
+  // the PTS is unset (GST_CLOCK_TIME_NONE), which is the default.
+  void set_pts(int64_t pts) { pts_ = pts; }
+
+  // Returns the presentation timestamp of the held data in nanoseconds, or a
+  // negative value if it is unset.
+  int64_t pts() const { return pts_; }
+
   // Returns the released byte buffer for the caller to acquire.
   std::string&& ReleaseBuffer() && { return std::move(bytes_); }
 
@@ -85,6 +105,8 @@ class GstreamerBuffer {
  private:
   std::string caps_;
   std::string bytes_;
+  bool is_key_frame_ = true;
+  int64_t pts_ = -1;
 };
 
 }  // namespace aistreams
@@ -17,6 +17,8 @@
 #ifndef AISTREAMS_BASE_TYPES_PACKET_TYPES_PACKET_TYPE_TRAITS_H_
 #define AISTREAMS_BASE_TYPES_PACKET_TYPES_PACKET_TYPE_TRAITS_H_
 
+#include <type_traits>
+
 #include "aistreams/port/status.h"
 #include "aistreams/proto/types/packet_type.pb.h"
 #include "google/protobuf/any.pb.h"
@@ -38,6 +40,11 @@ namespace aistreams {
 template <typename T>
 struct dependent_false : std::false_type {};
 
+// Whether an unpacked T is a view into the payload of its source packet rather
+// than an owner of its own data. Specialize this for such types.
+template <typename T, typename Enable = void>
+struct is_packet_view_type : std::false_type {};
+
 // Traits class to map a C++ type to a packet type.
 template <typename T, typename Enable = void>
 struct PacketTypeTraits {
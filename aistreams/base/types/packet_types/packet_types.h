@@ -27,6 +27,7 @@
 #include "aistreams/base/types/packet_types/protobuf_packet_type.h"
 #include "aistreams/base/types/packet_types/raw_image_packet_type.h"
 #include "aistreams/base/types/packet_types/string_packet_type.h"
+#include "aistreams/base/types/packet_types/struct_packet_type.h"
 #include "aistreams/port/canonical_errors.h"
 #include "aistreams/port/logging.h"
 #include "aistreams/port/status.h"
@@ -61,10 +62,9 @@ Status Pack(T&& t, Packet* p) {
   }
   PacketType* packet_type = p->mutable_header()->mutable_type();
   packet_type->set_type_id(
-      PacketTypeTraits<
-          typename std::remove_reference<T>::type>::packet_type_id());
+      PacketTypeTraits<typename std::decay<T>::type>::packet_type_id());
   auto type_descriptor_any_ptr = packet_type->mutable_type_descriptor();
-  auto status = PacketTypeTraits<typename std::remove_reference<T>::type>::
+  auto status = PacketTypeTraits<typename std::decay<T>::type>::
       packet_type_descriptor(t, type_descriptor_any_ptr);
   if (!status.ok()) {
     LOG(ERROR) << status;
@@ -0,0 +1,163 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <utility>
+
+#include "aistreams/base/types/eos.h"
+#include "aistreams/base/types/gstreamer_buffer.h"
+#include "aistreams/base/types/jpeg_frame.h"
+#include "aistreams/base/types/packet_types/packet_types.h"
+#include "aistreams/base/types/raw_image.h"
+#include "aistreams/port/benchmark.h"
+#include "aistreams/port/logging.h"
+#include "aistreams/port/status.h"
+#include "aistreams/proto/packet.pb.h"
+#include "aistreams/proto/types/raw_image.pb.h"
+
+namespace {
+
+struct BenchmarkBox {
+  float x_min;
+  float y_min;
+  float x_max;
+  float y_max;
+  float score;
+};
+
+}  // namespace
+
+AIS_REGISTER_STRUCT_PACKET_TYPE(BenchmarkBox, "aistreams.BenchmarkBox", 1);
+
+namespace aistreams {
+namespace {
+
+// Returns a value of type T whose payload is about `size` bytes. Types with a
+// fixed size ignore `size`.
+template <typename T>
+T MakeValue(int size);
+
+template <>
+std::string MakeValue<std::string>(int size) {
+  return std::string(size, 'x');
+}
+
+template <>
+GstreamerBuffer MakeValue<GstreamerBuffer>(int size) {
+  GstreamerBuffer gstreamer_buffer;
+  gstreamer_buffer.set_caps_string("application/octet-stream");
+  gstreamer_buffer.assign(std::string(size, 'x'));
+  return gstreamer_buffer;
+}
+
+template <>
+JpegFrame MakeValue<JpegFrame>(int size) {
+  return JpegFrame(std::string(size, 'x'));
+}
+
+// A single row of size / 3 SRGB pixels.
+template <>
+RawImage MakeValue<RawImage>(int size) {
+  return RawImage(1, size / 3, RAW_IMAGE_FORMAT_SRGB);
+}
+
+template <>
+Eos MakeValue<Eos>(int) {
+  Eos eos;
+  eos.set_reason("end of benchmark");
+  return eos;
+}
+
+template <>
+RawImageDescriptor MakeValue<RawImageDescriptor>(int) {
+  RawImageDescriptor descriptor;
+  descriptor.set_format(RAW_IMAGE_FORMAT_SRGB);
+  descriptor.set_height(1080);
+  descriptor.set_width(1920);
+  return descriptor;
+}
+
+template <>
+BenchmarkBox MakeValue<BenchmarkBox>(int) {
+  return BenchmarkBox{0.1f, 0.2f, 0.3f, 0.4f, 0.9f};
+}
+
+// Byte payload sizes: a small message, a compressed frame and an uncompressed
+// 1080p SRGB frame.
+void PayloadSizes(benchmark::internal::Benchmark* b) {
+  b->ArgName("bytes")->Arg(1 << 10)->Arg(1 << 16)->Arg(1920 * 1080 * 3);
+}
+
+// Packs a value into a packet, copying its payload.
+template <typename T>
+void BM_Pack(benchmark::State& state) {
+  const T value = MakeValue<T>(state.range(0));
+  Packet packet;
+  for (auto _ : state) {
+    Status status = Pack(value, &packet);
+    benchmark::DoNotOptimize(status);
+  }
+  state.SetBytesProcessed(state.iterations() * packet.payload().size());
+}
+
+// Unpacks a value from a packet, copying its payload.
+template <typename T>
+void BM_Unpack(benchmark::State& state) {
+  Packet packet;
+  CHECK(Pack(MakeValue<T>(state.range(0)), &packet).ok());
+  T value;
+  for (auto _ : state) {
+    Status status = Unpack(packet, &value);
+    benchmark::DoNotOptimize(status);
+  }
+  state.SetBytesProcessed(state.iterations() * packet.payload().size());
+}
+
+// Moves a value into a packet and back out again. This is the cost of the
+// adaptation itself, as no payload is copied.
+template <typename T>
+void BM_PackUnpackMove(benchmark::State& state) {
+  T value = MakeValue<T>(state.range(0));
+  for (auto _ : state) {
+    Packet packet;
+    Status status = Pack(std::move(value), &packet);
+    benchmark::DoNotOptimize(status);
+    status = Unpack(std::move(packet), &value);
+    benchmark::DoNotOptimize(status);
+  }
+}
+
+BENCHMARK_TEMPLATE(BM_Pack, std::string)->Apply(PayloadSizes);
+BENCHMARK_TEMPLATE(BM_Pack, GstreamerBuffer)->Apply(PayloadSizes);
+BENCHMARK_TEMPLATE(BM_Pack, JpegFrame)->Apply(PayloadSizes);
+BENCHMARK_TEMPLATE(BM_Pack, RawImage)->Apply(PayloadSizes);
+BENCHMARK_TEMPLATE(BM_Pack, Eos)->Arg(0);
+BENCHMARK_TEMPLATE(BM_Pack, RawImageDescriptor)->Arg(0);
+BENCHMARK_TEMPLATE(BM_Pack, BenchmarkBox)->Arg(0);
+
+BENCHMARK_TEMPLATE(BM_Unpack, std::string)->Apply(PayloadSizes);
+BENCHMARK_TEMPLATE(BM_Unpack, GstreamerBuffer)->Apply(PayloadSizes);
+BENCHMARK_TEMPLATE(BM_Unpack, JpegFrame)->Apply(PayloadSizes);
+BENCHMARK_TEMPLATE(BM_Unpack, RawImage)->Apply(PayloadSizes);
+BENCHMARK_TEMPLATE(BM_Unpack, Eos)->Arg(0);
+BENCHMARK_TEMPLATE(BM_Unpack, RawImageDescriptor)->Arg(0);
+BENCHMARK_TEMPLATE(BM_Unpack, BenchmarkBox)->Arg(0);
+
+BENCHMARK_TEMPLATE(BM_PackUnpackMove, std::string)->Apply(PayloadSizes);
+BENCHMARK_TEMPLATE(BM_PackUnpackMove, GstreamerBuffer)->Apply(PayloadSizes);
+BENCHMARK_TEMPLATE(BM_PackUnpackMove, JpegFrame)->Apply(PayloadSizes);
+BENCHMARK_TEMPLATE(BM_PackUnpackMove, RawImage)->Apply(PayloadSizes);
+
+}  // namespace
+}  // namespace aistreams
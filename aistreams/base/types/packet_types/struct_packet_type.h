@@ -0,0 +1,255 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AISTREAMS_BASE_TYPES_PACKET_TYPES_STRUCT_PACKET_TYPE_H_
+#define AISTREAMS_BASE_TYPES_PACKET_TYPES_STRUCT_PACKET_TYPE_H_
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "absl/strings/str_format.h"
+#include "absl/types/span.h"
+#include "aistreams/base/types/packet_types/packet_type_traits.h"
+#include "aistreams/port/canonical_errors.h"
+#include "aistreams/port/status.h"
+#include "aistreams/port/statusor.h"
+#include "aistreams/proto/packet.pb.h"
+#include "aistreams/proto/types/packet_type.pb.h"
+#include "aistreams/proto/types/struct_packet_type_descriptor.pb.h"
+#include "google/protobuf/any.pb.h"
+
+namespace aistreams {
+
+// Struct packets carry the raw in-memory representation of fixed layout
+// structs, such as bounding boxes and scores. Packing and unpacking them is a
+// plain memory copy, and absl::Span<const T> may be unpacked as a view directly
+// into the packet payload without any copies at all.
+//
+// To use a struct type T with packets, T must be trivially copyable and must be
+// registered at global scope:
+//
+//   struct Box {
+//     float x_min, y_min, x_max, y_max;
+//     float score;
+//   };
+//   AIS_REGISTER_STRUCT_PACKET_TYPE(Box, "example.Box", 1);
+//
+// You may then MakePacket from a Box or an absl::Span<const Box>, and use
+// PacketAs<Box> or PacketAs<absl::Span<const Box>> to read it back.
+//
+// Notes:
+// + The name and version are recorded in the packet and checked on unpack.
+//   Bump the version whenever the layout of T changes.
+// + The payload is in the sender's native byte order and struct layout, so the
+//   sender and receiver must agree on both.
+// + An unpacked absl::Span<const T> is a view into the packet payload. It must
+//   not outlive the Packet (or PacketAs) that it was unpacked from.
+
+// Specialize this (through AIS_REGISTER_STRUCT_PACKET_TYPE) to register T as a
+// struct packet type.
+template <typename T>
+struct StructPacketTypeInfo {
+  static constexpr bool registered = false;
+};
+
+#define AIS_REGISTER_STRUCT_PACKET_TYPE(struct_type, struct_name,           \
+                                        struct_version)                     \
+  namespace aistreams {                                                     \
+  template <>                                                               \
+  struct StructPacketTypeInfo<struct_type> {                                \
+    static_assert(std::is_trivially_copyable<struct_type>::value,           \
+                  "Struct packet types must be trivially copyable.");       \
+    static constexpr bool registered = true;                                \
+    static constexpr const char* type_name() { return struct_name; }        \
+    static constexpr int version() { return struct_version; }               \
+  };                                                                        \
+  }  // namespace aistreams
+
+template <typename T>
+struct is_struct_packet_type
+    : std::integral_constant<
+          bool, StructPacketTypeInfo<typename std::remove_cv<T>::type>::
+                    registered> {};
+
+namespace internal {
+
+template <typename T>
+Status PackStructPacketTypeDescriptor(google::protobuf::Any* any) {
+  if (any == nullptr) {
+    return InvalidArgumentError("Given a nullptr to a google::protobuf::Any");
+  }
+  StructPacketTypeDescriptor struct_packet_type_desc;
+  struct_packet_type_desc.set_type_name(StructPacketTypeInfo<T>::type_name());
+  struct_packet_type_desc.set_size(sizeof(T));
+  struct_packet_type_desc.set_version(StructPacketTypeInfo<T>::version());
+  any->PackFrom(struct_packet_type_desc);
+  return OkStatus();
+}
+
+// Validate the Packet against the StructPacketTypeDescriptor expected for T.
+// Return the number of elements of type T held in the payload if all went well.
+template <typename T>
+StatusOr<size_t> ValidateStructPacket(const Packet& p) {
+  StructPacketTypeDescriptor struct_packet_type_desc;
+  if (!p.header().type().type_descriptor().UnpackTo(
+          &struct_packet_type_desc)) {
+    return InvalidArgumentError(
+        "Failed to Unpack the type decriptor as a StructPacketTypeDescriptor");
+  }
+  if (struct_packet_type_desc.type_name() !=
+      StructPacketTypeInfo<T>::type_name()) {
+    return InvalidArgumentError(absl::StrFormat(
+        "Given a struct packet containing the type %s, but we are trying to "
+        "receive it as the type %s",
+        struct_packet_type_desc.type_name(),
+        StructPacketTypeInfo<T>::type_name()));
+  }
+  if (struct_packet_type_desc.version() !=
+      StructPacketTypeInfo<T>::version()) {
+    return InvalidArgumentError(absl::StrFormat(
+        "Given a struct packet of %s version %d, but we are trying to receive "
+        "it as version %d",
+        struct_packet_type_desc.type_name(), struct_packet_type_desc.version(),
+        StructPacketTypeInfo<T>::version()));
+  }
+  if (struct_packet_type_desc.size() != static_cast<int64_t>(sizeof(T))) {
+    return InvalidArgumentError(absl::StrFormat(
+        "The struct size recorded in the packet is inconsistent with the "
+        "destination struct size (%d vs %d)",
+        struct_packet_type_desc.size(), sizeof(T)));
+  }
+  if (p.payload().size() % sizeof(T) != 0) {
+    return InvalidArgumentError(absl::StrFormat(
+        "The given Packet's payload size (%d) is not a multiple of the struct "
+        "size (%d)",
+        p.payload().size(), sizeof(T)));
+  }
+  return p.payload().size() / sizeof(T);
+}
+
+}  // namespace internal
+
+// Specialization to map registered struct types to Packets of type
+// PACKET_TYPE_STRUCT.
+template <typename T>
+struct PacketTypeTraits<
+    T, typename std::enable_if<is_struct_packet_type<T>::value>::type> {
+  using value_type = T;
+  constexpr static PacketTypeId packet_type_id() { return PACKET_TYPE_STRUCT; }
+
+  constexpr static const char* packet_type_name() {
+    return StructPacketTypeInfo<T>::type_name();
+  }
+
+  static Status packet_type_descriptor(const T&, google::protobuf::Any* any) {
+    return internal::PackStructPacketTypeDescriptor<T>(any);
+  }
+};
+
+// Specialization to map a contiguous array of registered struct types to
+// Packets of type PACKET_TYPE_STRUCT.
+template <typename T>
+struct PacketTypeTraits<
+    absl::Span<const T>,
+    typename std::enable_if<is_struct_packet_type<T>::value>::type> {
+  using value_type = absl::Span<const T>;
+  constexpr static PacketTypeId packet_type_id() { return PACKET_TYPE_STRUCT; }
+
+  constexpr static const char* packet_type_name() {
+    return StructPacketTypeInfo<T>::type_name();
+  }
+
+  static Status packet_type_descriptor(const absl::Span<const T>&,
+                                       google::protobuf::Any* any) {
+    return internal::PackStructPacketTypeDescriptor<T>(any);
+  }
+};
+
+// An unpacked absl::Span<const T> views the payload of its source packet.
+template <typename T>
+struct is_packet_view_type<
+    absl::Span<const T>,
+    typename std::enable_if<is_struct_packet_type<T>::value>::type>
+    : std::true_type {};
+
+template <typename T, typename std::enable_if<
+                          is_struct_packet_type<T>::value>::type* = nullptr>
+Status PackPayload(const T& t, Packet* p) {
+  if (p == nullptr) {
+    return InvalidArgumentError("Given a nullptr to a Packet");
+  }
+  p->mutable_payload()->assign(reinterpret_cast<const char*>(&t), sizeof(T));
+  return OkStatus();
+}
+
+template <typename T, typename std::enable_if<
+                          is_struct_packet_type<T>::value>::type* = nullptr>
+Status PackPayload(absl::Span<const T> ts, Packet* p) {
+  if (p == nullptr) {
+    return InvalidArgumentError("Given a nullptr to a Packet");
+  }
+  p->mutable_payload()->assign(reinterpret_cast<const char*>(ts.data()),
+                               ts.size() * sizeof(T));
+  return OkStatus();
+}
+
+template <typename T, typename std::enable_if<
+                          is_struct_packet_type<T>::value>::type* = nullptr>
+Status UnpackPayload(const Packet& p, T* t) {
+  if (t == nullptr) {
+    return InvalidArgumentError("Given a nullptr to the destination struct");
+  }
+  auto count_statusor = internal::ValidateStructPacket<T>(p);
+  if (!count_statusor.ok()) {
+    return count_statusor.status();
+  }
+  if (count_statusor.ValueOrDie() != 1) {
+    return InvalidArgumentError(absl::StrFormat(
+        "Given a struct packet with %d elements, but we are trying to receive "
+        "exactly one",
+        count_statusor.ValueOrDie()));
+  }
+  std::memcpy(t, p.payload().data(), sizeof(T));
+  return OkStatus();
+}
+
+// The resulting span is a view into the payload of `p`.
+template <typename T, typename std::enable_if<
+                          is_struct_packet_type<T>::value>::type* = nullptr>
+Status UnpackPayload(const Packet& p, absl::Span<const T>* ts) {
+  if (ts == nullptr) {
+    return InvalidArgumentError("Given a nullptr to the destination span");
+  }
+  auto count_statusor = internal::ValidateStructPacket<T>(p);
+  if (!count_statusor.ok()) {
+    return count_statusor.status();
+  }
+  const char* data = p.payload().data();
+  if (reinterpret_cast<std::uintptr_t>(data) % alignof(T) != 0) {
+    return FailedPreconditionError(absl::StrFormat(
+        "The packet payload is not aligned to %d bytes and cannot be viewed "
+        "in-place",
+        alignof(T)));
+  }
+  *ts = absl::Span<const T>(reinterpret_cast<const T*>(data),
+                            count_statusor.ValueOrDie());
+  return OkStatus();
+}
+
+}  // namespace aistreams
+
+#endif  // AISTREAMS_BASE_TYPES_PACKET_TYPES_STRUCT_PACKET_TYPE_H_
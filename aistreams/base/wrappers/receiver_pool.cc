@@ -0,0 +1,148 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "aistreams/base/wrappers/receiver_pool.h"
+
+#include <map>
+#include <string>
+#include <utility>
+
+#include "absl/strings/str_format.h"
+#include "aistreams/base/make_packet.h"
+#include "aistreams/base/util/grpc_helpers.h"
+#include "aistreams/port/canonical_errors.h"
+#include "aistreams/port/logging.h"
+#include "aistreams/port/status.h"
+#include "aistreams/port/status_macros.h"
+
+namespace aistreams {
+
+ReceiverPool::ReceiverPool(const Options& options) : options_(options) {}
+
+Status ReceiverPool::Initialize() {
+  grpc_channel_ = CreateGrpcChannel(options_.connection_options);
+  if (grpc_channel_ == nullptr) {
+    return UnknownError("Failed to create a gRPC channel");
+  }
+  return OkStatus();
+}
+
+StatusOr<std::unique_ptr<ReceiverPool>> ReceiverPool::Create(
+    const Options& options) {
+  auto receiver_pool = std::make_unique<ReceiverPool>(options);
+  AIS_RETURN_IF_ERROR(receiver_pool->Initialize());
+  return receiver_pool;
+}
+
+void ReceiverPool::ReceiveLoop(Stream* stream, PacketCallback callback) {
+  while (true) {
+    Packet packet;
+    Status status = stream->receiver->Receive(&packet);
+    if (stream->is_removed) {
+      return;
+    }
+    if (!status.ok()) {
+      callback(MakeEosPacket(
+                   absl::StrFormat(
+                       "Could not receive a packet from the server: %s",
+                       status.message()))
+                   .ValueOrDie())
+          .IgnoreError();
+      return;
+    }
+    status = callback(std::move(packet));
+    if (!status.ok()) {
+      if (!IsCancelled(status)) {
+        LOG(ERROR) << "PacketCallback returned non-ok status: "
+                   << status.message();
+      }
+      return;
+    }
+  }
+}
+
+Status ReceiverPool::AddStream(const std::string& stream_name,
+                               const PacketCallback& callback) {
+  absl::MutexLock lock(&mu_);
+  if (streams_.find(stream_name) != streams_.end()) {
+    return AlreadyExistsError(absl::StrFormat(
+        "Already receiving from the stream \"%s\"", stream_name));
+  }
+
+  PacketReceiver::Options packet_receiver_options;
+  packet_receiver_options.connection_options = options_.connection_options;
+  packet_receiver_options.offset_options = options_.offset_options;
+  packet_receiver_options.stream_name = stream_name;
+  packet_receiver_options.receiver_name = options_.receiver_name;
+  packet_receiver_options.grpc_channel = grpc_channel_;
+  auto packet_receiver_statusor =
+      PacketReceiver::Create(packet_receiver_options);
+  if (!packet_receiver_statusor.ok()) {
+    LOG(ERROR) << packet_receiver_statusor.status();
+    return UnknownError(absl::StrFormat(
+        "Failed to create a PacketReceiver for the stream \"%s\"",
+        stream_name));
+  }
+
+  auto stream = std::make_unique<Stream>();
+  stream->receiver = std::move(packet_receiver_statusor).ValueOrDie();
+  stream->worker = std::thread(&ReceiverPool::ReceiveLoop, stream.get(),
+                               callback);
+  streams_[stream_name] = std::move(stream);
+  return OkStatus();
+}
+
+void ReceiverPool::StopStream(Stream* stream) {
+  stream->is_removed = true;
+  stream->receiver->Cancel();
+  stream->worker.join();
+}
+
+Status ReceiverPool::RemoveStream(const std::string& stream_name) {
+  std::unique_ptr<Stream> stream;
+  {
+    absl::MutexLock lock(&mu_);
+    auto it = streams_.find(stream_name);
+    if (it == streams_.end()) {
+      return NotFoundError(absl::StrFormat(
+          "Not receiving from the stream \"%s\"", stream_name));
+    }
+    stream = std::move(it->second);
+    streams_.erase(it);
+  }
+  StopStream(stream.get());
+  return OkStatus();
+}
+
+ReceiverPool::~ReceiverPool() {
+  // Join the workers without holding mu_, as their callbacks may call into the
+  // pool. Streams that they add meanwhile are stopped in the next round.
+  while (true) {
+    std::map<std::string, std::unique_ptr<Stream>> streams;
+    {
+      absl::MutexLock lock(&mu_);
+      streams.swap(streams_);
+    }
+    if (streams.empty()) {
+      return;
+    }
+    for (auto& name_and_stream : streams) {
+      StopStream(name_and_stream.second.get());
+    }
+  }
+}
+
+}  // namespace aistreams
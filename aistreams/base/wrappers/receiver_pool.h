@@ -0,0 +1,102 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AISTREAMS_BASE_WRAPPERS_RECEIVER_POOL_H_
+#define AISTREAMS_BASE_WRAPPERS_RECEIVER_POOL_H_
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "absl/synchronization/mutex.h"
+#include "aistreams/base/connection_options.h"
+#include "aistreams/base/offset_options.h"
+#include "aistreams/base/packet_receiver.h"
+#include "aistreams/port/grpcpp.h"
+#include "aistreams/port/status.h"
+#include "aistreams/port/statusor.h"
+
+namespace aistreams {
+
+// A ReceiverPool receives packets from several streams of the same server.
+//
+// All of the streams share a single gRPC channel, and every packet is handed
+// straight to the callback of its stream; there is no intermediate queue.
+// This makes it cheaper to consume many streams in one process than running a
+// receiver queue per stream.
+class ReceiverPool {
+ public:
+  // Options for configuring the receiver pool.
+  struct Options {
+    // Options to configure the RPC connection.
+    ConnectionOptions connection_options;
+
+    // Options to specify the offset to start receiving, for every stream.
+    OffsetOptions offset_options;
+
+    // A name that identifies the receiver to every stream.
+    //
+    // You may leave this empty; in this case, you will get a random assignment.
+    std::string receiver_name;
+  };
+
+  // Creates and initializes an instance that is ready for use.
+  static StatusOr<std::unique_ptr<ReceiverPool>> Create(const Options&);
+
+  // Start receiving from the stream named `stream_name`.
+  //
+  // `callback` runs for every packet of the stream, in stream order and on a
+  // thread of the pool, until it returns a non-OK Status or the stream is
+  // removed. If receiving fails, `callback` is given a last EOS packet that
+  // tells why.
+  Status AddStream(const std::string& stream_name,
+                   const PacketCallback& callback);
+
+  // Stop receiving from the stream named `stream_name`.
+  //
+  // This returns once its callback has returned for the last time. It must
+  // not be called from the callback itself.
+  Status RemoveStream(const std::string& stream_name);
+
+  // Use Create() rather than the constructors.
+  explicit ReceiverPool(const Options&);
+  ~ReceiverPool();
+  ReceiverPool(const ReceiverPool&) = delete;
+  ReceiverPool& operator=(const ReceiverPool&) = delete;
+
+ private:
+  struct Stream {
+    std::unique_ptr<PacketReceiver> receiver;
+    std::atomic<bool> is_removed{false};
+    std::thread worker;
+  };
+
+  Status Initialize();
+  static void ReceiveLoop(Stream* stream, PacketCallback callback);
+  static void StopStream(Stream* stream);
+
+  Options options_;
+  std::shared_ptr<grpc::Channel> grpc_channel_ = nullptr;
+
+  absl::Mutex mu_;
+  std::map<std::string, std::unique_ptr<Stream>> streams_ ABSL_GUARDED_BY(mu_);
+};
+
+}  // namespace aistreams
+
+#endif  // AISTREAMS_BASE_WRAPPERS_RECEIVER_POOL_H_
@@ -0,0 +1,192 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/base/wrappers/receiver_pool.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "aistreams/base/make_packet.h"
+#include "aistreams/base/packet_sender.h"
+#include "aistreams/port/canonical_errors.h"
+#include "aistreams/port/gtest.h"
+#include "aistreams/port/status.h"
+#include "aistreams/server/local_stream_server.h"
+
+namespace aistreams {
+
+namespace {
+
+constexpr absl::Duration kTimeout = absl::Seconds(5);
+
+class ReceiverPoolTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    auto server_statusor = LocalStreamServer::Create({});
+    ASSERT_TRUE(server_statusor.ok()) << server_statusor.status();
+    server_ = std::move(server_statusor).ValueOrDie();
+  }
+
+  ConnectionOptions MakeConnectionOptions() const {
+    ConnectionOptions options;
+    options.target_address = server_->target_address();
+    options.ssl_options.use_insecure_channel = true;
+    return options;
+  }
+
+  std::unique_ptr<ReceiverPool> CreatePool() {
+    ReceiverPool::Options options;
+    options.connection_options = MakeConnectionOptions();
+    options.offset_options.reset_offset = true;
+    options.offset_options.offset_position =
+        OffsetOptions::SpecialOffset::kOffsetBeginning;
+    auto pool_statusor = ReceiverPool::Create(options);
+    EXPECT_TRUE(pool_statusor.ok()) << pool_statusor.status();
+    return std::move(pool_statusor).ValueOrDie();
+  }
+
+  // Sends packets "<first>" to "<first + count - 1>" to `stream_name`.
+  void SendPackets(const std::string& stream_name, int first, int count) {
+    PacketSender::Options options;
+    options.connection_options = MakeConnectionOptions();
+    options.stream_name = stream_name;
+    auto sender = PacketSender::Create(options).ValueOrDie();
+    for (int i = first; i < first + count; ++i) {
+      ASSERT_TRUE(
+          sender->Send(MakePacket(std::to_string(i)).ValueOrDie()).ok());
+    }
+  }
+
+  // Returns a callback that records the payloads received from `stream_name`.
+  PacketCallback RecordPayloads(const std::string& stream_name) {
+    return [this, stream_name](Packet packet) {
+      absl::MutexLock lock(&mu_);
+      payloads_[stream_name].push_back(packet.payload());
+      return OkStatus();
+    };
+  }
+
+  // Waits until `count` payloads were received from `stream_name`. Returns
+  // false on timeout.
+  bool AwaitPayloads(const std::string& stream_name, int count) {
+    absl::MutexLock lock(&mu_);
+    awaited_stream_name_ = stream_name;
+    awaited_count_ = count;
+    return mu_.AwaitWithTimeout(
+        absl::Condition(this, &ReceiverPoolTest::HasAwaitedPayloads),
+        kTimeout);
+  }
+
+  bool HasAwaitedPayloads() const ABSL_SHARED_LOCKS_REQUIRED(mu_) {
+    auto it = payloads_.find(awaited_stream_name_);
+    return it != payloads_.end() && it->second.size() >= awaited_count_;
+  }
+
+  std::vector<std::string> payloads(const std::string& stream_name) {
+    absl::MutexLock lock(&mu_);
+    return payloads_[stream_name];
+  }
+
+  std::unique_ptr<LocalStreamServer> server_;
+  absl::Mutex mu_;
+  std::map<std::string, std::vector<std::string>> payloads_
+      ABSL_GUARDED_BY(mu_);
+  std::string awaited_stream_name_ ABSL_GUARDED_BY(mu_);
+  size_t awaited_count_ ABSL_GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace
+
+TEST_F(ReceiverPoolTest, FansOutStreams) {
+  auto pool = CreatePool();
+  const std::vector<std::string> stream_names = {"stream-a", "stream-b",
+                                                 "stream-c"};
+  for (const auto& stream_name : stream_names) {
+    SendPackets(stream_name, 0, 3);
+    ASSERT_TRUE(pool->AddStream(stream_name, RecordPayloads(stream_name)).ok());
+  }
+  for (const auto& stream_name : stream_names) {
+    SendPackets(stream_name, 3, 2);
+  }
+  for (const auto& stream_name : stream_names) {
+    ASSERT_TRUE(AwaitPayloads(stream_name, 5)) << stream_name;
+    EXPECT_EQ(payloads(stream_name),
+              std::vector<std::string>({"0", "1", "2", "3", "4"}));
+  }
+}
+
+TEST_F(ReceiverPoolTest, RejectsDuplicateAndUnknownStreams) {
+  auto pool = CreatePool();
+  ASSERT_TRUE(pool->AddStream("stream", RecordPayloads("stream")).ok());
+  EXPECT_TRUE(
+      IsAlreadyExists(pool->AddStream("stream", RecordPayloads("stream"))));
+  EXPECT_TRUE(IsNotFound(pool->RemoveStream("unknown")));
+}
+
+TEST_F(ReceiverPoolTest, RemoveStreamCancelsBlockedReceive) {
+  auto pool = CreatePool();
+  ASSERT_TRUE(pool->AddStream("stream", RecordPayloads("stream")).ok());
+  SendPackets("stream", 0, 1);
+  ASSERT_TRUE(AwaitPayloads("stream", 1));
+
+  // The worker is now blocked waiting for the next packet.
+  absl::Time start = absl::Now();
+  ASSERT_TRUE(pool->RemoveStream("stream").ok());
+  EXPECT_LT(absl::Now() - start, kTimeout);
+
+  // Neither the cancellation nor later packets reach the callback.
+  SendPackets("stream", 1, 1);
+  EXPECT_EQ(payloads("stream"), std::vector<std::string>({"0"}));
+
+  // The stream may be added again.
+  EXPECT_TRUE(pool->AddStream("stream", RecordPayloads("stream")).ok());
+  EXPECT_TRUE(AwaitPayloads("stream", 3));
+}
+
+TEST_F(ReceiverPoolTest, ShutdownStopsBlockedStreams) {
+  auto pool = CreatePool();
+  for (int i = 0; i < 4; ++i) {
+    std::string stream_name = absl::StrCat("stream-", i);
+    ASSERT_TRUE(pool->AddStream(stream_name, RecordPayloads(stream_name)).ok());
+  }
+  absl::Time start = absl::Now();
+  pool.reset();
+  EXPECT_LT(absl::Now() - start, kTimeout);
+}
+
+TEST_F(ReceiverPoolTest, ShutdownWhileCallbacksUseThePool) {
+  auto pool = CreatePool();
+  ReceiverPool* pool_ptr = pool.get();
+
+  // Every packet of "stream" has its callback add a stream to the pool.
+  ASSERT_TRUE(pool->AddStream("stream", [this, pool_ptr](Packet packet) {
+                    std::string stream_name =
+                        absl::StrCat("added-", packet.payload());
+                    pool_ptr->AddStream(stream_name,
+                                        RecordPayloads(stream_name))
+                        .IgnoreError();
+                    return RecordPayloads("stream")(std::move(packet));
+                  })
+                  .ok());
+  SendPackets("stream", 0, 20);
+  ASSERT_TRUE(AwaitPayloads("stream", 1));
+  pool.reset();
+}
+
+}  // namespace aistreams
@@ -18,6 +18,7 @@
 #define AISTREAMS_BASE_WRAPPERS_RECEIVER_QUEUE_H_
 
 #include <memory>
+#include <vector>
 
 #include "aistreams/port/status.h"
 #include "aistreams/port/statusor.h"
@@ -33,6 +34,15 @@ class ReceiverQueue {
   // up to `timeout` for the queue to become non-empty.
   bool TryPop(T& elem, absl::Duration timeout);
 
+  // Waits up to `timeout` for the queue to become non-empty, then removes up to
+  // `max_count` of the oldest elements at once and appends them to `elems`.
+  // Returns the number of elements removed.
+  int TryPopMany(int max_count, absl::Duration timeout, std::vector<T>* elems);
+
+  // Returns a file descriptor that is readable while the queue is non-empty,
+  // or -1 on failure. It is owned by the queue.
+  int ReadinessFd();
+
   // Returns the capacity of the queue.
   int capacity() const;
 
@@ -63,6 +73,17 @@ bool ReceiverQueue<T>::TryPop(T& elem, absl::Duration timeout) {
   return pcqueue_->TryPop(elem, timeout);
 }
 
+template <typename T>
+int ReceiverQueue<T>::TryPopMany(int max_count, absl::Duration timeout,
+                                 std::vector<T>* elems) {
+  return pcqueue_->TryPopMany(max_count, timeout, elems);
+}
+
+template <typename T>
+int ReceiverQueue<T>::ReadinessFd() {
+  return pcqueue_->ReadinessFd();
+}
+
 template <typename T>
 int ReceiverQueue<T>::capacity() const {
   return pcqueue_->capacity();
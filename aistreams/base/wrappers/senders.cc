@@ -32,6 +32,7 @@ Status MakePacketSender(const SenderOptions& options,
   packet_sender_options.connection_options = options.connection_options;
   packet_sender_options.stream_name = options.stream_name;
   packet_sender_options.trace_probability = options.trace_probability;
+  packet_sender_options.batch_options = options.batch_options;
   auto packet_sender_statusor = PacketSender::Create(packet_sender_options);
   if (!packet_sender_statusor.ok()) {
     LOG(ERROR) << packet_sender_statusor.status();
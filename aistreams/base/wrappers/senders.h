@@ -37,6 +37,10 @@ struct SenderOptions {
 
   // The probability to start a trace for each packet sent.
   double trace_probability = 0;
+
+  // Options to batch the packets sent. The default sends each packet on its
+  // own. See PacketSender::BatchOptions.
+  PacketSender::BatchOptions batch_options;
 };
 
 // Create a packet sender.
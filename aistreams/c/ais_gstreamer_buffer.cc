@@ -15,6 +15,7 @@
 #include "aistreams/c/ais_gstreamer_buffer.h"
 
 #include <algorithm>
+#include <string>
 
 #include "aistreams/c/ais_gstreamer_buffer_internal.h"
 #include "aistreams/c/ais_status_internal.h"
@@ -48,11 +49,22 @@ void AIS_GstreamerBufferAssign(const char* src, size_t count,
   return ais_gstreamer_buffer->gstreamer_buffer.assign(src, count);
 }
 
+char* AIS_GstreamerBufferResize(size_t count,
+                                AIS_GstreamerBuffer* ais_gstreamer_buffer) {
+  ais_gstreamer_buffer->gstreamer_buffer.assign(std::string(count, '\0'));
+  return ais_gstreamer_buffer->gstreamer_buffer.data();
+}
+
 size_t AIS_GstreamerBufferSize(
     const AIS_GstreamerBuffer* ais_gstreamer_buffer) {
   return ais_gstreamer_buffer->gstreamer_buffer.size();
 }
 
+const char* AIS_GstreamerBufferData(
+    const AIS_GstreamerBuffer* ais_gstreamer_buffer) {
+  return ais_gstreamer_buffer->gstreamer_buffer.data();
+}
+
 void AIS_GstreamerBufferCopyTo(const AIS_GstreamerBuffer* ais_gstreamer_buffer,
                                char* dst) {
   std::copy(ais_gstreamer_buffer->gstreamer_buffer.data(),
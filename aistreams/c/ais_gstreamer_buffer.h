@@ -51,10 +51,29 @@ extern const char* AIS_GstreamerBufferGetCapsString(
 extern void AIS_GstreamerBufferAssign(
     const char* src, size_t count, AIS_GstreamerBuffer* ais_gstreamer_buffer);
 
+// Set the data held in the given AIS_GstreamerBuffer to `count` bytes for you
+// to fill in, and return a pointer to them.
+//
+// Unlike AIS_GstreamerBufferAssign, this does not copy; write the bytes
+// straight into the returned address instead. The reference is valid as for
+// AIS_GstreamerBufferData.
+extern char* AIS_GstreamerBufferResize(
+    size_t count, AIS_GstreamerBuffer* ais_gstreamer_buffer);
+
 // Returns the size (number of bytes) held in the given AIS_GstreamerBuffer.
 extern size_t AIS_GstreamerBufferSize(
     const AIS_GstreamerBuffer* ais_gstreamer_buffer);
 
+// Return an unowned pointer to the data held in the given AIS_GstreamerBuffer.
+// There are AIS_GstreamerBufferSize bytes behind it.
+//
+// This reference is valid until the AIS_GstreamerBuffer is deleted or the next
+// call to AIS_GstreamerBufferAssign or AIS_GstreamerBufferResize. It lets
+// callers, e.g. a GstBuffer that wraps the memory, read the data without
+// copying it.
+extern const char* AIS_GstreamerBufferData(
+    const AIS_GstreamerBuffer* ais_gstreamer_buffer);
+
 // Copies the data held in the given AIS_GstreamerBuffer to the address starting
 // from dst.
 //
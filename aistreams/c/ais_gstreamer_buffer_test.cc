@@ -44,6 +44,9 @@ TEST(CAPI, AIS_GstreamerBufferTest) {
                   ais_gstreamer_buffer->gstreamer_buffer.size());
   EXPECT_EQ(src, dst);
 
+  EXPECT_EQ(AIS_GstreamerBufferData(ais_gstreamer_buffer),
+            ais_gstreamer_buffer->gstreamer_buffer.data());
+
   std::string dst2(AIS_GstreamerBufferSize(ais_gstreamer_buffer), '.');
   AIS_GstreamerBufferCopyTo(ais_gstreamer_buffer,
                             const_cast<char*>(dst2.data()));
@@ -52,4 +55,19 @@ TEST(CAPI, AIS_GstreamerBufferTest) {
   AIS_DeleteGstreamerBuffer(ais_gstreamer_buffer);
 }
 
+TEST(CAPI, AIS_GstreamerBufferResizeTest) {
+  AIS_GstreamerBuffer* ais_gstreamer_buffer = AIS_NewGstreamerBuffer();
+
+  std::string src = "hello";
+  char* data = AIS_GstreamerBufferResize(src.size(), ais_gstreamer_buffer);
+  EXPECT_EQ(data, AIS_GstreamerBufferData(ais_gstreamer_buffer));
+  EXPECT_EQ(AIS_GstreamerBufferSize(ais_gstreamer_buffer), src.size());
+  memcpy(data, src.data(), src.size());
+  EXPECT_EQ(std::string(AIS_GstreamerBufferData(ais_gstreamer_buffer),
+                        AIS_GstreamerBufferSize(ais_gstreamer_buffer)),
+            src);
+
+  AIS_DeleteGstreamerBuffer(ais_gstreamer_buffer);
+}
+
 }  // namespace aistreams
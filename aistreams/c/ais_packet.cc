@@ -20,6 +20,7 @@
 #include <string>
 #include <utility>
 
+#include "aistreams/base/make_packet.h"
 #include "aistreams/base/packet.h"
 #include "aistreams/base/packet_flags.h"
 #include "aistreams/base/types/gstreamer_buffer.h"
@@ -33,12 +34,15 @@
 
 using aistreams::GstreamerBuffer;
 using aistreams::IsEos;
+using aistreams::IsKeyFrame;
 using aistreams::MakeEosPacket;
 using aistreams::MakePacket;
 using aistreams::OkStatus;
+using aistreams::PACKET_TYPE_GSTREAMER_BUFFER;
 using aistreams::Packet;
 using aistreams::PacketFlags;
 using aistreams::SetPacketFlags;
+using aistreams::internal::SetToCurrentTime;
 using aistreams::UnsetPacketFlags;
 
 void AIS_DeletePacket(AIS_Packet* p) { delete p; }
@@ -106,6 +110,74 @@ AIS_Packet* AIS_NewGstreamerBufferPacket(
   return ais_packet.release();
 }
 
+AIS_Packet* AIS_NewGstreamerBufferPacketFromBytes(const char* caps_cstr,
+                                                  const char* src,
+                                                  size_t count,
+                                                  AIS_Status* ais_status) {
+  // Pack a GstreamerBuffer without data to get the header right, then copy the
+  // bytes into the payload in place.
+  GstreamerBuffer gstreamer_buffer;
+  gstreamer_buffer.set_caps_string(caps_cstr);
+  auto packet_status_or = MakePacket(std::move(gstreamer_buffer));
+  if (!packet_status_or.ok()) {
+    ais_status->status = packet_status_or.status();
+    return nullptr;
+  }
+  auto ais_packet = std::make_unique<AIS_Packet>();
+  ais_packet->packet = std::move(packet_status_or).ValueOrDie();
+  ais_packet->packet.mutable_payload()->assign(src, count);
+  ais_status->status = OkStatus();
+  return ais_packet.release();
+}
+
+AIS_Packet* AIS_NewBytesPacketOfSize(size_t count, char** data,
+                                     AIS_Status* ais_status) {
+  auto packet_status_or = MakePacket(std::string(count, '\0'));
+  if (!packet_status_or.ok()) {
+    ais_status->status = packet_status_or.status();
+    return nullptr;
+  }
+
+  auto ais_packet = std::make_unique<AIS_Packet>();
+  ais_packet->packet = std::move(packet_status_or).ValueOrDie();
+  *data = &(*ais_packet->packet.mutable_payload())[0];
+  ais_status->status = OkStatus();
+  return ais_packet.release();
+}
+
+AIS_Packet* AIS_NewGstreamerBufferPacketOfSize(const char* caps_cstr,
+                                               size_t count, char** data,
+                                               AIS_Status* ais_status) {
+  GstreamerBuffer gstreamer_buffer;
+  gstreamer_buffer.set_caps_string(caps_cstr);
+  auto packet_status_or = MakePacket(std::move(gstreamer_buffer));
+  if (!packet_status_or.ok()) {
+    ais_status->status = packet_status_or.status();
+    return nullptr;
+  }
+  auto ais_packet = std::make_unique<AIS_Packet>();
+  ais_packet->packet = std::move(packet_status_or).ValueOrDie();
+  ais_packet->packet.mutable_payload()->resize(count);
+  *data = &(*ais_packet->packet.mutable_payload())[0];
+  ais_status->status = OkStatus();
+  return ais_packet.release();
+}
+
+AIS_Packet* AIS_NewPacketFromTemplate(const AIS_Packet* ais_packet_template,
+                                      const char* src, size_t count,
+                                      AIS_Status* ais_status) {
+  auto ais_packet = std::make_unique<AIS_Packet>();
+  *ais_packet->packet.mutable_header() = ais_packet_template->packet.header();
+  ais_packet->packet.mutable_header()->clear_flags();
+  ais_packet->packet.mutable_header()->clear_server_metadata();
+  ais_status->status = SetToCurrentTime(&ais_packet->packet);
+  if (!ais_status->status.ok()) {
+    return nullptr;
+  }
+  ais_packet->packet.mutable_payload()->assign(src, count);
+  return ais_packet.release();
+}
+
 unsigned char AIS_IsEos(const AIS_Packet* ais_packet, char** reason) {
   if (reason == nullptr) {
     return static_cast<unsigned char>(IsEos(ais_packet->packet));
@@ -118,6 +190,33 @@ unsigned char AIS_IsEos(const AIS_Packet* ais_packet, char** reason) {
   return is_eos;
 }
 
+unsigned char AIS_IsKeyFrame(const AIS_Packet* ais_packet) {
+  return static_cast<unsigned char>(IsKeyFrame(ais_packet->packet));
+}
+
+int64_t AIS_GetTimestampNanos(const AIS_Packet* ais_packet) {
+  const auto& timestamp = ais_packet->packet.header().timestamp();
+  return timestamp.seconds() * 1000000000LL + timestamp.nanos();
+}
+
+const char* AIS_PacketPayloadData(const AIS_Packet* ais_packet) {
+  return ais_packet->packet.payload().data();
+}
+
+size_t AIS_PacketPayloadSize(const AIS_Packet* ais_packet) {
+  return ais_packet->packet.payload().size();
+}
+
+const char* AIS_PacketGetCapsString(const AIS_Packet* ais_packet) {
+  const auto& type = ais_packet->packet.header().type();
+  if (type.type_id() != PACKET_TYPE_GSTREAMER_BUFFER ||
+      !type.type_descriptor().UnpackTo(
+          &ais_packet->gstreamer_buffer_type_descriptor)) {
+    return nullptr;
+  }
+  return ais_packet->gstreamer_buffer_type_descriptor.caps_string().c_str();
+}
+
 void AIS_SetIsKeyFrame(unsigned char is_key_frame, AIS_Packet* ais_packet) {
   if (is_key_frame) {
     SetPacketFlags(PacketFlags::kIsKeyFrame, &ais_packet->packet);
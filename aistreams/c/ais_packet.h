@@ -18,6 +18,7 @@
 #define AISTREAMS_C_AIS_PACKET_H_
 
 #include <stddef.h>
+#include <stdint.h>
 
 #include "aistreams/c/ais_gstreamer_buffer.h"
 #include "aistreams/c/ais_status.h"
@@ -72,6 +73,54 @@ extern AIS_Packet* AIS_NewBytesPacket(const char* src, size_t count,
 extern AIS_Packet* AIS_NewGstreamerBufferPacket(
     AIS_GstreamerBuffer* ais_gstreamer_buffer, AIS_Status* ais_status);
 
+// Return a new packet of type AIS_PACKET_TYPE_GSTREAMER_BUFFER whose caps are
+// given by the null terminated `caps_cstr` and whose data are the bytes held
+// between [src, src+count).
+//
+// The bytes are copied once, straight into the packet; e.g. from a mapped
+// GstBuffer. This saves going through an intermediate AIS_GstreamerBuffer.
+//
+// Returns a nullptr on failure.
+extern AIS_Packet* AIS_NewGstreamerBufferPacketFromBytes(
+    const char* caps_cstr, const char* src, size_t count,
+    AIS_Status* ais_status);
+
+// Return a new packet whose header is a copy of that of `ais_packet_template`
+// and whose payload holds the bytes between [src, src+count). The header is
+// given the current time as its timestamp, and its flags and server metadata
+// are cleared.
+//
+// This lets a sender of many packets of the same type describe the type just
+// once, e.g. in a template made by AIS_NewGstreamerBufferPacketFromBytes when
+// the caps are set, rather than packing it anew into every packet.
+//
+// Returns a nullptr on failure.
+extern AIS_Packet* AIS_NewPacketFromTemplate(
+    const AIS_Packet* ais_packet_template, const char* src, size_t count,
+    AIS_Status* ais_status);
+
+// Return a new packet of type AIS_PACKET_TYPE_STRING whose payload is `count`
+// bytes long, and set `*data` to point to those bytes for you to fill in.
+//
+// Unlike AIS_NewBytesPacket, this does not copy; write the bytes straight into
+// the packet instead, e.g. by reading a file or extracting a GstBuffer into
+// `*data`. The pointer is valid until the packet is deleted or sent.
+//
+// Returns a nullptr on failure.
+extern AIS_Packet* AIS_NewBytesPacketOfSize(size_t count, char** data,
+                                            AIS_Status* ais_status);
+
+// Return a new packet of type AIS_PACKET_TYPE_GSTREAMER_BUFFER whose caps are
+// given by the null terminated `caps_cstr` and whose payload is `count` bytes
+// long. `*data` is set to point to those bytes for you to fill in, as with
+// AIS_NewBytesPacketOfSize.
+//
+// Returns a nullptr on failure.
+extern AIS_Packet* AIS_NewGstreamerBufferPacketOfSize(const char* caps_cstr,
+                                                      size_t count,
+                                                      char** data,
+                                                      AIS_Status* ais_status);
+
 // Delete a previously created status object.
 extern void AIS_DeletePacket(AIS_Packet*);
 
@@ -82,6 +131,33 @@ extern void AIS_DeletePacket(AIS_Packet*);
 // the caller.
 extern unsigned char AIS_IsEos(const AIS_Packet* ais_packet, char** reason);
 
+// Returns 1 if the given `ais_packet` is marked as a key frame; 0 otherwise.
+extern unsigned char AIS_IsKeyFrame(const AIS_Packet* ais_packet);
+
+// Returns the timestamp of the given `ais_packet` in nanoseconds since the
+// Unix epoch. This is the time at which the sender created the packet.
+extern int64_t AIS_GetTimestampNanos(const AIS_Packet* ais_packet);
+
+// Return an unowned pointer to the payload of the given `ais_packet`. There
+// are AIS_PacketPayloadSize bytes behind it.
+//
+// This reference is valid until the packet is deleted or its payload is moved
+// out, e.g. by AIS_NewGstreamerBufferPacketAs or AIS_SendPacket. The packet
+// owns its payload, so holding on to the AIS_Packet keeps the bytes readable
+// without copying them.
+extern const char* AIS_PacketPayloadData(const AIS_Packet* ais_packet);
+
+// Returns the size (number of bytes) of the payload of the given `ais_packet`.
+extern size_t AIS_PacketPayloadSize(const AIS_Packet* ais_packet);
+
+// Return an unowned pointer to the null terminated caps string of the given
+// `ais_packet` of type AIS_PACKET_TYPE_GSTREAMER_BUFFER, or NULL if it is of
+// another type.
+//
+// This reference is valid until the packet is deleted or changed, or until
+// this is called again on the same packet.
+extern const char* AIS_PacketGetCapsString(const AIS_Packet* ais_packet);
+
 // --------------------------------------------------------------------------
 // You should generally not use the methods below unless you are defining new
 // packet types or developing this library.
@@ -19,11 +19,16 @@
 
 #include "aistreams/c/ais_packet.h"
 #include "aistreams/proto/packet.pb.h"
+#include "aistreams/proto/types/gstreamer_buffer_packet_type_descriptor.pb.h"
 #include "aistreams/proto/types/packet_type.pb.h"
 
 // Internal opaque structures used by the Packet C API.
 struct AIS_Packet {
   aistreams::Packet packet;
+
+  // Holds the type descriptor unpacked by AIS_PacketGetCapsString.
+  mutable aistreams::GstreamerBufferPacketTypeDescriptor
+      gstreamer_buffer_type_descriptor;
 };
 
 #endif  // AISTREAMS_C_AIS_PACKET_INTERNAL_H_
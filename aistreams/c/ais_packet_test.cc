@@ -63,6 +63,132 @@ TEST(CAPI, AIS_PacketTest) {
   AIS_DeleteStatus(ais_status);
 }
 
+TEST(CAPI, AIS_GstreamerBufferPacketFromBytesTest) {
+  AIS_Status* ais_status = AIS_NewStatus();
+
+  std::string src = "hello";
+  AIS_Packet* ais_packet = AIS_NewGstreamerBufferPacketFromBytes(
+      "video/x-raw", src.c_str(), src.size(), ais_status);
+  EXPECT_NE(ais_packet, nullptr);
+
+  AIS_PacketAs* ais_packet_as =
+      AIS_NewGstreamerBufferPacketAs(ais_packet, ais_status);
+  AIS_DeletePacket(ais_packet);
+  EXPECT_NE(ais_packet_as, nullptr);
+
+  const AIS_GstreamerBuffer* ais_gstreamer_buffer_dst =
+      (const AIS_GstreamerBuffer*)AIS_PacketAsValue(ais_packet_as);
+  EXPECT_EQ(strcmp(AIS_GstreamerBufferGetCapsString(ais_gstreamer_buffer_dst),
+                   "video/x-raw"),
+            0);
+  std::string dst(AIS_GstreamerBufferSize(ais_gstreamer_buffer_dst), '.');
+  AIS_GstreamerBufferCopyTo(ais_gstreamer_buffer_dst,
+                            const_cast<char*>(dst.data()));
+  EXPECT_EQ(dst, src);
+
+  AIS_DeleteGstreamerBufferPacketAs(ais_packet_as);
+  AIS_DeleteStatus(ais_status);
+}
+
+TEST(CAPI, AIS_PacketFromTemplateTest) {
+  AIS_Status* ais_status = AIS_NewStatus();
+
+  AIS_Packet* ais_packet_template =
+      AIS_NewGstreamerBufferPacketFromBytes("video/x-raw", "", 0, ais_status);
+  EXPECT_NE(ais_packet_template, nullptr);
+  AIS_SetIsKeyFrame(1, ais_packet_template);
+
+  std::string src = "hello";
+  AIS_Packet* ais_packet = AIS_NewPacketFromTemplate(
+      ais_packet_template, src.c_str(), src.size(), ais_status);
+  AIS_DeletePacket(ais_packet_template);
+  EXPECT_NE(ais_packet, nullptr);
+  EXPECT_EQ(AIS_GetCode(ais_status), AIS_OK);
+  EXPECT_EQ(ais_packet->packet.header().flags(), 0);
+
+  AIS_PacketAs* ais_packet_as =
+      AIS_NewGstreamerBufferPacketAs(ais_packet, ais_status);
+  AIS_DeletePacket(ais_packet);
+  EXPECT_NE(ais_packet_as, nullptr);
+
+  const AIS_GstreamerBuffer* ais_gstreamer_buffer_dst =
+      (const AIS_GstreamerBuffer*)AIS_PacketAsValue(ais_packet_as);
+  EXPECT_EQ(strcmp(AIS_GstreamerBufferGetCapsString(ais_gstreamer_buffer_dst),
+                   "video/x-raw"),
+            0);
+  std::string dst(AIS_GstreamerBufferSize(ais_gstreamer_buffer_dst), '.');
+  AIS_GstreamerBufferCopyTo(ais_gstreamer_buffer_dst,
+                            const_cast<char*>(dst.data()));
+  EXPECT_EQ(dst, src);
+
+  AIS_DeleteGstreamerBufferPacketAs(ais_packet_as);
+  AIS_DeleteStatus(ais_status);
+}
+
+TEST(CAPI, AIS_PacketOfSizeTest) {
+  AIS_Status* ais_status = AIS_NewStatus();
+  std::string src = "hello";
+
+  char* data = nullptr;
+  AIS_Packet* ais_packet =
+      AIS_NewBytesPacketOfSize(src.size(), &data, ais_status);
+  EXPECT_NE(ais_packet, nullptr);
+  EXPECT_EQ(data, AIS_PacketPayloadData(ais_packet));
+  EXPECT_EQ(AIS_PacketPayloadSize(ais_packet), src.size());
+  memcpy(data, src.data(), src.size());
+  EXPECT_EQ(ais_packet->packet.payload(), src);
+  AIS_DeletePacket(ais_packet);
+
+  ais_packet = AIS_NewBytesPacket(src.data(), src.size(), ais_status);
+  EXPECT_NE(ais_packet, nullptr);
+  EXPECT_EQ(AIS_PacketGetCapsString(ais_packet), nullptr);
+  AIS_DeletePacket(ais_packet);
+
+  ais_packet = AIS_NewGstreamerBufferPacketOfSize("video/x-raw", src.size(),
+                                                  &data, ais_status);
+  EXPECT_NE(ais_packet, nullptr);
+  EXPECT_EQ(data, AIS_PacketPayloadData(ais_packet));
+  EXPECT_EQ(strcmp(AIS_PacketGetCapsString(ais_packet), "video/x-raw"), 0);
+  memcpy(data, src.data(), src.size());
+
+  AIS_PacketAs* ais_packet_as =
+      AIS_NewGstreamerBufferPacketAs(ais_packet, ais_status);
+  AIS_DeletePacket(ais_packet);
+  EXPECT_NE(ais_packet_as, nullptr);
+
+  const AIS_GstreamerBuffer* ais_gstreamer_buffer_dst =
+      (const AIS_GstreamerBuffer*)AIS_PacketAsValue(ais_packet_as);
+  EXPECT_EQ(strcmp(AIS_GstreamerBufferGetCapsString(ais_gstreamer_buffer_dst),
+                   "video/x-raw"),
+            0);
+  EXPECT_EQ(std::string(AIS_GstreamerBufferData(ais_gstreamer_buffer_dst),
+                        AIS_GstreamerBufferSize(ais_gstreamer_buffer_dst)),
+            src);
+
+  AIS_DeleteGstreamerBufferPacketAs(ais_packet_as);
+  AIS_DeleteStatus(ais_status);
+}
+
+TEST(CAPI, AIS_PacketHeaderTest) {
+  AIS_Status* ais_status = AIS_NewStatus();
+  AIS_Packet* ais_packet =
+      AIS_NewGstreamerBufferPacketFromBytes("video/x-h264", "", 0, ais_status);
+  EXPECT_NE(ais_packet, nullptr);
+
+  AIS_SetIsKeyFrame(1, ais_packet);
+  EXPECT_TRUE(AIS_IsKeyFrame(ais_packet));
+  AIS_SetIsKeyFrame(0, ais_packet);
+  EXPECT_FALSE(AIS_IsKeyFrame(ais_packet));
+
+  auto* timestamp = ais_packet->packet.mutable_header()->mutable_timestamp();
+  timestamp->set_seconds(12);
+  timestamp->set_nanos(345);
+  EXPECT_EQ(AIS_GetTimestampNanos(ais_packet), 12000000345);
+
+  AIS_DeletePacket(ais_packet);
+  AIS_DeleteStatus(ais_status);
+}
+
 TEST(CAPI, AIS_PacketEosTest) {
   {
     AIS_Status* ais_status = AIS_NewStatus();
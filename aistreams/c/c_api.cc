@@ -14,6 +14,10 @@
 
 #include "aistreams/c/c_api.h"
 
+#include <algorithm>
+#include <limits>
+#include <vector>
+
 #include "absl/strings/str_format.h"
 #include "absl/time/time.h"
 #include "aistreams/base/wrappers/senders.h"
@@ -24,14 +28,17 @@
 #include "aistreams/port/status.h"
 #include "aistreams/port/statusor.h"
 
+using aistreams::CancelledError;
 using aistreams::ConnectionOptions;
 using aistreams::DeadlineExceededError;
+using aistreams::InternalError;
 using aistreams::MakePacketReceiverQueue;
 using aistreams::MakePacketSender;
 using aistreams::OkStatus;
 using aistreams::Packet;
 using aistreams::PacketSender;
 using aistreams::ReceiverOptions;
+using aistreams::ReceiverPool;
 using aistreams::ReceiverQueue;
 using aistreams::SenderOptions;
 using aistreams::Status;
@@ -89,10 +96,23 @@ void AIS_SetSslRootCertPath(const char* ssl_root_cert_path,
 AIS_Sender* AIS_NewSender(const AIS_ConnectionOptions* options,
                           const char* stream_name, double trace_probability,
                           AIS_Status* ais_status) {
+  return AIS_NewBatchingSender(options, stream_name, trace_probability, 1, 0, 0,
+                               ais_status);
+}
+
+AIS_Sender* AIS_NewBatchingSender(const AIS_ConnectionOptions* options,
+                                  const char* stream_name,
+                                  double trace_probability,
+                                  int max_batch_packets,
+                                  size_t max_batch_bytes, int linger_ms,
+                                  AIS_Status* ais_status) {
   SenderOptions sender_options;
   sender_options.connection_options = options->connection_options;
   sender_options.stream_name = ToString(stream_name);
   sender_options.trace_probability = trace_probability;
+  sender_options.batch_options.max_packets = max_batch_packets;
+  sender_options.batch_options.max_bytes = max_batch_bytes;
+  sender_options.batch_options.linger = absl::Milliseconds(linger_ms);
 
   std::unique_ptr<PacketSender> sender;
   auto status = MakePacketSender(sender_options, &sender);
@@ -111,7 +131,13 @@ void AIS_DeleteSender(AIS_Sender* ais_sender) { delete ais_sender; }
 
 void AIS_SendPacket(AIS_Sender* ais_sender, AIS_Packet* ais_packet,
                     AIS_Status* ais_status) {
-  ais_status->status = ais_sender->packet_sender->Send(ais_packet->packet);
+  ais_status->status =
+      ais_sender->packet_sender->Send(std::move(ais_packet->packet));
+  return;
+}
+
+void AIS_FlushSender(AIS_Sender* ais_sender, AIS_Status* ais_status) {
+  ais_status->status = ais_sender->packet_sender->Flush();
   return;
 }
 
@@ -161,4 +187,95 @@ void AIS_ReceivePacket(AIS_Receiver* ais_receiver, AIS_Packet* ais_packet,
   return;
 }
 
+size_t AIS_ReceivePackets(AIS_Receiver* ais_receiver, AIS_Packet** ais_packets,
+                          size_t max_packets, int timeout_in_ms,
+                          AIS_Status* ais_status) {
+  absl::Duration timeout;
+  if (timeout_in_ms < 0) {
+    timeout = absl::InfiniteDuration();
+  } else {
+    timeout = absl::Milliseconds(timeout_in_ms);
+  }
+  std::vector<Packet> packets;
+  int max_count = static_cast<int>(std::min(
+      max_packets, static_cast<size_t>(std::numeric_limits<int>::max())));
+  packets.reserve(max_count);
+  size_t count =
+      ais_receiver->receiver_queue->TryPopMany(max_count, timeout, &packets);
+  for (size_t i = 0; i < count; ++i) {
+    ais_packets[i]->packet = std::move(packets[i]);
+  }
+  if (count == 0) {
+    ais_status->status = DeadlineExceededError(absl::StrFormat(
+        "The server did not deliver a packet within the given timeout (%d "
+        "milliseconds)",
+        timeout_in_ms));
+  } else {
+    ais_status->status = OkStatus();
+  }
+  return count;
+}
+
+unsigned char AIS_TryReceivePacket(AIS_Receiver* ais_receiver,
+                                   AIS_Packet* ais_packet) {
+  return static_cast<unsigned char>(ais_receiver->receiver_queue->TryPop(
+      ais_packet->packet, absl::ZeroDuration()));
+}
+
+int AIS_ReceiverFd(AIS_Receiver* ais_receiver, AIS_Status* ais_status) {
+  int fd = ais_receiver->receiver_queue->ReadinessFd();
+  if (fd < 0) {
+    ais_status->status = InternalError("Failed to create a readiness fd");
+  } else {
+    ais_status->status = OkStatus();
+  }
+  return fd;
+}
+
+AIS_ReceiverPool* AIS_NewReceiverPool(const AIS_ConnectionOptions* options,
+                                      const char* receiver_name,
+                                      AIS_Status* ais_status) {
+  ReceiverPool::Options receiver_pool_options;
+  receiver_pool_options.connection_options = options->connection_options;
+  receiver_pool_options.receiver_name = ToString(receiver_name);
+
+  auto receiver_pool_statusor = ReceiverPool::Create(receiver_pool_options);
+  if (!receiver_pool_statusor.ok()) {
+    ais_status->status = receiver_pool_statusor.status();
+    return nullptr;
+  }
+
+  auto ais_receiver_pool = std::make_unique<AIS_ReceiverPool>();
+  ais_receiver_pool->receiver_pool =
+      std::move(receiver_pool_statusor).ValueOrDie();
+  ais_status->status = OkStatus();
+  return ais_receiver_pool.release();
+}
+
+void AIS_DeleteReceiverPool(AIS_ReceiverPool* ais_receiver_pool) {
+  delete ais_receiver_pool;
+}
+
+void AIS_ReceiverPoolAddStream(AIS_ReceiverPool* ais_receiver_pool,
+                               const char* stream_name,
+                               AIS_ReceiverPoolCallback callback,
+                               void* user_data, AIS_Status* ais_status) {
+  ais_status->status = ais_receiver_pool->receiver_pool->AddStream(
+      ToString(stream_name), [callback, user_data](Packet packet) {
+        auto ais_packet = std::make_unique<AIS_Packet>();
+        ais_packet->packet = std::move(packet);
+        if (callback(ais_packet.release(), user_data) != 0) {
+          return CancelledError("The callback stopped receiving");
+        }
+        return OkStatus();
+      });
+}
+
+void AIS_ReceiverPoolRemoveStream(AIS_ReceiverPool* ais_receiver_pool,
+                                  const char* stream_name,
+                                  AIS_Status* ais_status) {
+  ais_status->status =
+      ais_receiver_pool->receiver_pool->RemoveStream(ToString(stream_name));
+}
+
 }  // end extern "C"
@@ -102,9 +102,29 @@ extern AIS_Sender* AIS_NewSender(const AIS_ConnectionOptions* options,
                                  double trace_probability,
                                  AIS_Status* ais_status);
 
+// Return a new packet sender object that sends packets in batches on success
+// and NULL otherwise.
+//
+// Packets are held back until `max_batch_packets` packets or
+// `max_batch_bytes` bytes are batched, or until the oldest has waited for
+// `linger_ms` milliseconds. A `max_batch_bytes` of 0 means no byte limit, and
+// a `linger_ms` of 0 means that packets wait until the batch is full or
+// AIS_FlushSender is called.
+extern AIS_Sender* AIS_NewBatchingSender(const AIS_ConnectionOptions* options,
+                                         const char* stream_name,
+                                         double trace_probability,
+                                         int max_batch_packets,
+                                         size_t max_batch_bytes,
+                                         int linger_ms, AIS_Status* ais_status);
+
 // Delete a packet sender object.
 extern void AIS_DeleteSender(AIS_Sender* ais_sender);
 
+// Send the packets that the packet sender holds back in its current batch.
+//
+// This is a no-op for senders that do not batch.
+extern void AIS_FlushSender(AIS_Sender* ais_sender, AIS_Status* ais_status);
+
 // Send a packet through the packet sender.
 //
 // Typically, you would use one of the packet creaters in ais_packet.h to
@@ -153,6 +173,78 @@ extern void AIS_ReceivePacket(AIS_Receiver* ais_receiver,
                               AIS_Packet* ais_packet, int timeout_in_sec,
                               AIS_Status* ais_status);
 
+// Receive up to `max_packets` packets through the packet receiver at once.
+//
+// This is like AIS_ReceivePacket, except that `ais_packets` is an array of
+// `max_packets` packets to receive into, and the timeout is in milliseconds. It
+// waits up to `timeout_in_ms` for the first packet, then takes the packets
+// that have already arrived, up to `max_packets`. A `timeout_in_ms` of 0 never
+// blocks, and a negative one waits with no timeout.
+//
+// Returns the number of packets received; they are at the front of
+// `ais_packets`. If none arrived in time, the status is DEADLINE_EXCEEDED.
+extern size_t AIS_ReceivePackets(AIS_Receiver* ais_receiver,
+                                 AIS_Packet** ais_packets, size_t max_packets,
+                                 int timeout_in_ms, AIS_Status* ais_status);
+
+// Receive a packet through the packet receiver if one has already arrived.
+//
+// Returns 1 if the packet supplied received a packet and 0 otherwise. This
+// never blocks.
+extern unsigned char AIS_TryReceivePacket(AIS_Receiver* ais_receiver,
+                                          AIS_Packet* ais_packet);
+
+// Return a file descriptor that is readable while the packet receiver holds
+// packets that are ready to be received. Returns -1 on failure.
+//
+// Use it to wait for many receivers in one thread, e.g. with poll, epoll or
+// the event loops of libuv and asyncio, and then receive with
+// AIS_TryReceivePacket or AIS_ReceivePackets without blocking. The descriptor
+// is owned by the receiver; do not read from or close it.
+extern int AIS_ReceiverFd(AIS_Receiver* ais_receiver, AIS_Status* ais_status);
+
+// --------------------------------------------------------------------------
+// Functions to receive packets from many streams on the server.
+
+// Represents a pool of packet receivers that share one connection.
+typedef struct AIS_ReceiverPool AIS_ReceiverPool;
+
+// Called for every packet received from a stream of a receiver pool.
+//
+// The callback takes ownership of `ais_packet` and must delete it. Return 0 to
+// keep receiving from the stream and non-zero to stop.
+typedef int (*AIS_ReceiverPoolCallback)(AIS_Packet* ais_packet,
+                                        void* user_data);
+
+// Return a new receiver pool object. NULL otherwise.
+//
+// `receiver_name`: specifies a name you use to receive from every stream. A
+//                  random name will be generated for you if NULL.
+extern AIS_ReceiverPool* AIS_NewReceiverPool(
+    const AIS_ConnectionOptions* options, const char* receiver_name,
+    AIS_Status* ais_status);
+
+// Delete a receiver pool object. This stops receiving from all of its streams.
+extern void AIS_DeleteReceiverPool(AIS_ReceiverPool* ais_receiver_pool);
+
+// Start receiving from a stream.
+//
+// `callback` is called with `user_data` for every packet of the stream, on a
+// thread owned by the pool. If receiving fails, the callback is given a last
+// EOS packet whose reason tells why.
+extern void AIS_ReceiverPoolAddStream(AIS_ReceiverPool* ais_receiver_pool,
+                                      const char* stream_name,
+                                      AIS_ReceiverPoolCallback callback,
+                                      void* user_data, AIS_Status* ais_status);
+
+// Stop receiving from a stream.
+//
+// This returns once the callback of the stream has returned for the last time,
+// so it must not be called from that callback.
+extern void AIS_ReceiverPoolRemoveStream(AIS_ReceiverPool* ais_receiver_pool,
+                                         const char* stream_name,
+                                         AIS_Status* ais_status);
+
 #ifdef __cplusplus
 }  // end extern "C"
 #endif
@@ -20,6 +20,7 @@
 #include <memory>
 
 #include "aistreams/base/connection_options.h"
+#include "aistreams/base/wrappers/receiver_pool.h"
 #include "aistreams/base/wrappers/receivers.h"
 #include "aistreams/base/wrappers/senders.h"
 #include "aistreams/c/c_api.h"
@@ -37,4 +38,8 @@ struct AIS_Receiver {
       nullptr;
 };
 
+struct AIS_ReceiverPool {
+  std::unique_ptr<aistreams::ReceiverPool> receiver_pool = nullptr;
+};
+
 #endif  // AISTREAMS_C_AIS_C_API_INTERNAL_H_
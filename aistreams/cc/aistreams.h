@@ -18,6 +18,7 @@
 #define AISTREAMS_CC_AISTREAMS_H_
 
 #include "aistreams/cc/aistreams_lite.h"
+#include "aistreams/cc/decode_service.h"
 #include "aistreams/cc/decoded_receivers.h"
 #include "aistreams/cc/ingesters.h"
 
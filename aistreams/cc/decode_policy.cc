@@ -0,0 +1,106 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "aistreams/cc/decode_policy.h"
+
+#include "absl/strings/str_format.h"
+#include "aistreams/port/canonical_errors.h"
+#include "aistreams/port/status.h"
+
+namespace aistreams {
+
+Status ValidateDecodePolicy(const DecodePolicy& policy) {
+  if (policy.every_nth_frame <= 0) {
+    return InvalidArgumentError(
+        absl::StrFormat("Given a non-positive every_nth_frame (%d)",
+                        policy.every_nth_frame));
+  }
+  if (policy.target_frames_per_second < 0) {
+    return InvalidArgumentError(
+        absl::StrFormat("Given a negative target_frames_per_second (%f)",
+                        policy.target_frames_per_second));
+  }
+  return OkStatus();
+}
+
+FrameSampler::FrameSampler(const DecodePolicy& policy) : policy_(policy) {}
+
+FrameSampler::Decision FrameSampler::Sample(bool is_key_frame,
+                                            absl::Time timestamp) {
+  ++frame_index_;
+
+  // A key frame starts a new GOP. Decide whether to decode it.
+  if (is_key_frame) {
+    if (gop_start_index_ >= 0) {
+      last_gop_frames_ = frame_index_ - gop_start_index_;
+      last_gop_duration_ = timestamp - gop_start_time_;
+    }
+    gop_start_index_ = frame_index_;
+    gop_start_time_ = timestamp;
+    is_feeding_gop_ =
+        IsDue(timestamp) ||
+        (!policy_.key_frames_only && IsDueBeforeNextKeyFrame(timestamp));
+  }
+
+  Decision decision;
+  if (!is_feeding_gop_ || (policy_.key_frames_only && !is_key_frame)) {
+    decision.feed = false;
+    decision.deliver = false;
+    return decision;
+  }
+  decision.deliver = IsDue(timestamp);
+  if (decision.deliver) {
+    AdvanceDue(timestamp);
+  }
+  return decision;
+}
+
+bool FrameSampler::IsDue(absl::Time timestamp) const {
+  return frame_index_ >= next_due_index_ && timestamp >= next_due_time_;
+}
+
+// Guesses whether a frame will be due before the next key frame, assuming the
+// current GOP is as long as the last one. Until a whole GOP has been seen,
+// this is assumed to be the case.
+bool FrameSampler::IsDueBeforeNextKeyFrame(absl::Time timestamp) const {
+  if (last_gop_frames_ <= 0) {
+    return true;
+  }
+  return next_due_index_ < frame_index_ + last_gop_frames_ &&
+         next_due_time_ < timestamp + last_gop_duration_;
+}
+
+void FrameSampler::AdvanceDue(absl::Time timestamp) {
+  next_due_index_ = frame_index_ + policy_.every_nth_frame;
+  if (policy_.target_frames_per_second <= 0) {
+    return;
+  }
+
+  // Keep to a steady cadence rather than counting from the delivered frame,
+  // so that jitter in the timestamps does not lower the delivered rate. Start
+  // over after a gap in the stream.
+  absl::Duration interval =
+      absl::Seconds(1 / policy_.target_frames_per_second);
+  if (next_due_time_ == absl::InfinitePast()) {
+    next_due_time_ = timestamp;
+  }
+  next_due_time_ += interval;
+  if (next_due_time_ <= timestamp) {
+    next_due_time_ = timestamp + interval;
+  }
+}
+
+}  // namespace aistreams
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AISTREAMS_CC_DECODE_POLICY_H_
+#define AISTREAMS_CC_DECODE_POLICY_H_
+
+#include <cstdint>
+
+#include "absl/time/time.h"
+#include "aistreams/port/status.h"
+
+namespace aistreams {
+
+// A DecodePolicy decides which frames of a server stream are decoded into
+// RawImages.
+//
+// The default policy decodes and delivers every frame. Consumers that only
+// sample a stream should say so here: frames that are not needed are skipped
+// before they reach the decoder whenever the codec allows it.
+struct DecodePolicy {
+  // If true, only key frames are decoded. All other packets are skipped
+  // before they reach the decoder.
+  bool key_frames_only = false;
+
+  // Only every Nth frame is delivered. 1 delivers every frame.
+  int every_nth_frame = 1;
+
+  // The maximum number of frames delivered per second, measured on the
+  // timestamps of the source packets.
+  //
+  // 0 means unlimited.
+  double target_frames_per_second = 0;
+};
+
+// Returns OK if `policy` is well formed.
+Status ValidateDecodePolicy(const DecodePolicy& policy);
+
+// A FrameSampler applies a DecodePolicy to a stream one frame at a time.
+//
+// A delta frame can only be decoded after the frames it references, so frames
+// are skipped at the granularity of a group of pictures (GOP): a GOP is fed to
+// the decoder only if a frame due for delivery may fall into it, judging by
+// the length of the previous GOP. Frames of a fed GOP that are not due are
+// decoded but not delivered. Intra-only streams, where every frame is a key
+// frame, therefore only ever decode the frames they deliver.
+class FrameSampler {
+ public:
+  // The fate of a single frame.
+  struct Decision {
+    // Whether the frame should be fed to the decoder.
+    bool feed = true;
+
+    // Whether the decoded frame should be delivered to the consumer.
+    bool deliver = true;
+  };
+
+  explicit FrameSampler(const DecodePolicy& policy);
+
+  // Decide the fate of the next frame of the stream.
+  Decision Sample(bool is_key_frame, absl::Time timestamp);
+
+ private:
+  bool IsDue(absl::Time timestamp) const;
+  bool IsDueBeforeNextKeyFrame(absl::Time timestamp) const;
+  void AdvanceDue(absl::Time timestamp);
+
+  DecodePolicy policy_;
+
+  int64_t frame_index_ = -1;
+  int64_t next_due_index_ = 0;
+  absl::Time next_due_time_ = absl::InfinitePast();
+
+  // Whether the current GOP is being fed to the decoder.
+  bool is_feeding_gop_ = true;
+  int64_t gop_start_index_ = -1;
+  absl::Time gop_start_time_;
+  int64_t last_gop_frames_ = 0;
+  absl::Duration last_gop_duration_;
+};
+
+}  // namespace aistreams
+
+#endif  // AISTREAMS_CC_DECODE_POLICY_H_
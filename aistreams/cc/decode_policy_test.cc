@@ -0,0 +1,92 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/cc/decode_policy.h"
+
+#include <string>
+
+#include "absl/time/time.h"
+#include "aistreams/port/gtest.h"
+
+namespace aistreams {
+
+namespace {
+
+// Samples `num_frames` frames at `fps`, with a key frame every `gop_size`
+// frames. Returns one character per frame: 'd' if it is delivered, 'f' if it
+// is only fed to the decoder, and '.' if it is skipped.
+std::string SampleStream(const DecodePolicy& policy, int num_frames, int fps,
+                         int gop_size) {
+  FrameSampler sampler(policy);
+  std::string fates;
+  for (int i = 0; i < num_frames; ++i) {
+    auto decision = sampler.Sample(i % gop_size == 0,
+                                   absl::UnixEpoch() + absl::Seconds(i) / fps);
+    fates += decision.deliver ? 'd' : (decision.feed ? 'f' : '.');
+  }
+  return fates;
+}
+
+}  // namespace
+
+TEST(DecodePolicyTest, ValidateTest) {
+  DecodePolicy policy;
+  EXPECT_TRUE(ValidateDecodePolicy(policy).ok());
+  policy.every_nth_frame = 0;
+  EXPECT_FALSE(ValidateDecodePolicy(policy).ok());
+  policy.every_nth_frame = 1;
+  policy.target_frames_per_second = -1;
+  EXPECT_FALSE(ValidateDecodePolicy(policy).ok());
+}
+
+TEST(FrameSamplerTest, DefaultPolicyTest) {
+  DecodePolicy policy;
+  EXPECT_EQ(SampleStream(policy, 8, 30, 4), "dddddddd");
+}
+
+TEST(FrameSamplerTest, KeyFramesOnlyTest) {
+  DecodePolicy policy;
+  policy.key_frames_only = true;
+  EXPECT_EQ(SampleStream(policy, 8, 30, 4), "d...d...");
+
+  policy.every_nth_frame = 8;
+  EXPECT_EQ(SampleStream(policy, 16, 30, 4), "d.......d.......");
+}
+
+TEST(FrameSamplerTest, EveryNthFrameIntraOnlyTest) {
+  DecodePolicy policy;
+  policy.every_nth_frame = 3;
+  EXPECT_EQ(SampleStream(policy, 9, 30, 1), "d..d..d..");
+}
+
+TEST(FrameSamplerTest, EveryNthFrameTest) {
+  DecodePolicy policy;
+  policy.every_nth_frame = 2;
+  EXPECT_EQ(SampleStream(policy, 8, 30, 4), "dfdfdfdf");
+
+  // GOPs without a due frame are skipped once the GOP length is known.
+  policy.every_nth_frame = 8;
+  EXPECT_EQ(SampleStream(policy, 16, 30, 2), "df......df......");
+}
+
+TEST(FrameSamplerTest, TargetFramesPerSecondTest) {
+  DecodePolicy policy;
+  policy.target_frames_per_second = 10;
+  EXPECT_EQ(SampleStream(policy, 9, 30, 1), "d..d..d..");
+
+  policy.target_frames_per_second = 1;
+  EXPECT_EQ(SampleStream(policy, 8, 4, 2), "df..df..");
+}
+
+}  // namespace aistreams
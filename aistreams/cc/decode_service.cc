@@ -0,0 +1,328 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "aistreams/cc/decode_service.h"
+
+#include <algorithm>
+#include <string>
+
+#include "absl/strings/str_format.h"
+#include "aistreams/cc/image_producer.h"
+#include "aistreams/port/canonical_errors.h"
+#include "aistreams/port/logging.h"
+#include "aistreams/port/status.h"
+#include "aistreams/port/status_macros.h"
+#include "aistreams/port/statusor.h"
+
+namespace aistreams {
+
+namespace {
+
+// The maximum number of source packets fed in one turn of a stream.
+constexpr int kPacketsPerTurn = 8;
+
+// How long a stream that had no source packets, or no room for EOS, is left
+// alone.
+constexpr int kIdlePollPeriodMs = 5;
+
+// How long consumers are given to make room for EOS on shutdown.
+constexpr int kShutdownEosTimeoutSeconds = 1;
+
+// Tries to deliver EOS to the consumer of an ended stream without waiting, so
+// that a consumer that is not popping cannot hold up a worker.
+//
+// Returns false if the stream must stay to retry later.
+bool TryFinishStream(ImageProducer* image_producer,
+                     const std::string& termination_message) {
+  auto status = image_producer->TryFinish(termination_message);
+  if (status.code() == StatusCode::kUnavailable) {
+    return false;
+  }
+  if (!status.ok()) {
+    LOG(ERROR) << status;
+  }
+  return true;
+}
+
+}  // namespace
+
+// A stream, as scheduled by the workers.
+//
+// Streams are served by stride scheduling: the idle stream with the smallest
+// pass is served next, and its pass then advances by the frames it was fed
+// divided by its priority.
+//
+// A stream that has ended stays until its consumer has room for EOS; its turns
+// then only retry delivering EOS.
+struct DecodeService::Stream {
+  std::unique_ptr<ImageProducer> image_producer;
+  int priority = 1;
+  double pass = 0;
+  absl::Time next_poll_time = absl::InfinitePast();
+  bool is_busy = false;
+  bool is_ending = false;
+  std::string termination_message;
+};
+
+DecodeService::DecodeService(const Options& options) : options_(options) {}
+
+StatusOr<std::unique_ptr<DecodeService>> DecodeService::Create(
+    const Options& options) {
+  if (options.num_workers <= 0) {
+    return InvalidArgumentError(
+        absl::StrFormat("Given a non-positive number of workers (%d)",
+                        options.num_workers));
+  }
+  if (options.max_frames_per_second < 0) {
+    return InvalidArgumentError(
+        absl::StrFormat("Given a negative frames per second budget (%f)",
+                        options.max_frames_per_second));
+  }
+  auto decode_service = std::make_unique<DecodeService>(options);
+  decode_service->Initialize();
+  return decode_service;
+}
+
+void DecodeService::Initialize() {
+  {
+    absl::MutexLock lock(&mu_);
+    frame_budget_ = std::max(1.0, options_.max_frames_per_second);
+    frame_budget_time_ = absl::Now();
+  }
+  for (int i = 0; i < options_.num_workers; ++i) {
+    workers_.emplace_back([this]() { WorkerLoop(); });
+  }
+}
+
+DecodeService::~DecodeService() {
+  // The workers finish the remaining streams on their way out. Bound how long
+  // each waits for its consumer, including those that are finishing already.
+  {
+    absl::MutexLock lock(&mu_);
+    is_shutting_down_ = true;
+    absl::Time eos_deadline =
+        absl::Now() + absl::Seconds(kShutdownEosTimeoutSeconds);
+    for (const auto& stream : streams_) {
+      stream->image_producer->SetEosDeadline(eos_deadline);
+    }
+    cv_.SignalAll();
+  }
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+Status DecodeService::AddStream(const StreamOptions& options,
+                                ReceiverQueue<Packet>* receiver_queue) {
+  if (options.priority <= 0) {
+    return InvalidArgumentError(absl::StrFormat(
+        "Given a non-positive stream priority (%d)", options.priority));
+  }
+  if (options.queue_size <= 0) {
+    return InvalidArgumentError(absl::StrFormat(
+        "Given a non-positive queue size (%d)", options.queue_size));
+  }
+  if (receiver_queue == nullptr) {
+    return InvalidArgumentError("Given a nullptr to the receiver queue");
+  }
+
+  // Create a receiver queue that gets source packets from the stream server.
+  auto src_packet_receiver_queue = std::make_unique<ReceiverQueue<Packet>>();
+  auto status = MakePacketReceiverQueue(options.receiver_options,
+                                        src_packet_receiver_queue.get());
+  if (!status.ok()) {
+    LOG(ERROR) << status;
+    return UnknownError("Failed to create the source packet receiver queue");
+  }
+
+  // Create the ImageProducer, sharing its output with the caller.
+  auto packetized_image_pcqueue =
+      std::make_shared<ProducerConsumerQueue<Packet>>(options.queue_size);
+  *receiver_queue = ReceiverQueue<Packet>(packetized_image_pcqueue);
+  ImageProducer::Options image_producer_options;
+  image_producer_options.timeout = options.timeout;
+  image_producer_options.source_packet_queue =
+      std::move(src_packet_receiver_queue);
+  image_producer_options.dest_image_packet_pcqueue =
+      std::move(packetized_image_pcqueue);
+  image_producer_options.decode_policy = options.decode_policy;
+  auto image_producer_statusor =
+      ImageProducer::Create(std::move(image_producer_options));
+  if (!image_producer_statusor.ok()) {
+    return image_producer_statusor.status();
+  }
+
+  // Hand the stream over to the workers.
+  auto stream = std::make_shared<Stream>();
+  stream->image_producer = std::move(image_producer_statusor).ValueOrDie();
+  stream->priority = options.priority;
+  absl::MutexLock lock(&mu_);
+  if (is_shutting_down_) {
+    return FailedPreconditionError("The decode service is shutting down");
+  }
+  stream->pass = virtual_time_;
+  streams_.push_back(std::move(stream));
+  cv_.SignalAll();
+  return OkStatus();
+}
+
+int DecodeService::NumStreams() {
+  absl::MutexLock lock(&mu_);
+  return streams_.size();
+}
+
+// Returns true if at least one frame may be fed.
+bool DecodeService::RefillFrameBudget(absl::Time now) {
+  if (options_.max_frames_per_second <= 0) {
+    return true;
+  }
+  double capacity = std::max(1.0, options_.max_frames_per_second);
+  double elapsed_seconds = absl::ToDoubleSeconds(now - frame_budget_time_);
+  frame_budget_ = std::min(
+      capacity,
+      frame_budget_ + elapsed_seconds * options_.max_frames_per_second);
+  frame_budget_time_ = now;
+  return frame_budget_ > 0;
+}
+
+// Blocks until a stream is due to be served and marks it busy.
+//
+// Returns nullptr once the service is shutting down.
+std::shared_ptr<DecodeService::Stream> DecodeService::AcquireStream() {
+  absl::MutexLock lock(&mu_);
+  while (!is_shutting_down_) {
+    absl::Time now = absl::Now();
+    absl::Time wake_time = absl::InfiniteFuture();
+    std::shared_ptr<Stream> next_stream = nullptr;
+    if (RefillFrameBudget(now)) {
+      for (const auto& stream : streams_) {
+        if (stream->is_busy) {
+          continue;
+        }
+        if (stream->next_poll_time > now) {
+          wake_time = std::min(wake_time, stream->next_poll_time);
+          continue;
+        }
+        if (next_stream == nullptr || stream->pass < next_stream->pass) {
+          next_stream = stream;
+        }
+      }
+    } else {
+      wake_time = now + absl::Seconds((1 - frame_budget_) /
+                                      options_.max_frames_per_second);
+    }
+    if (next_stream != nullptr) {
+      next_stream->is_busy = true;
+      virtual_time_ = next_stream->pass;
+      return next_stream;
+    }
+    cv_.WaitWithDeadline(&mu_, wake_time);
+  }
+  return nullptr;
+}
+
+void DecodeService::ReleaseStream(const std::shared_ptr<Stream>& stream,
+                                  int frames_fed, bool is_idle,
+                                  bool has_ended) {
+  absl::MutexLock lock(&mu_);
+  stream->is_busy = false;
+  if (options_.max_frames_per_second > 0) {
+    frame_budget_ -= frames_fed;
+  }
+  stream->pass += static_cast<double>(frames_fed) / stream->priority;
+  if (is_idle) {
+    // Do not let a stream bank turns while it has nothing to decode.
+    stream->pass = std::max(stream->pass, virtual_time_);
+    stream->next_poll_time =
+        absl::Now() + absl::Milliseconds(kIdlePollPeriodMs);
+  }
+  if (has_ended) {
+    streams_.erase(std::remove(streams_.begin(), streams_.end(), stream),
+                   streams_.end());
+  }
+  cv_.SignalAll();
+}
+
+// Finishes the streams that no worker is serving until none are left.
+//
+// A stream that is being served is left to its worker, which comes here once
+// it has released the stream.
+void DecodeService::FinishRemainingStreams() {
+  while (true) {
+    std::shared_ptr<Stream> stream = nullptr;
+    {
+      absl::MutexLock lock(&mu_);
+      auto it = std::find_if(
+          streams_.begin(), streams_.end(),
+          [](const std::shared_ptr<Stream>& s) { return !s->is_busy; });
+      if (it == streams_.end()) {
+        return;
+      }
+      stream = std::move(*it);
+      streams_.erase(it);
+    }
+    auto status = stream->image_producer->Finish(
+        stream->is_ending ? stream->termination_message
+                          : "The decode service has shut down");
+    if (!status.ok()) {
+      LOG(ERROR) << status;
+    }
+  }
+}
+
+void DecodeService::WorkerLoop() {
+  for (auto stream = AcquireStream(); stream != nullptr;
+       stream = AcquireStream()) {
+    if (stream->is_ending) {
+      bool has_ended = TryFinishStream(stream->image_producer.get(),
+                                       stream->termination_message);
+      ReleaseStream(stream, 0, /*is_idle=*/!has_ended, has_ended);
+      continue;
+    }
+
+    int frames_fed = 0;
+    bool is_idle = false;
+    bool has_ended = false;
+    std::string termination_message;
+    for (int i = 0; i < kPacketsPerTurn && !is_idle && !has_ended; ++i) {
+      switch (stream->image_producer->Step(&termination_message)) {
+        case ImageProducer::StepResult::kFedFrameHead:
+          ++frames_fed;
+          break;
+        case ImageProducer::StepResult::kFedPacket:
+        case ImageProducer::StepResult::kSkippedPacket:
+          break;
+        case ImageProducer::StepResult::kIdle:
+          is_idle = true;
+          break;
+        case ImageProducer::StepResult::kEnded:
+          has_ended = true;
+          break;
+      }
+    }
+    if (has_ended) {
+      stream->is_ending = true;
+      stream->termination_message = termination_message;
+      has_ended = TryFinishStream(stream->image_producer.get(),
+                                  termination_message);
+      is_idle = !has_ended;
+    }
+    ReleaseStream(stream, frames_fed, is_idle, has_ended);
+  }
+  FinishRemainingStreams();
+}
+
+}  // namespace aistreams
@@ -0,0 +1,143 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AISTREAMS_CC_DECODE_SERVICE_H_
+#define AISTREAMS_CC_DECODE_SERVICE_H_
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "aistreams/cc/aistreams_lite.h"
+#include "aistreams/cc/decode_policy.h"
+#include "aistreams/port/status.h"
+#include "aistreams/port/statusor.h"
+
+namespace aistreams {
+
+// A DecodeService decodes many server streams into RawImage Packets with a
+// fixed pool of worker threads.
+//
+// Each added stream is delivered through a ReceiverQueue just like those made
+// by MakeDecodedReceiverQueue. Rather than dedicating a thread to each stream,
+// the workers take turns feeding the decoders of the streams that have source
+// packets available:
+// + Streams are served in proportion to their priority, so a busy stream
+//   cannot starve the others.
+// + The total number of frames fed per second over all streams can be capped
+//   to bound the CPU spent on decoding.
+//
+// A stream that is not served as fast as its packets arrive falls behind in
+// its source queue rather than dropping frames.
+class DecodeService {
+ public:
+  // Options to configure the DecodeService.
+  struct Options {
+    // The number of worker threads that feed the decoders.
+    int num_workers = 4;
+
+    // The maximum number of frames fed for decoding per second, summed over
+    // all streams.
+    //
+    // 0 means unlimited.
+    double max_frames_per_second = 0;
+  };
+
+  // Options to configure each decoded stream.
+  struct StreamOptions {
+    // Options of the source stream.
+    ReceiverOptions receiver_options;
+
+    // The size of the receiver queue to create.
+    int queue_size = 10;
+
+    // The amount of time within which the server must yield a new source
+    // Packet. If this expires, the receiver queue is given an EOS packet.
+    absl::Duration timeout = absl::Seconds(10);
+
+    // The relative share of decoding this stream gets when it competes with
+    // others; e.g. a stream of priority 2 is fed twice as many frames as a
+    // stream of priority 1. This must be positive.
+    int priority = 1;
+
+    // Selects the frames of this stream to decode.
+    DecodePolicy decode_policy;
+  };
+
+  // Create a DecodeService with its workers running.
+  static StatusOr<std::unique_ptr<DecodeService>> Create(const Options&);
+
+  // Start decoding the stream specified in `options` into `receiver_queue`.
+  //
+  // Like MakeDecodedReceiverQueue, this waits for the first packet of the
+  // stream to learn whether it is decodable, decoded RawImages are dropped
+  // when `receiver_queue` is full, and an EOS packet is delivered when the
+  // stream ends. Releasing `receiver_queue` removes the stream.
+  //
+  // An ended stream stays until its consumer makes room for EOS, but the
+  // workers never wait for it meanwhile.
+  Status AddStream(const StreamOptions& options,
+                   ReceiverQueue<Packet>* receiver_queue);
+
+  // Returns the number of streams being decoded.
+  int NumStreams();
+
+  // Copy-control members. Use Create() rather than the constructors.
+  //
+  // The destructor stops the workers and delivers EOS to the remaining
+  // streams. Streams are finished in parallel by the workers, and EOS is
+  // dropped for consumers that do not make room for it within a second.
+  explicit DecodeService(const Options&);
+  ~DecodeService();
+  DecodeService() = delete;
+  DecodeService(const DecodeService&) = delete;
+  DecodeService& operator=(const DecodeService&) = delete;
+  DecodeService(DecodeService&&) = delete;
+  DecodeService& operator=(DecodeService&&) = delete;
+
+ private:
+  struct Stream;
+
+  void Initialize();
+  void WorkerLoop();
+  std::shared_ptr<Stream> AcquireStream();
+  void FinishRemainingStreams();
+  void ReleaseStream(const std::shared_ptr<Stream>& stream, int frames_fed,
+                     bool is_idle, bool has_ended);
+  bool RefillFrameBudget(absl::Time now) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  Options options_;
+
+  absl::Mutex mu_;
+  absl::CondVar cv_;
+  bool is_shutting_down_ ABSL_GUARDED_BY(mu_) = false;
+  std::vector<std::shared_ptr<Stream>> streams_ ABSL_GUARDED_BY(mu_);
+
+  // The pass of the most recently served stream. New streams start here.
+  double virtual_time_ ABSL_GUARDED_BY(mu_) = 0;
+
+  // Frames that may be fed before waiting on max_frames_per_second.
+  double frame_budget_ ABSL_GUARDED_BY(mu_) = 0;
+  absl::Time frame_budget_time_ ABSL_GUARDED_BY(mu_);
+
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace aistreams
+
+#endif  // AISTREAMS_CC_DECODE_SERVICE_H_
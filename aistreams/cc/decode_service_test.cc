@@ -0,0 +1,231 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/cc/decode_service.h"
+
+#include <poll.h>
+
+#include <memory>
+#include <string>
+
+#include "absl/strings/str_cat.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "aistreams/base/types/jpeg_frame.h"
+#include "aistreams/cc/aistreams_lite.h"
+#include "aistreams/port/gtest.h"
+#include "aistreams/port/status.h"
+#include "aistreams/server/local_stream_server.h"
+#include "aistreams/util/file_helpers.h"
+
+namespace aistreams {
+
+namespace {
+
+constexpr char kTestImageLenaPath[] = "testdata/jpegs/lena_color.jpg";
+
+class DecodeServiceTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    server_ = LocalStreamServer::Create(LocalStreamServer::Options())
+                  .ValueOrDie();
+    ASSERT_TRUE(file::GetContents(kTestImageLenaPath, &jpeg_bytes_).ok());
+  }
+
+  ConnectionOptions MakeConnectionOptions() const {
+    ConnectionOptions options;
+    options.target_address = server_->target_address();
+    options.ssl_options.use_insecure_channel = true;
+    return options;
+  }
+
+  // Sends `count` jpeg frames to `stream_name`, followed by EOS if `send_eos`.
+  void SendJpegs(const std::string& stream_name, int count, bool send_eos) {
+    SenderOptions options;
+    options.connection_options = MakeConnectionOptions();
+    options.stream_name = stream_name;
+    std::unique_ptr<PacketSender> sender;
+    ASSERT_TRUE(MakePacketSender(options, &sender).ok());
+    for (int i = 0; i < count; ++i) {
+      ASSERT_TRUE(
+          sender->Send(MakePacket(JpegFrame(jpeg_bytes_)).ValueOrDie()).ok());
+    }
+    if (send_eos) {
+      ASSERT_TRUE(sender->Send(MakeEosPacket("done").ValueOrDie()).ok());
+    }
+  }
+
+  DecodeService::StreamOptions MakeStreamOptions(
+      const std::string& stream_name, int queue_size) const {
+    DecodeService::StreamOptions options;
+    options.receiver_options.connection_options = MakeConnectionOptions();
+    options.receiver_options.stream_name = stream_name;
+    options.receiver_options.offset_options.reset_offset = true;
+    options.receiver_options.offset_options.offset_position =
+        OffsetOptions::SpecialOffset::kOffsetBeginning;
+    options.queue_size = queue_size;
+    return options;
+  }
+
+  std::unique_ptr<LocalStreamServer> server_;
+  std::string jpeg_bytes_;
+};
+
+// Pops packets until EOS and returns the number of images before it, or -1 if
+// EOS does not arrive.
+int CountImagesUntilEos(ReceiverQueue<Packet>* receiver_queue) {
+  int count = 0;
+  Packet packet;
+  while (receiver_queue->TryPop(packet, absl::Seconds(10))) {
+    if (IsEos(packet)) {
+      return count;
+    }
+    ++count;
+  }
+  return -1;
+}
+
+// Blocks until `receiver_queue` has a packet waiting.
+bool AwaitPacket(ReceiverQueue<Packet>* receiver_queue) {
+  struct pollfd fd = {receiver_queue->ReadinessFd(), POLLIN, 0};
+  return poll(&fd, 1, absl::ToInt64Milliseconds(absl::Seconds(10))) == 1;
+}
+
+TEST_F(DecodeServiceTest, DecodesManyStreams) {
+  constexpr int kNumStreams = 3;
+  constexpr int kNumFrames = 5;
+  for (int i = 0; i < kNumStreams; ++i) {
+    SendJpegs(absl::StrCat("stream-", i), kNumFrames, /*send_eos=*/true);
+  }
+
+  DecodeService::Options options;
+  options.num_workers = 2;
+  auto decode_service = DecodeService::Create(options).ValueOrDie();
+  ReceiverQueue<Packet> receiver_queues[kNumStreams];
+  for (int i = 0; i < kNumStreams; ++i) {
+    ASSERT_TRUE(decode_service
+                    ->AddStream(MakeStreamOptions(absl::StrCat("stream-", i),
+                                                  kNumFrames + 1),
+                                &receiver_queues[i])
+                    .ok());
+  }
+  for (int i = 0; i < kNumStreams; ++i) {
+    EXPECT_EQ(CountImagesUntilEos(&receiver_queues[i]), kNumFrames);
+  }
+}
+
+TEST_F(DecodeServiceTest, ReleasedConsumerRemovesStream) {
+  SendJpegs("stream", 1, /*send_eos=*/false);
+
+  auto decode_service =
+      DecodeService::Create(DecodeService::Options()).ValueOrDie();
+  {
+    ReceiverQueue<Packet> receiver_queue;
+    ASSERT_TRUE(decode_service
+                    ->AddStream(MakeStreamOptions("stream", 1), &receiver_queue)
+                    .ok());
+    EXPECT_EQ(decode_service->NumStreams(), 1);
+  }
+  absl::Time deadline = absl::Now() + absl::Seconds(10);
+  while (decode_service->NumStreams() > 0 && absl::Now() < deadline) {
+    absl::SleepFor(absl::Milliseconds(10));
+  }
+  EXPECT_EQ(decode_service->NumStreams(), 0);
+}
+
+TEST_F(DecodeServiceTest, ShutdownIsNotHeldUpBySlowConsumer) {
+  SendJpegs("slow-stream", 2, /*send_eos=*/false);
+  SendJpegs("stream", 1, /*send_eos=*/false);
+
+  auto decode_service =
+      DecodeService::Create(DecodeService::Options()).ValueOrDie();
+
+  // The slow consumer never makes room after its queue fills up.
+  ReceiverQueue<Packet> slow_receiver_queue;
+  ASSERT_TRUE(decode_service
+                  ->AddStream(MakeStreamOptions("slow-stream", 1),
+                              &slow_receiver_queue)
+                  .ok());
+  ReceiverQueue<Packet> receiver_queue;
+  ASSERT_TRUE(decode_service
+                  ->AddStream(MakeStreamOptions("stream", 10), &receiver_queue)
+                  .ok());
+  ASSERT_TRUE(AwaitPacket(&slow_receiver_queue));
+  ASSERT_TRUE(AwaitPacket(&receiver_queue));
+
+  absl::Time start_time = absl::Now();
+  decode_service.reset();
+  EXPECT_LT(absl::Now() - start_time, absl::Seconds(15));
+
+  // The other consumer still gets EOS; the slow one only its image.
+  EXPECT_EQ(CountImagesUntilEos(&receiver_queue), 1);
+  Packet packet;
+  ASSERT_TRUE(slow_receiver_queue.TryPop(packet, absl::ZeroDuration()));
+  EXPECT_FALSE(IsEos(packet));
+  EXPECT_FALSE(slow_receiver_queue.TryPop(packet, absl::ZeroDuration()));
+}
+
+TEST_F(DecodeServiceTest, StalledConsumerOfEndedStreamDoesNotHoldUpOthers) {
+  SendJpegs("stalled-stream", 2, /*send_eos=*/true);
+
+  // A single worker, so that nothing is decoded while it waits for EOS room.
+  DecodeService::Options options;
+  options.num_workers = 1;
+  auto decode_service = DecodeService::Create(options).ValueOrDie();
+
+  // The stalled consumer's queue fills up before its stream ends.
+  ReceiverQueue<Packet> stalled_receiver_queue;
+  ASSERT_TRUE(decode_service
+                  ->AddStream(MakeStreamOptions("stalled-stream", 1),
+                              &stalled_receiver_queue)
+                  .ok());
+  ASSERT_TRUE(AwaitPacket(&stalled_receiver_queue));
+
+  // Another stream is still decoded meanwhile.
+  constexpr int kNumFrames = 3;
+  SendJpegs("stream", kNumFrames, /*send_eos=*/true);
+  ReceiverQueue<Packet> receiver_queue;
+  ASSERT_TRUE(decode_service
+                  ->AddStream(MakeStreamOptions("stream", kNumFrames + 1),
+                              &receiver_queue)
+                  .ok());
+  EXPECT_EQ(CountImagesUntilEos(&receiver_queue), kNumFrames);
+
+  // EOS reaches the stalled consumer once it makes room.
+  int num_images = CountImagesUntilEos(&stalled_receiver_queue);
+  EXPECT_GE(num_images, 1);
+  EXPECT_LE(num_images, 2);
+  absl::Time deadline = absl::Now() + absl::Seconds(10);
+  while (decode_service->NumStreams() > 0 && absl::Now() < deadline) {
+    absl::SleepFor(absl::Milliseconds(10));
+  }
+  EXPECT_EQ(decode_service->NumStreams(), 0);
+}
+
+TEST_F(DecodeServiceTest, RejectsInvalidOptions) {
+  DecodeService::Options options;
+  options.num_workers = 0;
+  EXPECT_FALSE(DecodeService::Create(options).ok());
+
+  auto decode_service =
+      DecodeService::Create(DecodeService::Options()).ValueOrDie();
+  ReceiverQueue<Packet> receiver_queue;
+  auto stream_options = MakeStreamOptions("stream", 1);
+  stream_options.priority = 0;
+  EXPECT_FALSE(decode_service->AddStream(stream_options, &receiver_queue).ok());
+}
+
+}  // namespace
+
+}  // namespace aistreams
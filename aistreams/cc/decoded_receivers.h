@@ -20,6 +20,7 @@
 
 #include "absl/time/time.h"
 #include "aistreams/cc/aistreams_lite.h"
+#include "aistreams/cc/decode_policy.h"
 #include "aistreams/port/status.h"
 #include "aistreams/port/statusor.h"
 
@@ -45,6 +46,15 @@ Status MakeDecodedReceiverQueue(const ReceiverOptions& options, int queue_size,
                                 absl::Duration timeout,
                                 ReceiverQueue<Packet>* receiver_queue);
 
+// Same as above, but only decodes the frames selected by `decode_policy`.
+//
+// This is much cheaper for consumers that only sample the stream; e.g. those
+// that only need one frame per second.
+Status MakeDecodedReceiverQueue(const ReceiverOptions& options,
+                                const DecodePolicy& decode_policy,
+                                int queue_size, absl::Duration timeout,
+                                ReceiverQueue<Packet>* receiver_queue);
+
 }  // namespace aistreams
 
 #endif  // AISTREAMS_CC_DECODED_RECEIVERS_H_
@@ -0,0 +1,430 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "aistreams/cc/image_producer.h"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <utility>
+
+#include "absl/strings/str_format.h"
+#include "aistreams/base/packet_flags.h"
+#include "aistreams/gstreamer/type_utils.h"
+#include "aistreams/port/canonical_errors.h"
+#include "aistreams/port/logging.h"
+#include "aistreams/port/status.h"
+#include "aistreams/port/status_macros.h"
+#include "aistreams/port/statusor.h"
+
+namespace aistreams {
+
+namespace {
+
+constexpr int kRetrySeconds = 1;
+
+// The PTS distance between frames whose offsets are one apart. Any positive
+// value would do, since PTS are only used to tag frames.
+constexpr int64_t kNanosecondsPerOffset = 1000000;
+
+// How far a decoder may reorder frames. This covers the largest H.264 decoded
+// picture buffer.
+constexpr size_t kMaxReorderDepth = 16;
+
+// Returns the time of a packet, or now if it carries no timestamp.
+absl::Time PacketTime(const Packet& packet) {
+  const auto& timestamp = packet.header().timestamp();
+  if (timestamp.seconds() == 0 && timestamp.nanos() == 0) {
+    return absl::Now();
+  }
+  return absl::FromUnixSeconds(timestamp.seconds()) +
+         absl::Nanoseconds(timestamp.nanos());
+}
+
+}  // namespace
+
+PendingFrames::PendingFrames(size_t capacity, size_t max_reorder_depth)
+    : capacity_(capacity), max_reorder_depth_(max_reorder_depth) {}
+
+void PendingFrames::Add(int64_t tag, Frame frame) {
+  absl::MutexLock lock(&mu_);
+  if (capacity_ > 0 && frames_.size() >= capacity_) {
+    LOG(WARNING) << "Too many frames are awaiting decoding. Discarding the "
+                    "header of the oldest.";
+    frames_.erase(frames_.begin());
+  }
+  frames_[tag] = std::make_pair(num_added_++, std::move(frame));
+}
+
+bool PendingFrames::Take(int64_t tag, Frame* frame) {
+  absl::MutexLock lock(&mu_);
+  auto it = frames_.find(tag);
+  if (it == frames_.end()) {
+    return false;
+  }
+  int64_t order = it->second.first;
+  *frame = std::move(it->second.second);
+  frames_.erase(it);
+
+  // Frames too far behind this one will not come out of the decoder anymore.
+  int64_t min_order = order - static_cast<int64_t>(max_reorder_depth_);
+  while (!frames_.empty() && frames_.begin()->second.first < min_order) {
+    frames_.erase(frames_.begin());
+  }
+  return true;
+}
+
+size_t PendingFrames::size() {
+  absl::MutexLock lock(&mu_);
+  return frames_.size();
+}
+
+StatusOr<std::unique_ptr<ImageProducer>> ImageProducer::Create(
+    Options&& options) {
+  auto status = ValidateDecodePolicy(options.decode_policy);
+  if (!status.ok()) {
+    LOG(ERROR) << status;
+    return InvalidArgumentError("Given an invalid decode policy");
+  }
+  auto image_producer = std::make_unique<ImageProducer>(std::move(options));
+  status = image_producer->Initialize();
+  if (!status.ok()) {
+    return status;
+  }
+  return image_producer;
+}
+
+ImageProducer::ImageProducer(Options&& options)
+    : timeout_(options.timeout),
+      source_packet_queue_(std::move(options.source_packet_queue)),
+      dest_image_packet_pcqueue_(std::move(options.dest_image_packet_pcqueue)),
+      frame_sampler_(options.decode_policy),
+      // Bound the frames awaiting decoding as the header queue used to.
+      pending_frames_(source_packet_queue_->capacity(), kMaxReorderDepth) {}
+
+Status ImageProducer::Initialize() {
+  // We pull the first packet from the source stream and determine whether it
+  // has the correct Packet type to even be decodable.
+  auto first_packet_statusor = PullSourcePacket();
+  if (!first_packet_statusor.ok()) {
+    LOG(ERROR) << first_packet_statusor.status();
+    return UnavailableError("Unable to get the first packet from the server");
+  }
+
+  auto first_packet = std::move(first_packet_statusor).ValueOrDie();
+  bool feed_first_packet = AdmitPacket(first_packet);
+  auto first_gstreamer_buffer_statusor =
+      ToGstreamerBuffer(std::move(first_packet));
+  if (!first_gstreamer_buffer_statusor.ok()) {
+    LOG(ERROR) << first_gstreamer_buffer_statusor.status();
+    return InvalidArgumentError(
+        "Given a server stream that cannot be interpretted/decoded as a "
+        "sequence of raw images");
+  }
+  auto first_gstreamer_buffer =
+      std::move(first_gstreamer_buffer_statusor).ValueOrDie();
+  first_gstreamer_buffer.set_pts(frame_pts_);
+
+  // The packet stream type give by the caller is valid. Proceed to create a
+  // GstreamerRawImageYielder to manage/run a raw image decoding pipeline.
+  GstreamerRawImageYielder::Options yielder_options;
+  yielder_options.caps_string = first_gstreamer_buffer.get_caps();
+  yielder_options.callback_with_pts =
+      std::bind(&ImageProducer::PushImagePacket, this, std::placeholders::_1,
+                std::placeholders::_2);
+  auto yielder_statusor = GstreamerRawImageYielder::Create(yielder_options);
+  if (!yielder_statusor.ok()) {
+    LOG(ERROR) << yielder_statusor.status();
+    return InternalError("Unable to create a GstreamerRawImageYielder");
+  }
+  yielder_ = std::move(yielder_statusor).ValueOrDie();
+
+  // Remember to feed the first packet (othewise it will be dropped).
+  if (!feed_first_packet) {
+    return OkStatus();
+  }
+  auto status = yielder_->Feed(std::move(first_gstreamer_buffer));
+  if (!status.ok()) {
+    LOG(ERROR) << status;
+    return InternalError(
+        "Unable to successfully feed the first gstreamer buffer");
+  }
+  return OkStatus();
+}
+
+// Helper to pull a single packet from the source packet stream.
+StatusOr<Packet> ImageProducer::PullSourcePacket() {
+  Packet p;
+  if (!source_packet_queue_->TryPop(p, timeout_)) {
+    return UnavailableError(
+        absl::StrFormat("The server has not yielded any source packets "
+                        "within the timeout (%s)",
+                        absl::FormatDuration(timeout_)));
+  }
+  last_source_packet_time_ = absl::Now();
+  return p;
+}
+
+// Callback used to receive a decoded image from gstreamer.
+//
+// It will form a RawImage Packet from the decoded image and move it into the
+// output image receiver queue.
+Status ImageProducer::PushImagePacket(StatusOr<RawImage> raw_image_statusor,
+                                      int64_t pts) {
+  if (!raw_image_statusor.ok()) {
+    // We will detect/push EOS packets separately in Work().
+    if (IsResourceExhausted(raw_image_statusor.status())) {
+      return OkStatus();
+    } else {
+      LOG(ERROR) << raw_image_statusor.status();
+      return InternalError(
+          "Got an unexpected error from the given StatusOr<RawImage>");
+    }
+  }
+
+  // Pop the corresponding frame head's header information.
+  //
+  // Frames that were only decoded as references for later frames are dropped.
+  PendingFrames::Frame pending_frame;
+  bool has_pending_frame =
+      pts >= 0 && pending_frames_.Take(pts, &pending_frame);
+  if (has_pending_frame && !pending_frame.deliver) {
+    return OkStatus();
+  }
+
+  // Form a RawImage Packet.
+  auto packet_statusor = MakePacket(std::move(raw_image_statusor).ValueOrDie());
+  if (!packet_statusor.ok()) {
+    LOG(ERROR) << packet_statusor.status();
+    return InternalError("Unable to create a raw image packet");
+  }
+  auto packet = std::move(packet_statusor).ValueOrDie();
+
+  // Restore the corresponding frame head's header information.
+  if (has_pending_frame) {
+    const PacketHeader& frame_head_header = pending_frame.header;
+    *packet.mutable_header()->mutable_timestamp() =
+        frame_head_header.timestamp();
+    *packet.mutable_header()->mutable_addenda() = frame_head_header.addenda();
+    *packet.mutable_header()->mutable_server_metadata() =
+        frame_head_header.server_metadata();
+    packet.mutable_header()->set_trace_context(
+        frame_head_header.trace_context());
+  }
+
+  // Try to push a RawImage Packet onto the pcqueue.
+  // Drop if it is already full.
+  dest_image_packet_pcqueue_->TryEmplace(std::move(packet));
+  return OkStatus();
+}
+
+// Helper to push an EOS Packet shared producer/consumer queue.
+//
+// If `wait` is false, this gives up at once if the queue is full.
+Status ImageProducer::PushEosPacket(const std::string& reason, bool wait) {
+  auto eos_packet_statusor = MakeEosPacket(reason);
+  if (!eos_packet_statusor.ok()) {
+    LOG(ERROR) << eos_packet_statusor.status();
+    return InternalError("Couldn't create an EOS packet");
+  }
+  auto eos_packet =
+      std::make_unique<Packet>(std::move(eos_packet_statusor).ValueOrDie());
+  if (!wait) {
+    if (IsConsumerReleased() ||
+        dest_image_packet_pcqueue_->TryPush(eos_packet)) {
+      return OkStatus();
+    }
+    return UnavailableError("The consumer has no room for EOS yet");
+  }
+
+  // Block until EOS can be delivered, unless nobody is left to receive it.
+  while (!IsConsumerReleased()) {
+    absl::Time deadline;
+    {
+      absl::MutexLock lock(&eos_deadline_mu_);
+      deadline = eos_deadline_;
+    }
+    absl::Duration time_left =
+        std::max(absl::ZeroDuration(), deadline - absl::Now());
+    if (dest_image_packet_pcqueue_->TryPush(
+            eos_packet, std::min(time_left, absl::Seconds(kRetrySeconds)))) {
+      break;
+    }
+    if (absl::Now() >= deadline) {
+      return DeadlineExceededError(absl::StrFormat(
+          "The consumer did not make room for EOS in time; dropped EOS "
+          "(reason: \"%s\")",
+          reason));
+    }
+  }
+  return OkStatus();
+}
+
+// Helper to decide whether a Packet should be fed to the decoder.
+//
+// The decode policy is applied to packets that are frame heads (i.e. the first
+// in a sequence of packets that form a single coded picture); the rest of the
+// packets of a frame share its fate. Each admitted frame head is given a new
+// PTS tag, under which its header is kept together with whether its decoded
+// frame should be delivered.
+//
+// PushImagePacket will then receive decoded frames with the PTS of the frame
+// they were decoded from, and so recover the corresponding frame head's header
+// information.
+bool ImageProducer::AdmitPacket(const Packet& packet) {
+  if (!IsPacketFlagsSet(PacketFlags::kIsFrameHead, packet)) {
+    return is_feeding_frame_;
+  }
+  auto decision = frame_sampler_.Sample(
+      IsPacketFlagsSet(PacketFlags::kIsKeyFrame, packet), PacketTime(packet));
+  is_feeding_frame_ = decision.feed;
+  if (!is_feeding_frame_) {
+    return false;
+  }
+
+  // Derive the tag from the offset, but keep tags increasing even when the
+  // offsets do not.
+  int64_t pts = packet.header().server_metadata().offset() *
+                kNanosecondsPerOffset;
+  if (frame_pts_ >= 0 && pts <= frame_pts_) {
+    pts = frame_pts_ + kNanosecondsPerOffset;
+  }
+  frame_pts_ = pts;
+
+  PendingFrames::Frame pending_frame;
+  pending_frame.header = packet.header();
+  pending_frame.deliver = decision.deliver;
+  pending_frames_.Add(pts, std::move(pending_frame));
+  return true;
+}
+
+// Helper to feed a convert/feed a Packet into the Gstreamer for decoding.
+//
+// Packets that are not admitted under the decode policy are skipped.
+Status ImageProducer::Feed(Packet packet) {
+  if (!AdmitPacket(packet)) {
+    return OkStatus();
+  }
+
+  auto gstreamer_buffer_statusor = ToGstreamerBuffer(std::move(packet));
+  if (!gstreamer_buffer_statusor.ok()) {
+    return gstreamer_buffer_statusor.status();
+  }
+  auto gstreamer_buffer = std::move(gstreamer_buffer_statusor).ValueOrDie();
+  gstreamer_buffer.set_pts(frame_pts_);
+  return yielder_->Feed(std::move(gstreamer_buffer));
+}
+
+// The consumer holds the only other share of the destination queue.
+bool ImageProducer::IsConsumerReleased() const {
+  return dest_image_packet_pcqueue_.use_count() <= 1;
+}
+
+Status ImageProducer::Work() {
+  std::string termination_message;
+
+  while (!IsConsumerReleased()) {
+    // Get a Packet from the source stream.
+    auto packet_statusor = PullSourcePacket();
+    if (!packet_statusor.ok()) {
+      termination_message = packet_statusor.status().error_message();
+      break;
+    }
+    auto packet = std::move(packet_statusor).ValueOrDie();
+
+    // Feed the source packet into the decoder if it is not EOS.
+    // Break the loop otherwise.
+    if (IsEos(packet)) {
+      termination_message = "The raw image stream has ended";
+      break;
+    } else {
+      auto status = Feed(std::move(packet));
+      if (!status.ok()) {
+        termination_message = packet_statusor.status().error_message();
+        break;
+      }
+    }
+  }
+
+  return Finish(termination_message);
+}
+
+ImageProducer::StepResult ImageProducer::Step(
+    std::string* termination_message) {
+  if (IsConsumerReleased()) {
+    *termination_message = "The consumer has released the receiver queue";
+    return StepResult::kEnded;
+  }
+
+  // Check for a source packet without waiting.
+  Packet packet;
+  if (!source_packet_queue_->TryPop(packet, absl::ZeroDuration())) {
+    if (absl::Now() - last_source_packet_time_ > timeout_) {
+      *termination_message =
+          absl::StrFormat("The server has not yielded any source packets "
+                          "within the timeout (%s)",
+                          absl::FormatDuration(timeout_));
+      return StepResult::kEnded;
+    }
+    return StepResult::kIdle;
+  }
+  last_source_packet_time_ = absl::Now();
+
+  if (IsEos(packet)) {
+    *termination_message = "The raw image stream has ended";
+    return StepResult::kEnded;
+  }
+  bool is_frame_head = IsPacketFlagsSet(PacketFlags::kIsFrameHead, packet);
+  auto status = Feed(std::move(packet));
+  if (!status.ok()) {
+    *termination_message = std::string(status.message());
+    return StepResult::kEnded;
+  }
+  if (!is_feeding_frame_) {
+    return StepResult::kSkippedPacket;
+  }
+  return is_frame_head ? StepResult::kFedFrameHead : StepResult::kFedPacket;
+}
+
+void ImageProducer::SetEosDeadline(absl::Time eos_deadline) {
+  absl::MutexLock lock(&eos_deadline_mu_);
+  eos_deadline_ = eos_deadline;
+}
+
+void ImageProducer::ShutDownDecoder() {
+  if (is_decoder_shut_down_) {
+    return;
+  }
+  is_decoder_shut_down_ = true;
+  auto status = yielder_->SignalEOS();
+  if (!status.ok()) {
+    LOG(ERROR) << status;
+  }
+}
+
+Status ImageProducer::Finish(const std::string& termination_message) {
+  // Shut the decoder down and push a final EOS packet to notify the
+  // consumer.
+  ShutDownDecoder();
+  return PushEosPacket(termination_message, /*wait=*/true);
+}
+
+Status ImageProducer::TryFinish(const std::string& termination_message) {
+  ShutDownDecoder();
+  return PushEosPacket(termination_message, /*wait=*/false);
+}
+
+}  // namespace aistreams
@@ -0,0 +1,194 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AISTREAMS_CC_IMAGE_PRODUCER_H_
+#define AISTREAMS_CC_IMAGE_PRODUCER_H_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "aistreams/cc/aistreams_lite.h"
+#include "aistreams/cc/decode_policy.h"
+#include "aistreams/gstreamer/gstreamer_raw_image_yielder.h"
+#include "aistreams/port/status.h"
+#include "aistreams/port/statusor.h"
+#include "aistreams/util/producer_consumer_queue.h"
+
+namespace aistreams {
+
+// The headers of the frames fed to a decoder, awaiting their decoded images.
+//
+// Frames are tagged in decode order. A decoder that reorders frames (e.g. for
+// B-frames) yields them in presentation order, so a frame is matched by its
+// tag regardless of the order. A frame that the decoder dropped is discarded
+// once a frame fed more than `max_reorder_depth` frames after it comes out.
+//
+// This is thread-safe.
+class PendingFrames {
+ public:
+  struct Frame {
+    PacketHeader header;
+
+    // False if the frame is only decoded as a reference for later frames.
+    bool deliver = true;
+  };
+
+  // At most `capacity` frames are kept; 0 means no limit.
+  PendingFrames(size_t capacity, size_t max_reorder_depth);
+
+  // Add the frame tagged `tag`. Tags must increase from one call to the next.
+  //
+  // If the capacity is reached, the oldest frame is discarded.
+  void Add(int64_t tag, Frame frame);
+
+  // Take the frame tagged `tag` into `frame`. Returns false if there is none.
+  bool Take(int64_t tag, Frame* frame);
+
+  // Returns the number of frames kept.
+  size_t size();
+
+ private:
+  const size_t capacity_;
+  const size_t max_reorder_depth_;
+  absl::Mutex mu_;
+
+  // The frames keyed by their tags, with the order in which they were added.
+  std::map<int64_t, std::pair<int64_t, Frame>> frames_ ABSL_GUARDED_BY(mu_);
+  int64_t num_added_ ABSL_GUARDED_BY(mu_) = 0;
+};
+
+// An ImageProducer decodes the Packets of a source stream into RawImage
+// Packets.
+//
+// It is the engine behind MakeDecodedReceiverQueue and the DecodeService;
+// applications should use those instead.
+//
+// Each frame fed to the decoder is tagged with a PTS derived from the offset
+// of its frame head, and decoded images are matched with the header of their
+// frame by that tag. The decoder may therefore drop or reorder frames without
+// the images getting the wrong headers; see PendingFrames.
+//
+// The source packets can either be driven through the decoder by a dedicated
+// thread with Work(), or a little at a time by a scheduler with Step() and
+// Finish().
+class ImageProducer {
+ public:
+  struct Options {
+    absl::Duration timeout;
+    std::unique_ptr<ReceiverQueue<Packet>> source_packet_queue;
+    std::shared_ptr<ProducerConsumerQueue<Packet>> dest_image_packet_pcqueue;
+    DecodePolicy decode_policy;
+  };
+
+  // Create an ImageProducer.
+  //
+  // This pulls the first packet from the source stream to learn whether it is
+  // decodable at all.
+  static StatusOr<std::unique_ptr<ImageProducer>> Create(Options&& options);
+
+  // Main loop of a dedicated decoder thread.
+  //
+  // This terminates succesfully when any of the following is met:
+  // + The source packet queue passes an EOS.
+  // + The destination image packet queue is released by the caller.
+  Status Work();
+
+  // Result of a single Step().
+  enum class StepResult {
+    // A packet that starts a new frame was fed for decoding.
+    kFedFrameHead,
+
+    // A packet that continues the current frame was fed for decoding.
+    kFedPacket,
+
+    // A packet was skipped under the decode policy.
+    kSkippedPacket,
+
+    // No source packet was available yet.
+    kIdle,
+
+    // The stream has ended; call Finish() next.
+    kEnded,
+  };
+
+  // Feed the next source packet for decoding if one is already available.
+  //
+  // This never waits for the source stream. On kEnded, the reason is given in
+  // `termination_message`.
+  StepResult Step(std::string* termination_message);
+
+  // Shut the decoder down and push a final EOS packet to notify the consumer.
+  //
+  // This waits for the consumer to make room for EOS, up to the EOS deadline.
+  Status Finish(const std::string& termination_message);
+
+  // Same as Finish(), but never waits for the consumer.
+  //
+  // Returns an UNAVAILABLE error if the consumer has no room for EOS yet; call
+  // this (or Finish()) again later to retry.
+  Status TryFinish(const std::string& termination_message);
+
+  // Give up on delivering EOS at `eos_deadline`, even if Finish() is already
+  // waiting for room. There is no deadline by default.
+  //
+  // This is thread-safe.
+  void SetEosDeadline(absl::Time eos_deadline);
+
+  explicit ImageProducer(Options&& options);
+  ~ImageProducer() = default;
+  ImageProducer(const ImageProducer&) = delete;
+  ImageProducer& operator=(const ImageProducer&) = delete;
+
+ private:
+  Status Initialize();
+  bool AdmitPacket(const Packet& packet);
+  StatusOr<Packet> PullSourcePacket();
+  Status PushImagePacket(StatusOr<RawImage> raw_image_statusor, int64_t pts);
+  Status PushEosPacket(const std::string& reason, bool wait);
+  void ShutDownDecoder();
+  Status Feed(Packet packet);
+  bool IsConsumerReleased() const;
+
+  absl::Duration timeout_;
+  absl::Time last_source_packet_time_;
+  std::unique_ptr<ReceiverQueue<Packet>> source_packet_queue_;
+  std::shared_ptr<ProducerConsumerQueue<Packet>> dest_image_packet_pcqueue_;
+  FrameSampler frame_sampler_;
+  bool is_feeding_frame_ = true;
+
+  // The PTS tag of the frame being fed.
+  int64_t frame_pts_ = -1;
+
+  // Frames fed to the decoder, keyed by their PTS tags.
+  PendingFrames pending_frames_;
+
+  bool is_decoder_shut_down_ = false;
+
+  absl::Mutex eos_deadline_mu_;
+  absl::Time eos_deadline_ ABSL_GUARDED_BY(eos_deadline_mu_) =
+      absl::InfiniteFuture();
+
+  std::unique_ptr<GstreamerRawImageYielder> yielder_;
+};
+
+}  // namespace aistreams
+
+#endif  // AISTREAMS_CC_IMAGE_PRODUCER_H_
@@ -0,0 +1,104 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/cc/image_producer.h"
+
+#include <cstdint>
+
+#include "absl/strings/str_cat.h"
+#include "aistreams/port/gtest.h"
+
+namespace aistreams {
+
+namespace {
+
+PendingFrames::Frame MakeFrame(int64_t tag) {
+  PendingFrames::Frame frame;
+  frame.header.set_trace_context(absl::StrCat("frame-", tag));
+  return frame;
+}
+
+}  // namespace
+
+TEST(PendingFramesTest, MatchesInOrderOutput) {
+  PendingFrames pending_frames(0, 4);
+  for (int64_t tag = 0; tag < 5; ++tag) {
+    pending_frames.Add(tag, MakeFrame(tag));
+  }
+  for (int64_t tag = 0; tag < 5; ++tag) {
+    PendingFrames::Frame frame;
+    ASSERT_TRUE(pending_frames.Take(tag, &frame));
+    EXPECT_EQ(frame.header.trace_context(), absl::StrCat("frame-", tag));
+  }
+  EXPECT_EQ(pending_frames.size(), 0);
+}
+
+TEST(PendingFramesTest, MatchesReorderedOutput) {
+  // I P B B in decode order come out as I B B P.
+  PendingFrames pending_frames(0, 4);
+  for (int64_t tag = 0; tag < 4; ++tag) {
+    pending_frames.Add(tag, MakeFrame(tag));
+  }
+  for (int64_t tag : {0, 2, 3, 1}) {
+    PendingFrames::Frame frame;
+    ASSERT_TRUE(pending_frames.Take(tag, &frame)) << tag;
+    EXPECT_EQ(frame.header.trace_context(), absl::StrCat("frame-", tag));
+  }
+  EXPECT_EQ(pending_frames.size(), 0);
+}
+
+TEST(PendingFramesTest, DiscardsDroppedFramesBeyondReorderDepth) {
+  PendingFrames pending_frames(0, 2);
+  for (int64_t tag = 0; tag < 5; ++tag) {
+    pending_frames.Add(tag, MakeFrame(tag));
+  }
+
+  // Frame 0 was dropped by the decoder. It is kept while it may still come
+  // out after the frames that did.
+  PendingFrames::Frame frame;
+  ASSERT_TRUE(pending_frames.Take(2, &frame));
+  ASSERT_TRUE(pending_frames.Take(1, &frame));
+  EXPECT_EQ(pending_frames.size(), 3);
+
+  // It is discarded once a frame fed more than 2 frames after it comes out.
+  // Frame 3 is still within reach.
+  ASSERT_TRUE(pending_frames.Take(4, &frame));
+  EXPECT_EQ(frame.header.trace_context(), "frame-4");
+  EXPECT_FALSE(pending_frames.Take(0, &frame));
+  ASSERT_TRUE(pending_frames.Take(3, &frame));
+  EXPECT_EQ(frame.header.trace_context(), "frame-3");
+  EXPECT_EQ(pending_frames.size(), 0);
+}
+
+TEST(PendingFramesTest, UnknownTagIsNotMatched) {
+  PendingFrames pending_frames(0, 4);
+  pending_frames.Add(0, MakeFrame(0));
+  PendingFrames::Frame frame;
+  EXPECT_FALSE(pending_frames.Take(1, &frame));
+  EXPECT_EQ(pending_frames.size(), 1);
+}
+
+TEST(PendingFramesTest, DiscardsOldestFrameAtCapacity) {
+  PendingFrames pending_frames(2, 4);
+  for (int64_t tag = 0; tag < 3; ++tag) {
+    pending_frames.Add(tag, MakeFrame(tag));
+  }
+  EXPECT_EQ(pending_frames.size(), 2);
+  PendingFrames::Frame frame;
+  EXPECT_FALSE(pending_frames.Take(0, &frame));
+  EXPECT_TRUE(pending_frames.Take(1, &frame));
+  EXPECT_TRUE(pending_frames.Take(2, &frame));
+}
+
+}  // namespace aistreams
@@ -0,0 +1,779 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * SECTION: element-aismultisrc
+ * @title: aismultisrc
+ *
+ * The aismultisrc receives packets from several streams of the AI Streams
+ * server. Request a pad named src_<stream name> for every stream. All of the
+ * streams share one connection to the server, and their buffers are
+ * timestamped on a common timeline so that they can be composited or
+ * synchronized downstream.
+ *
+ * <refsect2>
+ * <title>Example launch line</title>
+ * |[
+ * gst-launch-1.0 -v compositor name=mix sink_1::xpos=640 ! autovideosink
+ * aismultisrc name=src target-address=localhost:50053
+ * src.src_camera-1 ! decodebin ! mix.
+ * src.src_camera-2 ! decodebin ! mix.
+ * ]|
+ * </refsect2>
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "aismultisrc.h"
+#include "aistreams/gstreamer/ais_type_utils.h"
+
+GST_DEBUG_CATEGORY_STATIC(ais_multi_src_debug_category);
+#define GST_CAT_DEFAULT ais_multi_src_debug_category
+
+/* prototypes*/
+
+static void ais_multi_src_set_property(GObject *object, guint property_id,
+                                       const GValue *value, GParamSpec *pspec);
+static void ais_multi_src_get_property(GObject *object, guint property_id,
+                                       GValue *value, GParamSpec *pspec);
+static void ais_multi_src_finalize(GObject *object);
+static GstPad *ais_multi_src_request_new_pad(GstElement *element,
+                                             GstPadTemplate *templ,
+                                             const gchar *name,
+                                             const GstCaps *caps);
+static void ais_multi_src_release_pad(GstElement *element, GstPad *pad);
+static GstStateChangeReturn ais_multi_src_change_state(
+    GstElement *element, GstStateChange transition);
+static gboolean ais_multi_src_src_query(GstPad *pad, GstObject *parent,
+                                        GstQuery *query);
+
+/* Codes labelling the properties of the plugin.
+ * The first code is a conventional zero sentinel.
+ */
+enum {
+  PROP_0,
+  PROP_TARGET_ADDRESS,
+  PROP_AUTHENTICATE_WITH_GOOGLE,
+  PROP_RECEIVER_NAME,
+  PROP_USE_INSECURE_CHANNEL,
+  PROP_SSL_DOMAIN_NAME,
+  PROP_SSL_ROOT_CERT_PATH,
+  PROP_LATENCY,
+};
+
+#define DEFAULT_LATENCY_MS 100
+
+/* The request pads are named after their stream, as in src_<stream name>. */
+#define SRC_PAD_PREFIX "src_"
+
+/* pad templates */
+
+static GstStaticPadTemplate ais_multi_src_template = GST_STATIC_PAD_TEMPLATE(
+    SRC_PAD_PREFIX "%s", GST_PAD_SRC, GST_PAD_REQUEST, GST_STATIC_CAPS_ANY);
+
+/* class initialization */
+
+G_DEFINE_TYPE_WITH_CODE(
+    AisMultiSrc, ais_multi_src, GST_TYPE_ELEMENT,
+    GST_DEBUG_CATEGORY_INIT(ais_multi_src_debug_category, "aismultisrc", 0,
+                            "debug category for the aismultisrc element"));
+
+static void ais_multi_src_class_init(AisMultiSrcClass *klass) {
+  GObjectClass *gobject_class = G_OBJECT_CLASS(klass);
+  GstElementClass *gstelement_class = GST_ELEMENT_CLASS(klass);
+
+  gobject_class->set_property = ais_multi_src_set_property;
+  gobject_class->get_property = ais_multi_src_get_property;
+
+  g_object_class_install_property(
+      gobject_class, PROP_TARGET_ADDRESS,
+      g_param_spec_string("target-address", "Target address",
+                          "Address to the AI Streams instance", NULL,
+                          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property(
+      gobject_class, PROP_AUTHENTICATE_WITH_GOOGLE,
+      g_param_spec_boolean(
+          "authenticate-with-google", "Authenticate with Google",
+          "Set to true (false) when using the managed (onprem) service", FALSE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property(
+      gobject_class, PROP_RECEIVER_NAME,
+      g_param_spec_string("receiver-name", "Receiver name",
+                          "Receiver name used to read from stream server", NULL,
+                          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property(
+      gobject_class, PROP_USE_INSECURE_CHANNEL,
+      g_param_spec_boolean("use-insecure-channel", "Use insecure channel",
+                           "Use an insecure channel to connect", FALSE,
+                           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property(
+      gobject_class, PROP_SSL_DOMAIN_NAME,
+      g_param_spec_string("ssl-domain-name", "SSL domain name",
+                          "The expected ssl domain name of the server", NULL,
+                          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property(
+      gobject_class, PROP_SSL_ROOT_CERT_PATH,
+      g_param_spec_string("ssl-root-cert-path", "SSL root certificate path",
+                          "The file path to the root CA certificate", NULL,
+                          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property(
+      gobject_class, PROP_LATENCY,
+      g_param_spec_uint("latency", "Latency",
+                        "Milliseconds of delivery jitter to absorb. Reported "
+                        "as the latency of the source",
+                        0, G_MAXUINT, DEFAULT_LATENCY_MS,
+                        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_set_static_metadata(
+      gstelement_class, "AI Streamer multi-stream source", "Generic",
+      "Receives packets from several streams of an AI Streamer stream server",
+      "Google Inc");
+
+  gst_element_class_add_static_pad_template(gstelement_class,
+                                            &ais_multi_src_template);
+
+  gobject_class->finalize = ais_multi_src_finalize;
+  gstelement_class->request_new_pad =
+      GST_DEBUG_FUNCPTR(ais_multi_src_request_new_pad);
+  gstelement_class->release_pad = GST_DEBUG_FUNCPTR(ais_multi_src_release_pad);
+  gstelement_class->change_state =
+      GST_DEBUG_FUNCPTR(ais_multi_src_change_state);
+}
+
+/* object initialization */
+
+static void ais_multi_src_init(AisMultiSrc *src) {
+  src->target_address = g_strdup("");
+  src->authenticate_with_google = FALSE;
+  src->receiver_name = g_strdup("");
+  src->use_insecure_channel = FALSE;
+  src->ssl_domain_name = g_strdup("aistreams.googleapis.com");
+  src->ssl_root_cert_path = g_strdup("");
+  src->latency = DEFAULT_LATENCY_MS;
+
+  g_mutex_init(&src->lock);
+  g_mutex_init(&src->time_lock);
+
+  GST_OBJECT_FLAG_SET(src, GST_ELEMENT_FLAG_SOURCE);
+}
+
+/**
+ * ais_multi_src_set_string
+ * @src: (not nullable): ais multi src object.
+ * @field: (not nullable): the string property to set.
+ * @value: the new value. NULL is taken as the empty string.
+ *
+ * The connection properties can only be changed while there is no receiver
+ * pool.
+ */
+static void ais_multi_src_set_string(AisMultiSrc *src, gchar **field,
+                                     const gchar *value) {
+  g_mutex_lock(&src->lock);
+  if (src->ais_receiver_pool != NULL) {
+    g_mutex_unlock(&src->lock);
+    GST_WARNING_OBJECT(src,
+                       "Changing the connection properties when the stream "
+                       "server is already connected is not supported");
+    return;
+  }
+  g_free(*field);
+  *field = g_strdup(value != NULL ? value : "");
+  g_mutex_unlock(&src->lock);
+}
+
+static void ais_multi_src_set_property(GObject *object, guint property_id,
+                                       const GValue *value,
+                                       GParamSpec *pspec) {
+  AisMultiSrc *src = AIS_MULTI_SRC(object);
+
+  switch (property_id) {
+    case PROP_TARGET_ADDRESS:
+      ais_multi_src_set_string(src, &src->target_address,
+                               g_value_get_string(value));
+      break;
+    case PROP_AUTHENTICATE_WITH_GOOGLE:
+      src->authenticate_with_google = g_value_get_boolean(value);
+      break;
+    case PROP_RECEIVER_NAME:
+      ais_multi_src_set_string(src, &src->receiver_name,
+                               g_value_get_string(value));
+      break;
+    case PROP_USE_INSECURE_CHANNEL:
+      src->use_insecure_channel = g_value_get_boolean(value);
+      break;
+    case PROP_SSL_DOMAIN_NAME:
+      ais_multi_src_set_string(src, &src->ssl_domain_name,
+                               g_value_get_string(value));
+      break;
+    case PROP_SSL_ROOT_CERT_PATH:
+      ais_multi_src_set_string(src, &src->ssl_root_cert_path,
+                               g_value_get_string(value));
+      break;
+    case PROP_LATENCY:
+      src->latency = g_value_get_uint(value);
+      gst_element_post_message(GST_ELEMENT(src),
+                               gst_message_new_latency(GST_OBJECT(src)));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
+  }
+}
+
+static void ais_multi_src_get_property(GObject *object, guint property_id,
+                                       GValue *value, GParamSpec *pspec) {
+  AisMultiSrc *src = AIS_MULTI_SRC(object);
+
+  switch (property_id) {
+    case PROP_TARGET_ADDRESS:
+      g_value_set_string(value, src->target_address);
+      break;
+    case PROP_AUTHENTICATE_WITH_GOOGLE:
+      g_value_set_boolean(value, src->authenticate_with_google);
+      break;
+    case PROP_RECEIVER_NAME:
+      g_value_set_string(value, src->receiver_name);
+      break;
+    case PROP_USE_INSECURE_CHANNEL:
+      g_value_set_boolean(value, src->use_insecure_channel);
+      break;
+    case PROP_SSL_DOMAIN_NAME:
+      g_value_set_string(value, src->ssl_domain_name);
+      break;
+    case PROP_SSL_ROOT_CERT_PATH:
+      g_value_set_string(value, src->ssl_root_cert_path);
+      break;
+    case PROP_LATENCY:
+      g_value_set_uint(value, src->latency);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
+      break;
+  }
+}
+
+void ais_multi_src_finalize(GObject *object) {
+  AisMultiSrc *src = AIS_MULTI_SRC(object);
+
+  g_free(src->target_address);
+  g_free(src->receiver_name);
+  g_free(src->ssl_domain_name);
+  g_free(src->ssl_root_cert_path);
+  g_mutex_clear(&src->lock);
+  g_mutex_clear(&src->time_lock);
+
+  G_OBJECT_CLASS(ais_multi_src_parent_class)->finalize(object);
+}
+
+/* The shared timeline. */
+
+static GstClockTime ais_multi_src_get_running_time(AisMultiSrc *src) {
+  GstClock *clock = gst_element_get_clock(GST_ELEMENT(src));
+  if (clock == NULL) {
+    return GST_CLOCK_TIME_NONE;
+  }
+  GstClockTime now = gst_clock_get_time(clock);
+  GstClockTime base_time = gst_element_get_base_time(GST_ELEMENT(src));
+  gst_object_unref(clock);
+  return now > base_time ? now - base_time : 0;
+}
+
+/**
+ * ais_multi_src_timestamp
+ * @src: (not nullable): ais multi src object.
+ * @packet_time: the packet timestamp in nanoseconds since the Unix epoch.
+ * Returns: the running time at which to present the packet.
+ *
+ * Maps packet timestamps onto the running time with one offset for all of the
+ * streams, so that packets created at the same time by different senders are
+ * presented together. The offset is fixed by the first packet received in
+ * PLAYING, from whichever stream.
+ */
+static GstClockTime ais_multi_src_timestamp(AisMultiSrc *src,
+                                            gint64 packet_time) {
+  GstClockTime now = ais_multi_src_get_running_time(src);
+  if (!GST_CLOCK_TIME_IS_VALID(now)) {
+    return GST_CLOCK_TIME_NONE;
+  }
+
+  g_mutex_lock(&src->time_lock);
+  if (!src->have_time_base) {
+    src->have_time_base = TRUE;
+    src->packet_time_base = packet_time;
+    src->running_time_base = now;
+  }
+  gint64 pts = (gint64)src->running_time_base +
+               (packet_time - src->packet_time_base);
+  g_mutex_unlock(&src->time_lock);
+
+  // Packets created before the first one are presented right away.
+  return pts > 0 ? (GstClockTime)pts : 0;
+}
+
+/* Streams. */
+
+static AisMultiSrcStream *ais_multi_src_stream_new(AisMultiSrc *src,
+                                                   GstPad *pad,
+                                                   const gchar *stream_name) {
+  AisMultiSrcStream *stream = g_new0(AisMultiSrcStream, 1);
+  stream->src = src;
+  stream->pad = pad;
+  stream->stream_name = g_strdup(stream_name);
+  stream->ais_status = AIS_NewStatus();
+  return stream;
+}
+
+static void ais_multi_src_stream_free(AisMultiSrcStream *stream) {
+  g_free(stream->stream_name);
+  g_free(stream->caps_string);
+  AIS_DeleteStatus(stream->ais_status);
+  g_free(stream);
+}
+
+/**
+ * ais_multi_src_has_stream
+ * @src: (not nullable): ais multi src object, with its lock held.
+ * @stream_name: (not nullable): the name of the stream to look for.
+ * Returns: TRUE if a pad already receives from @stream_name.
+ */
+static gboolean ais_multi_src_has_stream(AisMultiSrc *src,
+                                         const gchar *stream_name) {
+  for (GList *l = src->streams; l != NULL; l = l->next) {
+    AisMultiSrcStream *stream = (AisMultiSrcStream *)l->data;
+    if (g_strcmp0(stream->stream_name, stream_name) == 0) {
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+/**
+ * ais_multi_src_stream_push_start
+ * @stream: (not nullable): the stream to start.
+ *
+ * Pushes the stream-start event unless it was pushed before. The caps and
+ * segment events follow it, in that order.
+ */
+static void ais_multi_src_stream_push_start(AisMultiSrcStream *stream) {
+  if (stream->need_stream_start) {
+    gchar *stream_id = gst_pad_create_stream_id(
+        stream->pad, GST_ELEMENT(stream->src), stream->stream_name);
+    gst_pad_push_event(stream->pad, gst_event_new_stream_start(stream_id));
+    g_free(stream_id);
+    stream->need_stream_start = FALSE;
+  }
+}
+
+static void ais_multi_src_stream_push_segment(AisMultiSrcStream *stream) {
+  if (stream->need_segment) {
+    GstSegment segment;
+    gst_segment_init(&segment, GST_FORMAT_TIME);
+    gst_pad_push_event(stream->pad, gst_event_new_segment(&segment));
+    stream->need_segment = FALSE;
+  }
+}
+
+/**
+ * ais_multi_src_on_packet
+ * @ais_packet: (transfer full): a packet received from the stream.
+ * @user_data: the AisMultiSrcStream of the stream.
+ * Returns: 0 to keep receiving from the stream, and 1 to stop.
+ *
+ * The receiver pool callback. It runs on a thread of the pool and pushes the
+ * packet out of the pad of its stream.
+ */
+static int ais_multi_src_on_packet(AIS_Packet *ais_packet, void *user_data) {
+  AisMultiSrcStream *stream = (AisMultiSrcStream *)user_data;
+  AisMultiSrc *src = stream->src;
+
+  AIS_GstreamerBuffer *ais_gstreamer_buffer = NULL;
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  // Hold the stream lock while pushing, as a streaming thread would, so that
+  // deactivating the pad waits for the push to return.
+  GST_PAD_STREAM_LOCK(stream->pad);
+
+  char *reason;
+  if (AIS_IsEos(ais_packet, &reason)) {
+    ret = GST_FLOW_EOS;
+    AIS_Log(AIS_INFO, reason);
+    free(reason);
+    ais_multi_src_stream_push_start(stream);
+    ais_multi_src_stream_push_segment(stream);
+    gst_pad_push_event(stream->pad, gst_event_new_eos());
+    goto finalize;
+  }
+
+  // A live source outputs nothing while paused.
+  if (!g_atomic_int_get(&src->is_playing)) {
+    goto finalize;
+  }
+
+  // Start every stream at a key frame so that it can be decoded.
+  if (stream->awaiting_key_frame) {
+    if (!AIS_IsKeyFrame(ais_packet)) {
+      goto finalize;
+    }
+    stream->awaiting_key_frame = FALSE;
+  }
+
+  ais_gstreamer_buffer =
+      AIS_ToGstreamerBuffer(ais_packet, stream->ais_status);
+  if (ais_gstreamer_buffer == NULL) {
+    ret = GST_FLOW_ERROR;
+    goto failed_to_gstreamer_buffer;
+  }
+
+  ais_multi_src_stream_push_start(stream);
+
+  // Change the caps to those of the incoming packet if they are different.
+  const char *caps_string =
+      AIS_GstreamerBufferGetCapsString(ais_gstreamer_buffer);
+  if (stream->caps_string == NULL ||
+      strcmp(stream->caps_string, caps_string) != 0) {
+    GstCaps *caps = gst_caps_from_string(caps_string);
+    if (caps == NULL) {
+      ret = GST_FLOW_NOT_NEGOTIATED;
+      goto failed_parse_caps;
+    }
+    GST_INFO_OBJECT(stream->pad, "Setting caps to %s", caps_string);
+    gst_pad_push_event(stream->pad, gst_event_new_caps(caps));
+    gst_caps_unref(caps);
+    g_free(stream->caps_string);
+    stream->caps_string = g_strdup(caps_string);
+  }
+
+  ais_multi_src_stream_push_segment(stream);
+
+  // Wrap the received payload in the output GstBuffer rather than copying it.
+  gsize buf_size = AIS_GstreamerBufferSize(ais_gstreamer_buffer);
+  GstBuffer *buffer = gst_buffer_new_wrapped_full(
+      GST_MEMORY_FLAG_READONLY,
+      (gpointer)AIS_GstreamerBufferData(ais_gstreamer_buffer), buf_size, 0,
+      buf_size, ais_gstreamer_buffer,
+      (GDestroyNotify)AIS_DeleteGstreamerBuffer);
+  ais_gstreamer_buffer = NULL;
+
+  GstClockTime pts =
+      ais_multi_src_timestamp(src, AIS_GetTimestampNanos(ais_packet));
+  GST_BUFFER_PTS(buffer) = pts;
+  GST_BUFFER_DTS(buffer) = pts;
+
+  ret = gst_pad_push(stream->pad, buffer);
+  if (ret == GST_FLOW_NOT_LINKED || ret < GST_FLOW_EOS) {
+    goto failed_push;
+  }
+
+finalize:
+  GST_PAD_STREAM_UNLOCK(stream->pad);
+  AIS_DeleteGstreamerBuffer(ais_gstreamer_buffer);
+  AIS_DeletePacket(ais_packet);
+  return ret == GST_FLOW_OK ? 0 : 1;
+
+failed_to_gstreamer_buffer : {
+  GST_ELEMENT_ERROR(src, LIBRARY, FAILED,
+                    ("%s", AIS_Message(stream->ais_status)),
+                    ("%s", AIS_Message(stream->ais_status)));
+  goto finalize;
+}
+
+failed_parse_caps : {
+  GST_ELEMENT_ERROR(src, CORE, NEGOTIATION,
+                    ("Could not parse the caps of the received packet"),
+                    ("Got caps %s from the stream %s", caps_string,
+                     stream->stream_name));
+  goto finalize;
+}
+
+failed_push : {
+  GST_ELEMENT_ERROR(src, STREAM, FAILED, ("Internal data stream error."),
+                    ("Streaming of %s stopped, reason %s", stream->stream_name,
+                     gst_flow_get_name(ret)));
+  gst_pad_push_event(stream->pad, gst_event_new_eos());
+  goto finalize;
+}
+}
+
+/**
+ * ais_multi_src_add_stream
+ * @src: (not nullable): ais multi src object, with its lock held.
+ * @stream: (not nullable): the stream to start receiving from.
+ * Returns: TRUE on success, FALSE otherwise.
+ */
+static gboolean ais_multi_src_add_stream(AisMultiSrc *src,
+                                         AisMultiSrcStream *stream) {
+  stream->need_stream_start = TRUE;
+  stream->need_segment = TRUE;
+  stream->awaiting_key_frame = TRUE;
+  AIS_ReceiverPoolAddStream(src->ais_receiver_pool, stream->stream_name,
+                            ais_multi_src_on_packet, stream,
+                            stream->ais_status);
+  if (AIS_GetCode(stream->ais_status) != AIS_OK) {
+    goto failed_add_stream;
+  }
+  stream->is_added = TRUE;
+  return TRUE;
+
+failed_add_stream : {
+  GST_ELEMENT_ERROR(src, RESOURCE, NOT_FOUND,
+                    ("%s", AIS_Message(stream->ais_status)),
+                    ("%s", AIS_Message(stream->ais_status)));
+  AIS_Log(AIS_ERROR, AIS_Message(stream->ais_status));
+  AIS_Log(AIS_ERROR, "Failed to receive from a stream");
+  return FALSE;
+}
+}
+
+static GstPad *ais_multi_src_request_new_pad(GstElement *element,
+                                             GstPadTemplate *templ,
+                                             const gchar *name,
+                                             const GstCaps *caps) {
+  AisMultiSrc *src = AIS_MULTI_SRC(element);
+
+  if (name == NULL || !g_str_has_prefix(name, SRC_PAD_PREFIX) ||
+      name[strlen(SRC_PAD_PREFIX)] == '\0') {
+    goto bad_pad_name;
+  }
+  const gchar *stream_name = name + strlen(SRC_PAD_PREFIX);
+
+  g_mutex_lock(&src->lock);
+  gboolean has_stream = ais_multi_src_has_stream(src, stream_name);
+  g_mutex_unlock(&src->lock);
+  if (has_stream) {
+    goto duplicate_stream;
+  }
+
+  GstPad *pad = gst_pad_new_from_template(templ, name);
+  gst_pad_set_query_function(pad, ais_multi_src_src_query);
+  gst_pad_use_fixed_caps(pad);
+  AisMultiSrcStream *stream = ais_multi_src_stream_new(src, pad, stream_name);
+  gst_pad_set_element_private(pad, stream);
+
+  // Adding the pad activates it when the element is PAUSED or PLAYING, so it
+  // is ready for the packets of the stream. This also fails if a concurrent
+  // request added a pad of the same name first.
+  if (!gst_element_add_pad(element, pad)) {
+    gst_pad_set_element_private(pad, NULL);
+    gst_object_unref(pad);
+    ais_multi_src_stream_free(stream);
+    goto duplicate_stream;
+  }
+
+  g_mutex_lock(&src->lock);
+  src->streams = g_list_append(src->streams, stream);
+  if (g_atomic_int_get(&src->is_playing)) {
+    ais_multi_src_add_stream(src, stream);
+  }
+  g_mutex_unlock(&src->lock);
+
+  return pad;
+
+bad_pad_name : {
+  GST_WARNING_OBJECT(src,
+                     "Request a pad named " SRC_PAD_PREFIX
+                     "<stream name>, not %s",
+                     GST_STR_NULL(name));
+  return NULL;
+}
+
+duplicate_stream : {
+  GST_WARNING_OBJECT(src, "There is already a pad named %s", name);
+  return NULL;
+}
+}
+
+static void ais_multi_src_release_pad(GstElement *element, GstPad *pad) {
+  AisMultiSrc *src = AIS_MULTI_SRC(element);
+  AisMultiSrcStream *stream =
+      (AisMultiSrcStream *)gst_pad_get_element_private(pad);
+
+  // Deactivating the pad makes the callback of the stream return, so that it
+  // is quick to remove.
+  gst_pad_set_active(pad, FALSE);
+
+  g_mutex_lock(&src->lock);
+  src->streams = g_list_remove(src->streams, stream);
+  if (stream->is_added && src->ais_receiver_pool != NULL) {
+    AIS_ReceiverPoolRemoveStream(src->ais_receiver_pool, stream->stream_name,
+                                 stream->ais_status);
+  }
+  g_mutex_unlock(&src->lock);
+
+  gst_element_remove_pad(element, pad);
+  ais_multi_src_stream_free(stream);
+}
+
+static gboolean ais_multi_src_src_query(GstPad *pad, GstObject *parent,
+                                        GstQuery *query) {
+  AisMultiSrc *src = AIS_MULTI_SRC(parent);
+
+  if (GST_QUERY_TYPE(query) == GST_QUERY_LATENCY) {
+    // Buffers are due when the sender created them, so hold them back by the
+    // jitter buffer. Nothing is buffered here, so there is no upper bound.
+    gst_query_set_latency(query, TRUE, src->latency * GST_MSECOND,
+                          GST_CLOCK_TIME_NONE);
+    return TRUE;
+  }
+  return gst_pad_query_default(pad, parent, query);
+}
+
+/* State changes. */
+
+static gboolean ais_multi_src_start(AisMultiSrc *src) {
+  AIS_Status *ais_status = AIS_NewStatus();
+
+  g_mutex_lock(&src->lock);
+  src->ais_connection_options = AIS_NewConnectionOptions();
+  AIS_SetTargetAddress(src->target_address, src->ais_connection_options);
+  AIS_SetAuthenticateWithGoogle(src->authenticate_with_google,
+                                src->ais_connection_options);
+  AIS_SetUseInsecureChannel(src->use_insecure_channel,
+                            src->ais_connection_options);
+  AIS_SetSslDomainName(src->ssl_domain_name, src->ais_connection_options);
+  AIS_SetSslRootCertPath(src->ssl_root_cert_path, src->ais_connection_options);
+
+  src->ais_receiver_pool = AIS_NewReceiverPool(
+      src->ais_connection_options, src->receiver_name, ais_status);
+  g_mutex_unlock(&src->lock);
+  if (src->ais_receiver_pool == NULL) {
+    goto failed_new_receiver_pool;
+  }
+
+  AIS_DeleteStatus(ais_status);
+  return TRUE;
+
+failed_new_receiver_pool : {
+  GST_ELEMENT_ERROR(src, RESOURCE, NOT_FOUND, ("%s", AIS_Message(ais_status)),
+                    ("%s", AIS_Message(ais_status)));
+  AIS_Log(AIS_ERROR, AIS_Message(ais_status));
+  AIS_Log(AIS_ERROR, "Failed to create a new receiver pool");
+  AIS_DeleteStatus(ais_status);
+  return FALSE;
+}
+}
+
+static gboolean ais_multi_src_play(AisMultiSrc *src) {
+  gboolean ok = TRUE;
+
+  // Start a new timeline, as the running time does not advance while paused.
+  g_mutex_lock(&src->time_lock);
+  src->have_time_base = FALSE;
+  g_mutex_unlock(&src->time_lock);
+
+  g_mutex_lock(&src->lock);
+  g_atomic_int_set(&src->is_playing, TRUE);
+  for (GList *l = src->streams; l != NULL && ok; l = l->next) {
+    AisMultiSrcStream *stream = (AisMultiSrcStream *)l->data;
+    if (!stream->is_added) {
+      ok = ais_multi_src_add_stream(src, stream);
+    }
+  }
+  g_mutex_unlock(&src->lock);
+  return ok;
+}
+
+static void ais_multi_src_stop(AisMultiSrc *src) {
+  // The pads are inactive by now, so every callback returns promptly.
+  g_mutex_lock(&src->lock);
+  AIS_DeleteReceiverPool(src->ais_receiver_pool);
+  src->ais_receiver_pool = NULL;
+  AIS_DeleteConnectionOptions(src->ais_connection_options);
+  src->ais_connection_options = NULL;
+  for (GList *l = src->streams; l != NULL; l = l->next) {
+    AisMultiSrcStream *stream = (AisMultiSrcStream *)l->data;
+    stream->is_added = FALSE;
+    g_free(stream->caps_string);
+    stream->caps_string = NULL;
+  }
+  g_mutex_unlock(&src->lock);
+}
+
+static GstStateChangeReturn ais_multi_src_change_state(
+    GstElement *element, GstStateChange transition) {
+  AisMultiSrc *src = AIS_MULTI_SRC(element);
+  GstStateChangeReturn ret;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      if (!ais_multi_src_start(src)) {
+        return GST_STATE_CHANGE_FAILURE;
+      }
+      break;
+    case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
+      if (!ais_multi_src_play(src)) {
+        return GST_STATE_CHANGE_FAILURE;
+      }
+      break;
+    case GST_STATE_CHANGE_PLAYING_TO_PAUSED:
+      g_atomic_int_set(&src->is_playing, FALSE);
+      break;
+    default:
+      break;
+  }
+
+  ret = GST_ELEMENT_CLASS(ais_multi_src_parent_class)
+            ->change_state(element, transition);
+  if (ret == GST_STATE_CHANGE_FAILURE) {
+    return ret;
+  }
+
+  switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+    case GST_STATE_CHANGE_PLAYING_TO_PAUSED:
+      // Live sources do not preroll.
+      ret = GST_STATE_CHANGE_NO_PREROLL;
+      break;
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      ais_multi_src_stop(src);
+      break;
+    default:
+      break;
+  }
+  return ret;
+}
+
+static gboolean plugin_init(GstPlugin *plugin) {
+  return gst_element_register(plugin, "aismultisrc", GST_RANK_NONE,
+                              AIS_TYPE_MULTI_SRC);
+}
+
+#ifndef VERSION
+#define VERSION "0.0.1"
+#endif
+#ifndef PACKAGE
+#define PACKAGE "ais_package"
+#endif
+#ifndef PACKAGE_NAME
+#define PACKAGE_NAME "GStreamer"
+#endif
+#ifndef GST_PACKAGE_ORIGIN
+#define GST_PACKAGE_ORIGIN "https://gstreamer.freedesktop.org/"
+#endif
+
+GST_PLUGIN_DEFINE(GST_VERSION_MAJOR, GST_VERSION_MINOR, aismultisrc,
+                  "AI Streams Multi-Stream Source", plugin_init, VERSION,
+                  "Proprietary", PACKAGE_NAME, GST_PACKAGE_ORIGIN)
@@ -0,0 +1,127 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AIS_MULTI_SRC_H_
+#define AIS_MULTI_SRC_H_
+
+#include <gst/gst.h>
+
+#include "aistreams/c/c_api.h"
+
+G_BEGIN_DECLS
+
+#define AIS_TYPE_MULTI_SRC (ais_multi_src_get_type())
+#define AIS_MULTI_SRC(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj), AIS_TYPE_MULTI_SRC, AisMultiSrc))
+#define AIS_MULTI_SRC_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST((klass), AIS_TYPE_MULTI_SRC, AisMultiSrcClass))
+#define AIS_IS_MULTI_SRC(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj), AIS_TYPE_MULTI_SRC))
+#define AIS_IS_MULTI_SRC_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE((klass), AIS_TYPE_MULTI_SRC))
+
+typedef struct _AisMultiSrc AisMultiSrc;
+typedef struct _AisMultiSrcClass AisMultiSrcClass;
+typedef struct _AisMultiSrcStream AisMultiSrcStream;
+
+/**
+ * AisMultiSrc:
+ *
+ * The data associated with each #AisMultiSrc object.
+ */
+struct _AisMultiSrc {
+  GstElement element;
+
+  /* The address (ip:port) of the remote stream server. */
+  gchar *target_address;
+
+  /* Set to true when using the google managed service; othweise false.*/
+  gboolean authenticate_with_google;
+
+  /* A self identifying reciever name to the stream server. */
+  gchar *receiver_name;
+
+  /* Options to configure SSL information. See AisSrc. */
+  gboolean use_insecure_channel;
+  gchar *ssl_domain_name;
+  gchar *ssl_root_cert_path;
+
+  /* Milliseconds of delivery jitter to absorb. Buffers are timestamped from
+   * the packet headers, so downstream sinks render each buffer `latency`
+   * milliseconds after the sender created it.
+   */
+  guint latency;
+
+  /* ----- private ----- */
+
+  /* Guards the receiver pool and the list of streams. The receiver pool
+   * callbacks never take it, so the pool may be deleted while holding it. */
+  GMutex lock;
+
+  /* Options to configure the AI Streamer connection. */
+  AIS_ConnectionOptions *ais_connection_options;
+
+  /* An AI Streamer receiver pool that receives from every stream over one
+   * connection. It exists from PAUSED upwards. */
+  AIS_ReceiverPool *ais_receiver_pool;
+
+  /* The AisMultiSrcStream of every request pad. */
+  GList *streams;
+
+  /* Set while PLAYING. Packets that arrive otherwise are dropped. */
+  gint is_playing;
+
+  /* The timeline shared by all of the streams. A packet created at
+   * packet_time_base (in nanoseconds since the Unix epoch) is timestamped with
+   * the running time running_time_base, whichever stream it belongs to. */
+  GMutex time_lock;
+  gboolean have_time_base;
+  gint64 packet_time_base;
+  GstClockTime running_time_base;
+};
+
+/**
+ * AisMultiSrcStream:
+ *
+ * The data associated with each request pad, which outputs one stream.
+ */
+struct _AisMultiSrcStream {
+  AisMultiSrc *src;
+  GstPad *pad;
+
+  /* The name of the server stream to read from. */
+  gchar *stream_name;
+
+  /* Set once the stream has been added to the receiver pool. */
+  gboolean is_added;
+
+  /* The remaining fields are only used by the receiver pool callback. */
+  AIS_Status *ais_status;
+  gchar *caps_string;
+  gboolean need_stream_start;
+  gboolean need_segment;
+  gboolean awaiting_key_frame;
+};
+
+struct _AisMultiSrcClass {
+  GstElementClass parent_class;
+};
+
+GType ais_multi_src_get_type(void);
+
+G_END_DECLS
+
+#endif
@@ -26,6 +26,17 @@
  * target-address=<address to the server> stream-name=<name of your stream>
  * ]|
  * </refsect2>
+ *
+ * By default, packets are sent on the streaming thread, so a slow connection
+ * to the server stalls the whole pipeline. Set send-queue-size to instead send
+ * them from a dedicated thread through a bounded queue; drop-policy then
+ * decides what happens when the queue is full.
+ *
+ * If stats-interval is set, the sink periodically posts an "aissink-stats"
+ * element message with the following fields:
+ * - "queued-packets" (guint): packets waiting in the send queue.
+ * - "sent-packets" (guint64): packets sent from the send queue so far.
+ * - "dropped-packets" (guint64): packets dropped by the drop policy so far.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -53,6 +64,11 @@ static gboolean ais_sink_set_caps(GstBaseSink *sink, GstCaps *caps);
 static gboolean ais_sink_start(GstBaseSink *sink);
 static gboolean ais_sink_stop(GstBaseSink *sink);
 static GstFlowReturn ais_sink_render(GstBaseSink *sink, GstBuffer *buffer);
+static gboolean ais_sink_event(GstBaseSink *sink, GstEvent *event);
+static gboolean ais_sink_unlock(GstBaseSink *sink);
+static gboolean ais_sink_unlock_stop(GstBaseSink *sink);
+static void ais_sink_finalize(GObject *object);
+static void ais_sink_flush(AisSink *sink);
 
 /* Codes labelling the properties of the plugin.
  * The first code is a conventional zero sentinel.
@@ -66,8 +82,39 @@ enum {
   PROP_SSL_DOMAIN_NAME,
   PROP_SSL_ROOT_CERT_PATH,
   PROP_TRACE_PROBABILITY,
+  PROP_SEND_QUEUE_SIZE,
+  PROP_DROP_POLICY,
+  PROP_FLUSH_ON_EOS,
+  PROP_STATS_INTERVAL,
+  PROP_MAX_BATCH_PACKETS,
+  PROP_MAX_BATCH_BYTES,
+  PROP_LINGER_MS,
 };
 
+/* A packet waiting in the send queue. */
+typedef struct {
+  AIS_Packet *packet;
+  gboolean is_key_frame;
+} AisSinkQueuedPacket;
+
+#define AIS_TYPE_SINK_DROP_POLICY (ais_sink_drop_policy_get_type())
+static GType ais_sink_drop_policy_get_type(void) {
+  static GType drop_policy_type = 0;
+  static const GEnumValue drop_policies[] = {
+      {AIS_SINK_DROP_POLICY_BLOCK, "Block until there is room", "block"},
+      {AIS_SINK_DROP_POLICY_DROP_OLDEST, "Drop the oldest queued packet",
+       "drop-oldest"},
+      {AIS_SINK_DROP_POLICY_DROP_DELTA_FRAMES_FIRST,
+       "Drop delta frames before key frames", "drop-delta-frames-first"},
+      {0, NULL, NULL},
+  };
+  if (!drop_policy_type) {
+    drop_policy_type =
+        g_enum_register_static("AisSinkDropPolicy", drop_policies);
+  }
+  return drop_policy_type;
+}
+
 /* pad templates */
 
 static GstStaticPadTemplate ais_sink_sink_template = GST_STATIC_PAD_TEMPLATE(
@@ -130,6 +177,62 @@ static void ais_sink_class_init(AisSinkClass *klass) {
                           "Probability to start trace for a packet", 0, 1, 0,
                           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property(
+      gobject_class, PROP_SEND_QUEUE_SIZE,
+      g_param_spec_uint("send-queue-size", "Send queue size",
+                        "Maximum number of packets waiting to be sent by a "
+                        "dedicated thread (0 = send on the streaming thread)",
+                        0, G_MAXUINT, 0,
+                        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property(
+      gobject_class, PROP_DROP_POLICY,
+      g_param_spec_enum("drop-policy", "Drop policy",
+                        "What to do when the send queue is full",
+                        AIS_TYPE_SINK_DROP_POLICY,
+                        AIS_SINK_DROP_POLICY_DROP_DELTA_FRAMES_FIRST,
+                        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property(
+      gobject_class, PROP_FLUSH_ON_EOS,
+      g_param_spec_boolean("flush-on-eos", "Flush on EOS",
+                           "Send all queued packets before finishing on EOS "
+                           "or stopping; otherwise, discard them",
+                           TRUE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property(
+      gobject_class, PROP_STATS_INTERVAL,
+      g_param_spec_uint("stats-interval", "Stats interval",
+                        "Milliseconds between aissink-stats element messages "
+                        "(0 = disabled)",
+                        0, G_MAXUINT, 0,
+                        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property(
+      gobject_class, PROP_MAX_BATCH_PACKETS,
+      g_param_spec_uint("max-batch-packets", "Max batch packets",
+                        "The maximum number of packets sent together in one "
+                        "batch (1 = no batching)",
+                        1, G_MAXINT, 1,
+                        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property(
+      gobject_class, PROP_MAX_BATCH_BYTES,
+      g_param_spec_uint("max-batch-bytes", "Max batch bytes",
+                        "The maximum number of bytes sent together in one "
+                        "batch (0 = no limit)",
+                        0, G_MAXUINT, 0,
+                        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property(
+      gobject_class, PROP_LINGER_MS,
+      g_param_spec_uint("linger-ms", "Linger",
+                        "Milliseconds a packet may wait for its batch to fill "
+                        "up when batching (0 = until the batch is full, caps "
+                        "change or EOS)",
+                        0, G_MAXINT, 10,
+                        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata(
       GST_ELEMENT_CLASS(klass), "AI Streams sink", "Generic",
       "Send packets to AI Streams", "Google Inc");
@@ -140,9 +243,13 @@ static void ais_sink_class_init(AisSinkClass *klass) {
   base_sink_class->get_caps = GST_DEBUG_FUNCPTR(ais_sink_get_caps);
 
   gobject_class->dispose = ais_sink_dispose;
+  gobject_class->finalize = ais_sink_finalize;
   base_sink_class->start = GST_DEBUG_FUNCPTR(ais_sink_start);
   base_sink_class->stop = GST_DEBUG_FUNCPTR(ais_sink_stop);
   base_sink_class->render = GST_DEBUG_FUNCPTR(ais_sink_render);
+  base_sink_class->event = GST_DEBUG_FUNCPTR(ais_sink_event);
+  base_sink_class->unlock = GST_DEBUG_FUNCPTR(ais_sink_unlock);
+  base_sink_class->unlock_stop = GST_DEBUG_FUNCPTR(ais_sink_unlock_stop);
 }
 
 /* object initialization */
@@ -156,6 +263,18 @@ static void ais_sink_init(AisSink *sink) {
   sink->ssl_domain_name = g_strdup("aistreams.googleapis.com");
   sink->ssl_root_cert_path = g_strdup("");
   sink->trace_probability = 0;
+  sink->send_queue_size = 0;
+  sink->drop_policy = AIS_SINK_DROP_POLICY_DROP_DELTA_FRAMES_FIRST;
+  sink->flush_on_eos = TRUE;
+  sink->stats_interval = 0;
+  sink->max_batch_packets = 1;
+  sink->max_batch_bytes = 0;
+  /* Keep live streams with few frames per second from stalling on a batch
+   * that takes long to fill up. */
+  sink->linger_ms = 10;
+  g_mutex_init(&sink->queue_lock);
+  g_cond_init(&sink->queue_cond);
+  sink->send_queue = g_queue_new();
 }
 
 /**
@@ -313,6 +432,49 @@ static void ais_sink_set_property(GObject *object, guint property_id,
     case PROP_TRACE_PROBABILITY:
       sink->trace_probability = g_value_get_double(value);
       break;
+    case PROP_SEND_QUEUE_SIZE:
+      if (sink->ais_sender != NULL) {
+        GST_WARNING_OBJECT(sink,
+                           "Changing the 'send-queue-size' property when the "
+                           "client already connected is not supported");
+        break;
+      }
+      sink->send_queue_size = g_value_get_uint(value);
+      break;
+    case PROP_DROP_POLICY:
+      g_mutex_lock(&sink->queue_lock);
+      sink->drop_policy = g_value_get_enum(value);
+      g_mutex_unlock(&sink->queue_lock);
+      break;
+    case PROP_FLUSH_ON_EOS:
+      g_mutex_lock(&sink->queue_lock);
+      sink->flush_on_eos = g_value_get_boolean(value);
+      g_mutex_unlock(&sink->queue_lock);
+      break;
+    case PROP_STATS_INTERVAL:
+      g_mutex_lock(&sink->queue_lock);
+      sink->stats_interval = g_value_get_uint(value);
+      g_cond_broadcast(&sink->queue_cond);
+      g_mutex_unlock(&sink->queue_lock);
+      break;
+    case PROP_MAX_BATCH_PACKETS:
+    case PROP_MAX_BATCH_BYTES:
+    case PROP_LINGER_MS:
+      if (sink->ais_sender != NULL) {
+        GST_WARNING_OBJECT(sink,
+                           "Changing the '%s' property when the client "
+                           "already connected is not supported",
+                           pspec->name);
+        break;
+      }
+      if (property_id == PROP_MAX_BATCH_PACKETS) {
+        sink->max_batch_packets = g_value_get_uint(value);
+      } else if (property_id == PROP_MAX_BATCH_BYTES) {
+        sink->max_batch_bytes = g_value_get_uint(value);
+      } else {
+        sink->linger_ms = g_value_get_uint(value);
+      }
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
       break;
@@ -345,6 +507,33 @@ static void ais_sink_get_property(GObject *object, guint property_id,
     case PROP_TRACE_PROBABILITY:
       g_value_set_double(value, sink->trace_probability);
       break;
+    case PROP_SEND_QUEUE_SIZE:
+      g_value_set_uint(value, sink->send_queue_size);
+      break;
+    case PROP_DROP_POLICY:
+      g_mutex_lock(&sink->queue_lock);
+      g_value_set_enum(value, sink->drop_policy);
+      g_mutex_unlock(&sink->queue_lock);
+      break;
+    case PROP_FLUSH_ON_EOS:
+      g_mutex_lock(&sink->queue_lock);
+      g_value_set_boolean(value, sink->flush_on_eos);
+      g_mutex_unlock(&sink->queue_lock);
+      break;
+    case PROP_STATS_INTERVAL:
+      g_mutex_lock(&sink->queue_lock);
+      g_value_set_uint(value, sink->stats_interval);
+      g_mutex_unlock(&sink->queue_lock);
+      break;
+    case PROP_MAX_BATCH_PACKETS:
+      g_value_set_uint(value, sink->max_batch_packets);
+      break;
+    case PROP_MAX_BATCH_BYTES:
+      g_value_set_uint(value, sink->max_batch_bytes);
+      break;
+    case PROP_LINGER_MS:
+      g_value_set_uint(value, sink->linger_ms);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
       break;
@@ -362,6 +551,24 @@ void ais_sink_dispose(GObject *object) {
   g_free(sink->ssl_root_cert_path);
 }
 
+static void ais_sink_clear_packet_template(AisSink *sink) {
+  g_free(sink->caps_string);
+  sink->caps_string = NULL;
+  AIS_DeletePacket(sink->packet_template);
+  sink->packet_template = NULL;
+}
+
+void ais_sink_finalize(GObject *object) {
+  AisSink *sink = AIS_SINK(object);
+
+  ais_sink_clear_packet_template(sink);
+  g_queue_free(sink->send_queue);
+  g_cond_clear(&sink->queue_cond);
+  g_mutex_clear(&sink->queue_lock);
+
+  G_OBJECT_CLASS(ais_sink_parent_class)->finalize(object);
+}
+
 static GstCaps *ais_sink_get_caps(GstBaseSink *bsink, GstCaps *filter) {
   AisSink *sink = AIS_SINK(bsink);
 
@@ -377,7 +584,306 @@ static GstCaps *ais_sink_get_caps(GstBaseSink *bsink, GstCaps *filter) {
 }
 
 static gboolean ais_sink_set_caps(GstBaseSink *bsink, GstCaps *caps) {
+  AisSink *sink = AIS_SINK(bsink);
+
+  // Send the packets of the old caps before those of the new ones go out.
+  gchar *caps_string = gst_caps_to_string(caps);
+  if (sink->caps_string != NULL &&
+      g_strcmp0(sink->caps_string, caps_string) != 0) {
+    ais_sink_flush(sink);
+  }
+
+  // Describe the caps once here rather than for every rendered buffer.
+  ais_sink_clear_packet_template(sink);
+  sink->caps_string = caps_string;
+  AIS_Status *ais_status = AIS_NewStatus();
+  sink->packet_template = AIS_NewGstreamerBufferPacketFromBytes(
+      sink->caps_string, "", 0, ais_status);
+  if (sink->packet_template == NULL) {
+    goto failed_new_packet_template;
+  }
+  AIS_DeleteStatus(ais_status);
   return TRUE;
+
+failed_new_packet_template : {
+  GST_ELEMENT_ERROR(sink, STREAM, FAILED, ("%s", AIS_Message(ais_status)),
+                    ("Could not create a packet template for caps %s",
+                     sink->caps_string));
+  AIS_DeleteStatus(ais_status);
+  ais_sink_clear_packet_template(sink);
+  return FALSE;
+}
+}
+
+/* Send queue.
+ *
+ * When send-queue-size is positive, render hands packets to a bounded queue
+ * and a dedicated sender thread sends them to the server. All functions below
+ * named *_locked expect queue_lock to be held.
+ */
+
+static void ais_sink_free_queued_packet(AisSinkQueuedPacket *queued_packet) {
+  AIS_DeletePacket(queued_packet->packet);
+  g_free(queued_packet);
+}
+
+/* Drop every packet in the send queue. */
+static void ais_sink_clear_send_queue_locked(AisSink *sink) {
+  AisSinkQueuedPacket *queued_packet;
+  while ((queued_packet = g_queue_pop_head(sink->send_queue)) != NULL) {
+    ais_sink_free_queued_packet(queued_packet);
+    sink->dropped_packets++;
+  }
+  g_cond_broadcast(&sink->queue_cond);
+}
+
+/* Drop the newest delta frame in the send queue.
+ *
+ * Only key frames are queued after it, so the frames left in the queue stay
+ * decodable. Returns FALSE if there is no delta frame to drop.
+ */
+static gboolean ais_sink_drop_newest_delta_frame_locked(AisSink *sink) {
+  GList *link;
+  for (link = sink->send_queue->tail; link != NULL; link = link->prev) {
+    AisSinkQueuedPacket *queued_packet = link->data;
+    if (!queued_packet->is_key_frame) {
+      ais_sink_free_queued_packet(queued_packet);
+      g_queue_delete_link(sink->send_queue, link);
+      sink->dropped_packets++;
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+/* Create an aissink-stats element message describing the send queue. */
+static GstMessage *ais_sink_new_stats_message_locked(AisSink *sink) {
+  GstStructure *structure = gst_structure_new(
+      "aissink-stats", "queued-packets", G_TYPE_UINT,
+      g_queue_get_length(sink->send_queue), "sent-packets", G_TYPE_UINT64,
+      sink->sent_packets, "dropped-packets", G_TYPE_UINT64,
+      sink->dropped_packets, NULL);
+  return gst_message_new_element(GST_OBJECT(sink), structure);
+}
+
+/* Post stats if they are due, and return the time the next ones are due. */
+static gint64 ais_sink_maybe_post_stats_locked(AisSink *sink,
+                                               gint64 stats_time) {
+  gint64 now = g_get_monotonic_time();
+  if (sink->stats_interval == 0) {
+    return G_MAXINT64;
+  }
+  if (stats_time == G_MAXINT64) {
+    return now + sink->stats_interval * G_TIME_SPAN_MILLISECOND;
+  }
+  if (now < stats_time) {
+    return stats_time;
+  }
+
+  /* Do not hold the lock while the bus dispatches the message. */
+  GstMessage *message = ais_sink_new_stats_message_locked(sink);
+  g_mutex_unlock(&sink->queue_lock);
+  gst_element_post_message(GST_ELEMENT(sink), message);
+  g_mutex_lock(&sink->queue_lock);
+  return now + sink->stats_interval * G_TIME_SPAN_MILLISECOND;
+}
+
+static gpointer ais_sink_sender_loop(gpointer data) {
+  AisSink *sink = AIS_SINK(data);
+  gint64 stats_time = G_MAXINT64;
+
+  g_mutex_lock(&sink->queue_lock);
+  while (TRUE) {
+    stats_time = ais_sink_maybe_post_stats_locked(sink, stats_time);
+    if (g_queue_is_empty(sink->send_queue)) {
+      if (sink->stop_sending) {
+        break;
+      }
+      if (stats_time == G_MAXINT64) {
+        g_cond_wait(&sink->queue_cond, &sink->queue_lock);
+      } else {
+        g_cond_wait_until(&sink->queue_cond, &sink->queue_lock, stats_time);
+      }
+      continue;
+    }
+
+    /* Send the oldest packet without holding the lock. */
+    AisSinkQueuedPacket *queued_packet = g_queue_pop_head(sink->send_queue);
+    sink->is_sending = TRUE;
+    g_cond_broadcast(&sink->queue_cond);
+    g_mutex_unlock(&sink->queue_lock);
+
+    AIS_SendPacket(sink->ais_sender, queued_packet->packet,
+                   sink->ais_send_status);
+    gboolean sent = AIS_GetCode(sink->ais_send_status) == AIS_OK;
+    ais_sink_free_queued_packet(queued_packet);
+    if (!sent) {
+      GST_ELEMENT_WARNING(sink, STREAM, FAILED,
+                          ("%s", AIS_Message(sink->ais_send_status)),
+                          ("%s", AIS_Message(sink->ais_send_status)));
+      AIS_Log(AIS_ERROR, AIS_Message(sink->ais_send_status));
+      AIS_Log(AIS_ERROR,
+              "Please double check the ingress endpoint and stream name you "
+              "provided are valid");
+    }
+
+    g_mutex_lock(&sink->queue_lock);
+    sink->is_sending = FALSE;
+    if (sent) {
+      sink->sent_packets++;
+    } else {
+      sink->send_failed = TRUE;
+      ais_sink_clear_send_queue_locked(sink);
+    }
+    g_cond_broadcast(&sink->queue_cond);
+    if (sink->send_failed) {
+      break;
+    }
+  }
+  g_mutex_unlock(&sink->queue_lock);
+  return NULL;
+}
+
+/* Hand `packet` to the sender thread, applying the drop policy if the send
+ * queue is full. This takes ownership of `packet`.
+ */
+static GstFlowReturn ais_sink_enqueue_packet(AisSink *sink, AIS_Packet *packet,
+                                             gboolean is_key_frame) {
+  GstFlowReturn ret = GST_FLOW_OK;
+  AisSinkQueuedPacket *queued_packet = NULL;
+
+  g_mutex_lock(&sink->queue_lock);
+
+  /* Delta frames cannot be decoded once one of their references is dropped.
+   * Drop them all until the next key frame. */
+  if (sink->awaiting_key_frame && !is_key_frame) {
+    goto drop_packet;
+  }
+  sink->awaiting_key_frame = FALSE;
+
+  while (g_queue_get_length(sink->send_queue) >= sink->send_queue_size) {
+    if (sink->send_failed) {
+      ret = GST_FLOW_ERROR;
+      goto drop_packet;
+    }
+    if (sink->unlocked) {
+      ret = GST_FLOW_FLUSHING;
+      goto drop_packet;
+    }
+    switch (sink->drop_policy) {
+      case AIS_SINK_DROP_POLICY_BLOCK:
+        g_cond_wait(&sink->queue_cond, &sink->queue_lock);
+        break;
+      case AIS_SINK_DROP_POLICY_DROP_OLDEST:
+        ais_sink_free_queued_packet(g_queue_pop_head(sink->send_queue));
+        sink->dropped_packets++;
+        break;
+      case AIS_SINK_DROP_POLICY_DROP_DELTA_FRAMES_FIRST:
+        if (!is_key_frame) {
+          sink->awaiting_key_frame = TRUE;
+          goto drop_packet;
+        }
+        if (!ais_sink_drop_newest_delta_frame_locked(sink)) {
+          ais_sink_free_queued_packet(g_queue_pop_head(sink->send_queue));
+          sink->dropped_packets++;
+        }
+        break;
+    }
+  }
+  if (sink->send_failed) {
+    ret = GST_FLOW_ERROR;
+    goto drop_packet;
+  }
+
+  queued_packet = g_new(AisSinkQueuedPacket, 1);
+  queued_packet->packet = packet;
+  queued_packet->is_key_frame = is_key_frame;
+  g_queue_push_tail(sink->send_queue, queued_packet);
+  g_cond_broadcast(&sink->queue_cond);
+  g_mutex_unlock(&sink->queue_lock);
+  return ret;
+
+drop_packet : {
+  AIS_DeletePacket(packet);
+  sink->dropped_packets++;
+  g_mutex_unlock(&sink->queue_lock);
+  return ret;
+}
+}
+
+/* Block until the sender thread has sent every queued packet. */
+static void ais_sink_drain_send_queue(AisSink *sink) {
+  g_mutex_lock(&sink->queue_lock);
+  while ((!g_queue_is_empty(sink->send_queue) || sink->is_sending) &&
+         !sink->send_failed && !sink->unlocked) {
+    g_cond_wait(&sink->queue_cond, &sink->queue_lock);
+  }
+  g_mutex_unlock(&sink->queue_lock);
+}
+
+/* Sends everything rendered so far: first the send queue, then the batch that
+ * the sender holds back. */
+static void ais_sink_flush(AisSink *sink) {
+  if (sink->ais_sender == NULL) {
+    return;
+  }
+  if (sink->sender_thread != NULL) {
+    ais_sink_drain_send_queue(sink);
+  }
+  AIS_FlushSender(sink->ais_sender, sink->ais_status);
+  if (AIS_GetCode(sink->ais_status) != AIS_OK) {
+    GST_ELEMENT_WARNING(sink, STREAM, FAILED,
+                        ("%s", AIS_Message(sink->ais_status)),
+                        ("Failed to flush the batched packets"));
+  }
+}
+
+static void ais_sink_start_sender(AisSink *sink) {
+  if (sink->send_queue_size == 0) {
+    return;
+  }
+  sink->ais_send_status = AIS_NewStatus();
+  sink->is_sending = FALSE;
+  sink->stop_sending = FALSE;
+  sink->send_failed = FALSE;
+  sink->awaiting_key_frame = FALSE;
+  sink->sent_packets = 0;
+  sink->dropped_packets = 0;
+  sink->sender_thread =
+      g_thread_new("aissink-sender", ais_sink_sender_loop, sink);
+}
+
+/* Stop the sender thread, after it has sent the queued packets if
+ * flush-on-eos is set. */
+static void ais_sink_stop_sender(AisSink *sink) {
+  GstMessage *stats_message = NULL;
+  if (sink->sender_thread == NULL) {
+    return;
+  }
+
+  g_mutex_lock(&sink->queue_lock);
+  sink->stop_sending = TRUE;
+  if (!sink->flush_on_eos) {
+    ais_sink_clear_send_queue_locked(sink);
+  }
+  g_cond_broadcast(&sink->queue_cond);
+  g_mutex_unlock(&sink->queue_lock);
+  g_thread_join(sink->sender_thread);
+  sink->sender_thread = NULL;
+
+  /* Post the final stats. */
+  g_mutex_lock(&sink->queue_lock);
+  ais_sink_clear_send_queue_locked(sink);
+  if (sink->stats_interval > 0) {
+    stats_message = ais_sink_new_stats_message_locked(sink);
+  }
+  g_mutex_unlock(&sink->queue_lock);
+  if (stats_message != NULL) {
+    gst_element_post_message(GST_ELEMENT(sink), stats_message);
+  }
+
+  AIS_DeleteStatus(sink->ais_send_status);
+  sink->ais_send_status = NULL;
 }
 
 static gboolean ais_sink_start(GstBaseSink *bsink) {
@@ -394,12 +900,14 @@ static gboolean ais_sink_start(GstBaseSink *bsink) {
                          sink->ais_connection_options);
 
   sink->ais_status = AIS_NewStatus();
-  sink->ais_sender =
-      AIS_NewSender(sink->ais_connection_options, sink->stream_name,
-                    sink->trace_probability, sink->ais_status);
+  sink->ais_sender = AIS_NewBatchingSender(
+      sink->ais_connection_options, sink->stream_name, sink->trace_probability,
+      sink->max_batch_packets, sink->max_batch_bytes, sink->linger_ms,
+      sink->ais_status);
   if (sink->ais_sender == NULL) {
     goto failed_new_sender;
   }
+  ais_sink_start_sender(sink);
 
   return TRUE;
 
@@ -416,6 +924,9 @@ failed_new_sender : {
 static gboolean ais_sink_stop(GstBaseSink *bsink) {
   AisSink *sink = AIS_SINK(bsink);
 
+  // Let the queued packets go ahead of the EOS packet.
+  ais_sink_stop_sender(sink);
+
   AIS_Packet *packet = AIS_NewEosPacket("Sender sent EOS", sink->ais_status);
   if (AIS_GetCode(sink->ais_status) != AIS_OK) {
     goto failed_eos_send;
@@ -428,8 +939,10 @@ static gboolean ais_sink_stop(GstBaseSink *bsink) {
 done:
   AIS_DeletePacket(packet);
   AIS_DeleteSender(sink->ais_sender);
+  sink->ais_sender = NULL;
   AIS_DeleteStatus(sink->ais_status);
   AIS_DeleteConnectionOptions(sink->ais_connection_options);
+  ais_sink_clear_packet_template(sink);
   return TRUE;
 
 failed_eos_send : {
@@ -446,26 +959,21 @@ static GstFlowReturn ais_sink_render(GstBaseSink *bsink, GstBuffer *buffer) {
   AisSink *sink = AIS_SINK(bsink);
 
   AIS_Packet *packet = NULL;
-  AIS_GstreamerBuffer *ais_gstreamer_buffer = AIS_NewGstreamerBuffer();
 
-  // Set the bytes buffer.
+  if (sink->packet_template == NULL) {
+    goto not_negotiated;
+  }
+
+  // Create the packet from the template for the current caps, copying the
+  // mapped bytes straight into its payload.
   GstMapInfo map;
-  if (gst_buffer_map(buffer, &map, GST_MAP_READ)) {
-    AIS_GstreamerBufferAssign((char *)map.data, map.size, ais_gstreamer_buffer);
-    gst_buffer_unmap(buffer, &map);
-  } else {
+  if (!gst_buffer_map(buffer, &map, GST_MAP_READ)) {
     goto failed_buffer_map;
   }
-
-  // Set the caps string.
-  GstCaps *caps = gst_pad_get_current_caps(bsink->sinkpad);
-  gchar *caps_string = gst_caps_to_string(caps);
-  AIS_GstreamerBufferSetCapsString(caps_string, ais_gstreamer_buffer);
-  g_free(caps_string);
-  gst_caps_unref(caps);
-
-  // Create the packet.
-  packet = AIS_NewGstreamerBufferPacket(ais_gstreamer_buffer, sink->ais_status);
+  packet = AIS_NewPacketFromTemplate(sink->packet_template,
+                                     (const char *)map.data, map.size,
+                                     sink->ais_status);
+  gst_buffer_unmap(buffer, &map);
   if (packet == NULL) {
     goto failed_new_packet;
   }
@@ -480,6 +988,11 @@ static GstFlowReturn ais_sink_render(GstBaseSink *bsink, GstBuffer *buffer) {
   AIS_SetIsKeyFrame(is_key_frame, packet);
   AIS_SetIsFrameHead(1, packet);
 
+  // Hand the packet to the sender thread if there is one.
+  if (sink->sender_thread != NULL) {
+    return ais_sink_enqueue_packet(sink, packet, is_key_frame);
+  }
+
   // Send the packet.
   AIS_SendPacket(sink->ais_sender, packet, sink->ais_status);
   if (AIS_GetCode(sink->ais_status) != AIS_OK) {
@@ -487,10 +1000,15 @@ static GstFlowReturn ais_sink_render(GstBaseSink *bsink, GstBuffer *buffer) {
   }
 
 done:
-  AIS_DeleteGstreamerBuffer(ais_gstreamer_buffer);
   AIS_DeletePacket(packet);
   return GST_FLOW_OK;
 
+not_negotiated : {
+  GST_ELEMENT_ERROR(sink, CORE, NEGOTIATION,
+                    ("Received a buffer before the caps were set"), (NULL));
+  return GST_FLOW_NOT_NEGOTIATED;
+}
+
 failed_buffer_map : {
   GST_ELEMENT_WARNING(sink, STREAM, FAILED,
                       ("Failed to gst_buffer_map the incoming GstBuffer"),
@@ -513,12 +1031,47 @@ failed_send_packet : {
   AIS_Log(AIS_ERROR,
           "Please double check the ingress endpoint and stream name you "
           "provided are valid");
-  AIS_DeleteGstreamerBuffer(ais_gstreamer_buffer);
   AIS_DeletePacket(packet);
   return GST_FLOW_ERROR;
 }
 }
 
+static gboolean ais_sink_event(GstBaseSink *bsink, GstEvent *event) {
+  AisSink *sink = AIS_SINK(bsink);
+  gboolean flush_on_eos;
+
+  // Hold EOS back until the queued and batched packets are sent, so that the
+  // pipeline only reports EOS once everything has reached the server.
+  if (GST_EVENT_TYPE(event) == GST_EVENT_EOS) {
+    g_mutex_lock(&sink->queue_lock);
+    flush_on_eos = sink->flush_on_eos;
+    g_mutex_unlock(&sink->queue_lock);
+    if (flush_on_eos) {
+      ais_sink_flush(sink);
+    }
+  }
+  return GST_BASE_SINK_CLASS(ais_sink_parent_class)->event(bsink, event);
+}
+
+static gboolean ais_sink_unlock(GstBaseSink *bsink) {
+  AisSink *sink = AIS_SINK(bsink);
+
+  g_mutex_lock(&sink->queue_lock);
+  sink->unlocked = TRUE;
+  g_cond_broadcast(&sink->queue_cond);
+  g_mutex_unlock(&sink->queue_lock);
+  return TRUE;
+}
+
+static gboolean ais_sink_unlock_stop(GstBaseSink *bsink) {
+  AisSink *sink = AIS_SINK(bsink);
+
+  g_mutex_lock(&sink->queue_lock);
+  sink->unlocked = FALSE;
+  g_mutex_unlock(&sink->queue_lock);
+  return TRUE;
+}
+
 static gboolean plugin_init(GstPlugin *plugin) {
   return gst_element_register(plugin, "aissink", GST_RANK_NONE, AIS_TYPE_SINK);
 }
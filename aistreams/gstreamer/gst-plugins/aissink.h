@@ -34,6 +34,21 @@ G_BEGIN_DECLS
 typedef struct _AisSink AisSink;
 typedef struct _AisSinkClass AisSinkClass;
 
+/**
+ * AisSinkDropPolicy:
+ * @AIS_SINK_DROP_POLICY_BLOCK: block the streaming thread until there is room.
+ * @AIS_SINK_DROP_POLICY_DROP_OLDEST: drop the oldest queued packet.
+ * @AIS_SINK_DROP_POLICY_DROP_DELTA_FRAMES_FIRST: drop delta frames before key
+ *   frames, in a way that keeps the sent frames decodable.
+ *
+ * What #AisSink does when its send queue is full.
+ */
+typedef enum {
+  AIS_SINK_DROP_POLICY_BLOCK,
+  AIS_SINK_DROP_POLICY_DROP_OLDEST,
+  AIS_SINK_DROP_POLICY_DROP_DELTA_FRAMES_FIRST,
+} AisSinkDropPolicy;
+
 /**
  * AisSink:
  * @target_address: the address to the stream server.
@@ -50,6 +65,13 @@ struct _AisSink {
   gchar *ssl_domain_name;
   gchar *ssl_root_cert_path;
   gdouble trace_probability;
+  guint send_queue_size;
+  AisSinkDropPolicy drop_policy;
+  gboolean flush_on_eos;
+  guint stats_interval;
+  guint max_batch_packets;
+  guint max_batch_bytes;
+  guint linger_ms;
 
   /* An AI Streamer sender object. */
   AIS_Sender *ais_sender;
@@ -59,6 +81,30 @@ struct _AisSink {
 
   /* An AI Streamer status object. */
   AIS_Status *ais_status;
+
+  /* The negotiated caps and a packet whose header is prebuilt for them. Each
+   * rendered buffer is sent in a copy of packet_template's header. Both are
+   * only touched from the streaming thread. */
+  gchar *caps_string;
+  AIS_Packet *packet_template;
+
+  /* The thread that sends queued packets, and its own status object. It only
+   * runs when send_queue_size is positive. */
+  GThread *sender_thread;
+  AIS_Status *ais_send_status;
+
+  /* Everything below is protected by queue_lock. queue_cond is signalled
+   * whenever the send queue changes. */
+  GMutex queue_lock;
+  GCond queue_cond;
+  GQueue *send_queue;
+  gboolean is_sending;
+  gboolean stop_sending;
+  gboolean send_failed;
+  gboolean unlocked;
+  gboolean awaiting_key_frame;
+  guint64 sent_packets;
+  guint64 dropped_packets;
 };
 
 struct _AisSinkClass {
@@ -52,6 +52,7 @@ static void ais_src_get_property(GObject *object, guint property_id,
 static void ais_src_dispose(GObject *object);
 static gboolean ais_src_start(GstBaseSrc *basesrc);
 static gboolean ais_src_stop(GstBaseSrc *basesrc);
+static gboolean ais_src_query(GstBaseSrc *basesrc, GstQuery *query);
 static GstFlowReturn ais_src_create(GstPushSrc *psrc, GstBuffer **outbuf);
 
 /* Codes labelling the properties of the plugin.
@@ -67,8 +68,12 @@ enum {
   PROP_USE_INSECURE_CHANNEL,
   PROP_SSL_DOMAIN_NAME,
   PROP_SSL_ROOT_CERT_PATH,
+  PROP_LIVE_MODE,
+  PROP_LATENCY,
 };
 
+#define DEFAULT_LATENCY_MS 100
+
 /* pad templates */
 
 static GstStaticPadTemplate ais_src_template = GST_STATIC_PAD_TEMPLATE(
@@ -141,6 +146,22 @@ static void ais_src_class_init(AisSrcClass *klass) {
                           "The file path to the root CA certificate", NULL,
                           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property(
+      gobject_class, PROP_LIVE_MODE,
+      g_param_spec_boolean(
+          "live-mode", "Live mode",
+          "Timestamp buffers from the packet headers and skip to the next "
+          "key frame when falling behind",
+          FALSE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property(
+      gobject_class, PROP_LATENCY,
+      g_param_spec_uint("latency", "Latency",
+                        "Milliseconds of delivery jitter to absorb in live "
+                        "mode. Reported as the latency of the source",
+                        0, G_MAXUINT, DEFAULT_LATENCY_MS,
+                        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata(
       gstelement_class, "AI Streamer source", "Generic",
       "Receives packets from an AI Streamer stream server", "Google Inc");
@@ -151,6 +172,7 @@ static void ais_src_class_init(AisSrcClass *klass) {
   gobject_class->dispose = ais_src_dispose;
   gstbasesrc_class->start = GST_DEBUG_FUNCPTR(ais_src_start);
   gstbasesrc_class->stop = GST_DEBUG_FUNCPTR(ais_src_stop);
+  gstbasesrc_class->query = GST_DEBUG_FUNCPTR(ais_src_query);
   gstpushsrc_class->create = GST_DEBUG_FUNCPTR(ais_src_create);
 }
 
@@ -165,6 +187,8 @@ static void ais_src_init(AisSrc *src) {
   src->use_insecure_channel = FALSE;
   src->ssl_domain_name = g_strdup("aistreams.googleapis.com");
   src->ssl_root_cert_path = g_strdup("");
+  src->live_mode = FALSE;
+  src->latency = DEFAULT_LATENCY_MS;
 
   /* we operate in time */
   gst_base_src_set_format(GST_BASE_SRC(src), GST_FORMAT_TIME);
@@ -175,6 +199,8 @@ static void ais_src_init(AisSrc *src) {
    * TODO: could be useful to turn this into an option defaulting to TRUE.
    */
   gst_base_src_set_live(GST_BASE_SRC(src), TRUE);
+
+  /* Outside of live mode, buffers are timestamped on arrival. */
   gst_base_src_set_do_timestamp(GST_BASE_SRC(src), TRUE);
 }
 
@@ -365,6 +391,15 @@ static void ais_src_set_property(GObject *object, guint property_id,
     case PROP_SSL_ROOT_CERT_PATH:
       ais_src_set_ssl_root_cert_path(src, g_value_get_string(value), NULL);
       break;
+    case PROP_LIVE_MODE:
+      src->live_mode = g_value_get_boolean(value);
+      gst_base_src_set_do_timestamp(GST_BASE_SRC(src), !src->live_mode);
+      break;
+    case PROP_LATENCY:
+      src->latency = g_value_get_uint(value);
+      gst_element_post_message(GST_ELEMENT(src),
+                               gst_message_new_latency(GST_OBJECT(src)));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
   }
@@ -399,6 +434,12 @@ static void ais_src_get_property(GObject *object, guint property_id,
     case PROP_SSL_ROOT_CERT_PATH:
       g_value_set_string(value, src->ssl_root_cert_path);
       break;
+    case PROP_LIVE_MODE:
+      g_value_set_boolean(value, src->live_mode);
+      break;
+    case PROP_LATENCY:
+      g_value_set_uint(value, src->latency);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
       break;
@@ -417,20 +458,114 @@ void ais_src_dispose(GObject *object) {
   g_free(src->ssl_root_cert_path);
 }
 
+/* Live mode. */
+
+static GstClockTime ais_src_get_running_time(AisSrc *src) {
+  GstClock *clock = gst_element_get_clock(GST_ELEMENT(src));
+  if (clock == NULL) {
+    return GST_CLOCK_TIME_NONE;
+  }
+  GstClockTime now = gst_clock_get_time(clock);
+  GstClockTime base_time = gst_element_get_base_time(GST_ELEMENT(src));
+  gst_object_unref(clock);
+  return now > base_time ? now - base_time : 0;
+}
+
+/**
+ * ais_src_live_timestamp
+ * @src: (not nullable): ais src object.
+ * @packet_time: the packet timestamp in nanoseconds since the Unix epoch.
+ * @is_key_frame: whether the packet is a key frame.
+ * @pts: (out): the running time at which to present the packet.
+ * @discont: (out): set to TRUE if the timeline restarts at this packet.
+ * Returns: TRUE if the packet should be output, FALSE if it should be skipped.
+ *
+ * Maps packet timestamps onto the running time, so that the sender's pacing
+ * is kept downstream. A packet that could not be rendered within the latency
+ * any more means that the source fell behind; delta frames are then skipped
+ * and the timeline restarts at the next key frame. The timeline also restarts
+ * when the packet timestamps jump back or run ahead of the running time.
+ */
+static gboolean ais_src_live_timestamp(AisSrc *src, gint64 packet_time,
+                                       gboolean is_key_frame,
+                                       GstClockTime *pts, gboolean *discont) {
+  GstClockTime now = ais_src_get_running_time(src);
+  if (!GST_CLOCK_TIME_IS_VALID(now)) {
+    *pts = GST_CLOCK_TIME_NONE;
+    return TRUE;
+  }
+  GstClockTime latency = src->latency * GST_MSECOND;
+
+  if (src->have_time_base && packet_time >= src->packet_time_base) {
+    *pts = src->running_time_base + (packet_time - src->packet_time_base);
+    if (*pts + latency < now) {
+      if (!src->awaiting_key_frame) {
+        GST_DEBUG_OBJECT(src, "Fell behind by %" GST_TIME_FORMAT
+                         "; skipping to the next key frame",
+                         GST_TIME_ARGS(now - *pts));
+      }
+      src->awaiting_key_frame = TRUE;
+    } else if (*pts > now + latency) {
+      src->have_time_base = FALSE;
+    }
+  } else {
+    src->have_time_base = FALSE;
+  }
+
+  if (src->awaiting_key_frame) {
+    if (!is_key_frame) {
+      return FALSE;
+    }
+    src->awaiting_key_frame = FALSE;
+    src->have_time_base = FALSE;
+    *discont = TRUE;
+  }
+
+  if (!src->have_time_base) {
+    src->have_time_base = TRUE;
+    src->packet_time_base = packet_time;
+    src->running_time_base = now;
+    *pts = now;
+  }
+  return TRUE;
+}
+
+static gboolean ais_src_query(GstBaseSrc *bsrc, GstQuery *query) {
+  AisSrc *src = AIS_SRC(bsrc);
+
+  if (GST_QUERY_TYPE(query) == GST_QUERY_LATENCY && src->live_mode) {
+    // Buffers are due when the sender created them, so hold them back by the
+    // jitter buffer. Nothing is buffered here, so there is no upper bound.
+    gst_query_set_latency(query, TRUE, src->latency * GST_MSECOND,
+                          GST_CLOCK_TIME_NONE);
+    return TRUE;
+  }
+  return GST_BASE_SRC_CLASS(ais_src_parent_class)->query(bsrc, query);
+}
+
 static GstFlowReturn ais_src_create(GstPushSrc *psrc, GstBuffer **outbuf) {
   AisSrc *src = AIS_SRC(psrc);
 
   AIS_Packet *ais_packet = NULL;
   AIS_GstreamerBuffer *ais_gstreamer_buffer = NULL;
   GstFlowReturn ret = GST_FLOW_OK;
-
-  ais_packet = AIS_NewPacket(src->ais_status);
-  AIS_ReceivePacket(src->ais_receiver, ais_packet, src->timeout_in_sec,
-                    src->ais_status);
-  if (AIS_GetCode(src->ais_status) != AIS_OK) {
-    ret = GST_FLOW_ERROR;
-    goto failed_receive_packet;
-  }
+  GstClockTime pts = GST_CLOCK_TIME_NONE;
+  gboolean discont = FALSE;
+
+  // In live mode, keep receiving while skipping to the next key frame.
+  do {
+    AIS_DeletePacket(ais_packet);
+    ais_packet = AIS_NewPacket(src->ais_status);
+    AIS_ReceivePacket(src->ais_receiver, ais_packet, src->timeout_in_sec,
+                      src->ais_status);
+    if (AIS_GetCode(src->ais_status) != AIS_OK) {
+      ret = GST_FLOW_ERROR;
+      goto failed_receive_packet;
+    }
+  } while (src->live_mode && !AIS_IsEos(ais_packet, NULL) &&
+           !ais_src_live_timestamp(src, AIS_GetTimestampNanos(ais_packet),
+                                   AIS_IsKeyFrame(ais_packet), &pts,
+                                   &discont));
 
   char *reason;
   if (AIS_IsEos(ais_packet, &reason)) {
@@ -445,30 +580,40 @@ static GstFlowReturn ais_src_create(GstPushSrc *psrc, GstBuffer **outbuf) {
     goto failed_to_gstreamer_buffer;
   }
 
-  // Change the caps to those of the incoming packet if it is different.
+  // Change the caps to those of the incoming packet if they are different.
+  // Comparing against the cached caps string saves parsing the caps of every
+  // packet.
   const char *caps_string =
       AIS_GstreamerBufferGetCapsString(ais_gstreamer_buffer);
-  GstCaps *new_caps = gst_caps_from_string(caps_string);
-  GstCaps *caps = gst_pad_get_current_caps(GST_BASE_SRC(src)->srcpad);
-  if (caps == NULL || gst_caps_is_equal(caps, new_caps) == FALSE) {
+  if (src->caps_string == NULL || strcmp(src->caps_string, caps_string) != 0) {
+    GstCaps *caps = gst_caps_from_string(caps_string);
+    if (caps == NULL) {
+      ret = GST_FLOW_NOT_NEGOTIATED;
+      goto failed_parse_caps;
+    }
     g_print("Setting caps to %s\n", caps_string);
-    gst_base_src_set_caps(GST_BASE_SRC(src), new_caps);
-  }
-  if (caps != NULL) {
+    gst_base_src_set_caps(GST_BASE_SRC(src), caps);
     gst_caps_unref(caps);
+    g_free(src->caps_string);
+    src->caps_string = g_strdup(caps_string);
   }
-  gst_caps_unref(new_caps);
-
-  // Allocate a GstBuffer and copy the packet payload into it.
-  size_t buf_size = AIS_GstreamerBufferSize(ais_gstreamer_buffer);
-  *outbuf = gst_buffer_new_and_alloc(buf_size);
 
-  GstMapInfo map;
-  if (gst_buffer_map(*outbuf, &map, GST_MAP_READWRITE)) {
-    AIS_GstreamerBufferCopyTo(ais_gstreamer_buffer, (char *)map.data);
-    gst_buffer_unmap(*outbuf, &map);
-  } else {
-    goto failed_buffer_map;
+  // Wrap the received payload in the output GstBuffer rather than copying it.
+  // The AIS_GstreamerBuffer holding it is deleted when the memory is freed.
+  gsize buf_size = AIS_GstreamerBufferSize(ais_gstreamer_buffer);
+  *outbuf = gst_buffer_new_wrapped_full(
+      GST_MEMORY_FLAG_READONLY,
+      (gpointer)AIS_GstreamerBufferData(ais_gstreamer_buffer), buf_size, 0,
+      buf_size, ais_gstreamer_buffer,
+      (GDestroyNotify)AIS_DeleteGstreamerBuffer);
+  ais_gstreamer_buffer = NULL;
+
+  if (src->live_mode) {
+    GST_BUFFER_PTS(*outbuf) = pts;
+    GST_BUFFER_DTS(*outbuf) = pts;
+    if (discont) {
+      GST_BUFFER_FLAG_SET(*outbuf, GST_BUFFER_FLAG_DISCONT);
+    }
   }
 
 finalize:
@@ -490,9 +635,10 @@ failed_to_gstreamer_buffer : {
   goto finalize;
 }
 
-failed_buffer_map : {
-  GST_ELEMENT_WARNING(src, STREAM, FAILED,
-                      ("Failed to gst_buffer_map the given GstBuffer"), (NULL));
+failed_parse_caps : {
+  GST_ELEMENT_ERROR(src, CORE, NEGOTIATION,
+                    ("Could not parse the caps of the received packet"),
+                    ("Got caps %s", caps_string));
   goto finalize;
 }
 }
@@ -518,6 +664,10 @@ static gboolean ais_src_start(GstBaseSrc *bsrc) {
     goto failed_new_receiver;
   }
 
+  // Start the live mode timeline at the first key frame.
+  src->have_time_base = FALSE;
+  src->awaiting_key_frame = TRUE;
+
   return TRUE;
 
 failed_new_receiver : {
@@ -535,6 +685,8 @@ static gboolean ais_src_stop(GstBaseSrc *bsrc) {
   AIS_DeleteReceiver(src->ais_receiver);
   AIS_DeleteConnectionOptions(src->ais_connection_options);
   AIS_DeleteStatus(src->ais_status);
+  g_free(src->caps_string);
+  src->caps_string = NULL;
   return TRUE;
 }
 
@@ -72,6 +72,15 @@ struct _AisSrc {
   gchar *ssl_domain_name;
   gchar *ssl_root_cert_path;
 
+  /* Set to true to timestamp buffers from the packet headers rather than on
+   * arrival. Downstream sinks then render each buffer `latency` milliseconds
+   * after the sender created it, which absorbs that much jitter in the
+   * delivery. When packets arrive later than that, the source skips ahead to
+   * the next key frame to catch up.
+   */
+  gboolean live_mode;
+  guint latency;
+
   /* ----- private ----- */
 
   /* An AI Streamer status object. */
@@ -82,6 +91,18 @@ struct _AisSrc {
 
   /* An AI Streamer receiver object. */
   AIS_Receiver *ais_receiver;
+
+  /* The caps string last set on the source pad. Incoming packets are
+   * compared against it so that caps are only parsed when they change. */
+  gchar *caps_string;
+
+  /* The live mode timeline. A packet created at packet_time_base (in
+   * nanoseconds since the Unix epoch) is timestamped with the running time
+   * running_time_base. Delta frames are skipped while awaiting_key_frame. */
+  gboolean have_time_base;
+  gint64 packet_time_base;
+  GstClockTime running_time_base;
+  gboolean awaiting_key_frame;
 };
 
 struct _AisSrcClass {
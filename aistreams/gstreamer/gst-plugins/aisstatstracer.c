@@ -0,0 +1,509 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * SECTION: tracer-aisstats
+ * @title: aisstats
+ *
+ * The aisstats tracer periodically logs where the time goes in a pipeline.
+ * For every element, it logs
+ *
+ * + the rate of the buffers (and bytes) that it receives,
+ * + the time that it takes to process a buffer, excluding the time spent in
+ *   the elements downstream of it on the same thread. For sinks that
+ *   synchronize to the clock, this includes the wait for the clock.
+ * + for queue and queue2, the fill level of the queue.
+ *
+ * The stats cover the period since they were last logged, which is every
+ * second by default, starting with the first buffer pushed. A pipeline that
+ * stalls keeps reporting, without any buffers.
+ *
+ * <refsect2>
+ * <title>Example usage</title>
+ * |[
+ * GST_TRACERS="aisstats(interval-ms=5000)" gst-launch-1.0 videotestsrc !
+ * queue ! x264enc ! aissink target-address=localhost:50053
+ * ]|
+ * </refsect2>
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "aisstatstracer.h"
+#include "aistreams/c/ais_logging.h"
+
+GST_DEBUG_CATEGORY_STATIC(ais_stats_tracer_debug_category);
+#define GST_CAT_DEFAULT ais_stats_tracer_debug_category
+
+#define DEFAULT_INTERVAL_MS 1000
+
+/* The stats of one element over the current reporting period. */
+typedef struct {
+  /* The tracer that reports the stats, or NULL once it is gone. Guarded by
+   * tracer_links_lock. */
+  AisStatsTracer *tracer;
+
+  /* The path of the element in the pipeline. */
+  gchar *name;
+
+  /* Set if the element exposes its fill level, as queue and queue2 do. */
+  gboolean is_queue;
+
+  /* Guards the fields below. */
+  GMutex lock;
+
+  guint64 buffers;
+  guint64 bytes;
+
+  guint64 processed;
+  GstClockTime processing_time;
+  GstClockTime max_processing_time;
+
+  guint queue_level_buffers;
+  guint max_queue_level_buffers;
+  guint64 queue_level_time;
+  guint64 max_queue_level_time;
+} AisStatsTracerElementStats;
+
+/* A push in progress on the current thread. Pushes nest when an element
+ * pushes from within its chain function. */
+typedef struct {
+  /* The stats of the element that the buffers are pushed to, or NULL if it
+   * is a bin, which only forwards them. */
+  AisStatsTracerElementStats *stats;
+
+  GstClockTime start;
+
+  /* The time spent in the pushes nested in this one. */
+  GstClockTime nested_time;
+} AisStatsTracerPush;
+
+/* The pushes in progress on each thread, innermost last. */
+static GPrivate thread_pushes = G_PRIVATE_INIT((GDestroyNotify)g_array_unref);
+
+/* Attaches the AisStatsTracerElementStats to their element. */
+static GQuark element_stats_quark;
+
+/* Guards the links from the element stats to their tracer, which may be
+ * finalized before the elements. Only taken as elements and tracers go away,
+ * and before the lock of a tracer. */
+static GMutex tracer_links_lock;
+
+/* class initialization */
+
+G_DEFINE_TYPE_WITH_CODE(
+    AisStatsTracer, ais_stats_tracer, GST_TYPE_TRACER,
+    GST_DEBUG_CATEGORY_INIT(ais_stats_tracer_debug_category, "aisstats", 0,
+                            "debug category for the aisstats tracer"));
+
+static GArray *ais_stats_tracer_get_thread_pushes(void) {
+  GArray *pushes = (GArray *)g_private_get(&thread_pushes);
+  if (pushes == NULL) {
+    pushes = g_array_new(FALSE, FALSE, sizeof(AisStatsTracerPush));
+    g_private_set(&thread_pushes, pushes);
+  }
+  return pushes;
+}
+
+static void ais_stats_tracer_free_element_stats(
+    AisStatsTracerElementStats *stats) {
+  g_mutex_lock(&tracer_links_lock);
+  AisStatsTracer *self = stats->tracer;
+  if (self != NULL) {
+    g_mutex_lock(&self->lock);
+    self->element_stats = g_list_remove(self->element_stats, stats);
+    g_mutex_unlock(&self->lock);
+  }
+  g_mutex_unlock(&tracer_links_lock);
+  g_mutex_clear(&stats->lock);
+  g_free(stats->name);
+  g_free(stats);
+}
+
+/**
+ * ais_stats_tracer_get_element_stats
+ * @self: (not nullable): ais stats tracer object.
+ * @parent: (nullable): the parent of a pad.
+ * Returns: the stats of @parent if it is an element other than a bin, and
+ * NULL otherwise.
+ */
+static AisStatsTracerElementStats *ais_stats_tracer_get_element_stats(
+    AisStatsTracer *self, GstObject *parent) {
+  if (parent == NULL || !GST_IS_ELEMENT(parent) || GST_IS_BIN(parent)) {
+    return NULL;
+  }
+
+  AisStatsTracerElementStats *stats = (AisStatsTracerElementStats *)
+      g_object_get_qdata(G_OBJECT(parent), element_stats_quark);
+  if (stats != NULL) {
+    return stats;
+  }
+
+  gchar *name = gst_object_get_path_string(parent);
+  g_mutex_lock(&self->lock);
+  stats = (AisStatsTracerElementStats *)g_object_get_qdata(
+      G_OBJECT(parent), element_stats_quark);
+  if (stats == NULL) {
+    stats = g_new0(AisStatsTracerElementStats, 1);
+    stats->tracer = self;
+    g_mutex_init(&stats->lock);
+    stats->name = name;
+    name = NULL;
+    GObjectClass *klass = G_OBJECT_GET_CLASS(parent);
+    stats->is_queue =
+        g_object_class_find_property(klass, "current-level-buffers") != NULL &&
+        g_object_class_find_property(klass, "current-level-time") != NULL;
+    self->element_stats = g_list_prepend(self->element_stats, stats);
+    g_object_set_qdata_full(
+        G_OBJECT(parent), element_stats_quark, stats,
+        (GDestroyNotify)ais_stats_tracer_free_element_stats);
+  }
+  g_mutex_unlock(&self->lock);
+  g_free(name);
+  return stats;
+}
+
+/**
+ * ais_stats_tracer_report
+ * @self: (not nullable): ais stats tracer object, with its lock held.
+ * @ts: the tracer time at which the current period ends.
+ *
+ * Logs the stats of the period that ends at @ts and starts a new one.
+ */
+static void ais_stats_tracer_report(AisStatsTracer *self, GstClockTime ts) {
+  gdouble seconds = (gdouble)(ts - self->period_start) / GST_SECOND;
+  GString *line = g_string_new(NULL);
+  gboolean has_buffers = FALSE;
+
+  for (GList *l = self->element_stats; l != NULL; l = l->next) {
+    AisStatsTracerElementStats *stats = (AisStatsTracerElementStats *)l->data;
+    g_mutex_lock(&stats->lock);
+    has_buffers = has_buffers || stats->buffers > 0;
+    if (stats->buffers == 0 && !stats->is_queue) {
+      g_mutex_unlock(&stats->lock);
+      continue;
+    }
+
+    g_string_printf(line, "aisstats: %s: %.1f buffers/s, %.1f KiB/s",
+                    stats->name, stats->buffers / seconds,
+                    stats->bytes / 1024.0 / seconds);
+    if (stats->processed > 0) {
+      g_string_append_printf(
+          line, ", processing time %.3f ms (max %.3f ms)",
+          (gdouble)stats->processing_time / stats->processed / GST_MSECOND,
+          (gdouble)stats->max_processing_time / GST_MSECOND);
+    }
+    if (stats->is_queue) {
+      g_string_append_printf(
+          line, ", queue level %u buffers (max %u), %.1f ms (max %.1f ms)",
+          stats->queue_level_buffers, stats->max_queue_level_buffers,
+          (gdouble)stats->queue_level_time / GST_MSECOND,
+          (gdouble)stats->max_queue_level_time / GST_MSECOND);
+    }
+
+    stats->buffers = 0;
+    stats->bytes = 0;
+    stats->processed = 0;
+    stats->processing_time = 0;
+    stats->max_processing_time = 0;
+    stats->max_queue_level_buffers = stats->queue_level_buffers;
+    stats->max_queue_level_time = stats->queue_level_time;
+    g_mutex_unlock(&stats->lock);
+    AIS_Log(AIS_INFO, line->str);
+  }
+
+  if (!has_buffers) {
+    g_string_printf(line, "aisstats: no buffers were pushed for %.1f s",
+                    seconds);
+    AIS_Log(AIS_WARNING, line->str);
+  }
+
+  g_string_free(line, TRUE);
+  self->period_start = ts;
+}
+
+/**
+ * ais_stats_tracer_report_loop
+ * @data: (not nullable): ais stats tracer object.
+ *
+ * Reports the stats at the end of every period, until the tracer stops.
+ */
+static gpointer ais_stats_tracer_report_loop(gpointer data) {
+  AisStatsTracer *self = AIS_STATS_TRACER(data);
+
+  g_mutex_lock(&self->lock);
+  while (!self->is_stopping) {
+    if (self->period_start == GST_CLOCK_TIME_NONE) {
+      g_cond_wait(&self->cond, &self->lock);
+      continue;
+    }
+    GstClockTime now = gst_util_get_timestamp();
+    GstClockTime period_end =
+        self->period_start + self->interval_ms * GST_MSECOND;
+    if (now >= period_end) {
+      ais_stats_tracer_report(self, now);
+      continue;
+    }
+    g_cond_wait_until(&self->cond, &self->lock,
+                      g_get_monotonic_time() +
+                          GST_TIME_AS_USECONDS(period_end - now) + 1);
+  }
+  g_mutex_unlock(&self->lock);
+  return NULL;
+}
+
+/**
+ * ais_stats_tracer_start_period
+ * @self: (not nullable): ais stats tracer object.
+ * @ts: the tracer time of the first push.
+ *
+ * Starts the first reporting period.
+ */
+static void ais_stats_tracer_start_period(AisStatsTracer *self,
+                                          GstClockTime ts) {
+  g_mutex_lock(&self->lock);
+  if (self->period_start == GST_CLOCK_TIME_NONE) {
+    self->period_start = ts;
+    g_cond_signal(&self->cond);
+  }
+  g_mutex_unlock(&self->lock);
+  g_atomic_int_set(&self->is_started, TRUE);
+}
+
+/**
+ * ais_stats_tracer_push_pre
+ * @self: (not nullable): ais stats tracer object.
+ * @ts: the tracer time at which the push starts.
+ * @pad: (not nullable): the pad pushing.
+ * @buffers: the number of buffers pushed.
+ * @bytes: the size of the buffers pushed.
+ */
+static void ais_stats_tracer_push_pre(AisStatsTracer *self, GstClockTime ts,
+                                      GstPad *pad, guint buffers,
+                                      gsize bytes) {
+  AisStatsTracerElementStats *src_stats =
+      ais_stats_tracer_get_element_stats(self, GST_OBJECT_PARENT(pad));
+  GstPad *peer = GST_PAD_PEER(pad);
+  AisStatsTracerElementStats *sink_stats =
+      peer != NULL
+          ? ais_stats_tracer_get_element_stats(self, GST_OBJECT_PARENT(peer))
+          : NULL;
+
+  // A queue pushes from its own thread, with its lock released, so it can be
+  // asked for its level here.
+  guint queue_level_buffers = 0;
+  guint64 queue_level_time = 0;
+  if (src_stats != NULL && src_stats->is_queue) {
+    g_object_get(GST_OBJECT_PARENT(pad), "current-level-buffers",
+                 &queue_level_buffers, "current-level-time", &queue_level_time,
+                 NULL);
+    g_mutex_lock(&src_stats->lock);
+    src_stats->queue_level_buffers = queue_level_buffers;
+    src_stats->max_queue_level_buffers =
+        MAX(src_stats->max_queue_level_buffers, queue_level_buffers);
+    src_stats->queue_level_time = queue_level_time;
+    src_stats->max_queue_level_time =
+        MAX(src_stats->max_queue_level_time, queue_level_time);
+    g_mutex_unlock(&src_stats->lock);
+  }
+  if (sink_stats != NULL) {
+    g_mutex_lock(&sink_stats->lock);
+    sink_stats->buffers += buffers;
+    sink_stats->bytes += bytes;
+    g_mutex_unlock(&sink_stats->lock);
+  }
+  if (!g_atomic_int_get(&self->is_started)) {
+    ais_stats_tracer_start_period(self, ts);
+  }
+
+  AisStatsTracerPush push = {sink_stats, ts, 0};
+  g_array_append_val(ais_stats_tracer_get_thread_pushes(), push);
+}
+
+/**
+ * ais_stats_tracer_push_post
+ * @self: (not nullable): ais stats tracer object.
+ * @ts: the tracer time at which the push returned.
+ *
+ * Charges the time spent in the push, less that of the pushes nested in it,
+ * to the element pushed to.
+ */
+static void ais_stats_tracer_push_post(AisStatsTracer *self, GstClockTime ts) {
+  GArray *pushes = ais_stats_tracer_get_thread_pushes();
+  if (pushes->len == 0) {
+    return;
+  }
+  AisStatsTracerPush push =
+      g_array_index(pushes, AisStatsTracerPush, pushes->len - 1);
+  g_array_set_size(pushes, pushes->len - 1);
+
+  GstClockTime elapsed = ts > push.start ? ts - push.start : 0;
+  if (pushes->len > 0) {
+    g_array_index(pushes, AisStatsTracerPush, pushes->len - 1).nested_time +=
+        elapsed;
+  }
+  if (push.stats == NULL) {
+    return;
+  }
+
+  GstClockTime processing_time =
+      elapsed > push.nested_time ? elapsed - push.nested_time : 0;
+  g_mutex_lock(&push.stats->lock);
+  push.stats->processed++;
+  push.stats->processing_time += processing_time;
+  push.stats->max_processing_time =
+      MAX(push.stats->max_processing_time, processing_time);
+  g_mutex_unlock(&push.stats->lock);
+}
+
+/* hooks */
+
+static void do_push_buffer_pre(AisStatsTracer *self, GstClockTime ts,
+                               GstPad *pad, GstBuffer *buffer) {
+  ais_stats_tracer_push_pre(self, ts, pad, 1, gst_buffer_get_size(buffer));
+}
+
+static void do_push_buffer_list_pre(AisStatsTracer *self, GstClockTime ts,
+                                    GstPad *pad, GstBufferList *list) {
+  ais_stats_tracer_push_pre(self, ts, pad, gst_buffer_list_length(list),
+                            gst_buffer_list_calculate_size(list));
+}
+
+static void do_push_buffer_post(AisStatsTracer *self, GstClockTime ts,
+                                GstPad *pad, GstFlowReturn res) {
+  ais_stats_tracer_push_post(self, ts);
+}
+
+/* object initialization */
+
+/**
+ * ais_stats_tracer_parse_params
+ * @self: (not nullable): ais stats tracer object.
+ * @params: (not nullable): the parameters of the tracer.
+ *
+ * The parameters are given as in GST_TRACERS="aisstats(interval-ms=5000)".
+ */
+static void ais_stats_tracer_parse_params(AisStatsTracer *self,
+                                          const gchar *params) {
+  gchar *structure_string = g_strdup_printf("params,%s", params);
+  GstStructure *structure = gst_structure_from_string(structure_string, NULL);
+  gint interval_ms;
+  if (structure != NULL &&
+      gst_structure_get_int(structure, "interval-ms", &interval_ms) &&
+      interval_ms > 0) {
+    self->interval_ms = interval_ms;
+  } else {
+    GST_WARNING_OBJECT(self, "Ignoring the parameters %s", params);
+  }
+  if (structure != NULL) {
+    gst_structure_free(structure);
+  }
+  g_free(structure_string);
+}
+
+static void ais_stats_tracer_constructed(GObject *object) {
+  AisStatsTracer *self = AIS_STATS_TRACER(object);
+
+  G_OBJECT_CLASS(ais_stats_tracer_parent_class)->constructed(object);
+
+  gchar *params = NULL;
+  g_object_get(self, "params", &params, NULL);
+  if (params != NULL) {
+    ais_stats_tracer_parse_params(self, params);
+    g_free(params);
+  }
+
+  self->report_thread =
+      g_thread_new("aisstats", ais_stats_tracer_report_loop, self);
+}
+
+static void ais_stats_tracer_finalize(GObject *object) {
+  AisStatsTracer *self = AIS_STATS_TRACER(object);
+
+  if (self->report_thread != NULL) {
+    g_mutex_lock(&self->lock);
+    self->is_stopping = TRUE;
+    g_cond_signal(&self->cond);
+    g_mutex_unlock(&self->lock);
+    g_thread_join(self->report_thread);
+    self->report_thread = NULL;
+  }
+
+  // The stats live on with their elements, which must not report back.
+  g_mutex_lock(&tracer_links_lock);
+  g_mutex_lock(&self->lock);
+  for (GList *l = self->element_stats; l != NULL; l = l->next) {
+    ((AisStatsTracerElementStats *)l->data)->tracer = NULL;
+  }
+  g_list_free(self->element_stats);
+  self->element_stats = NULL;
+  g_mutex_unlock(&self->lock);
+  g_mutex_unlock(&tracer_links_lock);
+  g_cond_clear(&self->cond);
+  g_mutex_clear(&self->lock);
+
+  G_OBJECT_CLASS(ais_stats_tracer_parent_class)->finalize(object);
+}
+
+static void ais_stats_tracer_class_init(AisStatsTracerClass *klass) {
+  GObjectClass *gobject_class = G_OBJECT_CLASS(klass);
+
+  gobject_class->constructed = ais_stats_tracer_constructed;
+  gobject_class->finalize = ais_stats_tracer_finalize;
+}
+
+static void ais_stats_tracer_init(AisStatsTracer *self) {
+  GstTracer *tracer = GST_TRACER(self);
+
+  self->interval_ms = DEFAULT_INTERVAL_MS;
+  g_mutex_init(&self->lock);
+  g_cond_init(&self->cond);
+  self->period_start = GST_CLOCK_TIME_NONE;
+
+  gst_tracing_register_hook(tracer, "pad-push-pre",
+                            G_CALLBACK(do_push_buffer_pre));
+  gst_tracing_register_hook(tracer, "pad-push-post",
+                            G_CALLBACK(do_push_buffer_post));
+  gst_tracing_register_hook(tracer, "pad-push-list-pre",
+                            G_CALLBACK(do_push_buffer_list_pre));
+  gst_tracing_register_hook(tracer, "pad-push-list-post",
+                            G_CALLBACK(do_push_buffer_post));
+}
+
+static gboolean plugin_init(GstPlugin *plugin) {
+  element_stats_quark =
+      g_quark_from_static_string("ais-stats-tracer-element-stats");
+  return gst_tracer_register(plugin, "aisstats", AIS_TYPE_STATS_TRACER);
+}
+
+#ifndef VERSION
+#define VERSION "0.0.1"
+#endif
+#ifndef PACKAGE
+#define PACKAGE "ais_package"
+#endif
+#ifndef PACKAGE_NAME
+#define PACKAGE_NAME "GStreamer"
+#endif
+#ifndef GST_PACKAGE_ORIGIN
+#define GST_PACKAGE_ORIGIN "https://gstreamer.freedesktop.org/"
+#endif
+
+GST_PLUGIN_DEFINE(GST_VERSION_MAJOR, GST_VERSION_MINOR, aisstatstracer,
+                  "AI Streams pipeline stats tracer", plugin_init, VERSION,
+                  "Proprietary", PACKAGE_NAME, GST_PACKAGE_ORIGIN)
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AIS_STATS_TRACER_H_
+#define AIS_STATS_TRACER_H_
+
+#include <gst/gst.h>
+#include <gst/gsttracer.h>
+
+G_BEGIN_DECLS
+
+#define AIS_TYPE_STATS_TRACER (ais_stats_tracer_get_type())
+#define AIS_STATS_TRACER(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj), AIS_TYPE_STATS_TRACER, AisStatsTracer))
+#define AIS_STATS_TRACER_CLASS(klass)                       \
+  (G_TYPE_CHECK_CLASS_CAST((klass), AIS_TYPE_STATS_TRACER, \
+                           AisStatsTracerClass))
+#define AIS_IS_STATS_TRACER(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj), AIS_TYPE_STATS_TRACER))
+#define AIS_IS_STATS_TRACER_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE((klass), AIS_TYPE_STATS_TRACER))
+
+typedef struct _AisStatsTracer AisStatsTracer;
+typedef struct _AisStatsTracerClass AisStatsTracerClass;
+
+/**
+ * AisStatsTracer:
+ *
+ * The data associated with each #AisStatsTracer object.
+ */
+struct _AisStatsTracer {
+  GstTracer tracer;
+
+  /* The period (in milliseconds) at which the stats are logged. */
+  guint interval_ms;
+
+  /* ----- private ----- */
+
+  /* Guards the fields below. The stats of each element have their own lock,
+   * so that the streaming threads do not contend for this one. */
+  GMutex lock;
+
+  /* Signals the report thread to recheck the fields below. */
+  GCond cond;
+
+  /* The stats of the elements that have seen a buffer, as
+   * AisStatsTracerElementStats. Each is freed along with its element. */
+  GList *element_stats;
+
+  /* The tracer time at which the current reporting period started, or
+   * GST_CLOCK_TIME_NONE until the first buffer is pushed. */
+  GstClockTime period_start;
+
+  /* Set (atomically) once period_start is. */
+  gint is_started;
+
+  /* Logs the stats every interval, even when no buffers flow. */
+  GThread *report_thread;
+  gboolean is_stopping;
+};
+
+struct _AisStatsTracerClass {
+  GstTracerClass parent_class;
+};
+
+GType ais_stats_tracer_get_type(void);
+
+G_END_DECLS
+
+#endif
@@ -61,6 +61,15 @@ Status AissinkCliBuilder::ValidateSettings() const {
   if (trace_probability_ < 0 || trace_probability_ > 1) {
     return InvalidArgumentError("Given an invalid trace probability.");
   }
+  if (send_queue_size_ < 0) {
+    return InvalidArgumentError("Given a negative send queue size.");
+  }
+  if (max_batch_packets_ <= 0) {
+    return InvalidArgumentError("Given a non-positive maximum batch size.");
+  }
+  if (max_batch_bytes_ < 0 || linger_ms_ < 0) {
+    return InvalidArgumentError("Given a negative batch byte limit or linger.");
+  }
   return OkStatus();
 }
 
@@ -78,6 +87,17 @@ StatusOr<std::string> AissinkCliBuilder::Finalize() const {
   tokens.push_back(SetPluginParam("ssl-root-cert-path", ssl_root_cert_path_));
   tokens.push_back(
       SetPluginParam("trace-probability", ToString(trace_probability_)));
+  if (send_queue_size_ > 0) {
+    tokens.push_back(
+        SetPluginParam("send-queue-size", std::to_string(send_queue_size_)));
+  }
+  if (max_batch_packets_ > 1) {
+    tokens.push_back(SetPluginParam("max-batch-packets",
+                                    std::to_string(max_batch_packets_)));
+    tokens.push_back(
+        SetPluginParam("max-batch-bytes", std::to_string(max_batch_bytes_)));
+    tokens.push_back(SetPluginParam("linger-ms", std::to_string(linger_ms_)));
+  }
   return absl::StrJoin(tokens, " ");
 }
 
@@ -61,6 +61,24 @@ class AissinkCliBuilder {
     return *this;
   }
 
+  // Send packets from a dedicated thread through a queue of this size, so
+  // that a slow connection does not stall the pipeline. 0 sends them on the
+  // streaming thread.
+  AissinkCliBuilder& SetSendQueueSize(int send_queue_size) {
+    send_queue_size_ = send_queue_size;
+    return *this;
+  }
+
+  // Send packets in batches of up to `max_batch_packets` packets or
+  // `max_batch_bytes` bytes, holding each back for at most `linger_ms`.
+  AissinkCliBuilder& SetBatching(int max_batch_packets, int max_batch_bytes,
+                                 int linger_ms) {
+    max_batch_packets_ = max_batch_packets;
+    max_batch_bytes_ = max_batch_bytes;
+    linger_ms_ = linger_ms;
+    return *this;
+  }
+
   // On success, returns the gstreamer commandline configuration string.
   StatusOr<std::string> Finalize() const;
 
@@ -76,6 +94,10 @@ class AissinkCliBuilder {
   std::string ssl_root_cert_path_;
 
   double trace_probability_ = 0;
+  int send_queue_size_ = 0;
+  int max_batch_packets_ = 1;
+  int max_batch_bytes_ = 0;
+  int linger_ms_ = 0;
 };
 
 }  // namespace aistreams
@@ -56,6 +56,9 @@ Status AissrcCliBuilder::ValidateSettings() const {
       return InvalidArgumentError("Given an empty path to the ssl root cert");
     }
   }
+  if (latency_in_ms_ < 0) {
+    return InvalidArgumentError("Given a negative latency");
+  }
   return OkStatus();
 }
 
@@ -73,6 +76,10 @@ StatusOr<std::string> AissrcCliBuilder::Finalize() const {
   tokens.push_back(SetPluginParam("ssl-root-cert-path", ssl_root_cert_path_));
   tokens.push_back(
       SetPluginParam("timeout-in-sec", std::to_string(timeout_in_sec_)));
+  if (live_mode_) {
+    tokens.push_back(SetPluginParam("live-mode", ToString(live_mode_)));
+    tokens.push_back(SetPluginParam("latency", std::to_string(latency_in_ms_)));
+  }
   return absl::StrJoin(tokens, " ");
 }
 
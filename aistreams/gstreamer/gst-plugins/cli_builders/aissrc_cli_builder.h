@@ -61,6 +61,14 @@ class AissrcCliBuilder {
     return *this;
   }
 
+  // Timestamp buffers from the packet headers, absorbing up to
+  // `latency_in_ms` of delivery jitter. See the live-mode property of aissrc.
+  AissrcCliBuilder& SetLiveMode(bool live_mode, int latency_in_ms) {
+    live_mode_ = live_mode;
+    latency_in_ms_ = latency_in_ms;
+    return *this;
+  }
+
   // On success, returns the gstreamer commandline configuration string.
   StatusOr<std::string> Finalize() const;
 
@@ -75,6 +83,9 @@ class AissrcCliBuilder {
   int timeout_in_sec_;
   std::string ssl_domain_name_;
   std::string ssl_root_cert_path_;
+
+  bool live_mode_ = false;
+  int latency_in_ms_ = 100;
 };
 
 }  // namespace aistreams
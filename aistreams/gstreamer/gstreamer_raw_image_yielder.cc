@@ -53,15 +53,28 @@ GstreamerRawImageYielder::Create(const Options& options) {
 }
 
 Status GstreamerRawImageYielder::Initialize() {
+  if (options_.callback && options_.callback_with_pts) {
+    return InvalidArgumentError(
+        "Given both a callback and a callback with PTS; set at most one");
+  }
+  if (options_.callback) {
+    options_.callback_with_pts = [callback = options_.callback](
+                                     StatusOr<RawImage> raw_image_statusor,
+                                     int64_t pts) {
+      return callback(std::move(raw_image_statusor));
+    };
+  }
+
   // Create a GstreamerRunner with a generic decoding pipeline.
   GstreamerRunner::Options gstreamer_runner_options;
   gstreamer_runner_options.appsrc_caps_string = options_.caps_string;
   gstreamer_runner_options.processing_pipeline_string = kGenericDecodeString;
-  if (options_.callback) {
+  if (options_.callback_with_pts) {
     gstreamer_runner_options.receiver_callback =
         [this](GstreamerBuffer gstreamer_buffer) -> Status {
+      int64_t pts = gstreamer_buffer.pts();
       auto raw_image_status_or = ToRawImage(std::move(gstreamer_buffer));
-      options_.callback(std::move(raw_image_status_or));
+      options_.callback_with_pts(std::move(raw_image_status_or), pts);
       return OkStatus();
     };
   }
@@ -84,13 +97,20 @@ Status GstreamerRawImageYielder::Feed(const GstreamerBuffer& gstreamer_buffer) {
   return gstreamer_runner_->Feed(gstreamer_buffer);
 }
 
+Status GstreamerRawImageYielder::Feed(GstreamerBuffer&& gstreamer_buffer) {
+  if (eos_signaled_) {
+    return FailedPreconditionError("Cannot feed after EOS is signaled");
+  }
+  return gstreamer_runner_->Feed(std::move(gstreamer_buffer));
+}
+
 Status GstreamerRawImageYielder::SignalEOS() {
   eos_signaled_ = true;
   gstreamer_runner_.reset(nullptr);
 
   // Deliver EOS. Ignore any callback errors.
-  if (options_.callback) {
-    auto status = options_.callback(EOSStatus());
+  if (options_.callback_with_pts) {
+    auto status = options_.callback_with_pts(EOSStatus(), -1);
     if (!status.ok()) {
       LOG(ERROR) << status;
     }
@@ -17,6 +17,7 @@
 #ifndef AISTREAMS_GSTREAMER_GSTREAMER_RAW_IMAGE_YIELDER_H_
 #define AISTREAMS_GSTREAMER_GSTREAMER_RAW_IMAGE_YIELDER_H_
 
+#include <cstdint>
 #include <functional>
 #include <memory>
 
@@ -43,6 +44,10 @@ class GstreamerRawImageYielder {
   //
   // `caps_string`: indicates the caps of all fed GstreamerBuffers.
   // `callback`: will be called as soon as a new RawImage is available.
+  // `callback_with_pts`: same as `callback`, but is also given the PTS in
+  //                      nanoseconds of the fed GstreamerBuffer that the
+  //                      RawImage was decoded from (negative if unknown). Set
+  //                      at most one of the two callbacks.
   //
   // The argument passed to the callback can contain a RawImage when no special
   // conditions or errors have been encountered upstream or during decoding.
@@ -50,9 +55,11 @@ class GstreamerRawImageYielder {
   // `kNotFound`: This indicates that EOS (end-of-stream) is
   //                       reached. You should quit gracefully.
   using Callback = std::function<Status(StatusOr<RawImage>)>;
+  using CallbackWithPts = std::function<Status(StatusOr<RawImage>, int64_t)>;
   struct Options {
     std::string caps_string;
     Callback callback;
+    CallbackWithPts callback_with_pts;
   };
 
   // Create an instance in a fully initialized state.
@@ -62,6 +69,9 @@ class GstreamerRawImageYielder {
   // Feed a GstreamerBuffer into the yielder for processing.
   Status Feed(const GstreamerBuffer&);
 
+  // Same as above, but moves the GstreamerBuffer in to avoid copying its bytes.
+  Status Feed(GstreamerBuffer&&);
+
   // Signal that no more inputs are to be fed.
   //
   // You may do this yourself if you want your subscribers to be notified
@@ -15,15 +15,25 @@
 #include "aistreams/gstreamer/gstreamer_runner.h"
 
 #include <gst/app/gstappsink.h>
+#include <gst/app/gstappsrc.h>
 #include <gst/gst.h>
 
 #include <algorithm>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <set>
+#include <string>
 #include <thread>
 #include <utility>
+#include <vector>
 
+#include "absl/strings/ascii.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
 #include "aistreams/gstreamer/gstreamer_utils.h"
 #include "aistreams/port/canonical_errors.h"
 #include "aistreams/port/logging.h"
@@ -37,46 +47,85 @@ namespace {
 
 constexpr char kAppSrcName[] = "feed";
 constexpr char kAppSinkName[] = "fetch";
+constexpr char kTeeName[] = "ais_tee";
 constexpr int kPipelineFinishTimeoutSeconds = 5;
+constexpr int kAppSinkPullTimeoutMs = 100;
+constexpr int kAppSrcBlockPollPeriodMs = 100;
 
-// RAII object that grants a *running* glib main loop.
+// GDestroyNotify for the std::string that backs a wrapped GstBuffer.
+void DeleteString(gpointer data) { delete static_cast<std::string*>(data); }
+
+// Process-wide glib main loop that dispatches the bus messages of all runners.
 //
-// The event loop is run in a background thread. Gstreamer's Bus mechanism works
-// as long as there is some glib main loop running; i.e. it needn't be in the
-// main thread.
-class GMainLoopManager {
+// The loop iterates its own GMainContext in a single background thread that
+// is started on first use and lives for the rest of the process. Gstreamer's
+// Bus mechanism works as long as some glib main loop is running the context
+// that the bus watch is attached to; i.e. it needn't be in the main thread nor
+// be dedicated to a single pipeline.
+class SharedGMainLoop {
  public:
-  GMainLoopManager() {
-    glib_main_loop_ = g_main_loop_new(NULL, FALSE);
-    glib_main_loop_runner_ =
-        std::thread([this]() { g_main_loop_run(glib_main_loop_); });
-    while (g_main_loop_is_running(glib_main_loop_) != TRUE)
-      ;
+  static SharedGMainLoop* Get() {
+    static SharedGMainLoop* shared_main_loop = new SharedGMainLoop();
+    return shared_main_loop;
   }
 
-  ~GMainLoopManager() {
-    g_main_loop_quit(glib_main_loop_);
-    glib_main_loop_runner_.join();
-    g_main_loop_unref(glib_main_loop_);
-  }
+  GMainContext* context() const { return glib_main_context_; }
 
-  GMainLoopManager(const GMainLoopManager&) = delete;
-  GMainLoopManager(GMainLoopManager&&) = delete;
-  GMainLoopManager& operator=(const GMainLoopManager&) = delete;
+  SharedGMainLoop(const SharedGMainLoop&) = delete;
+  SharedGMainLoop& operator=(const SharedGMainLoop&) = delete;
 
  private:
+  SharedGMainLoop() {
+    glib_main_context_ = g_main_context_new();
+    glib_main_loop_ = g_main_loop_new(glib_main_context_, FALSE);
+    std::thread glib_main_loop_runner(
+        [this]() { g_main_loop_run(glib_main_loop_); });
+    glib_main_loop_runner.detach();
+  }
+
+  GMainContext* glib_main_context_ = nullptr;
   GMainLoop* glib_main_loop_ = nullptr;
-  std::thread glib_main_loop_runner_;
+};
+
+// Ends a CompletionSignal once the pipeline has posted EOS and every appsink
+// reader has delivered its last sample, so that no result is delivered after
+// the runner reports completion.
+class EosBarrier {
+ public:
+  // `parties` is the number of Arrive() calls that end `completion_signal`.
+  EosBarrier(std::shared_ptr<CompletionSignal> completion_signal, int parties)
+      : completion_signal_(std::move(completion_signal)), pending_(parties) {}
+
+  // Record that one party has reached its end of stream.
+  void Arrive() {
+    if (pending_.fetch_sub(1) == 1) {
+      completion_signal_->End();
+    }
+  }
+
+  EosBarrier(const EosBarrier&) = delete;
+  EosBarrier& operator=(const EosBarrier&) = delete;
+
+ private:
+  std::shared_ptr<CompletionSignal> completion_signal_;
+  std::atomic<int> pending_;
+};
+
+// State shared between a pipeline and the watch on its bus.
+struct BusWatchContext {
+  std::shared_ptr<CompletionSignal> completion_signal;
+  std::shared_ptr<EosBarrier> eos_barrier;
+  GstreamerRunner::ElementMessageCallback element_message_callback;
 };
 
 // Callback attached to observe pipeline bus messages.
 gboolean gst_bus_message_callback(GstBus* bus, GstMessage* message,
-                                  CompletionSignal* signal) {
+                                  BusWatchContext* context) {
   GError* err;
   gchar* debug_info;
   switch (GST_MESSAGE_TYPE(message)) {
     case GST_MESSAGE_EOS:
-      signal->End();
+      context->eos_barrier->Arrive();
       break;
     case GST_MESSAGE_ERROR:
       gst_message_parse_error(message, &err, &debug_info);
@@ -86,7 +135,19 @@ gboolean gst_bus_message_callback(GstBus* bus, GstMessage* message,
       LOG(ERROR) << absl::StrFormat("Additional debug info: %s",
                                     debug_info ? debug_info : "none");
       LOG(ERROR) << "Got gstreamer error; shutting down event loop";
-      signal->End();
+      g_clear_error(&err);
+      g_free(debug_info);
+      context->completion_signal->End();
+      break;
+    case GST_MESSAGE_ELEMENT:
+      if (context->element_message_callback) {
+        const GstStructure* structure = gst_message_get_structure(message);
+        if (structure != nullptr) {
+          gchar* structure_string = gst_structure_to_string(structure);
+          context->element_message_callback(structure_string);
+          g_free(structure_string);
+        }
+      }
       break;
     default:
       break;
@@ -94,36 +155,402 @@ gboolean gst_bus_message_callback(GstBus* bus, GstMessage* message,
   return TRUE;
 }
 
-// Callback for receiving new GstSample's from appsink.
-GstFlowReturn on_new_sample_from_sink(
-    GstElement* elt, GstreamerRunner::ReceiverCallback* receiver_callback) {
-  // Get the GstSample from appsink.
-  GstSample* sample = gst_app_sink_pull_sample(GST_APP_SINK(elt));
+// GDestroyNotify for the BusWatchContext.
+void DeleteBusWatchContext(gpointer data) {
+  delete static_cast<BusWatchContext*>(data);
+}
+
+// GSourceFunc that notifies the absl::Notification it is given.
+gboolean NotifyOnLoop(gpointer data) {
+  static_cast<absl::Notification*>(data)->Notify();
+  return G_SOURCE_REMOVE;
+}
+
+// RAII object that watches a pipeline's bus on the shared main loop.
+//
+// The watch holds its own share of the CompletionSignal, so a message that is
+// being dispatched while the watch is removed never sees a dangling signal.
+//
+// Destroying the watch waits until the shared loop has finished any dispatch
+// that was already running, so no callback runs once the destructor returns.
+class BusWatch {
+ public:
+  BusWatch(GstElement* gst_pipeline,
+           std::shared_ptr<CompletionSignal> completion_signal,
+           std::shared_ptr<EosBarrier> eos_barrier,
+           GstreamerRunner::ElementMessageCallback element_message_callback) {
+    auto context = std::make_unique<BusWatchContext>();
+    context->completion_signal = std::move(completion_signal);
+    context->eos_barrier = std::move(eos_barrier);
+    context->element_message_callback = std::move(element_message_callback);
+
+    GstBus* bus = gst_element_get_bus(gst_pipeline);
+    bus_watch_source_ = gst_bus_create_watch(bus);
+    gst_object_unref(bus);
+    g_source_set_callback(bus_watch_source_,
+                          (GSourceFunc)gst_bus_message_callback,
+                          context.release(), DeleteBusWatchContext);
+    g_source_attach(bus_watch_source_, SharedGMainLoop::Get()->context());
+  }
+
+  ~BusWatch() {
+    // g_source_destroy only prevents future dispatches. The loop runs one
+    // source at a time, so once it gets to notify `done` the current dispatch
+    // (if any) has returned. When called from the loop thread itself,
+    // g_main_context_invoke notifies right away instead of deadlocking.
+    g_source_destroy(bus_watch_source_);
+    absl::Notification done;
+    g_main_context_invoke(SharedGMainLoop::Get()->context(), NotifyOnLoop,
+                          &done);
+    done.WaitForNotification();
+    g_source_unref(bus_watch_source_);
+  }
 
-  // No-op if callbacks are not supplied.
-  if (receiver_callback == nullptr || !(*receiver_callback)) {
+  BusWatch(const BusWatch&) = delete;
+  BusWatch& operator=(const BusWatch&) = delete;
+
+ private:
+  GSource* bus_watch_source_ = nullptr;
+};
+
+// Object that delivers the GstSample's of an appsink to a receiver callback.
+//
+// The caps string is cached and only regenerated when the caps change, since
+// this almost never happens over the lifetime of a pipeline.
+//
+// Samples are either pushed in from the appsink's "new-sample" signal (see
+// on_new_sample_from_sink) or pulled by a dedicated reader thread (see
+// StartPulling). Only one of the two is ever active, so Deliver() is never
+// called concurrently.
+class AppSinkReceiver {
+ public:
+  explicit AppSinkReceiver(GstreamerRunner::ReceiverCallback receiver_callback)
+      : receiver_callback_(std::move(receiver_callback)) {}
+
+  ~AppSinkReceiver() {
+    StopPulling();
+    if (caps_ != nullptr) {
+      gst_caps_unref(caps_);
+    }
+  }
+
+  // Deliver `sample` through the receiver callback. This consumes `sample`.
+  Status Deliver(GstSample* sample) {
+    // No-op if callbacks are not supplied.
+    if (!receiver_callback_) {
+      gst_sample_unref(sample);
+      return OkStatus();
+    }
+
+    // Copy the GstSample into aistreamer's GstreamerBuffer type.
+    GstreamerBuffer gstreamer_buffer;
+    gstreamer_buffer.set_caps_string(CapsString(gst_sample_get_caps(sample)));
+
+    GstBuffer* buffer = gst_sample_get_buffer(sample);
+    gstreamer_buffer.set_is_key_frame(
+        !GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT));
+    if (GST_BUFFER_PTS_IS_VALID(buffer)) {
+      gstreamer_buffer.set_pts(GST_BUFFER_PTS(buffer));
+    }
+    GstMapInfo map;
+    gst_buffer_map(buffer, &map, GST_MAP_READ);
+    gstreamer_buffer.assign(reinterpret_cast<char*>(map.data), map.size);
+    gst_buffer_unmap(buffer, &map);
     gst_sample_unref(sample);
-    return GST_FLOW_OK;
+
+    // Deliver the GstreamerBuffer using the callback.
+    // TODO: Decide on special status codes to pause/halt the pipeline.
+    return receiver_callback_(std::move(gstreamer_buffer));
   }
 
-  // Copy the GstSample into aistreamer's GstreamerBuffer type.
-  GstreamerBuffer gstreamer_buffer;
+  // Start a reader thread that pulls samples from `appsink` and delivers them
+  // in batches of up to `batch_size`. The thread arrives at `eos_barrier` once
+  // it has delivered its last sample.
+  void StartPulling(GstElement* appsink, int batch_size,
+                    std::shared_ptr<EosBarrier> eos_barrier) {
+    stop_pulling_ = false;
+    reader_thread_ = std::thread([this, appsink, batch_size, eos_barrier]() {
+      PullLoop(appsink, batch_size);
+      eos_barrier->Arrive();
+    });
+  }
 
-  GstCaps* caps = gst_sample_get_caps(sample);
-  gchar* caps_string = gst_caps_to_string(caps);
-  gstreamer_buffer.set_caps_string(caps_string);
-  g_free(caps_string);
+  // Stop the reader thread, if any, and block until it exits.
+  void StopPulling() {
+    stop_pulling_ = true;
+    if (reader_thread_.joinable()) {
+      reader_thread_.join();
+    }
+  }
 
-  GstBuffer* buffer = gst_sample_get_buffer(sample);
-  GstMapInfo map;
-  gst_buffer_map(buffer, &map, GST_MAP_READ);
-  gstreamer_buffer.assign(reinterpret_cast<char*>(map.data), map.size);
-  gst_buffer_unmap(buffer, &map);
-  gst_sample_unref(sample);
+  AppSinkReceiver(const AppSinkReceiver&) = delete;
+  AppSinkReceiver& operator=(const AppSinkReceiver&) = delete;
 
-  // Deliver the GstreamerBuffer using the callback.
-  // TODO: Decide on special status codes to pause/halt the pipeline.
-  Status status = (*receiver_callback)(std::move(gstreamer_buffer));
+ private:
+  // Returns the caps string of `caps`, regenerating it only on a change.
+  const std::string& CapsString(GstCaps* caps) {
+    if (caps == caps_) {
+      return caps_string_;
+    }
+    if (caps_ == nullptr || caps == nullptr ||
+        !gst_caps_is_equal(caps, caps_)) {
+      caps_string_.clear();
+      if (caps != nullptr) {
+        gchar* caps_string = gst_caps_to_string(caps);
+        caps_string_ = caps_string;
+        g_free(caps_string);
+      }
+    }
+    gst_caps_replace(&caps_, caps);
+    return caps_string_;
+  }
+
+  void PullLoop(GstElement* appsink, int batch_size) {
+    GstAppSink* gst_appsink = GST_APP_SINK(appsink);
+    std::vector<GstSample*> batch;
+    batch.reserve(batch_size);
+    while (!stop_pulling_) {
+      // Wait for the first sample, then take whatever else is already queued.
+      GstSample* sample = gst_app_sink_try_pull_sample(
+          gst_appsink, kAppSinkPullTimeoutMs * GST_MSECOND);
+      if (sample == nullptr) {
+        if (gst_app_sink_is_eos(gst_appsink)) {
+          break;
+        }
+        continue;
+      }
+      batch.push_back(sample);
+      while (static_cast<int>(batch.size()) < batch_size) {
+        sample = gst_app_sink_try_pull_sample(gst_appsink, 0);
+        if (sample == nullptr) {
+          break;
+        }
+        batch.push_back(sample);
+      }
+
+      Status status = OkStatus();
+      for (GstSample* s : batch) {
+        if (status.ok()) {
+          status = Deliver(s);
+        } else {
+          gst_sample_unref(s);
+        }
+      }
+      batch.clear();
+      if (!status.ok()) {
+        LOG(ERROR) << status.message();
+        PostError(appsink, status);
+        break;
+      }
+    }
+  }
+
+  // Post an error on the bus as the streaming thread would have on a
+  // GST_FLOW_ERROR.
+  static void PostError(GstElement* appsink, const Status& status) {
+    GError* err = g_error_new_literal(GST_STREAM_ERROR, GST_STREAM_ERROR_FAILED,
+                                      "The receiver callback failed");
+    std::string debug_info(status.message());
+    gst_element_post_message(
+        appsink,
+        gst_message_new_error(GST_OBJECT(appsink), err, debug_info.c_str()));
+    g_error_free(err);
+  }
+
+  GstreamerRunner::ReceiverCallback receiver_callback_;
+
+  GstCaps* caps_ = nullptr;
+  std::string caps_string_;
+
+  std::atomic<bool> stop_pulling_{false};
+  std::thread reader_thread_;
+};
+
+// Object that bounds the data waiting to enter a pipeline through its appsrc.
+//
+// Fed buffers wait in a queue until the appsrc signals "need-data", and are
+// then handed over until it signals "enough-data". When the queue would exceed
+// its byte limit, the AppSrcLeakyMode decides whether Push blocks or which
+// buffers are dropped.
+class AppSrcFeeder {
+ public:
+  AppSrcFeeder(GstElement* appsrc, uint64_t max_bytes,
+               GstreamerRunner::AppSrcLeakyMode leaky_mode,
+               std::shared_ptr<CompletionSignal> completion_signal)
+      : appsrc_(appsrc),
+        max_bytes_(max_bytes),
+        leaky_mode_(leaky_mode),
+        completion_signal_(std::move(completion_signal)) {
+    // Keep at most one buffer inside the appsrc so that the bound is enforced
+    // here rather than by the appsrc's own, unbounded, queue.
+    g_object_set(G_OBJECT(appsrc_), "max-bytes", static_cast<guint64>(1),
+                 NULL);
+    g_signal_connect(appsrc_, "need-data", G_CALLBACK(OnNeedData), this);
+    g_signal_connect(appsrc_, "enough-data", G_CALLBACK(OnEnoughData), this);
+  }
+
+  ~AppSrcFeeder() {
+    g_signal_handlers_disconnect_by_data(appsrc_, this);
+    Close();
+  }
+
+  // Queue `buffer` for the appsrc. This always consumes the given reference.
+  //
+  // Buffers that are dropped by the leaky mode are not errors.
+  Status Push(GstBuffer* buffer, bool is_key_frame) {
+    uint64_t size = gst_buffer_get_size(buffer);
+    absl::MutexLock lock(&mu_);
+    if (closed_ || eos_) {
+      gst_buffer_unref(buffer);
+      return FailedPreconditionError("The appsrc no longer accepts buffers");
+    }
+    if (push_failed_) {
+      gst_buffer_unref(buffer);
+      return InternalError("Failed to push a GstBuffer");
+    }
+
+    switch (leaky_mode_) {
+      case GstreamerRunner::AppSrcLeakyMode::kBlock:
+        while (!closed_ && !HasRoom(size) &&
+               !completion_signal_->IsCompleted()) {
+          has_room_.WaitWithTimeout(
+              &mu_, absl::Milliseconds(kAppSrcBlockPollPeriodMs));
+        }
+        if (!HasRoom(size)) {
+          gst_buffer_unref(buffer);
+          return FailedPreconditionError(
+              "The pipeline stopped while waiting for room in the appsrc "
+              "queue");
+        }
+        break;
+      case GstreamerRunner::AppSrcLeakyMode::kDropOldest:
+        while (!HasRoom(size)) {
+          DropFront();
+        }
+        break;
+      case GstreamerRunner::AppSrcLeakyMode::kDropUntilKeyFrame:
+        if ((awaiting_key_frame_ && !is_key_frame) || !HasRoom(size)) {
+          awaiting_key_frame_ = true;
+          gst_buffer_unref(buffer);
+          ++dropped_buffers_;
+          return OkStatus();
+        }
+        awaiting_key_frame_ = false;
+        break;
+    }
+
+    queue_.push_back(buffer);
+    queued_bytes_ += size;
+    Drain();
+    return OkStatus();
+  }
+
+  // Signal end-of-stream to the appsrc once all queued buffers are handed over.
+  void EndOfStream() {
+    absl::MutexLock lock(&mu_);
+    eos_ = true;
+    Drain();
+  }
+
+  // Drop all queued buffers and stop accepting new ones.
+  void Close() {
+    absl::MutexLock lock(&mu_);
+    closed_ = true;
+    for (GstBuffer* buffer : queue_) {
+      gst_buffer_unref(buffer);
+    }
+    queue_.clear();
+    queued_bytes_ = 0;
+    has_room_.SignalAll();
+  }
+
+  GstreamerRunner::AppSrcStats GetStats() {
+    absl::MutexLock lock(&mu_);
+    GstreamerRunner::AppSrcStats stats;
+    stats.queued_buffers = queue_.size();
+    stats.queued_bytes = queued_bytes_;
+    stats.dropped_buffers = dropped_buffers_;
+    return stats;
+  }
+
+  AppSrcFeeder(const AppSrcFeeder&) = delete;
+  AppSrcFeeder& operator=(const AppSrcFeeder&) = delete;
+
+ private:
+  static void OnNeedData(GstElement* appsrc, guint length,
+                         AppSrcFeeder* feeder) {
+    feeder->need_data_ = true;
+    absl::MutexLock lock(&feeder->mu_);
+    feeder->Drain();
+  }
+
+  // This may be called from within Drain() while it pushes a buffer.
+  static void OnEnoughData(GstElement* appsrc, AppSrcFeeder* feeder) {
+    feeder->need_data_ = false;
+  }
+
+  // A buffer always fits into an empty queue, however large it is.
+  bool HasRoom(uint64_t size) const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    return queue_.empty() || queued_bytes_ + size <= max_bytes_;
+  }
+
+  void DropFront() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    GstBuffer* buffer = queue_.front();
+    queue_.pop_front();
+    queued_bytes_ -= gst_buffer_get_size(buffer);
+    gst_buffer_unref(buffer);
+    ++dropped_buffers_;
+  }
+
+  // Hand queued buffers to the appsrc for as long as it asks for them.
+  void Drain() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    while (need_data_ && !queue_.empty() && !closed_) {
+      GstBuffer* buffer = queue_.front();
+      queue_.pop_front();
+      queued_bytes_ -= gst_buffer_get_size(buffer);
+      GstFlowReturn ret;
+      g_signal_emit_by_name(appsrc_, "push-buffer", buffer, &ret);
+      gst_buffer_unref(buffer);
+      if (ret != GST_FLOW_OK) {
+        push_failed_ = true;
+      }
+    }
+    if (eos_ && !eos_sent_ && queue_.empty() && !closed_) {
+      GstFlowReturn ret;
+      g_signal_emit_by_name(appsrc_, "end-of-stream", &ret);
+      eos_sent_ = true;
+    }
+    has_room_.SignalAll();
+  }
+
+  GstElement* appsrc_ = nullptr;
+  const uint64_t max_bytes_;
+  const GstreamerRunner::AppSrcLeakyMode leaky_mode_;
+  std::shared_ptr<CompletionSignal> completion_signal_ = nullptr;
+  std::atomic<bool> need_data_{false};
+
+  absl::Mutex mu_;
+  absl::CondVar has_room_;
+  std::deque<GstBuffer*> queue_ ABSL_GUARDED_BY(mu_);
+  uint64_t queued_bytes_ ABSL_GUARDED_BY(mu_) = 0;
+  int64_t dropped_buffers_ ABSL_GUARDED_BY(mu_) = 0;
+  bool awaiting_key_frame_ ABSL_GUARDED_BY(mu_) = false;
+  bool push_failed_ ABSL_GUARDED_BY(mu_) = false;
+  bool eos_ ABSL_GUARDED_BY(mu_) = false;
+  bool eos_sent_ ABSL_GUARDED_BY(mu_) = false;
+  bool closed_ ABSL_GUARDED_BY(mu_) = false;
+};
+
+// Callback for receiving new GstSample's from appsink.
+GstFlowReturn on_new_sample_from_sink(GstElement* elt,
+                                      AppSinkReceiver* appsink_receiver) {
+  // Get the GstSample from appsink.
+  GstSample* sample = gst_app_sink_pull_sample(GST_APP_SINK(elt));
+  if (sample == nullptr) {
+    return GST_FLOW_OK;
+  }
+
+  Status status = appsink_receiver->Deliver(sample);
   if (!status.ok()) {
     LOG(ERROR) << status.message();
     return GST_FLOW_ERROR;
@@ -135,16 +562,97 @@ Status ValidateOptions(const GstreamerRunner::Options& options) {
   if (options.processing_pipeline_string.empty()) {
     return InvalidArgumentError("Given an empty processing pipeline string");
   }
+  if (options.appsink_max_buffers < 0) {
+    return InvalidArgumentError(absl::StrFormat(
+        "Given a negative appsink max-buffers (%d)",
+        options.appsink_max_buffers));
+  }
+  if (options.appsrc_max_bytes < 0) {
+    return InvalidArgumentError(absl::StrFormat(
+        "Given a negative appsrc max bytes (%d)", options.appsrc_max_bytes));
+  }
+  if (options.appsink_pull_batch_size <= 0) {
+    return InvalidArgumentError(absl::StrFormat(
+        "Given a non-positive appsink pull batch size (%d)",
+        options.appsink_pull_batch_size));
+  }
+  if (options.receiver_callback && !options.output_branches.empty()) {
+    return InvalidArgumentError(
+        "Given both a receiver callback and output branches; use one or the "
+        "other");
+  }
+  std::set<std::string> branch_names;
+  for (const auto& branch : options.output_branches) {
+    if (branch.name.empty()) {
+      return InvalidArgumentError("Given an output branch without a name");
+    }
+    for (char c : branch.name) {
+      if (!absl::ascii_isalnum(c) && c != '_' && c != '-') {
+        return InvalidArgumentError(absl::StrFormat(
+            "Given an output branch name \"%s\" with characters other than "
+            "letters, digits, '_' and '-'",
+            branch.name));
+      }
+    }
+    if (!branch_names.insert(branch.name).second) {
+      return InvalidArgumentError(absl::StrFormat(
+          "Given more than one output branch named \"%s\"", branch.name));
+    }
+    if (!branch.receiver_callback) {
+      return InvalidArgumentError(absl::StrFormat(
+          "Given no receiver callback for the output branch \"%s\"",
+          branch.name));
+    }
+    if (branch.queue_max_buffers < 0) {
+      return InvalidArgumentError(absl::StrFormat(
+          "Given a negative queue max-buffers (%d) for the output branch "
+          "\"%s\"",
+          branch.queue_max_buffers, branch.name));
+    }
+  }
   return OkStatus();
 }
 
+// Returns the name of the appsink that ends the output branch `branch_name`.
+std::string BranchAppSinkName(const std::string& branch_name) {
+  return absl::StrCat(kAppSinkName, "_", branch_name);
+}
+
+// Returns the gst-launch string of an output branch, to follow the tee.
+//
+// tee. ! queue ! [branch-processing-pipeline !] appsink
+std::string BranchPipelineString(const GstreamerRunner::OutputBranch& branch) {
+  std::string queue_string = "queue";
+  if (branch.queue_max_buffers > 0) {
+    absl::StrAppend(&queue_string, " max-size-buffers=",
+                    branch.queue_max_buffers,
+                    " max-size-bytes=0 max-size-time=0");
+  }
+  if (branch.queue_leaky) {
+    absl::StrAppend(&queue_string, " leaky=downstream");
+  }
+
+  std::vector<std::string> branch_elements;
+  branch_elements.push_back(absl::StrCat(kTeeName, "."));
+  branch_elements.push_back(queue_string);
+  if (!branch.processing_pipeline_string.empty()) {
+    branch_elements.push_back(branch.processing_pipeline_string);
+  }
+  branch_elements.push_back(
+      absl::StrFormat("appsink name=%s", BranchAppSinkName(branch.name)));
+  return absl::StrJoin(branch_elements, " ! ");
+}
+
 // Object that owns and configures a gstreamer pipeline.
 //
 // It supports pipelines of the form:
 // gst-launch [appsrc !] main-processing-pipeline [! appsink]
 //
 // appsrc and appsink are added depending on whether appsrc caps and a callback
-// is provided in Options.
+// is provided in Options. If output branches are provided instead of a
+// callback, the appsink is replaced by a tee that feeds one appsink per branch:
+// gst-launch [appsrc !] main-processing-pipeline ! tee
+//     tee. ! queue ! [branch-processing-pipeline !] appsink ...
 class GstreamerPipeline {
  public:
   static StatusOr<std::unique_ptr<GstreamerPipeline>> Create(
@@ -175,7 +683,13 @@ class GstreamerPipeline {
       pipeline_elements.push_back(
           absl::StrFormat("appsink name=%s", kAppSinkName));
     }
+    if (!options.output_branches.empty()) {
+      pipeline_elements.push_back(absl::StrFormat("tee name=%s", kTeeName));
+    }
     std::string pipeline_string = absl::StrJoin(pipeline_elements, " ! ");
+    for (const auto& branch : options.output_branches) {
+      absl::StrAppend(&pipeline_string, " ", BranchPipelineString(branch));
+    }
 
     gstreamer_pipeline->gst_pipeline_ =
         gst_parse_launch(pipeline_string.c_str(), NULL);
@@ -207,19 +721,18 @@ class GstreamerPipeline {
       gst_caps_unref(appsrc_caps);
     }
 
-    // Configure the appsink.
+    // Configure the appsinks.
+    if (options.appsink_pull_mode) {
+      gstreamer_pipeline->appsink_pull_batch_size_ =
+          options.appsink_pull_batch_size;
+    }
     if (options.receiver_callback) {
-      gstreamer_pipeline->gst_appsink_ = gst_bin_get_by_name(
-          GST_BIN(gstreamer_pipeline->gst_pipeline_), kAppSinkName);
-      if (gstreamer_pipeline->gst_appsink_ == nullptr) {
-        return InternalError("Failed to get a pointer to the appsink element");
-      }
-      g_object_set(G_OBJECT(gstreamer_pipeline->gst_appsink_), "emit-signals",
-                   TRUE, "sync", options.appsink_sync ? TRUE : FALSE, NULL);
-      g_signal_connect(gstreamer_pipeline->gst_appsink_, "new-sample",
-                       G_CALLBACK(on_new_sample_from_sink),
-                       const_cast<GstreamerRunner::ReceiverCallback*>(
-                           &options.receiver_callback));
+      AIS_RETURN_IF_ERROR(gstreamer_pipeline->AddAppSink(
+          kAppSinkName, options.receiver_callback, options));
+    }
+    for (const auto& branch : options.output_branches) {
+      AIS_RETURN_IF_ERROR(gstreamer_pipeline->AddAppSink(
+          BranchAppSinkName(branch.name), branch.receiver_callback, options));
     }
 
     return gstreamer_pipeline;
@@ -229,27 +742,87 @@ class GstreamerPipeline {
 
   GstElement* gst_appsrc() const { return gst_appsrc_; }
 
+  // Returns the number of appsink reader threads that StartAppSinkReader()
+  // starts.
+  int num_appsink_readers() const {
+    return appsink_pull_batch_size_ > 0 ? static_cast<int>(appsinks_.size())
+                                        : 0;
+  }
+
+  // Start pulling results from the appsink if it is configured for pull mode.
+  // Each reader arrives at `eos_barrier` when done.
+  //
+  // Call this after the pipeline has been set to play.
+  void StartAppSinkReader(const std::shared_ptr<EosBarrier>& eos_barrier) {
+    if (appsink_pull_batch_size_ <= 0) {
+      return;
+    }
+    for (auto& appsink : appsinks_) {
+      appsink.receiver->StartPulling(appsink.gst_appsink,
+                                     appsink_pull_batch_size_, eos_barrier);
+    }
+  }
+
   GstreamerPipeline() = default;
   ~GstreamerPipeline() { Cleanup(); }
   GstreamerPipeline(const GstreamerPipeline&) = delete;
   GstreamerPipeline& operator=(const GstreamerPipeline&) = delete;
 
  private:
+  // An appsink and the receiver that delivers its results.
+  struct AppSink {
+    GstElement* gst_appsink = nullptr;
+    std::unique_ptr<AppSinkReceiver> receiver;
+  };
+
+  // Configure the appsink named `name` to deliver through `receiver_callback`.
+  Status AddAppSink(const std::string& name,
+                    const GstreamerRunner::ReceiverCallback& receiver_callback,
+                    const GstreamerRunner::Options& options) {
+    AppSink appsink;
+    appsink.gst_appsink =
+        gst_bin_get_by_name(GST_BIN(gst_pipeline_), name.c_str());
+    if (appsink.gst_appsink == nullptr) {
+      return InternalError(absl::StrFormat(
+          "Failed to get a pointer to the appsink element \"%s\"", name));
+    }
+    g_object_set(G_OBJECT(appsink.gst_appsink), "emit-signals",
+                 options.appsink_pull_mode ? FALSE : TRUE, "sync",
+                 options.appsink_sync ? TRUE : FALSE, "max-buffers",
+                 static_cast<guint>(options.appsink_max_buffers), "drop",
+                 options.appsink_drop ? TRUE : FALSE, NULL);
+    appsink.receiver = std::make_unique<AppSinkReceiver>(receiver_callback);
+    if (!options.appsink_pull_mode) {
+      g_signal_connect(appsink.gst_appsink, "new-sample",
+                       G_CALLBACK(on_new_sample_from_sink),
+                       appsink.receiver.get());
+    }
+    appsinks_.push_back(std::move(appsink));
+    return OkStatus();
+  }
+
   void Cleanup() {
+    // Stop the readers before releasing the elements they read from.
+    for (auto& appsink : appsinks_) {
+      appsink.receiver.reset();
+    }
     if (gst_pipeline_ != nullptr) {
       gst_object_unref(gst_pipeline_);
     }
     if (gst_appsrc_ != nullptr) {
       gst_object_unref(gst_appsrc_);
     }
-    if (gst_appsink_ != nullptr) {
-      gst_object_unref(gst_appsink_);
+    for (auto& appsink : appsinks_) {
+      gst_object_unref(appsink.gst_appsink);
     }
   }
 
   GstElement* gst_pipeline_ = nullptr;
   GstElement* gst_appsrc_ = nullptr;
-  GstElement* gst_appsink_ = nullptr;
+  std::vector<AppSink> appsinks_;
+
+  // Positive only when the appsink is configured for pull mode.
+  int appsink_pull_batch_size_ = 0;
 };
 
 }  // namespace
@@ -266,6 +839,16 @@ class GstreamerRunner::GstreamerRunnerImpl {
 
   // Feed a GstreamerBuffer into the running pipeline.
   Status Feed(const GstreamerBuffer&);
+  Status Feed(GstreamerBuffer&&);
+
+  GstreamerRunner::AppSrcStats GetAppSrcStats();
+
+  // Emit the action signal `signal_name` on the element `element_name`.
+  Status EmitActionSignal(const std::string& element_name,
+                          const std::string& signal_name);
+
+  // Get the string property at `property_path` (see gst_child_proxy_get).
+  StatusOr<std::string> GetStringProperty(const std::string& property_path);
 
   bool IsCompleted() { return completion_signal_->IsCompleted(); }
 
@@ -279,12 +862,17 @@ class GstreamerRunner::GstreamerRunnerImpl {
  private:
   Status Initialize();
   Status Finalize();
+  Status ValidateFeed(const GstreamerBuffer&);
+  Status PushBuffer(GstBuffer*, const GstreamerBuffer& gstreamer_buffer);
 
   Options options_;
 
   std::unique_ptr<GstreamerPipeline> gstreamer_pipeline_ = nullptr;
-  std::unique_ptr<CompletionSignal> completion_signal_ = nullptr;
-  std::unique_ptr<GMainLoopManager> glib_loop_manager_ = nullptr;
+  std::shared_ptr<CompletionSignal> completion_signal_ = nullptr;
+  std::unique_ptr<BusWatch> bus_watch_ = nullptr;
+
+  // Set only when the fed data is bounded by appsrc_max_bytes.
+  std::unique_ptr<AppSrcFeeder> appsrc_feeder_ = nullptr;
 };
 
 StatusOr<std::unique_ptr<GstreamerRunner::GstreamerRunnerImpl>>
@@ -303,16 +891,27 @@ Status GstreamerRunner::GstreamerRunnerImpl::Initialize() {
   gstreamer_pipeline_ = std::move(gstreamer_pipeline_statusor).ValueOrDie();
 
   // Create the completion signal to observe the pipeline progress.
-  completion_signal_ = std::make_unique<CompletionSignal>();
-  GstBus* bus = gst_element_get_bus(gstreamer_pipeline_->gst_pipeline());
-  gst_bus_add_watch(bus, (GstBusFunc)gst_bus_message_callback,
-                    completion_signal_.get());
-  gst_object_unref(bus);
+  // In pull mode, the pipeline only completes once the appsink readers have
+  // also delivered everything.
+  completion_signal_ = std::make_shared<CompletionSignal>();
+  completion_signal_->Start();
+  auto eos_barrier = std::make_shared<EosBarrier>(
+      completion_signal_, 1 + gstreamer_pipeline_->num_appsink_readers());
+  bus_watch_ = std::make_unique<BusWatch>(
+      gstreamer_pipeline_->gst_pipeline(), completion_signal_, eos_barrier,
+      options_.element_message_callback);
+
+  // Bound the data waiting in the appsrc if requested.
+  if (gstreamer_pipeline_->gst_appsrc() != nullptr &&
+      options_.appsrc_max_bytes > 0) {
+    appsrc_feeder_ = std::make_unique<AppSrcFeeder>(
+        gstreamer_pipeline_->gst_appsrc(), options_.appsrc_max_bytes,
+        options_.appsrc_leaky_mode, completion_signal_);
+  }
 
   // Start the pipeline.
-  completion_signal_->Start();
-  glib_loop_manager_ = std::make_unique<GMainLoopManager>();
   gst_element_set_state(gstreamer_pipeline_->gst_pipeline(), GST_STATE_PLAYING);
+  gstreamer_pipeline_->StartAppSinkReader(eos_barrier);
   return OkStatus();
 }
 
@@ -320,7 +919,9 @@ Status GstreamerRunner::GstreamerRunnerImpl::Finalize() {
   // Allow the pipeline to complete its processing gracefully.
   // Do this by sending it EOS and enforcing a deadline.
   if (!completion_signal_->IsCompleted()) {
-    if (gstreamer_pipeline_->gst_appsrc()) {
+    if (appsrc_feeder_ != nullptr) {
+      appsrc_feeder_->EndOfStream();
+    } else if (gstreamer_pipeline_->gst_appsrc()) {
       GstFlowReturn ret;
       g_signal_emit_by_name(gstreamer_pipeline_->gst_appsrc(), "end-of-stream",
                             &ret);
@@ -338,6 +939,8 @@ Status GstreamerRunner::GstreamerRunnerImpl::Finalize() {
     }
   }
   gst_element_set_state(gstreamer_pipeline_->gst_pipeline(), GST_STATE_NULL);
+  appsrc_feeder_.reset();
+  bus_watch_.reset();
 
   return OkStatus();
 }
@@ -349,7 +952,7 @@ GstreamerRunner::GstreamerRunnerImpl::~GstreamerRunnerImpl() {
   }
 }
 
-Status GstreamerRunner::GstreamerRunnerImpl::Feed(
+Status GstreamerRunner::GstreamerRunnerImpl::ValidateFeed(
     const GstreamerBuffer& gstreamer_buffer) {
   if (IsCompleted()) {
     return FailedPreconditionError(
@@ -366,6 +969,38 @@ Status GstreamerRunner::GstreamerRunnerImpl::Feed(
         "Feeding the runner with caps \"%s\" when \"%s\" is expected",
         gstreamer_buffer.get_caps(), options_.appsrc_caps_string));
   }
+  return OkStatus();
+}
+
+// Pushes `buffer` into the appsrc. This always consumes the given reference.
+//
+// The flags and timestamps of `buffer` are set from those of
+// `gstreamer_buffer`. Buffers without a PTS are timestamped by the appsrc.
+Status GstreamerRunner::GstreamerRunnerImpl::PushBuffer(
+    GstBuffer* buffer, const GstreamerBuffer& gstreamer_buffer) {
+  bool is_key_frame = gstreamer_buffer.is_key_frame();
+  if (!is_key_frame) {
+    GST_BUFFER_FLAG_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+  }
+  if (gstreamer_buffer.pts() >= 0) {
+    GST_BUFFER_PTS(buffer) = gstreamer_buffer.pts();
+  }
+  if (appsrc_feeder_ != nullptr) {
+    return appsrc_feeder_->Push(buffer, is_key_frame);
+  }
+  GstFlowReturn ret;
+  g_signal_emit_by_name(gstreamer_pipeline_->gst_appsrc(), "push-buffer",
+                        buffer, &ret);
+  gst_buffer_unref(buffer);
+  if (ret != GST_FLOW_OK) {
+    return InternalError("Failed to push a GstBuffer");
+  }
+  return OkStatus();
+}
+
+Status GstreamerRunner::GstreamerRunnerImpl::Feed(
+    const GstreamerBuffer& gstreamer_buffer) {
+  AIS_RETURN_IF_ERROR(ValidateFeed(gstreamer_buffer));
 
   // Create a new GstBuffer by copying.
   GstBuffer* buffer = gst_buffer_new_and_alloc(gstreamer_buffer.size());
@@ -376,16 +1011,104 @@ Status GstreamerRunner::GstreamerRunnerImpl::Feed(
   gst_buffer_unmap(buffer, &map);
 
   // Feed the buffer.
-  GstFlowReturn ret;
-  g_signal_emit_by_name(gstreamer_pipeline_->gst_appsrc(), "push-buffer",
-                        buffer, &ret);
-  gst_buffer_unref(buffer);
-  if (ret != GST_FLOW_OK) {
-    return InternalError("Failed to push a GstBuffer");
+  return PushBuffer(buffer, gstreamer_buffer);
+}
+
+Status GstreamerRunner::GstreamerRunnerImpl::Feed(
+    GstreamerBuffer&& gstreamer_buffer) {
+  AIS_RETURN_IF_ERROR(ValidateFeed(gstreamer_buffer));
+
+  // Create a new GstBuffer that wraps the bytes in place. The GstBuffer owns
+  // the string and frees it once gstreamer is done with it.
+  auto bytes = std::make_unique<std::string>(
+      std::move(gstreamer_buffer).ReleaseBuffer());
+  GstBuffer* buffer = nullptr;
+  if (bytes->empty()) {
+    buffer = gst_buffer_new();
+  } else {
+    size_t size = bytes->size();
+    char* data = &(*bytes)[0];
+    buffer = gst_buffer_new_wrapped_full(GST_MEMORY_FLAG_READONLY, data, size,
+                                         0, size, bytes.release(),
+                                         DeleteString);
+  }
+
+  // Feed the buffer.
+  return PushBuffer(buffer, gstreamer_buffer);
+}
+
+GstreamerRunner::AppSrcStats
+GstreamerRunner::GstreamerRunnerImpl::GetAppSrcStats() {
+  AppSrcStats stats;
+  if (appsrc_feeder_ != nullptr) {
+    stats = appsrc_feeder_->GetStats();
+  }
+  if (gstreamer_pipeline_->gst_appsrc() != nullptr) {
+    stats.appsrc_level_bytes = gst_app_src_get_current_level_bytes(
+        GST_APP_SRC(gstreamer_pipeline_->gst_appsrc()));
+  }
+  return stats;
+}
+
+Status GstreamerRunner::GstreamerRunnerImpl::EmitActionSignal(
+    const std::string& element_name, const std::string& signal_name) {
+  if (IsCompleted()) {
+    return FailedPreconditionError(
+        "The runner has already completed. Please Create() it again and retry");
+  }
+  GstElement* element = gst_bin_get_by_name(
+      GST_BIN(gstreamer_pipeline_->gst_pipeline()), element_name.c_str());
+  if (element == nullptr) {
+    return NotFoundError(absl::StrFormat(
+        "No element named \"%s\" in the pipeline", element_name));
+  }
+  guint signal_id = g_signal_lookup(signal_name.c_str(),
+                                    G_OBJECT_TYPE(G_OBJECT(element)));
+  if (signal_id == 0) {
+    gst_object_unref(element);
+    return InvalidArgumentError(absl::StrFormat(
+        "The element \"%s\" has no signal \"%s\"", element_name,
+        signal_name));
+  }
+  GSignalQuery signal_query;
+  g_signal_query(signal_id, &signal_query);
+  if (!(signal_query.signal_flags & G_SIGNAL_ACTION) ||
+      signal_query.n_params != 0 ||
+      signal_query.return_type != G_TYPE_NONE) {
+    gst_object_unref(element);
+    return InvalidArgumentError(absl::StrFormat(
+        "The signal \"%s\" is not an action signal without arguments or "
+        "return value",
+        signal_name));
   }
+  g_signal_emit(element, signal_id, 0);
+  gst_object_unref(element);
   return OkStatus();
 }
 
+StatusOr<std::string> GstreamerRunner::GstreamerRunnerImpl::GetStringProperty(
+    const std::string& property_path) {
+  GObject* target = nullptr;
+  GParamSpec* pspec = nullptr;
+  if (!gst_child_proxy_lookup(
+          GST_CHILD_PROXY(gstreamer_pipeline_->gst_pipeline()),
+          property_path.c_str(), &target, &pspec)) {
+    return NotFoundError(absl::StrFormat(
+        "No property \"%s\" in the pipeline", property_path));
+  }
+  if (pspec->value_type != G_TYPE_STRING) {
+    g_object_unref(target);
+    return InvalidArgumentError(absl::StrFormat(
+        "The property \"%s\" is not a string", property_path));
+  }
+  gchar* value = nullptr;
+  g_object_get(target, pspec->name, &value, NULL);
+  g_object_unref(target);
+  std::string property_value = value != nullptr ? value : "";
+  g_free(value);
+  return property_value;
+}
+
 // -----------------------------------------------------------------------
 // GstreamerRunner
 
@@ -424,6 +1147,41 @@ Status GstreamerRunner::Feed(const GstreamerBuffer& gstreamer_buffer) const {
   return OkStatus();
 }
 
+Status GstreamerRunner::Feed(GstreamerBuffer&& gstreamer_buffer) const {
+  Status status = gstreamer_runner_impl_->Feed(std::move(gstreamer_buffer));
+  if (!status.ok()) {
+    LOG(ERROR) << status;
+    return UnknownError("Failed to Feed the GstreamerRunner");
+  }
+  return OkStatus();
+}
+
+GstreamerRunner::AppSrcStats GstreamerRunner::GetAppSrcStats() const {
+  return gstreamer_runner_impl_->GetAppSrcStats();
+}
+
+Status GstreamerRunner::EmitActionSignal(const std::string& element_name,
+                                         const std::string& signal_name) const {
+  Status status =
+      gstreamer_runner_impl_->EmitActionSignal(element_name, signal_name);
+  if (!status.ok()) {
+    LOG(ERROR) << status;
+    return UnknownError("Failed to emit an action signal");
+  }
+  return OkStatus();
+}
+
+StatusOr<std::string> GstreamerRunner::GetStringProperty(
+    const std::string& property_path) const {
+  auto value_statusor =
+      gstreamer_runner_impl_->GetStringProperty(property_path);
+  if (!value_statusor.ok()) {
+    LOG(ERROR) << value_statusor.status();
+    return UnknownError("Failed to get a property");
+  }
+  return value_statusor;
+}
+
 bool GstreamerRunner::IsCompleted() const {
   return gstreamer_runner_impl_->IsCompleted();
 }
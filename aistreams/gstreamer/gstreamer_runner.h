@@ -18,7 +18,10 @@
 #define AISTREAMS_GSTREAMER_GSTREAMER_RUNNER_H_
 
 #include <atomic>
+#include <cstdint>
 #include <functional>
+#include <string>
+#include <vector>
 
 #include "absl/time/time.h"
 #include "aistreams/base/types/gstreamer_buffer.h"
@@ -37,6 +40,72 @@ class GstreamerRunner {
  public:
   using ReceiverCallback = std::function<Status(GstreamerBuffer)>;
 
+  // Callback for element messages posted on the pipeline bus.
+  //
+  // It is given the message's GstStructure serialized by
+  // gst_structure_to_string.
+  using ElementMessageCallback = std::function<void(const std::string&)>;
+
+  // What Feed does when the data waiting to enter the pipeline would exceed
+  // Options::appsrc_max_bytes.
+  enum class AppSrcLeakyMode {
+    // Block the caller until there is room.
+    kBlock,
+
+    // Drop the oldest waiting buffers to make room.
+    kDropOldest,
+
+    // Drop the fed buffer, and all that follow it up to the next key frame
+    // (see GstreamerBuffer::is_key_frame).
+    kDropUntilKeyFrame,
+  };
+
+  // Statistics of the data fed into the pipeline.
+  struct AppSrcStats {
+    // Buffers and bytes waiting to be handed to the appsrc.
+    int64_t queued_buffers = 0;
+    uint64_t queued_bytes = 0;
+
+    // Bytes already handed to, but not yet consumed from, the appsrc.
+    uint64_t appsrc_level_bytes = 0;
+
+    // Buffers dropped because appsrc_max_bytes would have been exceeded.
+    int64_t dropped_buffers = 0;
+  };
+
+  // An output branch of the pipeline.
+  //
+  // The output of the main processing pipeline is split by a tee, so that a
+  // single decode can serve several consumers; e.g. one that needs the full
+  // resolution frames and another that only needs thumbnails.
+  struct OutputBranch {
+    // REQUIRED: A name that is unique among the branches.
+    //
+    // It may only contain letters, digits, '_' and '-'.
+    std::string name;
+
+    // OPTIONAL: The gstreamer pipeline string to run on this branch only;
+    // e.g. "videoscale ! video/x-raw,width=320,height=240".
+    //
+    // If empty, the branch delivers the output of the main processing
+    // pipeline as is.
+    std::string processing_pipeline_string;
+
+    // REQUIRED: Receives the results of this branch.
+    ReceiverCallback receiver_callback;
+
+    // Value of "max-size-buffers" for the queue that starts the branch. The
+    // queue is then limited by this alone.
+    //
+    // 0 keeps the default limits of the queue.
+    int queue_max_buffers = 0;
+
+    // If true, the oldest buffers in the queue that starts the branch are
+    // dropped when it is full, so a slow branch never stalls the others.
+    // Otherwise, it blocks all branches until it has room.
+    bool queue_leaky = false;
+  };
+
   // Options for configuring the gstreamer runner.
   struct Options {
     // REQUIRED: The gstreamer pipeline string to run.
@@ -53,11 +122,54 @@ class GstreamerRunner {
     // processing pipeline to deliver the result through the given callback.
     ReceiverCallback receiver_callback;
 
+    // OPTIONAL: If non-empty, the output of the main processing pipeline is
+    // split into these branches, each of which ends with its own appsink.
+    //
+    // This cannot be used together with receiver_callback. The appsink
+    // options below apply to the appsinks of all branches.
+    std::vector<OutputBranch> output_branches;
+
+    // OPTIONAL: If non-empty, this is called with every element message that
+    // the pipeline posts on its bus; e.g. the "splitmuxsink-fragment-closed"
+    // notifications of a splitmuxsink.
+    //
+    // It runs on the thread that watches the bus, so keep it short.
+    ElementMessageCallback element_message_callback;
+
     // ----------------------------------------------
     // System configurations. Power users only.
 
+    // Maximum bytes of fed data that may wait to enter the pipeline.
+    //
+    // 0 means unlimited, in which case Feed never blocks nor drops; the
+    // waiting data then grows without bound if the pipeline cannot keep up.
+    int64_t appsrc_max_bytes = 0;
+
+    // What Feed does when appsrc_max_bytes would be exceeded.
+    AppSrcLeakyMode appsrc_leaky_mode = AppSrcLeakyMode::kBlock;
+
     // Value of "sync" for appsink.
     bool appsink_sync = false;
+
+    // Value of "max-buffers" for appsink. 0 means unlimited.
+    int appsink_max_buffers = 0;
+
+    // Value of "drop" for appsink. If true, the oldest buffers are dropped
+    // when the appsink already holds `appsink_max_buffers`.
+    bool appsink_drop = false;
+
+    // If true, results are pulled from the appsink by a dedicated reader
+    // thread. Otherwise, they are delivered through the appsink's "new-sample"
+    // signal on gstreamer's streaming thread.
+    //
+    // Pulling decouples the receiver callback from the streaming thread; use
+    // the appsink_max_buffers and appsink_drop options above to decide between
+    // latency and drops when the callback cannot keep up.
+    bool appsink_pull_mode = false;
+
+    // The maximum number of results the reader thread pulls and delivers per
+    // wake-up when appsink_pull_mode is true.
+    int appsink_pull_batch_size = 8;
   };
 
   // Create and run a gstreamer pipeline.
@@ -65,9 +177,40 @@ class GstreamerRunner {
 
   // Feed a GstreamerBuffer object for processing.
   //
-  // This is available only if you enable it in the Options.
+  // This is available only if you enable it in the Options. If the
+  // appsrc_max_bytes option is set, this may block or drop data according to
+  // the appsrc_leaky_mode option.
   Status Feed(const GstreamerBuffer&) const;
 
+  // Same as above, but moves the GstreamerBuffer in.
+  //
+  // The held bytes are handed to gstreamer without copying them.
+  Status Feed(GstreamerBuffer&&) const;
+
+  // Returns the statistics of the data fed so far.
+  //
+  // The queue and drop counts are only tracked when appsrc_max_bytes is set.
+  AppSrcStats GetAppSrcStats() const;
+
+  // Emit the action signal `signal_name` on the pipeline element named
+  // `element_name`; e.g. the "split-now" signal of a splitmuxsink.
+  //
+  // Only action signals that take no arguments and return nothing are
+  // supported.
+  Status EmitActionSignal(const std::string& element_name,
+                          const std::string& signal_name) const;
+
+  // Returns the current value of a string property of a pipeline element.
+  //
+  // `property_path` is as for gst_child_proxy_get; i.e. element names that lead
+  // to the element, then the property name, all separated by "::". For
+  // example, "ais_splitmuxsink::sink::location" names the file that a
+  // splitmuxsink is writing.
+  //
+  // This is available even after the pipeline has completed.
+  StatusOr<std::string> GetStringProperty(
+      const std::string& property_path) const;
+
   // Returns true if the pipeline has completed; otherwise, false.
   bool IsCompleted() const;
 
@@ -16,6 +16,7 @@
 
 #include <gst/gst.h>
 
+#include <atomic>
 #include <string>
 
 #include "aistreams/base/types/gstreamer_buffer.h"
@@ -164,6 +165,55 @@ TEST(GstreamerRunner, JpegFeederTest) {
   }
 }
 
+TEST(GstreamerRunner, JpegMoveFeederTest) {
+  ProducerConsumerQueue<GstreamerBuffer> pcqueue(10);
+  {
+    GstreamerRunner::Options options;
+    options.processing_pipeline_string = kProcessingPipelineString;
+    options.appsrc_caps_string = kJpegCapsString;
+    options.receiver_callback =
+        [&pcqueue](GstreamerBuffer gstreamer_buffer) -> Status {
+      pcqueue.TryEmplace(std::move(gstreamer_buffer));
+      return OkStatus();
+    };
+    auto runner_statusor = GstreamerRunner::Create(options);
+    EXPECT_TRUE(runner_statusor.ok());
+    auto runner = std::move(runner_statusor).ValueOrDie();
+
+    // Feed by moving the bytes into the pipeline.
+    {
+      GstreamerBuffer gstreamer_buffer =
+          GstreamerBufferFromFile(kTestImageLenaPath, kJpegCapsString)
+              .ValueOrDie();
+      EXPECT_TRUE(runner->Feed(std::move(gstreamer_buffer)).ok());
+    }
+    {
+      GstreamerBuffer gstreamer_buffer =
+          GstreamerBufferFromFile(kTestImageSquaresPath, kJpegCapsString)
+              .ValueOrDie();
+      EXPECT_TRUE(runner->Feed(std::move(gstreamer_buffer)).ok());
+    }
+  }
+
+  // Verify the results.
+  {
+    GstreamerBuffer gstreamer_buffer;
+    EXPECT_TRUE(pcqueue.TryPop(gstreamer_buffer, absl::Seconds(1)));
+    auto raw_image_statusor = ToRawImage(std::move(gstreamer_buffer));
+    ASSERT_TRUE(raw_image_statusor.ok());
+    EXPECT_EQ(raw_image_statusor.ValueOrDie().height(), 512);
+    EXPECT_EQ(raw_image_statusor.ValueOrDie().width(), 512);
+  }
+  {
+    GstreamerBuffer gstreamer_buffer;
+    EXPECT_TRUE(pcqueue.TryPop(gstreamer_buffer, absl::Seconds(1)));
+    auto raw_image_statusor = ToRawImage(std::move(gstreamer_buffer));
+    ASSERT_TRUE(raw_image_statusor.ok());
+    EXPECT_EQ(raw_image_statusor.ValueOrDie().height(), 243);
+    EXPECT_EQ(raw_image_statusor.ValueOrDie().width(), 243);
+  }
+}
+
 TEST(GstreamerRunner, NoFeedFetchPipelineTest) {
   {
     GstreamerRunner::Options options;
@@ -209,4 +259,194 @@ TEST(GstreamerRunner, FetchOnlyPipelineTest) {
   }
 }
 
+TEST(GstreamerRunner, FetchOnlyPullModePipelineTest) {
+  {
+    ProducerConsumerQueue<RawImage> pcqueue(10);
+    GstreamerRunner::Options options;
+    options.processing_pipeline_string =
+        "videotestsrc num-buffers=7 is-live=true ! "
+        "video/x-raw,format=RGB,height=100,width=100";
+    options.appsink_pull_mode = true;
+    options.appsink_pull_batch_size = 3;
+    options.receiver_callback = [&pcqueue](GstreamerBuffer buffer) -> Status {
+      auto raw_image_status_or = ToRawImage(std::move(buffer));
+      if (!raw_image_status_or.ok()) {
+        LOG(ERROR) << raw_image_status_or.status();
+      }
+      pcqueue.Emplace(std::move(raw_image_status_or).ValueOrDie());
+      return OkStatus();
+    };
+    auto runner_statusor = GstreamerRunner::Create(options);
+    ASSERT_TRUE(runner_statusor.ok());
+    auto runner = std::move(runner_statusor).ValueOrDie();
+    while (!runner->WaitUntilCompleted(absl::Seconds(1)))
+      ;
+    EXPECT_TRUE(runner->IsCompleted());
+    EXPECT_EQ(pcqueue.count(), 7);
+    RawImage raw_image;
+    EXPECT_TRUE(pcqueue.TryPop(raw_image, absl::Seconds(1)));
+    EXPECT_EQ(raw_image.height(), 100);
+    EXPECT_EQ(raw_image.width(), 100);
+    EXPECT_EQ(raw_image.channels(), 3);
+  }
+  {
+    GstreamerRunner::Options options;
+    options.processing_pipeline_string = "videotestsrc num-buffers=1";
+    options.appsink_pull_mode = true;
+    options.appsink_pull_batch_size = 0;
+    options.receiver_callback = [](GstreamerBuffer buffer) -> Status {
+      return OkStatus();
+    };
+    EXPECT_FALSE(GstreamerRunner::Create(options).ok());
+  }
+}
+
+TEST(GstreamerRunner, OutputBranchesTest) {
+  ProducerConsumerQueue<GstreamerBuffer> full_pcqueue(10);
+  ProducerConsumerQueue<GstreamerBuffer> thumbnail_pcqueue(10);
+  {
+    GstreamerRunner::Options options;
+    options.processing_pipeline_string = kProcessingPipelineString;
+    options.appsrc_caps_string = kJpegCapsString;
+    GstreamerRunner::OutputBranch full_branch;
+    full_branch.name = "full";
+    full_branch.receiver_callback =
+        [&full_pcqueue](GstreamerBuffer gstreamer_buffer) -> Status {
+      full_pcqueue.TryEmplace(std::move(gstreamer_buffer));
+      return OkStatus();
+    };
+    options.output_branches.push_back(full_branch);
+    GstreamerRunner::OutputBranch thumbnail_branch;
+    thumbnail_branch.name = "thumbnail";
+    thumbnail_branch.processing_pipeline_string =
+        "videoscale ! video/x-raw,width=64,height=64";
+    thumbnail_branch.queue_max_buffers = 1;
+    thumbnail_branch.queue_leaky = true;
+    thumbnail_branch.receiver_callback =
+        [&thumbnail_pcqueue](GstreamerBuffer gstreamer_buffer) -> Status {
+      thumbnail_pcqueue.TryEmplace(std::move(gstreamer_buffer));
+      return OkStatus();
+    };
+    options.output_branches.push_back(thumbnail_branch);
+    auto runner_statusor = GstreamerRunner::Create(options);
+    ASSERT_TRUE(runner_statusor.ok());
+    auto runner = std::move(runner_statusor).ValueOrDie();
+
+    GstreamerBuffer gstreamer_buffer =
+        GstreamerBufferFromFile(kTestImageLenaPath, kJpegCapsString)
+            .ValueOrDie();
+    EXPECT_TRUE(runner->Feed(std::move(gstreamer_buffer)).ok());
+  }
+
+  // Each branch delivers the single decoded image in its own way.
+  {
+    GstreamerBuffer gstreamer_buffer;
+    ASSERT_TRUE(full_pcqueue.TryPop(gstreamer_buffer, absl::Seconds(1)));
+    auto raw_image_statusor = ToRawImage(std::move(gstreamer_buffer));
+    ASSERT_TRUE(raw_image_statusor.ok());
+    EXPECT_EQ(raw_image_statusor.ValueOrDie().height(), 512);
+    EXPECT_EQ(raw_image_statusor.ValueOrDie().width(), 512);
+  }
+  {
+    GstreamerBuffer gstreamer_buffer;
+    ASSERT_TRUE(thumbnail_pcqueue.TryPop(gstreamer_buffer, absl::Seconds(1)));
+    auto raw_image_statusor = ToRawImage(std::move(gstreamer_buffer));
+    ASSERT_TRUE(raw_image_statusor.ok());
+    EXPECT_EQ(raw_image_statusor.ValueOrDie().height(), 64);
+    EXPECT_EQ(raw_image_statusor.ValueOrDie().width(), 64);
+  }
+}
+
+TEST(GstreamerRunner, OutputBranchesValidationTest) {
+  GstreamerRunner::Options options;
+  options.processing_pipeline_string = kProcessingPipelineString;
+  options.appsrc_caps_string = kJpegCapsString;
+  GstreamerRunner::OutputBranch branch;
+  branch.name = "bad name";
+  branch.receiver_callback = [](GstreamerBuffer) { return OkStatus(); };
+  options.output_branches.push_back(branch);
+  EXPECT_FALSE(GstreamerRunner::Create(options).ok());
+
+  options.output_branches[0].name = "good_name";
+  options.output_branches.push_back(options.output_branches[0]);
+  EXPECT_FALSE(GstreamerRunner::Create(options).ok());
+
+  options.output_branches.pop_back();
+  options.receiver_callback = [](GstreamerBuffer) { return OkStatus(); };
+  EXPECT_FALSE(GstreamerRunner::Create(options).ok());
+}
+
+TEST(GstreamerRunner, PtsTest) {
+  constexpr int kNumBuffers = 5;
+  constexpr int64_t kPtsPeriod = 1000000;
+  constexpr char kCapsString[] = "application/x-aistreams-test";
+  ProducerConsumerQueue<GstreamerBuffer> pcqueue(kNumBuffers);
+  {
+    GstreamerRunner::Options options;
+    options.appsrc_caps_string = kCapsString;
+    options.processing_pipeline_string = "identity";
+    options.receiver_callback =
+        [&pcqueue](GstreamerBuffer gstreamer_buffer) -> Status {
+      pcqueue.TryEmplace(std::move(gstreamer_buffer));
+      return OkStatus();
+    };
+    auto runner_statusor = GstreamerRunner::Create(options);
+    ASSERT_TRUE(runner_statusor.ok());
+    auto runner = std::move(runner_statusor).ValueOrDie();
+
+    for (int i = 0; i < kNumBuffers; ++i) {
+      GstreamerBuffer gstreamer_buffer;
+      gstreamer_buffer.set_caps_string(kCapsString);
+      gstreamer_buffer.assign(std::string(1, 'a'));
+      gstreamer_buffer.set_pts(i * kPtsPeriod);
+      EXPECT_TRUE(runner->Feed(std::move(gstreamer_buffer)).ok());
+    }
+  }
+
+  // The given PTS come out unchanged.
+  for (int i = 0; i < kNumBuffers; ++i) {
+    GstreamerBuffer gstreamer_buffer;
+    ASSERT_TRUE(pcqueue.TryPop(gstreamer_buffer, absl::Seconds(1)));
+    EXPECT_EQ(gstreamer_buffer.pts(), i * kPtsPeriod);
+  }
+}
+
+TEST(GstreamerRunner, BoundedAppSrcDropUntilKeyFrameTest) {
+  constexpr int kBufferSize = 100;
+  constexpr int kNumBuffers = 10;
+  constexpr char kCapsString[] = "application/x-aistreams-test";
+  std::atomic<int> received_count{0};
+  GstreamerRunner::AppSrcStats stats;
+  {
+    // Each buffer takes 100ms to process, so at most one fits into the queue.
+    GstreamerRunner::Options options;
+    options.appsrc_caps_string = kCapsString;
+    options.processing_pipeline_string = "identity sleep-time=100000";
+    options.appsrc_max_bytes = kBufferSize;
+    options.appsrc_leaky_mode =
+        GstreamerRunner::AppSrcLeakyMode::kDropUntilKeyFrame;
+    options.receiver_callback =
+        [&received_count](GstreamerBuffer buffer) -> Status {
+      ++received_count;
+      return OkStatus();
+    };
+    auto runner_statusor = GstreamerRunner::Create(options);
+    ASSERT_TRUE(runner_statusor.ok());
+    auto runner = std::move(runner_statusor).ValueOrDie();
+
+    // Only the first buffer is a key frame.
+    for (int i = 0; i < kNumBuffers; ++i) {
+      GstreamerBuffer gstreamer_buffer;
+      gstreamer_buffer.set_caps_string(kCapsString);
+      gstreamer_buffer.assign(std::string(kBufferSize, 'a'));
+      gstreamer_buffer.set_is_key_frame(i == 0);
+      EXPECT_TRUE(runner->Feed(std::move(gstreamer_buffer)).ok());
+    }
+    stats = runner->GetAppSrcStats();
+    EXPECT_LE(stats.queued_bytes, kBufferSize);
+    EXPECT_GT(stats.dropped_buffers, 0);
+  }
+  EXPECT_EQ(received_count + stats.dropped_buffers, kNumBuffers);
+}
+
 }  // namespace aistreams
@@ -0,0 +1,298 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/gstreamer/gstreamer_segmented_video_writer.h"
+
+#include <gst/gst.h>
+
+#include <cerrno>
+#include <cstdio>
+
+#include "absl/strings/match.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "aistreams/port/canonical_errors.h"
+#include "aistreams/port/logging.h"
+#include "aistreams/port/status.h"
+#include "aistreams/port/status_macros.h"
+
+namespace aistreams {
+
+namespace {
+
+constexpr char kSplitMuxSinkName[] = "ais_splitmuxsink";
+constexpr char kSplitNowSignal[] = "split-now";
+constexpr char kSplitMuxSinkLocation[] = "ais_splitmuxsink::sink::location";
+constexpr char kFragmentClosedMessage[] = "splitmuxsink-fragment-closed";
+constexpr char kH264CapsPrefix[] = "video/x-h264";
+
+Status ValidateOptions(const GstreamerSegmentedVideoWriter::Options& options) {
+  if (options.caps_string.empty()) {
+    return InvalidArgumentError(
+        "You must supply the expected caps string of the incoming gstreamer "
+        "buffers");
+  }
+  if (!absl::StrContains(options.file_path_pattern, "%")) {
+    return InvalidArgumentError(absl::StrFormat(
+        "The file path pattern must contain an integer directive for the file "
+        "index (given \"%s\")",
+        options.file_path_pattern));
+  }
+  if (options.max_frames_per_file < 0) {
+    return InvalidArgumentError(
+        absl::StrFormat("Given a negative maximum frame count (%d)",
+                        options.max_frames_per_file));
+  }
+  if (options.max_duration_per_file < absl::ZeroDuration()) {
+    return InvalidArgumentError(
+        absl::StrFormat("Given a negative maximum duration (%s)",
+                        absl::FormatDuration(options.max_duration_per_file)));
+  }
+  if (options.max_bytes_per_file < 0) {
+    return InvalidArgumentError(
+        absl::StrFormat("Given a negative maximum file size (%d)",
+                        options.max_bytes_per_file));
+  }
+  if (options.max_frames_per_file == 0 &&
+      options.max_duration_per_file == absl::ZeroDuration() &&
+      options.max_bytes_per_file == 0) {
+    return InvalidArgumentError(
+        "You must supply at least one of the maximum frame count, duration, "
+        "or size of each file");
+  }
+  return OkStatus();
+}
+
+StatusOr<std::string> AssembleGstreamerPipeline(
+    const GstreamerSegmentedVideoWriter::Options& options) {
+  bool passthrough =
+      GstreamerSegmentedVideoWriter::IsPassthroughCaps(options.caps_string);
+  std::vector<std::string> pipeline_elements;
+  if (!passthrough) {
+    pipeline_elements.push_back("decodebin");
+    pipeline_elements.push_back("videoconvert");
+
+    // Frame count limits are enforced with "split-now", which takes effect on
+    // the next key frame. Place the key frames on the file boundaries.
+    if (options.max_frames_per_file > 0) {
+      pipeline_elements.push_back(absl::StrFormat(
+          "x264enc key-int-max=%d", options.max_frames_per_file));
+    } else {
+      pipeline_elements.push_back("x264enc");
+    }
+  }
+  pipeline_elements.push_back("h264parse");
+
+  std::vector<std::string> splitmuxsink_properties;
+  splitmuxsink_properties.push_back(
+      absl::StrFormat("splitmuxsink name=%s", kSplitMuxSinkName));
+  splitmuxsink_properties.push_back(
+      absl::StrFormat("location=\"%s\"", options.file_path_pattern));
+  splitmuxsink_properties.push_back(
+      absl::StrFormat("max-size-time=%d", absl::ToInt64Nanoseconds(
+                                              options.max_duration_per_file)));
+  splitmuxsink_properties.push_back(
+      absl::StrFormat("max-size-bytes=%d", options.max_bytes_per_file));
+
+  // The splitmuxsink can only ask the encoder for key frames on time limits.
+  if (!passthrough && options.max_duration_per_file > absl::ZeroDuration() &&
+      options.max_bytes_per_file == 0) {
+    splitmuxsink_properties.push_back("send-keyframe-requests=true");
+  }
+  pipeline_elements.push_back(absl::StrJoin(splitmuxsink_properties, " "));
+  return absl::StrJoin(pipeline_elements, " ! ");
+}
+
+// Returns the file path in a serialized splitmuxsink message structure named
+// `message_name` or an empty string if `structure_string` is not one.
+std::string FragmentFilePath(const std::string& structure_string,
+                             const char* message_name) {
+  std::string file_path;
+  GstStructure* structure =
+      gst_structure_from_string(structure_string.c_str(), NULL);
+  if (structure == nullptr) {
+    return file_path;
+  }
+  if (gst_structure_has_name(structure, message_name)) {
+    const gchar* location = gst_structure_get_string(structure, "location");
+    if (location != nullptr) {
+      file_path = location;
+    }
+  }
+  gst_structure_free(structure);
+  return file_path;
+}
+
+}  // namespace
+
+GstreamerSegmentedVideoWriter::GstreamerSegmentedVideoWriter(
+    const Options& options)
+    : options_(options) {}
+
+GstreamerSegmentedVideoWriter::~GstreamerSegmentedVideoWriter() {
+  // Finish the pipeline while the state its bus messages update still exists.
+  gstreamer_runner_.reset(nullptr);
+}
+
+StatusOr<std::unique_ptr<GstreamerSegmentedVideoWriter>>
+GstreamerSegmentedVideoWriter::Create(const Options& options) {
+  AIS_RETURN_IF_ERROR(ValidateOptions(options));
+
+  auto video_writer = std::make_unique<GstreamerSegmentedVideoWriter>(options);
+  auto status = video_writer->Initialize();
+  if (!status.ok()) {
+    LOG(ERROR) << status;
+    return InternalError(
+        "Failed to Initialize the GstreamerSegmentedVideoWriter");
+  }
+  return video_writer;
+}
+
+Status GstreamerSegmentedVideoWriter::Initialize() {
+  // Assemble the main gstreamer processing pipeline string.
+  auto pipeline_string_statusor = AssembleGstreamerPipeline(options_);
+  if (!pipeline_string_statusor.ok()) {
+    return pipeline_string_statusor.status();
+  }
+  auto pipeline_string = std::move(pipeline_string_statusor).ValueOrDie();
+
+  // Create a GstreamerRunner that can be fed and reports finished files.
+  GstreamerRunner::Options gstreamer_runner_options;
+  gstreamer_runner_options.appsrc_caps_string = options_.caps_string;
+  gstreamer_runner_options.processing_pipeline_string = pipeline_string;
+  gstreamer_runner_options.element_message_callback =
+      [this](const std::string& structure_string) {
+        OnElementMessage(structure_string);
+      };
+
+  auto gstreamer_runner_statusor =
+      GstreamerRunner::Create(gstreamer_runner_options);
+  if (!gstreamer_runner_statusor.ok()) {
+    LOG(ERROR) << gstreamer_runner_statusor.status();
+    return UnknownError("Failed to create the GstreamerRunner");
+  }
+  gstreamer_runner_ = std::move(gstreamer_runner_statusor).ValueOrDie();
+
+  return OkStatus();
+}
+
+void GstreamerSegmentedVideoWriter::OnElementMessage(
+    const std::string& structure_string) {
+  std::string file_path =
+      FragmentFilePath(structure_string, kFragmentClosedMessage);
+  if (file_path.empty()) {
+    return;
+  }
+  {
+    absl::MutexLock lock(&mu_);
+    if (aborting_) {
+      closed_file_paths_.push_back(std::move(file_path));
+      return;
+    }
+    reported_file_path_ = file_path;
+  }
+  if (options_.file_ready_callback) {
+    options_.file_ready_callback(file_path);
+  }
+}
+
+void GstreamerSegmentedVideoWriter::Abort() {
+  if (gstreamer_runner_ == nullptr) {
+    return;
+  }
+  {
+    absl::MutexLock lock(&mu_);
+    aborting_ = true;
+  }
+
+  // Ask the sink which file it is writing rather than rely on bus messages,
+  // since those still in flight are discarded if the pipeline has failed.
+  std::string partial_file_path;
+  auto location_statusor =
+      gstreamer_runner_->GetStringProperty(kSplitMuxSinkLocation);
+  if (location_statusor.ok()) {
+    partial_file_path = std::move(location_statusor).ValueOrDie();
+  } else {
+    LOG(WARNING) << "Could not tell which file was being written; leaving it "
+                    "in place";
+  }
+  gstreamer_runner_.reset(nullptr);
+
+  std::vector<std::string> closed_file_paths;
+  {
+    absl::MutexLock lock(&mu_);
+    if (partial_file_path == reported_file_path_) {
+      partial_file_path.clear();
+    }
+    closed_file_paths.swap(closed_file_paths_);
+  }
+  for (const auto& file_path : closed_file_paths) {
+    if (file_path != partial_file_path && options_.file_ready_callback) {
+      options_.file_ready_callback(file_path);
+    }
+  }
+  // The file may never have been created if opening it is what failed.
+  if (!partial_file_path.empty() &&
+      std::remove(partial_file_path.c_str()) != 0 && errno != ENOENT) {
+    LOG(WARNING) << absl::StrFormat("Failed to remove the partial file %s",
+                                    partial_file_path);
+  }
+}
+
+bool GstreamerSegmentedVideoWriter::IsPassthroughCaps(
+    const std::string& caps_string) {
+  return absl::StartsWith(caps_string, kH264CapsPrefix);
+}
+
+Status GstreamerSegmentedVideoWriter::CountFrame(bool is_key_frame,
+                                                 bool is_frame_head) {
+  // The other buffers of a frame neither count nor may start a new file.
+  if (options_.max_frames_per_file <= 0 || !is_frame_head) {
+    return OkStatus();
+  }
+
+  // Ask to split before feeding the key frame so that it starts the new file.
+  if (frames_in_file_ >= options_.max_frames_per_file && is_key_frame) {
+    frames_in_file_ = 0;
+    AIS_RETURN_IF_ERROR(gstreamer_runner_->EmitActionSignal(kSplitMuxSinkName,
+                                                            kSplitNowSignal));
+  }
+  ++frames_in_file_;
+  return OkStatus();
+}
+
+Status GstreamerSegmentedVideoWriter::Put(
+    const GstreamerBuffer& gstreamer_buffer) {
+  if (gstreamer_runner_ == nullptr) {
+    return FailedPreconditionError("The writer has been aborted");
+  }
+  AIS_RETURN_IF_ERROR(CountFrame(true, true));
+  return gstreamer_runner_->Feed(gstreamer_buffer);
+}
+
+Status GstreamerSegmentedVideoWriter::Put(GstreamerBuffer&& gstreamer_buffer) {
+  return Put(std::move(gstreamer_buffer), true);
+}
+
+Status GstreamerSegmentedVideoWriter::Put(GstreamerBuffer&& gstreamer_buffer,
+                                          bool is_key_frame,
+                                          bool is_frame_head) {
+  if (gstreamer_runner_ == nullptr) {
+    return FailedPreconditionError("The writer has been aborted");
+  }
+  AIS_RETURN_IF_ERROR(CountFrame(is_key_frame, is_frame_head));
+  return gstreamer_runner_->Feed(std::move(gstreamer_buffer));
+}
+
+}  // namespace aistreams
@@ -0,0 +1,150 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AISTREAMS_GSTREAMER_GSTREAMER_SEGMENTED_VIDEO_WRITER_H_
+#define AISTREAMS_GSTREAMER_GSTREAMER_SEGMENTED_VIDEO_WRITER_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "aistreams/base/types/gstreamer_buffer.h"
+#include "aistreams/gstreamer/gstreamer_runner.h"
+#include "aistreams/port/status.h"
+#include "aistreams/port/statusor.h"
+
+namespace aistreams {
+
+// This class writes a sequence of video files from frames it receives.
+//
+// Unlike the GstreamerVideoWriter, a single gstreamer pipeline stays up for the
+// lifetime of the object and rolls over to a new file whenever one of the
+// limits in the Options is reached. Files are always split on a key frame, so
+// the limits are approximate.
+//
+// H.264 buffers are remuxed as they are (see IsPassthroughCaps). All others,
+// e.g. raw images or JPEG, are decoded and re-encoded with H.264.
+class GstreamerSegmentedVideoWriter {
+ public:
+  // Called with the path of each video file once it is completely written.
+  using FileReadyCallback = std::function<void(const std::string&)>;
+
+  // Options to configure the GstreamerSegmentedVideoWriter.
+  struct Options {
+    // The caps string of all gstreamer buffers that would be fed.
+    std::string caps_string;
+
+    // The path pattern of the output video files.
+    //
+    // This must contain exactly one printf-style integer directive, which is
+    // replaced by the index of each file; e.g. "/tmp/video-%05d.mp4".
+    std::string file_path_pattern;
+
+    // Maximum number of frames saved into each video file.
+    //
+    // 0 means no limit.
+    int max_frames_per_file = 0;
+
+    // Maximum duration of each video file.
+    //
+    // absl::ZeroDuration() means no limit.
+    absl::Duration max_duration_per_file = absl::ZeroDuration();
+
+    // Maximum size of each video file in bytes.
+    //
+    // 0 means no limit.
+    int64_t max_bytes_per_file = 0;
+
+    // OPTIONAL: Called when a video file has been completely written.
+    //
+    // This runs on a gstreamer thread, so keep it short.
+    FileReadyCallback file_ready_callback;
+  };
+
+  // Create an instance in a fully initialized state.
+  static StatusOr<std::unique_ptr<GstreamerSegmentedVideoWriter>> Create(
+      const Options&);
+
+  // Add a gstreamer buffer into the output videos.
+  //
+  // It must have the same caps as that specified in Options.
+  Status Put(const GstreamerBuffer&);
+
+  // Same as above, but moves the GstreamerBuffer in to avoid copying its bytes.
+  Status Put(GstreamerBuffer&&);
+
+  // Same as above, but also says whether the buffer is a key frame and whether
+  // it is the first buffer of a frame (see IsFrameHead in packet_utils.h).
+  //
+  // Use this for encoded buffers that are remuxed. Only frame heads count
+  // towards max_frames_per_file, and a new file may only start on a frame head
+  // that is also a key frame. The overloads above treat every buffer as a
+  // whole key frame.
+  Status Put(GstreamerBuffer&&, bool is_key_frame, bool is_frame_head = true);
+
+  // Stop writing and remove the file that was being written, without reporting
+  // it to the file ready callback. Files that were finished before still are,
+  // and a file that has been reported is never removed.
+  //
+  // Use this instead of destroying the writer when the output is known to be
+  // incomplete; e.g. after Put() fails. No buffer may be Put() afterwards.
+  void Abort();
+
+  // Returns true if buffers with the caps `caps_string` are remuxed without
+  // transcoding.
+  static bool IsPassthroughCaps(const std::string& caps_string);
+
+  // Copy-control members. Use Create() rather than the constructors.
+  //
+  // The destructor finishes the last video file before it returns.
+  explicit GstreamerSegmentedVideoWriter(const Options&);
+  ~GstreamerSegmentedVideoWriter();
+  GstreamerSegmentedVideoWriter() = delete;
+  GstreamerSegmentedVideoWriter(const GstreamerSegmentedVideoWriter&) = delete;
+  GstreamerSegmentedVideoWriter& operator=(
+      const GstreamerSegmentedVideoWriter&) = delete;
+  GstreamerSegmentedVideoWriter(GstreamerSegmentedVideoWriter&&) = delete;
+  GstreamerSegmentedVideoWriter& operator=(GstreamerSegmentedVideoWriter&&) =
+      delete;
+
+ private:
+  Status Initialize();
+  Status CountFrame(bool is_key_frame, bool is_frame_head);
+  void OnElementMessage(const std::string& structure_string);
+
+  Options options_;
+  // The number of frame heads put into the current file.
+  int frames_in_file_ = 0;
+  std::unique_ptr<GstreamerRunner> gstreamer_runner_ = nullptr;
+
+  absl::Mutex mu_;
+
+  // The path of the most recently reported file.
+  std::string reported_file_path_ ABSL_GUARDED_BY(mu_);
+
+  // Set by Abort(). Closed files are then held back in closed_file_paths_
+  // until it is known which of them was cut short.
+  bool aborting_ ABSL_GUARDED_BY(mu_) = false;
+  std::vector<std::string> closed_file_paths_ ABSL_GUARDED_BY(mu_);
+};
+
+}  // namespace aistreams
+
+#endif  // AISTREAMS_GSTREAMER_GSTREAMER_SEGMENTED_VIDEO_WRITER_H_
@@ -0,0 +1,144 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/gstreamer/gstreamer_segmented_video_writer.h"
+
+#include <experimental/filesystem>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_format.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "aistreams/base/types/gstreamer_buffer.h"
+#include "aistreams/port/gtest.h"
+#include "aistreams/util/file_path.h"
+#include "aistreams/util/random_string.h"
+
+namespace fs = std::experimental::filesystem;
+
+namespace aistreams {
+
+namespace {
+
+constexpr int kWidth = 64;
+constexpr int kHeight = 48;
+constexpr int kFramesPerSecond = 30;
+
+// Returns the `index`th frame of a raw RGB video.
+GstreamerBuffer MakeFrame(int index) {
+  GstreamerBuffer gstreamer_buffer;
+  gstreamer_buffer.set_caps_string(absl::StrFormat(
+      "video/x-raw,format=RGB,width=%d,height=%d,framerate=%d/1", kWidth,
+      kHeight, kFramesPerSecond));
+  gstreamer_buffer.assign(std::string(kWidth * kHeight * 3, index % 256));
+  gstreamer_buffer.set_pts(
+      absl::ToInt64Nanoseconds(absl::Seconds(1) * index / kFramesPerSecond));
+  return gstreamer_buffer;
+}
+
+}  // namespace
+
+TEST(GstreamerSegmentedVideoWriter, AbortRemovesPartialFile) {
+  std::string output_dir = file::JoinPath(testing::TempDir(), RandomString(5));
+  ASSERT_TRUE(fs::create_directory(output_dir));
+
+  absl::Mutex mu;
+  std::vector<std::string> ready_file_paths;
+  GstreamerSegmentedVideoWriter::Options options;
+  options.caps_string = MakeFrame(0).get_caps();
+  options.file_path_pattern = file::JoinPath(output_dir, "video-%05d.mp4");
+  options.max_frames_per_file = 5;
+  options.file_ready_callback = [&mu,
+                                 &ready_file_paths](const std::string& path) {
+    absl::MutexLock lock(&mu);
+    ready_file_paths.push_back(path);
+  };
+  auto video_writer =
+      GstreamerSegmentedVideoWriter::Create(options).ValueOrDie();
+
+  // Write two whole files and start a third.
+  for (int i = 0; i < 12; ++i) {
+    ASSERT_TRUE(video_writer->Put(MakeFrame(i)).ok());
+  }
+  video_writer->Abort();
+  EXPECT_FALSE(video_writer->Put(MakeFrame(12)).ok());
+
+  // Only the whole files are reported and left behind.
+  std::string first_file_path = file::JoinPath(output_dir, "video-00000.mp4");
+  std::string second_file_path = file::JoinPath(output_dir, "video-00001.mp4");
+  std::string partial_file_path =
+      file::JoinPath(output_dir, "video-00002.mp4");
+  {
+    absl::MutexLock lock(&mu);
+    EXPECT_EQ(ready_file_paths,
+              std::vector<std::string>({first_file_path, second_file_path}));
+  }
+  EXPECT_TRUE(fs::exists(first_file_path));
+  EXPECT_TRUE(fs::exists(second_file_path));
+  EXPECT_FALSE(fs::exists(partial_file_path));
+
+  ASSERT_TRUE(fs::remove_all(output_dir));
+}
+
+TEST(GstreamerSegmentedVideoWriter, AbortAfterErrorKeepsReportedFiles) {
+  std::string output_dir = file::JoinPath(testing::TempDir(), RandomString(5));
+  ASSERT_TRUE(fs::create_directory(output_dir));
+
+  // Only the directory of the first file exists, so opening the second fails
+  // and takes the pipeline down.
+  std::string first_file_dir = file::JoinPath(output_dir, "part-0");
+  ASSERT_TRUE(fs::create_directory(first_file_dir));
+
+  absl::Mutex mu;
+  std::vector<std::string> ready_file_paths;
+  GstreamerSegmentedVideoWriter::Options options;
+  options.caps_string = MakeFrame(0).get_caps();
+  options.file_path_pattern =
+      file::JoinPath(output_dir, "part-%d", "video.mp4");
+  options.max_frames_per_file = 5;
+  options.file_ready_callback = [&mu,
+                                 &ready_file_paths](const std::string& path) {
+    absl::MutexLock lock(&mu);
+    ready_file_paths.push_back(path);
+  };
+  auto video_writer =
+      GstreamerSegmentedVideoWriter::Create(options).ValueOrDie();
+
+  bool failed = false;
+  absl::Time deadline = absl::Now() + absl::Seconds(10);
+  for (int i = 0; !failed && absl::Now() < deadline; ++i) {
+    failed = !video_writer->Put(MakeFrame(i)).ok();
+    absl::SleepFor(absl::Milliseconds(10));
+  }
+  ASSERT_TRUE(failed);
+  video_writer->Abort();
+
+  // The first file is whole; it is left behind whether or not its report made
+  // it out before the pipeline failed.
+  std::string first_file_path = file::JoinPath(first_file_dir, "video.mp4");
+  EXPECT_TRUE(fs::exists(first_file_path));
+  {
+    absl::MutexLock lock(&mu);
+    for (const auto& path : ready_file_paths) {
+      EXPECT_EQ(path, first_file_path);
+      EXPECT_TRUE(fs::exists(path));
+    }
+  }
+
+  ASSERT_TRUE(fs::remove_all(output_dir));
+}
+
+}  // namespace aistreams
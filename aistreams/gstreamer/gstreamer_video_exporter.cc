@@ -19,10 +19,11 @@
 #include "absl/strings/match.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
+#include "absl/strings/str_replace.h"
 #include "aistreams/base/util/packet_utils.h"
 #include "aistreams/gstreamer/gstreamer_raw_image_yielder.h"
 #include "aistreams/gstreamer/gstreamer_runner.h"
-#include "aistreams/gstreamer/gstreamer_video_writer.h"
+#include "aistreams/gstreamer/gstreamer_segmented_video_writer.h"
 #include "aistreams/gstreamer/type_utils.h"
 #include "aistreams/port/canonical_errors.h"
 #include "aistreams/port/logging.h"
@@ -282,6 +283,39 @@ Status Attach(std::shared_ptr<Channel<T>> channel,
   return OkStatus();
 }
 
+// --------------------------------------------------------------------
+// Values that the video sources deliver to the LocalVideoSaver.
+
+// A raw or an encoded video frame to be saved.
+struct VideoFrame {
+  GstreamerBuffer gstreamer_buffer;
+
+  // Only key frames may start a new video file. Raw frames always are.
+  bool is_key_frame = true;
+
+  // Whether this is the first buffer of a frame; encoded frames may span
+  // several. Raw frames always are.
+  bool is_frame_head = true;
+};
+
+// Converts the decoded images of the sources into VideoFrames.
+StatusOr<VideoFrame> ToVideoFrame(StatusOr<RawImage> raw_image_statusor) {
+  if (!raw_image_statusor.ok()) {
+    return raw_image_statusor.status();
+  }
+  auto gstreamer_buffer_statusor =
+      ToGstreamerBuffer(std::move(raw_image_statusor).ValueOrDie());
+  if (!gstreamer_buffer_statusor.ok()) {
+    return UnknownError(absl::StrFormat(
+        "Could not convert a raw image into a gstreamer buffer: %s",
+        gstreamer_buffer_statusor.status().message()));
+  }
+  VideoFrame video_frame;
+  video_frame.gstreamer_buffer =
+      std::move(gstreamer_buffer_statusor).ValueOrDie();
+  return video_frame;
+}
+
 // --------------------------------------------------------------------
 // GstreamerInputSource implementation.
 //
@@ -291,7 +325,7 @@ Status Attach(std::shared_ptr<Channel<T>> channel,
 // GstreamerRunner).
 
 class GstreamerInputSource : public Worker<GstreamerInputSource, std::tuple<>,
-                                           std::tuple<StatusOr<RawImage>>> {
+                                           std::tuple<StatusOr<VideoFrame>>> {
  public:
   struct Options {
     std::string gstreamer_input_pipeline;
@@ -308,16 +342,14 @@ class GstreamerInputSource : public Worker<GstreamerInputSource, std::tuple<>,
         DecideProcessingPipeline();
     gstreamer_runner_options.receiver_callback =
         [this](GstreamerBuffer buffer) -> Status {
-      auto raw_image_statusor = ToRawImage(std::move(buffer));
-      if (!raw_image_statusor.ok()) {
-        return raw_image_statusor.status();
-      }
+      // The buffers are already raw RGB images; hand them over as they are.
+      VideoFrame video_frame;
+      video_frame.gstreamer_buffer = std::move(buffer);
       if (out_channel()->IsDstCompleted()) {
         return CancelledError(absl::StrFormat(
             "%s: The downstream worker has completed.", GetName()));
       }
-      if (!out_channel()->pcqueue()->TryEmplace(
-              std::move(raw_image_statusor))) {
+      if (!out_channel()->pcqueue()->TryEmplace(std::move(video_frame))) {
         LOG(ERROR)
             << "The working raw image buffer is full; dropping frame. Consider "
                "increasing the working buffer size if you believe this is "
@@ -350,7 +382,7 @@ class GstreamerInputSource : public Worker<GstreamerInputSource, std::tuple<>,
  private:
   Options options_;
 
-  std::shared_ptr<Channel<StatusOr<RawImage>>> out_channel() {
+  std::shared_ptr<Channel<StatusOr<VideoFrame>>> out_channel() {
     return std::get<0>(out_channels_);
   }
 
@@ -381,11 +413,12 @@ class GstreamerInputSource : public Worker<GstreamerInputSource, std::tuple<>,
 // StreamServerSource implementation.
 
 class StreamServerSource : public Worker<StreamServerSource, std::tuple<>,
-                                         std::tuple<StatusOr<RawImage>>> {
+                                         std::tuple<StatusOr<VideoFrame>>> {
  public:
   struct Options {
     ReceiverOptions receiver_options;
     absl::Duration receiver_timeout = absl::Seconds(10);
+    bool passthrough_encoded_video = true;
   };
   explicit StreamServerSource(const Options& options) : options_(options) {}
 
@@ -412,15 +445,22 @@ class StreamServerSource : public Worker<StreamServerSource, std::tuple<>,
         break;
       }
 
-      // Feed the Packet for decoding.
-      auto gstreamer_buffer_statusor =
-          ToGstreamerBuffer(std::move(packet_statusor).ValueOrDie());
+      // Forward the Packet as it is or feed it for decoding.
+      Packet packet = std::move(packet_statusor).ValueOrDie();
+      bool is_key_frame = IsKeyFrame(packet);
+      bool is_frame_head = IsFrameHead(packet);
+      auto gstreamer_buffer_statusor = ToGstreamerBuffer(std::move(packet));
       if (!gstreamer_buffer_statusor.ok()) {
         return_status = UnknownError(absl::StrFormat(
             "Failed to convert a packet to a gstreamer buffer: %s",
             gstreamer_buffer_statusor.status().message()));
         break;
       }
+      if (raw_image_yielder_ == nullptr) {
+        ForwardEncodedFrame(std::move(gstreamer_buffer_statusor).ValueOrDie(),
+                            is_key_frame, is_frame_head);
+        continue;
+      }
       auto status = raw_image_yielder_->Feed(
           std::move(gstreamer_buffer_statusor).ValueOrDie());
       if (!status.ok()) {
@@ -431,13 +471,43 @@ class StreamServerSource : public Worker<StreamServerSource, std::tuple<>,
       }
     }
 
-    raw_image_yielder_->SignalEOS();
+    if (raw_image_yielder_ != nullptr) {
+      raw_image_yielder_->SignalEOS();
+    } else if (!out_channel()->pcqueue()->TryEmplace(
+                   NotFoundError("Reached EOS."))) {
+      LOG(WARNING) << absl::StrFormat(
+          "%s: Failed to deliver EOS to dependent workers.", GetName());
+    }
     return return_status;
   }
 
   ~StreamServerSource() = default;
 
  private:
+  // Deliver a buffer of an encoded frame as it is to the output channel.
+  //
+  // Frames that follow a dropped buffer cannot be decoded without it, so they
+  // are dropped too up to the head of the next key frame.
+  void ForwardEncodedFrame(GstreamerBuffer gstreamer_buffer, bool is_key_frame,
+                           bool is_frame_head) {
+    if (awaiting_key_frame_ && !(is_key_frame && is_frame_head)) {
+      return;
+    }
+    VideoFrame video_frame;
+    video_frame.gstreamer_buffer = std::move(gstreamer_buffer);
+    video_frame.is_key_frame = is_key_frame;
+    video_frame.is_frame_head = is_frame_head;
+    if (!out_channel()->pcqueue()->TryEmplace(std::move(video_frame))) {
+      LOG(ERROR)
+          << "The working video frame buffer is full; dropping frames up to "
+             "the next key frame. Consider increasing the working buffer size "
+             "if you believe this is transient.";
+      awaiting_key_frame_ = true;
+      return;
+    }
+    awaiting_key_frame_ = false;
+  }
+
   StatusOr<Packet> ReceivePacket(bool* is_eos) {
     Packet p;
     if (!packet_receiver_queue_->TryPop(p, options_.receiver_timeout)) {
@@ -482,8 +552,10 @@ class StreamServerSource : public Worker<StreamServerSource, std::tuple<>,
     if (is_eos) {
       return NotFoundError("Got EOS. The stream has already ended.");
     }
-    auto gstreamer_buffer_statusor =
-        ToGstreamerBuffer(std::move(packet_statusor).ValueOrDie());
+    Packet packet = std::move(packet_statusor).ValueOrDie();
+    bool is_key_frame = IsKeyFrame(packet);
+    bool is_frame_head = IsFrameHead(packet);
+    auto gstreamer_buffer_statusor = ToGstreamerBuffer(std::move(packet));
     if (!gstreamer_buffer_statusor.ok()) {
       return UnknownError(absl::StrFormat(
           "Failed to convert the first packet to a gstreamer buffer: %s",
@@ -491,13 +563,25 @@ class StreamServerSource : public Worker<StreamServerSource, std::tuple<>,
     }
     auto gstreamer_buffer = std::move(gstreamer_buffer_statusor).ValueOrDie();
 
+    // Encoded H.264 streams are saved without transcoding.
+    if (options_.passthrough_encoded_video &&
+        GstreamerSegmentedVideoWriter::IsPassthroughCaps(
+            gstreamer_buffer.get_caps())) {
+      LOG(INFO) << absl::StrFormat(
+          "%s: Saving the encoded stream without transcoding (caps \"%s\").",
+          GetName(), gstreamer_buffer.get_caps());
+      ForwardEncodedFrame(std::move(gstreamer_buffer), is_key_frame,
+                          is_frame_head);
+      return OkStatus();
+    }
+
     // Create the raw image yielder.
     GstreamerRawImageYielder::Options raw_image_yielder_options;
     raw_image_yielder_options.caps_string = gstreamer_buffer.get_caps();
     raw_image_yielder_options.callback =
         [this](StatusOr<RawImage> raw_image_statusor) -> Status {
       if (!out_channel()->pcqueue()->TryEmplace(
-              std::move(raw_image_statusor))) {
+              ToVideoFrame(std::move(raw_image_statusor)))) {
         LOG(ERROR)
             << "The working raw image buffer is full; dropping frame. Consider "
                "increasing the working buffer size if you believe this is "
@@ -514,7 +598,7 @@ class StreamServerSource : public Worker<StreamServerSource, std::tuple<>,
     raw_image_yielder_ = std::move(raw_image_yielder_statusor).ValueOrDie();
 
     // Feed the first buffer.
-    status = raw_image_yielder_->Feed(gstreamer_buffer);
+    status = raw_image_yielder_->Feed(std::move(gstreamer_buffer));
     if (!status.ok()) {
       return UnknownError(absl::StrFormat(
           "Failed to Feed the first buffer into the raw image yielder: %s",
@@ -525,27 +609,34 @@ class StreamServerSource : public Worker<StreamServerSource, std::tuple<>,
 
   Options options_;
 
-  std::shared_ptr<Channel<StatusOr<RawImage>>> out_channel() {
+  std::shared_ptr<Channel<StatusOr<VideoFrame>>> out_channel() {
     return std::get<0>(out_channels_);
   }
 
   std::unique_ptr<ReceiverQueue<Packet>> packet_receiver_queue_ = nullptr;
 
   // TODO: Consider pushing the decoder into the local video saver.
+  //
+  // This stays null when the encoded stream is forwarded as it is.
   std::unique_ptr<GstreamerRawImageYielder> raw_image_yielder_ = nullptr;
+
+  // True while encoded frames must be dropped up to the next key frame.
+  bool awaiting_key_frame_ = true;
 };
 
 // --------------------------------------------------------------------
 // LocalVideoSaver implementation.
 
 class LocalVideoSaver
-    : public Worker<LocalVideoSaver, std::tuple<StatusOr<RawImage>>,
+    : public Worker<LocalVideoSaver, std::tuple<StatusOr<VideoFrame>>,
                     std::tuple<StatusOr<std::string>>> {
  public:
   struct Options {
     std::string file_prefix;
     std::string output_dir;
     int max_frames_per_file;
+    absl::Duration max_duration_per_file;
+    int64_t max_bytes_per_file;
 
     // TODO: Consider refactoring to have two Workers, one having no output
     // stream and another having one so that we can avoid this conditional
@@ -557,94 +648,72 @@ class LocalVideoSaver
   Status WorkImpl() {
     AIS_RETURN_IF_ERROR(ValidatePreconditions());
 
+    // A single segmented video writer rolls over files as the limits are
+    // reached. It is only recreated when the caps of the frames change.
     Status return_status = OkStatus();
-    for (bool start_new_file = true; start_new_file;) {
-      std::unique_ptr<GstreamerVideoWriter> video_writer = nullptr;
-      std::string output_video_file_path;
-      for (int image_index = 0; image_index < options_.max_frames_per_file;
-           ++image_index) {
-        // Get a new raw image from the decoder.
-        StatusOr<RawImage> raw_image_statusor;
-        while (!in_channel()->pcqueue()->TryPop(raw_image_statusor,
-                                                absl::Seconds(5))) {
-          if (in_channel()->IsSrcCompleted()) {
-            raw_image_statusor = NotFoundError(
-                "The image source completed without delivering an EOS.");
-            break;
-          }
-        }
-        if (raw_image_statusor.status().code() == StatusCode::kNotFound) {
-          start_new_file = false;
+    std::unique_ptr<GstreamerSegmentedVideoWriter> video_writer = nullptr;
+    std::string video_writer_caps;
+    while (!options_.forward_file_paths || !out_channel()->IsDstCompleted()) {
+      // Get a new video frame from the source.
+      StatusOr<VideoFrame> video_frame_statusor;
+      while (!in_channel()->pcqueue()->TryPop(video_frame_statusor,
+                                              absl::Seconds(5))) {
+        if (in_channel()->IsSrcCompleted()) {
+          video_frame_statusor = NotFoundError(
+              "The video source completed without delivering an EOS.");
           break;
         }
-
-        // Get the raw image and write it into the current video file.
-        auto raw_image_gstreamer_buffer_statusor =
-            ToGstreamerBuffer(std::move(raw_image_statusor).ValueOrDie());
-        if (!raw_image_gstreamer_buffer_statusor.ok()) {
-          return_status = UnknownError(absl::StrFormat(
-              "Could not convert a raw image into a gstreamer buffer: %s",
-              raw_image_gstreamer_buffer_statusor.status().message()));
-          break;
-        }
-        auto raw_image_gstreamer_buffer =
-            std::move(raw_image_gstreamer_buffer_statusor).ValueOrDie();
-
-        if (video_writer == nullptr) {
-          output_video_file_path = GenerateVideoFilePath();
-          GstreamerVideoWriter::Options video_writer_options;
-          video_writer_options.file_path = output_video_file_path;
-          video_writer_options.caps_string =
-              raw_image_gstreamer_buffer.get_caps();
-          auto video_writer_statusor =
-              GstreamerVideoWriter::Create(video_writer_options);
-          if (!video_writer_statusor.ok()) {
-            return_status = InternalError(
-                absl::StrFormat("Failed to create a new video writer: %s",
-                                video_writer_statusor.status().message()));
-            break;
-          }
-          video_writer = std::move(video_writer_statusor).ValueOrDie();
-        }
-
-        auto status = video_writer->Put(raw_image_gstreamer_buffer);
-        if (!status.ok()) {
-          return_status = UnknownError(absl::StrFormat(
-              "Failed to write a raw image: %s", status.message()));
+      }
+      if (video_frame_statusor.status().code() == StatusCode::kNotFound) {
+        break;
+      }
+      if (!video_frame_statusor.ok()) {
+        return_status = video_frame_statusor.status();
+        break;
+      }
+      auto video_frame = std::move(video_frame_statusor).ValueOrDie();
+
+      if (video_writer == nullptr ||
+          video_frame.gstreamer_buffer.get_caps() != video_writer_caps) {
+        // Finish the files of the previous caps before starting new ones.
+        video_writer.reset(nullptr);
+        video_writer_caps = video_frame.gstreamer_buffer.get_caps();
+        GstreamerSegmentedVideoWriter::Options video_writer_options;
+        video_writer_options.caps_string = video_writer_caps;
+        video_writer_options.file_path_pattern = GenerateVideoFilePathPattern();
+        video_writer_options.max_frames_per_file = options_.max_frames_per_file;
+        video_writer_options.max_duration_per_file =
+            options_.max_duration_per_file;
+        video_writer_options.max_bytes_per_file = options_.max_bytes_per_file;
+        video_writer_options.file_ready_callback =
+            [this](const std::string& file_path) { OnFileReady(file_path); };
+        auto video_writer_statusor =
+            GstreamerSegmentedVideoWriter::Create(video_writer_options);
+        if (!video_writer_statusor.ok()) {
+          return_status = InternalError(
+              absl::StrFormat("Failed to create a new video writer: %s",
+                              video_writer_statusor.status().message()));
           break;
         }
+        video_writer = std::move(video_writer_statusor).ValueOrDie();
       }
 
-      // Explicitly flush the video file.
-      video_writer.reset(nullptr);
-      if (!return_status.ok()) {
-        if (std::remove(output_video_file_path.c_str()) != 0) {
-          LOG(WARNING) << absl::StrFormat("%s: Failed to remove %s.", GetName(),
-                                          output_video_file_path);
-        }
-        start_new_file = false;
-        continue;
-      }
-      LOG(INFO) << absl::StrFormat("%s: Successfully wrote local file %s.",
-                                   GetName(), output_video_file_path);
-
-      if (options_.forward_file_paths) {
-        // Forward the video path if downstream is still running.
-        // Stop processing otherwise.
-        if (!out_channel()->IsDstCompleted()) {
-          if (!out_channel()->pcqueue()->TryEmplace(output_video_file_path)) {
-            LOG(WARNING) << absl::StrFormat(
-                "%s: The file path buffer is full. Omitting %s from "
-                "downstream processing.",
-                GetName(), output_video_file_path);
-          }
-        } else {
-          start_new_file = false;
-          continue;
-        }
+      auto status = video_writer->Put(std::move(video_frame.gstreamer_buffer),
+                                      video_frame.is_key_frame,
+                                      video_frame.is_frame_head);
+      if (!status.ok()) {
+        return_status = UnknownError(absl::StrFormat(
+            "Failed to write a video frame: %s", status.message()));
+
+        // Discard the truncated file rather than forwarding it.
+        video_writer->Abort();
+        break;
       }
     }
 
+    // Explicitly flush the last video file.
+    video_writer.reset(nullptr);
+
     // Cleanup.
     if (options_.forward_file_paths) {
       if (!out_channel()->pcqueue()->TryEmplace(
@@ -659,7 +728,7 @@ class LocalVideoSaver
  private:
   Options options_;
 
-  std::shared_ptr<Channel<StatusOr<RawImage>>> in_channel() {
+  std::shared_ptr<Channel<StatusOr<VideoFrame>>> in_channel() {
     return std::get<0>(in_channels_);
   }
 
@@ -667,12 +736,44 @@ class LocalVideoSaver
     return std::get<0>(out_channels_);
   }
 
+  // Called by the video writer each time it finishes a file.
+  void OnFileReady(const std::string& file_path) {
+    LOG(INFO) << absl::StrFormat("%s: Successfully wrote local file %s.",
+                                 GetName(), file_path);
+    if (!options_.forward_file_paths) {
+      return;
+    }
+
+    // Forward the video path if downstream is still running.
+    if (out_channel()->IsDstCompleted()) {
+      return;
+    }
+    if (!out_channel()->pcqueue()->TryEmplace(file_path)) {
+      LOG(WARNING) << absl::StrFormat(
+          "%s: The file path buffer is full. Omitting %s from "
+          "downstream processing.",
+          GetName(), file_path);
+    }
+  }
+
   Status ValidatePreconditions() {
-    if (options_.max_frames_per_file <= 0) {
+    if (options_.max_frames_per_file < 0 ||
+        options_.max_duration_per_file < absl::ZeroDuration() ||
+        options_.max_bytes_per_file < 0) {
+      return InvalidArgumentError(absl::StrFormat(
+          "%s: The maximum frame count, duration and size must not be "
+          "negative (given %d, %s and %d)",
+          GetName(), options_.max_frames_per_file,
+          FormatDuration(options_.max_duration_per_file),
+          options_.max_bytes_per_file));
+    }
+    if (options_.max_frames_per_file == 0 &&
+        options_.max_duration_per_file == absl::ZeroDuration() &&
+        options_.max_bytes_per_file == 0) {
       return InvalidArgumentError(
-          absl::StrFormat("%s: A positive value for the maximum frame count is "
-                          "expected (given %d)",
-                          GetName(), options_.max_frames_per_file));
+          absl::StrFormat("%s: A positive value for at least one of the "
+                          "maximum frame count, duration or size is expected",
+                          GetName()));
     }
     if (in_channel() == nullptr) {
       return FailedPreconditionError(absl::StrFormat(
@@ -696,14 +797,15 @@ class LocalVideoSaver
     return OkStatus();
   }
 
-  std::string GenerateVideoFilePath() {
+  std::string GenerateVideoFilePathPattern() {
     // TODO: Name the files according to server conventions.
     //
     // Currently, we use the following:
-    // [<optional-prefix>-]<random-session-id>-<time-string>.mp4
+    // [<optional-prefix>-]<random-session-id>-<time-string>-<index>.mp4
     //
     // The <time-string> is in absl's default human readable format (RFC3339).
-    // and uses the local time.
+    // and uses the local time at which the video writer started. The <index>
+    // counts the files written since then.
     //
     // It is better to use the packet timestamp for the stream server
     // source and the gstreamer buffer time for the gstreamer input source
@@ -720,14 +822,16 @@ class LocalVideoSaver
     file_name_components.push_back(session_string);
     file_name_components.push_back(time_string);
     std::string file_name = absl::StrJoin(file_name_components, "-");
-    file_name += ".mp4";
 
     // Decide the output file path.
     std::string file_path = file_name;
     if (!options_.output_dir.empty()) {
       file_path = absl::StrFormat("%s/%s", options_.output_dir, file_name);
     }
-    return file_path;
+
+    // Escape everything but the directive for the file index.
+    file_path = absl::StrReplaceAll(file_path, {{"%", "%%"}});
+    return file_path + "-%05d.mp4";
   }
 };
 
@@ -887,6 +991,9 @@ Status GstreamerVideoExporter::Run() {
   local_video_saver_options.output_dir = options_.output_dir;
   local_video_saver_options.file_prefix = options_.file_prefix;
   local_video_saver_options.max_frames_per_file = options_.max_frames_per_file;
+  local_video_saver_options.max_duration_per_file =
+      options_.max_duration_per_file;
+  local_video_saver_options.max_bytes_per_file = options_.max_bytes_per_file;
   local_video_saver_options.forward_file_paths = options_.upload_to_gcs;
   auto local_video_saver =
       std::make_shared<LocalVideoSaver>(local_video_saver_options);
@@ -894,6 +1001,9 @@ Status GstreamerVideoExporter::Run() {
 
   StreamServerSource::Options stream_server_source_options;
   stream_server_source_options.receiver_options = options_.receiver_options;
+  stream_server_source_options.receiver_timeout = options_.receiver_timeout;
+  stream_server_source_options.passthrough_encoded_video =
+      options_.passthrough_encoded_video;
   auto stream_server_source =
       std::make_shared<StreamServerSource>(stream_server_source_options);
   stream_server_source->SetName(kStreamServerSourceName);
@@ -916,10 +1026,10 @@ Status GstreamerVideoExporter::Run() {
                         local_video_saver->GetName(), gcs_uploader->GetName()));
   }
 
-  auto raw_image_channel = std::make_shared<Channel<StatusOr<RawImage>>>(
+  auto video_frame_channel = std::make_shared<Channel<StatusOr<VideoFrame>>>(
       options_.working_buffer_size);
   if (options_.use_gstreamer_input_source) {
-    status = Attach<0, 0>(raw_image_channel, gstreamer_input_source,
+    status = Attach<0, 0>(video_frame_channel, gstreamer_input_source,
                           local_video_saver);
     if (!status.ok()) {
       LOG(ERROR) << status;
@@ -928,7 +1038,7 @@ Status GstreamerVideoExporter::Run() {
           gstreamer_input_source->GetName(), local_video_saver->GetName()));
     }
   } else {
-    status = Attach<0, 0>(raw_image_channel, stream_server_source,
+    status = Attach<0, 0>(video_frame_channel, stream_server_source,
                           local_video_saver);
     if (!status.ok()) {
       LOG(ERROR) << status;
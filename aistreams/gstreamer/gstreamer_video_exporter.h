@@ -17,11 +17,13 @@
 #ifndef AISTREAMS_GSTREAMER_GSTREAMER_VIDEO_EXPORTER_H_
 #define AISTREAMS_GSTREAMER_GSTREAMER_VIDEO_EXPORTER_H_
 
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <thread>
 
 #include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "aistreams/base/types/gstreamer_buffer.h"
 #include "aistreams/base/types/raw_image.h"
 #include "aistreams/base/wrappers/receivers.h"
@@ -45,10 +47,20 @@ class GstreamerVideoExporter {
     // ------------------------------------------------------------
     // Video writing configurations.
 
+    // A single video writer stays up for the whole export and rolls over to
+    // a new file as soon as any of the limits below is reached. Files are
+    // split on key frames, so the limits are approximate. 0 disables a limit,
+    // but at least one of them must be set.
+
     // Maximum number of frames saved into each video file.
-    // TODO: add max time interval and consider max file size.
     int max_frames_per_file = 200;
 
+    // Maximum duration of each video file.
+    absl::Duration max_duration_per_file = absl::ZeroDuration();
+
+    // Maximum size of each video file in bytes.
+    int64_t max_bytes_per_file = 0;
+
     // The directory into which video files are saved.
     //
     // Leaving this empty will save to the current working directory.
@@ -96,6 +108,11 @@ class GstreamerVideoExporter {
     // Stream server source's timeout to receive packets.
     absl::Duration receiver_timeout = absl::Seconds(10);
 
+    // If true, H.264 streams from the stream server source are remuxed into
+    // the video files without transcoding; files then start on the key
+    // frames of the stream. Raw and JPEG streams are always transcoded.
+    bool passthrough_encoded_video = true;
+
     // ------------------------------------------------------------
     // System configurations.
 
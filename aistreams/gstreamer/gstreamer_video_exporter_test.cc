@@ -14,10 +14,17 @@
 
 #include "aistreams/gstreamer/gstreamer_video_exporter.h"
 
+#include <algorithm>
 #include <experimental/filesystem>
 #include <string>
+#include <vector>
 
+#include "absl/strings/str_format.h"
+#include "aistreams/base/make_packet.h"
+#include "aistreams/base/packet_flags.h"
 #include "aistreams/base/types/gstreamer_buffer.h"
+#include "aistreams/base/wrappers/senders.h"
+#include "aistreams/gstreamer/gstreamer_runner.h"
 #include "aistreams/gstreamer/type_utils.h"
 #include "aistreams/port/gtest.h"
 #include "aistreams/port/logging.h"
@@ -26,13 +33,51 @@
 #include "aistreams/port/statusor.h"
 #include "aistreams/util/file_path.h"
 #include "aistreams/util/producer_consumer_queue.h"
+#include "aistreams/server/local_stream_server.h"
 #include "aistreams/util/random_string.h"
 
 namespace fs = std::experimental::filesystem;
 
 namespace aistreams {
 
-// TODO: Add a stream server source test. Requires making a mock video server.
+namespace {
+
+constexpr char kUnalignedH264Caps[] = "video/x-h264,stream-format=byte-stream";
+
+// Runs `pipeline` to completion and returns the buffers that it outputs.
+std::vector<GstreamerBuffer> RunPipeline(const std::string& pipeline) {
+  absl::Mutex mu;
+  std::vector<GstreamerBuffer> buffers;
+  GstreamerRunner::Options runner_options;
+  runner_options.processing_pipeline_string = pipeline;
+  runner_options.receiver_callback = [&mu,
+                                      &buffers](GstreamerBuffer buffer) {
+    absl::MutexLock lock(&mu);
+    buffers.push_back(std::move(buffer));
+    return OkStatus();
+  };
+  auto runner = GstreamerRunner::Create(runner_options).ValueOrDie();
+  while (!runner->WaitUntilCompleted(absl::Seconds(1)))
+    ;
+  runner.reset(nullptr);
+  return buffers;
+}
+
+// Returns a packet holding `gstreamer_buffer` with the given flags.
+Packet MakeVideoPacket(GstreamerBuffer gstreamer_buffer, bool is_key_frame,
+                       bool is_frame_head) {
+  Packet packet = MakePacket(std::move(gstreamer_buffer)).ValueOrDie();
+  ClearPacketFlags(&packet);
+  if (is_key_frame) {
+    SetPacketFlags(PacketFlags::kIsKeyFrame, &packet);
+  }
+  if (is_frame_head) {
+    SetPacketFlags(PacketFlags::kIsFrameHead, &packet);
+  }
+  return packet;
+}
+
+}  // namespace
 
 TEST(GstreamerVideoExporter, GstreamerInputSourceBasicTest) {
   std::string output_dir = file::JoinPath(testing::TempDir(), RandomString(5));
@@ -91,4 +136,111 @@ TEST(GstreamerVideoExporter, GstreamerInputSourceBasicTest) {
   ASSERT_TRUE(fs::remove_all(output_dir));
 }
 
+TEST(GstreamerVideoExporter, MaxDurationPerFileTest) {
+  std::string output_dir = file::JoinPath(testing::TempDir(), RandomString(5));
+  ASSERT_TRUE(fs::create_directory(output_dir));
+
+  // videotestsrc produces 30 frames per second by default.
+  GstreamerVideoExporter::Options options;
+  options.max_frames_per_file = 0;
+  options.max_duration_per_file = absl::Seconds(1);
+  options.output_dir = output_dir;
+  options.upload_to_gcs = false;
+  options.use_gstreamer_input_source = true;
+  options.gstreamer_input_pipeline = "videotestsrc num-buffers=90 is-live=true";
+  auto video_exporter = GstreamerVideoExporter::Create(options).ValueOrDie();
+  auto status = video_exporter->Run();
+  EXPECT_TRUE(status.ok());
+
+  // Files are split on key frames, so only expect roughly one per second.
+  auto output_video_count = std::distance(fs::directory_iterator(output_dir),
+                                          fs::directory_iterator());
+  EXPECT_GE(output_video_count, 2);
+  EXPECT_LE(output_video_count, 4);
+
+  ASSERT_TRUE(fs::remove_all(output_dir));
+}
+
+TEST(GstreamerVideoExporter, StreamServerSourcePassthroughTest) {
+  std::string output_dir = file::JoinPath(testing::TempDir(), RandomString(5));
+  ASSERT_TRUE(fs::create_directory(output_dir));
+
+  // Encode a video with a key frame every 7 frames.
+  constexpr int kNumFrames = 42;
+  constexpr int kKeyFrameInterval = 7;
+  std::vector<GstreamerBuffer> encoded_frames = RunPipeline(absl::StrFormat(
+      "videotestsrc num-buffers=%d ! x264enc key-int-max=%d bframes=0 "
+      "tune=zerolatency ! video/x-h264,stream-format=byte-stream,alignment=au",
+      kNumFrames, kKeyFrameInterval));
+  ASSERT_EQ(encoded_frames.size(), kNumFrames);
+
+  // Send each frame in two packets, only the first of which is a frame head.
+  // The packets are then not aligned to access units, so say so in the caps.
+  auto server =
+      LocalStreamServer::Create(LocalStreamServer::Options()).ValueOrDie();
+  ConnectionOptions connection_options;
+  connection_options.target_address = server->target_address();
+  connection_options.ssl_options.use_insecure_channel = true;
+  {
+    SenderOptions sender_options;
+    sender_options.connection_options = connection_options;
+    sender_options.stream_name = "video";
+    std::unique_ptr<PacketSender> sender;
+    ASSERT_TRUE(MakePacketSender(sender_options, &sender).ok());
+    for (const auto& frame : encoded_frames) {
+      std::string bytes(frame.data(), frame.size());
+      size_t head_size = bytes.size() / 2;
+      GstreamerBuffer head;
+      head.set_caps_string(kUnalignedH264Caps);
+      head.set_pts(frame.pts());
+      GstreamerBuffer tail = head;
+      tail.set_pts(-1);
+      head.assign(bytes.substr(0, head_size));
+      tail.assign(bytes.substr(head_size));
+      ASSERT_TRUE(sender
+                      ->Send(MakeVideoPacket(std::move(head),
+                                             frame.is_key_frame(), true))
+                      .ok());
+      ASSERT_TRUE(sender
+                      ->Send(MakeVideoPacket(std::move(tail),
+                                             frame.is_key_frame(), false))
+                      .ok());
+    }
+    ASSERT_TRUE(sender->Send(MakeEosPacket("done").ValueOrDie()).ok());
+  }
+
+  // Run the video exporter. With transcoding, x264enc would place the key
+  // frames on every 10th frame instead.
+  GstreamerVideoExporter::Options options;
+  options.max_frames_per_file = 10;
+  options.output_dir = output_dir;
+  options.upload_to_gcs = false;
+  options.receiver_options.connection_options = connection_options;
+  options.receiver_options.stream_name = "video";
+  options.receiver_options.offset_options.reset_offset = true;
+  options.receiver_options.offset_options.offset_position =
+      OffsetOptions::SpecialOffset::kOffsetBeginning;
+  auto video_exporter = GstreamerVideoExporter::Create(options).ValueOrDie();
+  EXPECT_TRUE(video_exporter->Run().ok());
+
+  // Files roll over on the first key frame after 10 frames; i.e. every 14.
+  std::vector<std::string> output_video_paths;
+  for (const auto& entry : fs::directory_iterator(output_dir)) {
+    output_video_paths.push_back(entry.path());
+  }
+  std::sort(output_video_paths.begin(), output_video_paths.end());
+  ASSERT_EQ(output_video_paths.size(), 3);
+  for (const auto& path : output_video_paths) {
+    std::vector<GstreamerBuffer> frames = RunPipeline(
+        absl::StrFormat("filesrc location=%s ! qtdemux", path));
+    ASSERT_EQ(frames.size(), 2 * kKeyFrameInterval) << path;
+    for (size_t i = 0; i < frames.size(); ++i) {
+      EXPECT_EQ(frames[i].is_key_frame(), i % kKeyFrameInterval == 0)
+          << path << " frame " << i;
+    }
+  }
+
+  ASSERT_TRUE(fs::remove_all(output_dir));
+}
+
 }  // namespace aistreams
@@ -98,4 +98,8 @@ Status GstreamerVideoWriter::Put(const GstreamerBuffer& gstreamer_buffer) {
   return gstreamer_runner_->Feed(gstreamer_buffer);
 }
 
+Status GstreamerVideoWriter::Put(GstreamerBuffer&& gstreamer_buffer) {
+  return gstreamer_runner_->Feed(std::move(gstreamer_buffer));
+}
+
 }  // namespace aistreams
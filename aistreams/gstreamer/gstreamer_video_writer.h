@@ -48,6 +48,9 @@ class GstreamerVideoWriter {
   // It must have the same caps as that specified in Options.
   Status Put(const GstreamerBuffer&);
 
+  // Same as above, but moves the GstreamerBuffer in to avoid copying its bytes.
+  Status Put(GstreamerBuffer&&);
+
   // Copy-control members. Use Create() rather than the constructors.
   explicit GstreamerVideoWriter(const Options&);
   ~GstreamerVideoWriter() = default;
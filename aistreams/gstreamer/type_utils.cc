@@ -146,6 +146,7 @@ StatusOr<RawImage> ToRgbRawImage(const GstreamerRawImageInfo& info,
 }
 
 StatusOr<GstreamerBuffer> GstreamerBufferPacketToGstreamerBuffer(Packet p) {
+  bool is_key_frame = IsKeyFrame(p);
   PacketAs<GstreamerBuffer> packet_as(std::move(p));
   if (!packet_as.ok()) {
     LOG(ERROR) << packet_as.status();
@@ -153,7 +154,9 @@ StatusOr<GstreamerBuffer> GstreamerBufferPacketToGstreamerBuffer(Packet p) {
         "Failed to adapt supposedly a GstreamerBuffer packet into a "
         "GstreamerBuffer");
   }
-  return std::move(packet_as).ValueOrDie();
+  GstreamerBuffer gstreamer_buffer = std::move(packet_as).ValueOrDie();
+  gstreamer_buffer.set_is_key_frame(is_key_frame);
+  return gstreamer_buffer;
 }
 
 StatusOr<GstreamerBuffer> JpegPacketToGstreamerBuffer(Packet p) {
@@ -0,0 +1,94 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <utility>
+
+#include "aistreams/base/packet.h"
+#include "aistreams/base/types/gstreamer_buffer.h"
+#include "aistreams/base/types/raw_image.h"
+#include "aistreams/gstreamer/gstreamer_utils.h"
+#include "aistreams/gstreamer/type_utils.h"
+#include "aistreams/port/benchmark.h"
+#include "aistreams/port/logging.h"
+#include "aistreams/proto/types/raw_image.pb.h"
+
+namespace aistreams {
+namespace {
+
+// Frame sizes as (height, width): 720p, 1080p and 4K. The rows of the last,
+// 1366 pixel wide, frame are not 4 byte aligned in RGB and take the slow
+// (padding) path through the conversions.
+void FrameSizes(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"height", "width"})
+      ->Args({720, 1280})
+      ->Args({1080, 1920})
+      ->Args({2160, 3840})
+      ->Args({768, 1366});
+}
+
+// Also initializes Gstreamer, which the conversions need to handle caps.
+RawImage MakeRawImage(const benchmark::State& state) {
+  CHECK(GstInit().ok());
+  return RawImage(state.range(0), state.range(1), RAW_IMAGE_FORMAT_SRGB);
+}
+
+// Converts a RawImage that the caller keeps, so it is copied in.
+void BM_ToGstreamerBufferFromRawImage(benchmark::State& state) {
+  const RawImage raw_image = MakeRawImage(state);
+  for (auto _ : state) {
+    auto gstreamer_buffer_statusor = ToGstreamerBuffer(raw_image);
+    benchmark::DoNotOptimize(gstreamer_buffer_statusor);
+  }
+  state.SetBytesProcessed(state.iterations() * raw_image.size());
+}
+BENCHMARK(BM_ToGstreamerBufferFromRawImage)->Apply(FrameSizes);
+
+// Converts a GstreamerBuffer that the caller keeps, so it is copied in.
+void BM_ToRawImage(benchmark::State& state) {
+  const GstreamerBuffer gstreamer_buffer =
+      ToGstreamerBuffer(MakeRawImage(state)).ValueOrDie();
+  for (auto _ : state) {
+    auto raw_image_statusor = ToRawImage(gstreamer_buffer);
+    benchmark::DoNotOptimize(raw_image_statusor);
+  }
+  state.SetBytesProcessed(state.iterations() * gstreamer_buffer.size());
+}
+BENCHMARK(BM_ToRawImage)->Apply(FrameSizes);
+
+// Moves a RawImage into a GstreamerBuffer and back. Aligned frames copy no
+// pixels, so this is the cost of building and parsing the caps.
+void BM_RawImageRoundTripMove(benchmark::State& state) {
+  RawImage raw_image = MakeRawImage(state);
+  for (auto _ : state) {
+    GstreamerBuffer gstreamer_buffer =
+        ToGstreamerBuffer(std::move(raw_image)).ValueOrDie();
+    raw_image = ToRawImage(std::move(gstreamer_buffer)).ValueOrDie();
+  }
+}
+BENCHMARK(BM_RawImageRoundTripMove)->Apply(FrameSizes);
+
+// Converts a RawImage packet that the caller keeps, as the source elements do
+// for every frame.
+void BM_ToGstreamerBufferFromPacket(benchmark::State& state) {
+  const Packet packet = MakePacket(MakeRawImage(state)).ValueOrDie();
+  for (auto _ : state) {
+    auto gstreamer_buffer_statusor = ToGstreamerBuffer(packet);
+    benchmark::DoNotOptimize(gstreamer_buffer_statusor);
+  }
+  state.SetBytesProcessed(state.iterations() * packet.payload().size());
+}
+BENCHMARK(BM_ToGstreamerBufferFromPacket)->Apply(FrameSizes);
+
+}  // namespace
+}  // namespace aistreams
@@ -30,7 +30,11 @@
 
 // Options that configure video outputs.
 ABSL_FLAG(int, max_frames_per_file, 200,
-          "The maximum number of video frames per file.");
+          "The maximum number of video frames per file. 0 means no limit.");
+ABSL_FLAG(absl::Duration, max_duration_per_file, absl::ZeroDuration(),
+          "The maximum duration of each video file. 0 means no limit.");
+ABSL_FLAG(int64_t, max_bytes_per_file, 0,
+          "The maximum size of each video file in bytes. 0 means no limit.");
 ABSL_FLAG(std::string, output_dir, "",
           "The directory to output local video files.");
 ABSL_FLAG(std::string, file_prefix, "",
@@ -70,6 +74,8 @@ ABSL_FLAG(std::string, ssl_root_cert_path, "",
           "The path to the ssl root certificate.");
 ABSL_FLAG(int, receiver_timeout_in_sec, 15,
           "The timeout for the stream server to deliver a packet.");
+ABSL_FLAG(bool, passthrough_encoded_video, true,
+          "Save H.264 streams without transcoding them.");
 
 // System configurations.
 ABSL_FLAG(int, working_buffer_size, 100,
@@ -113,6 +119,8 @@ void RunChunker() {
 
   // Configure the video output.
   options.max_frames_per_file = absl::GetFlag(FLAGS_max_frames_per_file);
+  options.max_duration_per_file = absl::GetFlag(FLAGS_max_duration_per_file);
+  options.max_bytes_per_file = absl::GetFlag(FLAGS_max_bytes_per_file);
   options.output_dir = absl::GetFlag(FLAGS_output_dir);
   options.file_prefix = absl::GetFlag(FLAGS_file_prefix);
 
@@ -155,6 +163,8 @@ void RunChunker() {
   options.receiver_options = receiver_options;
   options.receiver_timeout =
       absl::Seconds(absl::GetFlag(FLAGS_receiver_timeout_in_sec));
+  options.passthrough_encoded_video =
+      absl::GetFlag(FLAGS_passthrough_encoded_video);
 
   // Configure system settings.
   options.working_buffer_size = absl::GetFlag(FLAGS_working_buffer_size);
@@ -43,6 +43,12 @@ ABSL_FLAG(int, timeout_in_sec, 5,
 ABSL_FLAG(int, playback_duration_in_sec, -1,
           "The maximum amount of time to playback (in seconds). -1 removes "
           "this bound.");
+ABSL_FLAG(bool, live_mode, false,
+          "Play back with low latency: present frames on the timeline of the "
+          "sender and skip ahead to the next key frame when falling behind.");
+ABSL_FLAG(int, latency_in_ms, 100,
+          "The amount of delivery jitter (in milliseconds) to absorb in live "
+          "mode.");
 ABSL_FLAG(std::string, output_mp4, "",
           "If non-empty, save the playback as an mp4 of the given file name. "
           "Otherwise, render to screen.");
@@ -61,6 +67,8 @@ Status RunPlayback() {
   ssl_options.ssl_domain_name = absl::GetFlag(FLAGS_ssl_domain_name);
   ssl_options.ssl_root_cert_path = absl::GetFlag(FLAGS_ssl_root_cert_path);
   int timeout_in_sec = absl::GetFlag(FLAGS_timeout_in_sec);
+  bool live_mode = absl::GetFlag(FLAGS_live_mode);
+  int latency_in_ms = absl::GetFlag(FLAGS_latency_in_ms);
   AissrcCliBuilder aissrc_cli_builder;
   auto aissrc_plugin_statusor =
       aissrc_cli_builder.SetTargetAddress(target_address)
@@ -68,6 +76,7 @@ Status RunPlayback() {
           .SetStreamName(stream_name)
           .SetSslOptions(ssl_options)
           .SetTimeoutInSec(timeout_in_sec)
+          .SetLiveMode(live_mode, latency_in_ms)
           .Finalize();
   if (!aissrc_plugin_statusor.ok()) {
     LOG(ERROR) << aissrc_plugin_statusor.status();
@@ -0,0 +1,67 @@
+# Copyright 2020 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+"""Asyncio support for the aistreams_py receiver queues."""
+
+import asyncio
+
+
+class PacketIterator:
+  """Asynchronously iterates over the packets of a ReceiverQueue.
+
+  The iterator waits on the readiness file descriptor of the queue through the
+  event loop, so no thread is tied up while the queue is empty. Iteration stops
+  at the first EOS packet, whose reason is then kept in `eos_reason`.
+
+  Example:
+
+    queue = aistreams_py.make_decoded_receiver_queue(options, 10, 30)
+    async for packet in PacketIterator(queue):
+      frame = numpy.asarray(packet.take_raw_image())
+  """
+
+  def __init__(self, receiver_queue, loop=None):
+    self._queue = receiver_queue
+    self._loop = loop
+    self.eos_reason = None
+
+  def __aiter__(self):
+    return self
+
+  async def __anext__(self):
+    if self.eos_reason is not None:
+      raise StopAsyncIteration
+    while True:
+      packet = self._queue.try_pop(0)
+      if packet is not None:
+        break
+      await self._wait_until_readable()
+    if packet.is_eos():
+      self.eos_reason = packet.eos_reason()
+      raise StopAsyncIteration
+    return packet
+
+  async def _wait_until_readable(self):
+    loop = self._loop or asyncio.get_running_loop()
+    fd = self._queue.fileno()
+    readable = loop.create_future()
+
+    def on_readable():
+      if not readable.done():
+        readable.set_result(None)
+
+    loop.add_reader(fd, on_readable)
+    try:
+      await readable
+    finally:
+      loop.remove_reader(fd)
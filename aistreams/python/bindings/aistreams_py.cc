@@ -0,0 +1,412 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Python bindings for sending and receiving packets.
+//
+// RawImage, GstreamerBuffer and BytesPayload objects implement the buffer
+// protocol, so e.g. numpy.asarray(raw_image) views the image in place rather
+// than copying it. Their payloads are never reallocated from Python, so such
+// views stay valid for as long as they exist; the bytes may still be written
+// through them. Payloads are moved, not copied, out of received packets and
+// into the sender. make_packet copies its source instead, so that the source
+// object, and any views of it, stay valid.
+//
+// Every call that may block releases the GIL.
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/time/time.h"
+#include "aistreams/base/connection_options.h"
+#include "aistreams/base/offset_options.h"
+#include "aistreams/base/packet.h"
+#include "aistreams/base/packet_sender.h"
+#include "aistreams/base/types/gstreamer_buffer.h"
+#include "aistreams/base/types/raw_image.h"
+#include "aistreams/base/util/packet_utils.h"
+#include "aistreams/base/wrappers/receivers.h"
+#include "aistreams/base/wrappers/senders.h"
+#include "aistreams/cc/decode_policy.h"
+#include "aistreams/cc/decoded_receivers.h"
+#include "aistreams/port/status.h"
+#include "aistreams/port/statusor.h"
+#include "pybind11/pybind11.h"
+#include "pybind11/stl.h"
+
+namespace aistreams {
+namespace {
+
+namespace py = pybind11;
+
+// The payload of a string packet. It is held on its own so that Python can
+// view it through the buffer protocol instead of copying it into a bytes.
+struct BytesPayload {
+  std::string bytes;
+};
+
+// Raises a RuntimeError carrying `status` if it is not OK.
+void ThrowIfError(const Status& status) {
+  if (!status.ok()) {
+    throw std::runtime_error(status.ToString());
+  }
+}
+
+// Moves the payload of `packet` out as a value of type T. The packet keeps
+// its header but is left without a payload.
+template <typename T>
+T TakePayload(Packet* packet) {
+  PacketHeader header = packet->header();
+  PacketAs<T> packet_as(std::move(*packet));
+  packet->Clear();
+  *packet->mutable_header() = std::move(header);
+  ThrowIfError(packet_as.status());
+  return std::move(packet_as).ValueOrDie();
+}
+
+template <typename T>
+Packet MakePacketOrThrow(T&& t) {
+  auto packet_statusor = MakePacket(std::forward<T>(t));
+  ThrowIfError(packet_statusor.status());
+  return std::move(packet_statusor).ValueOrDie();
+}
+
+// Converts a timeout in seconds to a Duration. Negative values wait forever.
+absl::Duration ToTimeout(double timeout_in_sec) {
+  if (timeout_in_sec < 0) {
+    return absl::InfiniteDuration();
+  }
+  return absl::Seconds(timeout_in_sec);
+}
+
+py::buffer_info BytesBufferInfo(char* data, size_t size) {
+  return py::buffer_info(data, sizeof(uint8_t),
+                         py::format_descriptor<uint8_t>::format(), 1,
+                         {static_cast<py::ssize_t>(size)}, {sizeof(uint8_t)});
+}
+
+std::string CopyBuffer(py::buffer buffer) {
+  py::buffer_info info = buffer.request();
+  return std::string(static_cast<const char*>(info.ptr),
+                     info.size * info.itemsize);
+}
+
+void BindOptions(py::module& m) {
+  py::class_<SslOptions>(m, "SslOptions")
+      .def(py::init<>())
+      .def_readwrite("use_insecure_channel", &SslOptions::use_insecure_channel)
+      .def_readwrite("ssl_domain_name", &SslOptions::ssl_domain_name)
+      .def_readwrite("ssl_root_cert_path", &SslOptions::ssl_root_cert_path);
+
+  py::class_<ConnectionOptions>(m, "ConnectionOptions")
+      .def(py::init<>())
+      .def_readwrite("target_address", &ConnectionOptions::target_address)
+      .def_readwrite("authenticate_with_google",
+                     &ConnectionOptions::authenticate_with_google)
+      .def_readwrite("ssl_options", &ConnectionOptions::ssl_options);
+
+  py::class_<OffsetOptions>(m, "OffsetOptions")
+      .def(py::init<>())
+      .def_readwrite("reset_offset", &OffsetOptions::reset_offset)
+      .def("set_position_beginning",
+           [](OffsetOptions& o) {
+             o.offset_position =
+                 OffsetOptions::SpecialOffset::kOffsetBeginning;
+           })
+      .def("set_position_end",
+           [](OffsetOptions& o) {
+             o.offset_position = OffsetOptions::SpecialOffset::kOffsetEnd;
+           })
+      .def("set_position_offset",
+           [](OffsetOptions& o, int64_t offset) {
+             o.offset_position = offset;
+           })
+      .def("set_position_time_nanos", [](OffsetOptions& o, int64_t nanos) {
+        o.offset_position = absl::FromUnixNanos(nanos);
+      });
+
+  py::class_<PacketSender::BatchOptions>(m, "BatchOptions")
+      .def(py::init<>())
+      .def_readwrite("max_packets", &PacketSender::BatchOptions::max_packets)
+      .def_readwrite("max_bytes", &PacketSender::BatchOptions::max_bytes)
+      .def_property(
+          "linger_in_sec",
+          [](const PacketSender::BatchOptions& o) {
+            return absl::ToDoubleSeconds(o.linger);
+          },
+          [](PacketSender::BatchOptions& o, double linger_in_sec) {
+            o.linger = absl::Seconds(linger_in_sec);
+          });
+
+  py::class_<SenderOptions>(m, "SenderOptions")
+      .def(py::init<>())
+      .def_readwrite("connection_options", &SenderOptions::connection_options)
+      .def_readwrite("stream_name", &SenderOptions::stream_name)
+      .def_readwrite("trace_probability", &SenderOptions::trace_probability)
+      .def_readwrite("batch_options", &SenderOptions::batch_options);
+
+  py::class_<ReceiverOptions>(m, "ReceiverOptions")
+      .def(py::init<>())
+      .def_readwrite("connection_options",
+                     &ReceiverOptions::connection_options)
+      .def_readwrite("offset_options", &ReceiverOptions::offset_options)
+      .def_readwrite("stream_name", &ReceiverOptions::stream_name)
+      .def_readwrite("receiver_name", &ReceiverOptions::receiver_name)
+      .def_readwrite("buffer_capacity", &ReceiverOptions::buffer_capacity);
+
+  py::class_<DecodePolicy>(m, "DecodePolicy")
+      .def(py::init<>())
+      .def_readwrite("key_frames_only", &DecodePolicy::key_frames_only)
+      .def_readwrite("every_nth_frame", &DecodePolicy::every_nth_frame)
+      .def_readwrite("target_frames_per_second",
+                     &DecodePolicy::target_frames_per_second);
+}
+
+void BindPayloads(py::module& m) {
+  py::enum_<RawImageFormat>(m, "RawImageFormat")
+      .value("RAW_IMAGE_FORMAT_UNKNOWN", RAW_IMAGE_FORMAT_UNKNOWN)
+      .value("RAW_IMAGE_FORMAT_SRGB", RAW_IMAGE_FORMAT_SRGB)
+      .export_values();
+
+  // Viewed as a height x width x channels array of uint8.
+  py::class_<RawImage>(m, "RawImage", py::buffer_protocol())
+      .def(py::init<>())
+      .def(py::init<int, int, RawImageFormat>(), py::arg("height"),
+           py::arg("width"), py::arg("format") = RAW_IMAGE_FORMAT_SRGB)
+      .def_property_readonly("height", &RawImage::height)
+      .def_property_readonly("width", &RawImage::width)
+      .def_property_readonly("channels", &RawImage::channels)
+      .def_property_readonly("format", &RawImage::format)
+      .def_buffer([](RawImage& r) {
+        return py::buffer_info(
+            r.data(), sizeof(uint8_t), py::format_descriptor<uint8_t>::format(),
+            3, {r.height(), r.width(), r.channels()},
+            {sizeof(uint8_t) * r.width() * r.channels(),
+             sizeof(uint8_t) * r.channels(), sizeof(uint8_t)});
+      });
+
+  // Viewed as a flat array of uint8.
+  //
+  // The bytes are given on construction, either copied from a buffer or as
+  // `size` zeros to be filled in through a view, and cannot be replaced.
+  py::class_<GstreamerBuffer>(m, "GstreamerBuffer", py::buffer_protocol())
+      .def(py::init<>())
+      .def(py::init([](py::buffer buffer, const std::string& caps) {
+             GstreamerBuffer g;
+             g.set_caps_string(caps);
+             g.assign(CopyBuffer(buffer));
+             return g;
+           }),
+           py::arg("data"), py::arg("caps") = "")
+      .def(py::init([](size_t size, const std::string& caps) {
+             GstreamerBuffer g;
+             g.set_caps_string(caps);
+             g.assign(std::string(size, '\0'));
+             return g;
+           }),
+           py::arg("size"), py::arg("caps") = "")
+      .def_property("caps", &GstreamerBuffer::get_caps,
+                    [](GstreamerBuffer& g, const std::string& caps) {
+                      g.set_caps_string(caps);
+                    })
+      .def_property("is_key_frame", &GstreamerBuffer::is_key_frame,
+                    &GstreamerBuffer::set_is_key_frame)
+      .def("__len__", &GstreamerBuffer::size)
+      .def_buffer([](GstreamerBuffer& g) {
+        return BytesBufferInfo(g.data(), g.size());
+      });
+
+  // Viewed as a flat array of uint8.
+  py::class_<BytesPayload>(m, "BytesPayload", py::buffer_protocol())
+      .def("tobytes",
+           [](const BytesPayload& b) {
+             return py::bytes(b.bytes.data(), b.bytes.size());
+           })
+      .def("__len__", [](const BytesPayload& b) { return b.bytes.size(); })
+      .def_buffer([](BytesPayload& b) {
+        return BytesBufferInfo(&b.bytes[0], b.bytes.size());
+      });
+}
+
+void BindPacket(py::module& m) {
+  py::enum_<PacketTypeId>(m, "PacketTypeId")
+      .value("PACKET_TYPE_UNKNOWN", PACKET_TYPE_UNKNOWN)
+      .value("PACKET_TYPE_JPEG", PACKET_TYPE_JPEG)
+      .value("PACKET_TYPE_RAW_IMAGE", PACKET_TYPE_RAW_IMAGE)
+      .value("PACKET_TYPE_PROTOBUF", PACKET_TYPE_PROTOBUF)
+      .value("PACKET_TYPE_STRING", PACKET_TYPE_STRING)
+      .value("PACKET_TYPE_GSTREAMER_BUFFER", PACKET_TYPE_GSTREAMER_BUFFER)
+      .value("PACKET_TYPE_CONTROL_SIGNAL", PACKET_TYPE_CONTROL_SIGNAL)
+      .value("PACKET_TYPE_STRUCT", PACKET_TYPE_STRUCT)
+      .export_values();
+
+  // The take_* methods move the payload out of the packet, which keeps its
+  // header but is left without a payload.
+  py::class_<Packet>(m, "Packet")
+      .def_property_readonly("type_id",
+                             [](const Packet& p) { return GetPacketTypeId(p); })
+      .def_property_readonly("timestamp_nanos",
+                             [](const Packet& p) {
+                               const auto& timestamp = p.header().timestamp();
+                               return timestamp.seconds() * 1000000000LL +
+                                      timestamp.nanos();
+                             })
+      .def("is_eos", [](const Packet& p) { return IsEos(p); })
+      .def("eos_reason",
+           [](const Packet& p) {
+             std::string reason;
+             IsEos(p, &reason);
+             return reason;
+           })
+      .def("is_key_frame", [](const Packet& p) { return IsKeyFrame(p); })
+      .def("take_raw_image",
+           [](Packet& p) { return TakePayload<RawImage>(&p); })
+      .def("take_gstreamer_buffer",
+           [](Packet& p) { return TakePayload<GstreamerBuffer>(&p); })
+      .def("take_bytes", [](Packet& p) {
+        return BytesPayload{TakePayload<std::string>(&p)};
+      });
+
+  // make_packet copies the payload of a RawImage or GstreamerBuffer into the
+  // packet, so the source may still be used. Other buffers are copied in as a
+  // string packet.
+  m.def("make_packet",
+        [](const RawImage& r) { return MakePacketOrThrow(r); });
+  m.def("make_packet",
+        [](const GstreamerBuffer& g) { return MakePacketOrThrow(g); });
+  m.def("make_packet", [](py::buffer buffer) {
+    return MakePacketOrThrow(CopyBuffer(buffer));
+  });
+  m.def("make_eos_packet", [](const std::string& reason) {
+    auto packet_statusor = MakeEosPacket(reason);
+    ThrowIfError(packet_statusor.status());
+    return std::move(packet_statusor).ValueOrDie();
+  });
+}
+
+void BindSender(py::module& m) {
+  // send moves the payload of the packet into the sender.
+  py::class_<PacketSender>(m, "PacketSender")
+      .def(
+          "send",
+          [](PacketSender& sender, Packet& packet) {
+            // The packet is owned by Python, so only touch it with the GIL.
+            Packet to_send = std::move(packet);
+            py::gil_scoped_release release;
+            ThrowIfError(sender.Send(std::move(to_send)));
+          },
+          py::arg("packet"))
+      .def("flush", [](PacketSender& sender) {
+        py::gil_scoped_release release;
+        ThrowIfError(sender.Flush());
+      });
+
+  m.def(
+      "make_packet_sender",
+      [](const SenderOptions& options) {
+        py::gil_scoped_release release;
+        std::unique_ptr<PacketSender> sender;
+        ThrowIfError(MakePacketSender(options, &sender));
+        return sender;
+      },
+      py::arg("options"));
+}
+
+void BindReceivers(py::module& m) {
+  // Timeouts are in seconds. Negative timeouts wait forever.
+  //
+  // fileno() returns a file descriptor that is readable while the queue is
+  // non-empty, for use with select/poll or an asyncio event loop. See
+  // aio.PacketIterator.
+  py::class_<ReceiverQueue<Packet>>(m, "ReceiverQueue")
+      .def(
+          "try_pop",
+          [](ReceiverQueue<Packet>& queue,
+             double timeout_in_sec) -> py::object {
+            Packet packet;
+            bool popped;
+            {
+              py::gil_scoped_release release;
+              popped = queue.TryPop(packet, ToTimeout(timeout_in_sec));
+            }
+            if (!popped) {
+              return py::none();
+            }
+            return py::cast(std::move(packet));
+          },
+          py::arg("timeout_in_sec"))
+      .def(
+          "try_pop_many",
+          [](ReceiverQueue<Packet>& queue, int max_count,
+             double timeout_in_sec) {
+            std::vector<Packet> packets;
+            {
+              py::gil_scoped_release release;
+              queue.TryPopMany(max_count, ToTimeout(timeout_in_sec), &packets);
+            }
+            return packets;
+          },
+          py::arg("max_count"), py::arg("timeout_in_sec"))
+      .def("fileno",
+           [](ReceiverQueue<Packet>& queue) {
+             int fd = queue.ReadinessFd();
+             if (fd < 0) {
+               throw std::runtime_error(
+                   "Failed to create the readiness file descriptor");
+             }
+             return fd;
+           })
+      .def_property_readonly("capacity", &ReceiverQueue<Packet>::capacity);
+
+  m.def(
+      "make_packet_receiver_queue",
+      [](const ReceiverOptions& options) {
+        py::gil_scoped_release release;
+        ReceiverQueue<Packet> receiver_queue;
+        ThrowIfError(MakePacketReceiverQueue(options, &receiver_queue));
+        return receiver_queue;
+      },
+      py::arg("options"));
+
+  m.def(
+      "make_decoded_receiver_queue",
+      [](const ReceiverOptions& options, int queue_size, double timeout_in_sec,
+         const DecodePolicy& decode_policy) {
+        py::gil_scoped_release release;
+        ReceiverQueue<Packet> receiver_queue;
+        ThrowIfError(MakeDecodedReceiverQueue(options, decode_policy,
+                                              queue_size,
+                                              ToTimeout(timeout_in_sec),
+                                              &receiver_queue));
+        return receiver_queue;
+      },
+      py::arg("options"), py::arg("queue_size"), py::arg("timeout_in_sec"),
+      py::arg("decode_policy") = DecodePolicy());
+}
+
+}  // namespace
+}  // namespace aistreams
+
+PYBIND11_MODULE(aistreams_py, m) {
+  m.doc() = "Send and receive AI Streams packets.";
+  aistreams::BindOptions(m);
+  aistreams::BindPayloads(m);
+  aistreams::BindPacket(m);
+  aistreams::BindSender(m);
+  aistreams::BindReceivers(m);
+}
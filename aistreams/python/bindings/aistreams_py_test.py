@@ -0,0 +1,154 @@
+# Copyright 2020 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+"""Tests for the aistreams_py bindings."""
+
+import asyncio
+import os
+import unittest
+
+from aistreams.python.bindings import aio
+from aistreams.python.bindings import aistreams_py
+
+
+def _fill(buffer, data):
+  view = memoryview(buffer).cast("B")
+  view[:] = data
+
+
+class MakePacketTest(unittest.TestCase):
+
+  def test_raw_image_is_usable_after_make_packet(self):
+    raw_image = aistreams_py.RawImage(2, 3)
+    data = bytes(range(2 * 3 * 3))
+    _fill(raw_image, data)
+    view = memoryview(raw_image)
+
+    packet = aistreams_py.make_packet(raw_image)
+
+    self.assertEqual(packet.type_id, aistreams_py.PACKET_TYPE_RAW_IMAGE)
+    self.assertEqual((raw_image.height, raw_image.width, raw_image.channels),
+                     (2, 3, 3))
+    self.assertEqual(view.tobytes(), data)
+    self.assertEqual(memoryview(raw_image).tobytes(), data)
+
+    # The packet holds its own copy.
+    _fill(raw_image, bytes(len(data)))
+    taken = packet.take_raw_image()
+    self.assertEqual(memoryview(taken).shape, (2, 3, 3))
+    self.assertEqual(memoryview(taken).tobytes(), data)
+
+  def test_gstreamer_buffer_is_usable_after_make_packet(self):
+    gstreamer_buffer = aistreams_py.GstreamerBuffer(b"abc", caps="video/x-raw")
+    view = memoryview(gstreamer_buffer)
+
+    packet = aistreams_py.make_packet(gstreamer_buffer)
+
+    self.assertEqual(packet.type_id,
+                     aistreams_py.PACKET_TYPE_GSTREAMER_BUFFER)
+    self.assertEqual(gstreamer_buffer.caps, "video/x-raw")
+    self.assertEqual(len(gstreamer_buffer), 3)
+    self.assertEqual(view.tobytes(), b"abc")
+    taken = packet.take_gstreamer_buffer()
+    self.assertEqual(taken.caps, "video/x-raw")
+    self.assertEqual(memoryview(taken).tobytes(), b"abc")
+
+  def test_gstreamer_buffer_views_stay_valid(self):
+    gstreamer_buffer = aistreams_py.GstreamerBuffer(4)
+    view = memoryview(gstreamer_buffer)
+    _fill(gstreamer_buffer, b"abcd")
+
+    # The bytes can be written through views, but not replaced.
+    self.assertFalse(hasattr(gstreamer_buffer, "assign"))
+    self.assertFalse(hasattr(gstreamer_buffer, "resize"))
+    gstreamer_buffer.caps = "video/x-raw"
+    gstreamer_buffer.is_key_frame = False
+    self.assertEqual(view.tobytes(), b"abcd")
+    self.assertEqual(memoryview(gstreamer_buffer).tobytes(), b"abcd")
+
+  def test_bytes_are_copied(self):
+    data = bytearray(b"hello")
+    packet = aistreams_py.make_packet(data)
+    data[0:1] = b"j"
+    self.assertEqual(packet.take_bytes().tobytes(), b"hello")
+
+
+class TakePayloadTest(unittest.TestCase):
+
+  def test_packet_keeps_its_header(self):
+    packet = aistreams_py.make_packet(b"hello")
+    timestamp_nanos = packet.timestamp_nanos
+
+    payload = packet.take_bytes()
+
+    self.assertEqual(payload.tobytes(), b"hello")
+    self.assertEqual(packet.type_id, aistreams_py.PACKET_TYPE_STRING)
+    self.assertEqual(packet.timestamp_nanos, timestamp_nanos)
+    self.assertEqual(len(packet.take_bytes()), 0)
+
+  def test_wrong_type_raises(self):
+    packet = aistreams_py.make_packet(b"hello")
+    with self.assertRaises(RuntimeError):
+      packet.take_raw_image()
+
+
+class _FakeReceiverQueue:
+  """Pops the packets put in it; readable through a pipe once it has some."""
+
+  def __init__(self):
+    self._packets = []
+    self._read_fd, self._write_fd = os.pipe()
+
+  def close(self):
+    os.close(self._read_fd)
+    os.close(self._write_fd)
+
+  def put(self, packets):
+    self._packets.extend(packets)
+    os.write(self._write_fd, b"x")
+
+  def try_pop(self, timeout_in_sec):
+    del timeout_in_sec  # Unused.
+    if not self._packets:
+      return None
+    return self._packets.pop(0)
+
+  def fileno(self):
+    return self._read_fd
+
+
+class PacketIteratorTest(unittest.TestCase):
+
+  def test_waits_for_packets_until_eos(self):
+    queue = _FakeReceiverQueue()
+    self.addCleanup(queue.close)
+
+    async def receive():
+      # The packets arrive only once the iterator waits for them.
+      asyncio.get_running_loop().call_soon(queue.put, [
+          aistreams_py.make_packet(b"0"),
+          aistreams_py.make_packet(b"1"),
+          aistreams_py.make_eos_packet("done"),
+          aistreams_py.make_packet(b"2"),
+      ])
+      iterator = aio.PacketIterator(queue)
+      payloads = [packet.take_bytes().tobytes() async for packet in iterator]
+      return payloads, iterator.eos_reason
+
+    payloads, eos_reason = asyncio.run(receive())
+    self.assertEqual(payloads, [b"0", b"1"])
+    self.assertEqual(eos_reason, "done")
+
+
+if __name__ == "__main__":
+  unittest.main()
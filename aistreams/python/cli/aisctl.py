@@ -30,24 +30,33 @@ import click
 _LOGGING_FORMAT = "%(levelname)s: %(message)s"
 
 
-def _set_environment_variables():
+def _set_environment_variables(pipeline_stats_interval_ms):
   gst_plugin_path = os.path.join(
       pathlib.Path(gst.__file__).parents[0], "gst-plugins")
   logging.debug("Setting GST_PLUGIN_PATH to \"%s\"", gst_plugin_path)
   os.environ["GST_PLUGIN_PATH"] = gst_plugin_path
   os.environ["GLOG_alsologtostderr"] = "1"
+  if pipeline_stats_interval_ms > 0:
+    gst_tracers = "aisstats(interval-ms={})".format(pipeline_stats_interval_ms)
+    logging.debug("Setting GST_TRACERS to \"%s\"", gst_tracers)
+    os.environ["GST_TRACERS"] = gst_tracers
 
 
 @click.group()
 @click.option("--verbose", "-v", is_flag=True, help="Verbose output.")
-def main(verbose):
+@click.option(
+    "--pipeline-stats-interval-ms",
+    default=0,
+    help="Log the stats of the GStreamer pipelines at this interval. "
+    "0 disables the stats.")
+def main(verbose, pipeline_stats_interval_ms):
   """AI Streams CLI."""
   if verbose:
     logging.basicConfig(format=_LOGGING_FORMAT, level=logging.DEBUG)
   else:
     logging.basicConfig(format=_LOGGING_FORMAT, level=logging.INFO)
 
-  _set_environment_variables()
+  _set_environment_variables(pipeline_stats_interval_ms)
 
 
 main.add_command(chunk.cli)
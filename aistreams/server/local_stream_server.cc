@@ -0,0 +1,474 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "aistreams/server/local_stream_server.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+
+#include "absl/strings/match.h"
+#include "absl/strings/str_format.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "aistreams/port/canonical_errors.h"
+#include "aistreams/port/logging.h"
+#include "aistreams/port/status.h"
+#include "aistreams/port/status_macros.h"
+#include "aistreams/proto/packet.pb.h"
+#include "aistreams/proto/stream.grpc.pb.h"
+#include "aistreams/proto/stream.pb.h"
+#include "aistreams/util/constants.h"
+
+namespace aistreams {
+
+namespace {
+
+using ::aistreams::constants::kStreamMetadataKeyName;
+
+// How often blocked calls check whether they have been cancelled.
+constexpr absl::Duration kPollInterval = absl::Milliseconds(100);
+
+absl::Duration FromProtoDuration(const google::protobuf::Duration& duration) {
+  return absl::Seconds(duration.seconds()) +
+         absl::Nanoseconds(duration.nanos());
+}
+
+}  // namespace
+
+// The StreamServer service behind a LocalStreamServer.
+class LocalStreamService : public StreamServer::Service {
+ public:
+  explicit LocalStreamService(
+      const StreamLog::RetentionOptions& retention_options)
+      : retention_options_(retention_options) {}
+
+  // Ends the calls blocked waiting for packets, and fails any that follow.
+  void Shutdown();
+
+  grpc::Status SendPackets(grpc::ServerContext* context,
+                           grpc::ServerReader<Packet>* reader,
+                           SendPacketsResponse* response) override;
+
+  grpc::Status SendOnePacket(grpc::ServerContext* context,
+                             const Packet* packet,
+                             SendOnePacketResponse* response) override;
+
+  grpc::Status ReceivePackets(grpc::ServerContext* context,
+                              const ReceivePacketsRequest* request,
+                              grpc::ServerWriter<Packet>* writer) override;
+
+  grpc::Status ReceiveOnePacket(grpc::ServerContext* context,
+                                const ReceiveOnePacketRequest* request,
+                                ReceiveOnePacketResponse* response) override;
+
+  grpc::Status ReplayStream(grpc::ServerContext* context,
+                            const ReplayStreamRequest* request,
+                            grpc::ServerWriter<Packet>* writer) override;
+
+ private:
+  struct Stream {
+    explicit Stream(const StreamLog::RetentionOptions& retention_options)
+        : log(retention_options) {}
+
+    absl::Mutex mu;
+
+    // Signalled whenever a packet is appended and on shutdown.
+    absl::CondVar cv;
+
+    StreamLog log ABSL_GUARDED_BY(mu);
+
+    // The offset of the next packet of every consumer seen. Replays do not
+    // move it.
+    std::map<std::string, int64_t> consumer_offsets ABSL_GUARDED_BY(mu);
+
+    // The consumers that have a ReceivePackets call in flight.
+    std::set<std::string> active_consumers ABSL_GUARDED_BY(mu);
+  };
+
+  // Returns the stream named in the metadata of `context` in `stream`,
+  // creating it on first use.
+  grpc::Status GetStream(const grpc::ServerContext* context, Stream** stream)
+      ABSL_LOCKS_EXCLUDED(mu_);
+
+  void Append(Stream* stream, Packet packet) ABSL_LOCKS_EXCLUDED(stream->mu);
+
+  // Returns the offset at which `consumer_name` starts reading: that of
+  // `offset_config` if given; otherwise where the consumer left off; otherwise
+  // `new_consumer_offset`.
+  static int64_t StartOffset(Stream* stream, const std::string& consumer_name,
+                             const OffsetConfig* offset_config,
+                             int64_t new_consumer_offset)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(stream->mu);
+
+  // Waits until the packet at `offset` has been appended, the call ends, or
+  // `deadline` passes.
+  grpc::Status AwaitPacket(grpc::ServerContext* context, Stream* stream,
+                           int64_t offset, absl::Time deadline)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(stream->mu);
+
+  // Writes the packets of `stream` to `writer` for `consumer_name`, from its
+  // StartOffset() onwards, until the call ends or no packet arrives in
+  // `timeout`.
+  //
+  // Unless `is_replay` is true, the call claims the consumer, whose offset
+  // it advances, and evicted packets fail it with OUT_OF_RANGE. A replay
+  // skips evicted packets, and only reads the offset of the consumer, so that
+  // it may run alongside a claiming call; e.g. in PacketReceiver's Auto mode.
+  grpc::Status WritePackets(grpc::ServerContext* context, Stream* stream,
+                            const std::string& consumer_name,
+                            const OffsetConfig* offset_config,
+                            int64_t new_consumer_offset,
+                            absl::Duration timeout, bool is_replay,
+                            grpc::ServerWriter<Packet>* writer);
+
+  const StreamLog::RetentionOptions retention_options_;
+  std::atomic<bool> is_shut_down_{false};
+
+  absl::Mutex mu_;
+  std::map<std::string, std::unique_ptr<Stream>> streams_ ABSL_GUARDED_BY(mu_);
+};
+
+void LocalStreamService::Shutdown() {
+  is_shut_down_ = true;
+  absl::MutexLock lock(&mu_);
+  for (auto& name_and_stream : streams_) {
+    Stream* stream = name_and_stream.second.get();
+    absl::MutexLock stream_lock(&stream->mu);
+    stream->cv.SignalAll();
+  }
+}
+
+grpc::Status LocalStreamService::GetStream(const grpc::ServerContext* context,
+                                           Stream** stream) {
+  auto it = context->client_metadata().find(kStreamMetadataKeyName);
+  if (it == context->client_metadata().end()) {
+    return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                        "The request does not name a stream");
+  }
+  std::string stream_name(it->second.data(), it->second.size());
+  absl::MutexLock lock(&mu_);
+  auto& stream_ptr = streams_[stream_name];
+  if (stream_ptr == nullptr) {
+    LOG(INFO) << "Created the stream \"" << stream_name << "\"";
+    stream_ptr = std::make_unique<Stream>(retention_options_);
+  }
+  *stream = stream_ptr.get();
+  return grpc::Status::OK;
+}
+
+void LocalStreamService::Append(Stream* stream, Packet packet) {
+  absl::MutexLock lock(&stream->mu);
+  stream->log.Append(std::move(packet), absl::Now());
+  stream->cv.SignalAll();
+}
+
+int64_t LocalStreamService::StartOffset(Stream* stream,
+                                        const std::string& consumer_name,
+                                        const OffsetConfig* offset_config,
+                                        int64_t new_consumer_offset) {
+  if (offset_config != nullptr) {
+    return stream->log.Seek(*offset_config);
+  }
+  auto it = stream->consumer_offsets.find(consumer_name);
+  if (it != stream->consumer_offsets.end()) {
+    return it->second;
+  }
+  return new_consumer_offset;
+}
+
+grpc::Status LocalStreamService::AwaitPacket(grpc::ServerContext* context,
+                                             Stream* stream, int64_t offset,
+                                             absl::Time deadline) {
+  while (offset >= stream->log.end_offset()) {
+    if (is_shut_down_) {
+      return grpc::Status(grpc::StatusCode::CANCELLED,
+                          "The server is shutting down");
+    }
+    if (context->IsCancelled()) {
+      return grpc::Status(grpc::StatusCode::CANCELLED,
+                          "The call was cancelled");
+    }
+    absl::Time now = absl::Now();
+    if (now >= deadline) {
+      return grpc::Status(grpc::StatusCode::DEADLINE_EXCEEDED,
+                          "No new packet arrived in time");
+    }
+    stream->cv.WaitWithTimeout(&stream->mu,
+                               std::min(kPollInterval, deadline - now));
+  }
+  return grpc::Status::OK;
+}
+
+grpc::Status LocalStreamService::WritePackets(
+    grpc::ServerContext* context, Stream* stream,
+    const std::string& consumer_name, const OffsetConfig* offset_config,
+    int64_t new_consumer_offset, absl::Duration timeout, bool is_replay,
+    grpc::ServerWriter<Packet>* writer) {
+  if (consumer_name.empty()) {
+    return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                        "The request does not name a consumer");
+  }
+
+  int64_t offset;
+  {
+    absl::MutexLock lock(&stream->mu);
+    if (!is_replay &&
+        !stream->active_consumers.insert(consumer_name).second) {
+      return grpc::Status(
+          grpc::StatusCode::ALREADY_EXISTS,
+          absl::StrFormat("The consumer \"%s\" is already receiving",
+                          consumer_name));
+    }
+    offset = StartOffset(stream, consumer_name, offset_config,
+                         new_consumer_offset);
+    if (!is_replay) {
+      stream->consumer_offsets[consumer_name] = offset;
+    }
+  }
+
+  grpc::Status status;
+  while (true) {
+    std::shared_ptr<const Packet> packet;
+    {
+      absl::MutexLock lock(&stream->mu);
+      stream->log.Expire(absl::Now());
+      status = AwaitPacket(context, stream, offset, absl::Now() + timeout);
+      if (!status.ok()) {
+        break;
+      }
+      if (offset < stream->log.begin_offset()) {
+        if (!is_replay) {
+          status = grpc::Status(
+              grpc::StatusCode::OUT_OF_RANGE,
+              absl::StrFormat("The packet at offset %d has been evicted; the "
+                              "oldest retained packet is at offset %d",
+                              offset, stream->log.begin_offset()));
+          break;
+        }
+        offset = stream->log.begin_offset();
+        continue;
+      }
+      packet = stream->log.Get(offset);
+    }
+
+    // Write without holding the lock, so that a slow consumer does not hold
+    // up the senders.
+    if (!writer->Write(*packet)) {
+      break;
+    }
+    ++offset;
+    if (!is_replay) {
+      absl::MutexLock lock(&stream->mu);
+      stream->consumer_offsets[consumer_name] = offset;
+    }
+  }
+
+  if (!is_replay) {
+    absl::MutexLock lock(&stream->mu);
+    stream->active_consumers.erase(consumer_name);
+  }
+  return status;
+}
+
+grpc::Status LocalStreamService::SendPackets(grpc::ServerContext* context,
+                                             grpc::ServerReader<Packet>* reader,
+                                             SendPacketsResponse* response) {
+  Stream* stream;
+  grpc::Status status = GetStream(context, &stream);
+  if (!status.ok()) {
+    return status;
+  }
+  Packet packet;
+  while (reader->Read(&packet)) {
+    Append(stream, std::move(packet));
+    packet.Clear();
+  }
+  return grpc::Status::OK;
+}
+
+grpc::Status LocalStreamService::SendOnePacket(
+    grpc::ServerContext* context, const Packet* packet,
+    SendOnePacketResponse* response) {
+  Stream* stream;
+  grpc::Status status = GetStream(context, &stream);
+  if (!status.ok()) {
+    return status;
+  }
+  Append(stream, *packet);
+  response->set_accepted(true);
+  return grpc::Status::OK;
+}
+
+grpc::Status LocalStreamService::ReceivePackets(
+    grpc::ServerContext* context, const ReceivePacketsRequest* request,
+    grpc::ServerWriter<Packet>* writer) {
+  Stream* stream;
+  grpc::Status status = GetStream(context, &stream);
+  if (!status.ok()) {
+    return status;
+  }
+  int64_t new_consumer_offset;
+  {
+    absl::MutexLock lock(&stream->mu);
+    new_consumer_offset = stream->log.end_offset();
+  }
+  return WritePackets(
+      context, stream, request->consumer_name(),
+      request->has_offset_config() ? &request->offset_config() : nullptr,
+      new_consumer_offset,
+      request->has_timeout() ? FromProtoDuration(request->timeout())
+                             : absl::InfiniteDuration(),
+      /*is_replay=*/false, writer);
+}
+
+grpc::Status LocalStreamService::ReplayStream(
+    grpc::ServerContext* context, const ReplayStreamRequest* request,
+    grpc::ServerWriter<Packet>* writer) {
+  Stream* stream;
+  grpc::Status status = GetStream(context, &stream);
+  if (!status.ok()) {
+    return status;
+  }
+
+  // Honor the deprecated seek options too.
+  OffsetConfig offset_config;
+  bool has_offset_config = true;
+  if (request->has_offset_config()) {
+    offset_config = request->offset_config();
+  } else if (request->has_seek_time()) {
+    *offset_config.mutable_seek_time() = request->seek_time();
+  } else if (request->seek_option_case() ==
+             ReplayStreamRequest::kSeekOffset) {
+    offset_config.set_seek_position(request->seek_offset());
+  } else {
+    has_offset_config = false;
+  }
+
+  // A replay starts from the oldest retained packet by default.
+  return WritePackets(
+      context, stream, request->consumer_name(),
+      has_offset_config ? &offset_config : nullptr,
+      /*new_consumer_offset=*/0,
+      request->has_timeout() ? FromProtoDuration(request->timeout())
+                             : absl::InfiniteDuration(),
+      /*is_replay=*/true, writer);
+}
+
+grpc::Status LocalStreamService::ReceiveOnePacket(
+    grpc::ServerContext* context, const ReceiveOnePacketRequest* request,
+    ReceiveOnePacketResponse* response) {
+  Stream* stream;
+  grpc::Status status = GetStream(context, &stream);
+  if (!status.ok()) {
+    return status;
+  }
+  if (request->consumer_name().empty()) {
+    return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                        "The request does not name a consumer");
+  }
+
+  absl::MutexLock lock(&stream->mu);
+  stream->log.Expire(absl::Now());
+  int64_t offset = StartOffset(
+      stream, request->consumer_name(),
+      request->has_offset_config() ? &request->offset_config() : nullptr,
+      stream->log.end_offset());
+  if (offset < stream->log.begin_offset()) {
+    return grpc::Status(
+        grpc::StatusCode::OUT_OF_RANGE,
+        absl::StrFormat("The packet at offset %d has been evicted; the "
+                        "oldest retained packet is at offset %d",
+                        offset, stream->log.begin_offset()));
+  }
+  // Record a new consumer now, so that it receives the next packet sent even
+  // if this call ends without one.
+  stream->consumer_offsets[request->consumer_name()] = offset;
+  if (offset >= stream->log.end_offset()) {
+    if (!request->blocking()) {
+      return grpc::Status(grpc::StatusCode::UNAVAILABLE,
+                          "No new packet is available");
+    }
+    absl::Time deadline =
+        context->deadline() == std::chrono::system_clock::time_point::max()
+            ? absl::InfiniteFuture()
+            : absl::FromChrono(context->deadline());
+    status = AwaitPacket(context, stream, offset, deadline);
+    if (!status.ok()) {
+      return status;
+    }
+  }
+  *response->mutable_packet() = *stream->log.Get(offset);
+  response->set_valid(true);
+  stream->consumer_offsets[request->consumer_name()] = offset + 1;
+  return grpc::Status::OK;
+}
+
+LocalStreamServer::LocalStreamServer(const Options& options)
+    : options_(options) {}
+
+Status LocalStreamServer::Initialize() {
+  service_ = std::make_unique<LocalStreamService>(options_.retention_options);
+  grpc::ServerBuilder builder;
+  int port = 0;
+  builder.AddListeningPort(options_.address, grpc::InsecureServerCredentials(),
+                           &port);
+  builder.RegisterService(service_.get());
+  builder.SetMaxReceiveMessageSize(-1);
+  server_ = builder.BuildAndStart();
+  if (server_ == nullptr) {
+    return UnknownError(absl::StrFormat("Failed to start a server on \"%s\"",
+                                        options_.address));
+  }
+
+  // Resolve a request for a free port to the one that was picked.
+  target_address_ = options_.address;
+  if (!absl::StartsWith(target_address_, "unix:")) {
+    target_address_ =
+        absl::StrFormat("%s:%d",
+                        target_address_.substr(0, target_address_.rfind(':')),
+                        port);
+  }
+  return OkStatus();
+}
+
+StatusOr<std::unique_ptr<LocalStreamServer>> LocalStreamServer::Create(
+    const Options& options) {
+  auto server = std::make_unique<LocalStreamServer>(options);
+  AIS_RETURN_IF_ERROR(server->Initialize());
+  return server;
+}
+
+void LocalStreamServer::Wait() { server_->Wait(); }
+
+void LocalStreamServer::Shutdown() {
+  service_->Shutdown();
+  server_->Shutdown();
+}
+
+LocalStreamServer::~LocalStreamServer() {
+  if (server_ != nullptr) {
+    Shutdown();
+  }
+}
+
+}  // namespace aistreams
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AISTREAMS_SERVER_LOCAL_STREAM_SERVER_H_
+#define AISTREAMS_SERVER_LOCAL_STREAM_SERVER_H_
+
+#include <memory>
+#include <string>
+
+#include "aistreams/port/grpcpp.h"
+#include "aistreams/port/status.h"
+#include "aistreams/port/statusor.h"
+#include "aistreams/server/stream_log.h"
+
+namespace aistreams {
+
+class LocalStreamService;
+
+// A LocalStreamServer is a lightweight stream server that keeps its streams
+// in memory. It serves the same StreamServer RPCs as the real service, so
+// that the client stack can be tested and loaded end to end without one.
+//
+// + Streams are created on their first use by a sender or receiver.
+// + Every packet sent is assigned the next offset in its stream and the time
+//   it arrived, recorded in its server metadata.
+// + The server tracks the offset of every consumer (by receiver name), so that
+//   a receiver that reconnects resumes where it left off. A receiver new to a
+//   stream starts from the next packet sent, unless it sets an OffsetConfig.
+// + ReceivePackets fails with OUT_OF_RANGE once the next packet of its
+//   consumer has been evicted by the retention. ReplayStream instead skips
+//   ahead to the oldest retained packet.
+// + A consumer has at most one ReceivePackets call at a time. ReplayStream
+//   starts where its consumer left off but does not move it, so it may run
+//   alongside; PacketReceiver's Auto mode opens both calls at once.
+//
+// The server runs on its own threads, in process. It listens on a local port
+// or a Unix domain socket.
+class LocalStreamServer {
+ public:
+  // Options for configuring the server.
+  struct Options {
+    // The address to listen on.
+    //
+    // "localhost:0" listens on a free port; see target_address(). Use
+    // "unix:<path>" to listen on a Unix domain socket.
+    std::string address = "localhost:0";
+
+    // The retention applied to every stream.
+    StreamLog::RetentionOptions retention_options;
+  };
+
+  // Creates a server that is already serving.
+  static StatusOr<std::unique_ptr<LocalStreamServer>> Create(const Options&);
+
+  // Returns the address that clients should connect to; i.e. the value for
+  // ConnectionOptions::target_address. The channel must be insecure.
+  const std::string& target_address() const { return target_address_; }
+
+  // Blocks until the server is shut down.
+  void Wait();
+
+  // Stops serving. The calls in flight are ended.
+  void Shutdown();
+
+  // Use Create() rather than the constructors.
+  explicit LocalStreamServer(const Options&);
+  ~LocalStreamServer();
+  LocalStreamServer(const LocalStreamServer&) = delete;
+  LocalStreamServer& operator=(const LocalStreamServer&) = delete;
+
+ private:
+  Status Initialize();
+
+  Options options_;
+  std::string target_address_;
+  std::unique_ptr<LocalStreamService> service_;
+  std::unique_ptr<grpc::Server> server_;
+};
+
+}  // namespace aistreams
+
+#endif  // AISTREAMS_SERVER_LOCAL_STREAM_SERVER_H_
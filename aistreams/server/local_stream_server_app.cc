@@ -0,0 +1,66 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/time/time.h"
+#include "aistreams/port/logging.h"
+#include "aistreams/port/status.h"
+#include "aistreams/port/status_macros.h"
+#include "aistreams/port/statusor.h"
+#include "aistreams/server/local_stream_server.h"
+
+ABSL_FLAG(std::string, address, "localhost:50051",
+          "Address to listen on; either ip:port or unix:<path>.");
+ABSL_FLAG(int, retention_max_age_in_sec, -1,
+          "Packets older than this are evicted. Active if non-negative.");
+ABSL_FLAG(int64_t, retention_max_packets, 0,
+          "The number of packets retained per stream. Active if positive.");
+ABSL_FLAG(int64_t, retention_max_bytes, 0,
+          "The payload bytes retained per stream. Active if positive.");
+
+namespace aistreams {
+
+Status RunServer() {
+  LocalStreamServer::Options options;
+  options.address = absl::GetFlag(FLAGS_address);
+  int retention_max_age_in_sec = absl::GetFlag(FLAGS_retention_max_age_in_sec);
+  if (retention_max_age_in_sec >= 0) {
+    options.retention_options.max_age =
+        absl::Seconds(retention_max_age_in_sec);
+  }
+  options.retention_options.max_packets =
+      absl::GetFlag(FLAGS_retention_max_packets);
+  options.retention_options.max_bytes =
+      absl::GetFlag(FLAGS_retention_max_bytes);
+
+  AIS_ASSIGN_OR_RETURN(auto server, LocalStreamServer::Create(options));
+  LOG(INFO) << "Serving on " << server->target_address();
+  server->Wait();
+  return OkStatus();
+}
+
+}  // namespace aistreams
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  absl::ParseCommandLine(argc, argv);
+  auto status = aistreams::RunServer();
+  if (!status.ok()) {
+    LOG(ERROR) << status;
+  }
+  return 0;
+}
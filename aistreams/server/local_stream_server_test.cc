@@ -0,0 +1,212 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/server/local_stream_server.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/time/time.h"
+#include "aistreams/base/packet.h"
+#include "aistreams/base/packet_receiver.h"
+#include "aistreams/base/packet_sender.h"
+#include "aistreams/port/gtest.h"
+#include "aistreams/port/canonical_errors.h"
+#include "aistreams/port/status.h"
+
+namespace aistreams {
+
+namespace {
+
+constexpr char kStreamName[] = "test-stream";
+
+std::unique_ptr<LocalStreamServer> CreateServer(
+    const StreamLog::RetentionOptions& retention_options = {}) {
+  LocalStreamServer::Options options;
+  options.retention_options = retention_options;
+  auto server_statusor = LocalStreamServer::Create(options);
+  EXPECT_TRUE(server_statusor.ok()) << server_statusor.status();
+  return std::move(server_statusor).ValueOrDie();
+}
+
+ConnectionOptions MakeConnectionOptions(const LocalStreamServer& server) {
+  ConnectionOptions options;
+  options.target_address = server.target_address();
+  options.ssl_options.use_insecure_channel = true;
+  return options;
+}
+
+// Sends packets "<first>" to "<first + count - 1>".
+void SendPackets(const LocalStreamServer& server, int first, int count) {
+  PacketSender::Options options;
+  options.connection_options = MakeConnectionOptions(server);
+  options.stream_name = kStreamName;
+  auto sender = PacketSender::Create(options).ValueOrDie();
+  for (int i = first; i < first + count; ++i) {
+    ASSERT_TRUE(sender->Send(MakePacket(std::to_string(i)).ValueOrDie()).ok());
+  }
+}
+
+std::unique_ptr<PacketReceiver> CreateReceiver(
+    const LocalStreamServer& server, const std::string& receiver_name,
+    ReceiverMode receiver_mode, const OffsetOptions& offset_options = {}) {
+  PacketReceiver::Options options;
+  options.connection_options = MakeConnectionOptions(server);
+  options.stream_name = kStreamName;
+  options.receiver_name = receiver_name;
+  options.receiver_mode = receiver_mode;
+  options.offset_options = offset_options;
+  options.timeout = absl::Seconds(1);
+  return PacketReceiver::Create(options).ValueOrDie();
+}
+
+OffsetOptions FromBeginning() {
+  OffsetOptions offset_options;
+  offset_options.reset_offset = true;
+  offset_options.offset_position =
+      OffsetOptions::SpecialOffset::kOffsetBeginning;
+  return offset_options;
+}
+
+// Receives `count` packets, and checks that they are "<first>" onwards, at the
+// matching offsets.
+void ExpectPackets(PacketReceiver* receiver, int first, int count) {
+  for (int i = first; i < first + count; ++i) {
+    Packet packet;
+    ASSERT_TRUE(receiver->Receive(&packet).ok());
+    EXPECT_EQ(packet.payload(), std::to_string(i));
+    EXPECT_EQ(packet.header().server_metadata().offset(), i);
+  }
+}
+
+TEST(LocalStreamServerTest, ReceivesFromBeginning) {
+  auto server = CreateServer();
+  SendPackets(*server, 0, 5);
+  auto receiver =
+      CreateReceiver(*server, "receiver", ReceiverMode::StreamingReceive,
+                     FromBeginning());
+  ExpectPackets(receiver.get(), 0, 5);
+}
+
+TEST(LocalStreamServerTest, ConsumerResumesWhereItLeftOff) {
+  auto server = CreateServer();
+  SendPackets(*server, 0, 5);
+  {
+    auto receiver =
+        CreateReceiver(*server, "receiver", ReceiverMode::UnaryReceive,
+                       FromBeginning());
+    ExpectPackets(receiver.get(), 0, 3);
+  }
+  auto receiver =
+      CreateReceiver(*server, "receiver", ReceiverMode::UnaryReceive);
+  ExpectPackets(receiver.get(), 3, 2);
+}
+
+TEST(LocalStreamServerTest, NewConsumerReceivesNextPacket) {
+  auto server = CreateServer();
+  SendPackets(*server, 0, 5);
+  auto receiver =
+      CreateReceiver(*server, "receiver", ReceiverMode::UnaryReceive);
+  Packet packet;
+  EXPECT_FALSE(receiver->Receive(&packet).ok());
+  SendPackets(*server, 5, 1);
+  ExpectPackets(receiver.get(), 5, 1);
+}
+
+TEST(LocalStreamServerTest, EvictedOffsetIsOutOfRange) {
+  StreamLog::RetentionOptions retention_options;
+  retention_options.max_packets = 3;
+  auto server = CreateServer(retention_options);
+  SendPackets(*server, 0, 5);
+
+  OffsetOptions offset_options;
+  offset_options.reset_offset = true;
+  offset_options.offset_position = int64_t{0};
+  auto receiver = CreateReceiver(
+      *server, "receiver", ReceiverMode::StreamingReceive, offset_options);
+  Packet packet;
+  EXPECT_TRUE(IsOutOfRange(receiver->Receive(&packet)));
+}
+
+TEST(LocalStreamServerTest, AutoModeReplaysFromOldestRetainedPacket) {
+  StreamLog::RetentionOptions retention_options;
+  retention_options.max_packets = 3;
+  auto server = CreateServer(retention_options);
+  SendPackets(*server, 0, 5);
+
+  OffsetOptions offset_options;
+  offset_options.reset_offset = true;
+  offset_options.offset_position = int64_t{0};
+  auto receiver = CreateReceiver(*server, "receiver", ReceiverMode::Auto,
+                                 offset_options);
+  ExpectPackets(receiver.get(), 2, 3);
+}
+
+TEST(LocalStreamServerTest, AutoModeWithNamedReceiverIsDeterministic) {
+  // Auto mode opens ReceivePackets and ReplayStream at once, under the same
+  // consumer name; neither call may turn the other away.
+  for (int i = 0; i < 10; ++i) {
+    StreamLog::RetentionOptions retention_options;
+    retention_options.max_packets = 3;
+    auto server = CreateServer(retention_options);
+    SendPackets(*server, 0, 3);
+    auto receiver = CreateReceiver(*server, "receiver", ReceiverMode::Auto,
+                                   FromBeginning());
+    ExpectPackets(receiver.get(), 0, 3);
+
+    // The evicted packets switch a new receiver over to the replay.
+    SendPackets(*server, 3, 2);
+    OffsetOptions offset_options;
+    offset_options.reset_offset = true;
+    offset_options.offset_position = int64_t{0};
+    receiver = CreateReceiver(*server, "other-receiver", ReceiverMode::Auto,
+                              offset_options);
+    ExpectPackets(receiver.get(), 2, 3);
+  }
+}
+
+TEST(LocalStreamServerTest, ReplayDoesNotMoveConsumer) {
+  auto server = CreateServer();
+  SendPackets(*server, 0, 5);
+  {
+    auto receiver =
+        CreateReceiver(*server, "receiver", ReceiverMode::UnaryReceive,
+                       FromBeginning());
+    ExpectPackets(receiver.get(), 0, 3);
+  }
+
+  // A replay starts where the consumer left off...
+  {
+    auto receiver = CreateReceiver(*server, "receiver", ReceiverMode::Replay);
+    ExpectPackets(receiver.get(), 3, 2);
+  }
+
+  // ... but the consumer resumes from there still.
+  auto receiver =
+      CreateReceiver(*server, "receiver", ReceiverMode::UnaryReceive);
+  ExpectPackets(receiver.get(), 3, 2);
+}
+
+TEST(LocalStreamServerTest, StreamingTimesOut) {
+  auto server = CreateServer();
+  auto receiver =
+      CreateReceiver(*server, "receiver", ReceiverMode::StreamingReceive);
+  Packet packet;
+  EXPECT_FALSE(receiver->Receive(&packet).ok());
+}
+
+}  // namespace
+
+}  // namespace aistreams
@@ -0,0 +1,134 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "aistreams/server/stream_log.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "aistreams/base/util/packet_utils.h"
+#include "google/protobuf/timestamp.pb.h"
+
+namespace aistreams {
+
+namespace {
+
+void ToProtoTimestamp(absl::Time t, google::protobuf::Timestamp* timestamp) {
+  int64_t nanos = absl::ToUnixNanos(t);
+  timestamp->set_seconds(nanos / 1000000000);
+  timestamp->set_nanos(nanos % 1000000000);
+}
+
+absl::Time FromProtoTimestamp(const google::protobuf::Timestamp& timestamp) {
+  return absl::FromUnixSeconds(timestamp.seconds()) +
+         absl::Nanoseconds(timestamp.nanos());
+}
+
+}  // namespace
+
+StreamLog::StreamLog(const RetentionOptions& retention_options)
+    : retention_options_(retention_options) {}
+
+int64_t StreamLog::Append(Packet packet, absl::Time now) {
+  last_timestamp_ = std::max(now, last_timestamp_ + absl::Nanoseconds(1));
+  int64_t offset = end_offset();
+  ServerMetadata* server_metadata =
+      packet.mutable_header()->mutable_server_metadata();
+  server_metadata->set_offset(offset);
+  ToProtoTimestamp(last_timestamp_, server_metadata->mutable_timestamp());
+  bytes_ += packet.payload().size();
+  packets_.push_back(std::make_shared<const Packet>(std::move(packet)));
+  Evict();
+  Expire(now);
+  return offset;
+}
+
+void StreamLog::Evict() {
+  while (!packets_.empty() &&
+         ((retention_options_.max_packets > 0 &&
+           static_cast<int64_t>(packets_.size()) >
+               retention_options_.max_packets) ||
+          (retention_options_.max_bytes > 0 &&
+           bytes_ > retention_options_.max_bytes))) {
+    bytes_ -= packets_.front()->payload().size();
+    packets_.pop_front();
+    ++begin_offset_;
+  }
+}
+
+void StreamLog::Expire(absl::Time now) {
+  if (retention_options_.max_age == absl::InfiniteDuration()) {
+    return;
+  }
+  absl::Time oldest_retained = now - retention_options_.max_age;
+  while (!packets_.empty() &&
+         FromProtoTimestamp(
+             packets_.front()->header().server_metadata().timestamp()) <
+             oldest_retained) {
+    bytes_ -= packets_.front()->payload().size();
+    packets_.pop_front();
+    ++begin_offset_;
+  }
+}
+
+std::shared_ptr<const Packet> StreamLog::Get(int64_t offset) const {
+  if (offset < begin_offset() || offset >= end_offset()) {
+    return nullptr;
+  }
+  return packets_[offset - begin_offset_];
+}
+
+int64_t StreamLog::RollBackToKeyFrame(int64_t offset) const {
+  if (offset >= end_offset()) {
+    return end_offset();
+  }
+  while (offset > begin_offset() && !IsKeyFrame(*Get(offset))) {
+    --offset;
+  }
+  return offset;
+}
+
+int64_t StreamLog::Seek(const OffsetConfig& offset_config) const {
+  switch (offset_config.config_case()) {
+    case OffsetConfig::kSpecialOffset:
+      if (offset_config.special_offset() == OffsetConfig::OFFSET_BEGINNING) {
+        return begin_offset();
+      }
+      return end_offset();
+    case OffsetConfig::kSeekPosition:
+      return RollBackToKeyFrame(std::min(
+          std::max(offset_config.seek_position(), begin_offset()),
+          end_offset()));
+    case OffsetConfig::kSeekTime: {
+      // Find the first packet that is not earlier than the seek time, then
+      // step back to the latest packet that is.
+      absl::Time seek_time = FromProtoTimestamp(offset_config.seek_time());
+      auto it = std::partition_point(
+          packets_.begin(), packets_.end(),
+          [seek_time](const std::shared_ptr<const Packet>& packet) {
+            return FromProtoTimestamp(
+                       packet->header().server_metadata().timestamp()) <
+                   seek_time;
+          });
+      int64_t offset = begin_offset_ + (it - packets_.begin());
+      return RollBackToKeyFrame(std::max(offset - 1, begin_offset()));
+    }
+    default:
+      return begin_offset();
+  }
+}
+
+}  // namespace aistreams
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AISTREAMS_SERVER_STREAM_LOG_H_
+#define AISTREAMS_SERVER_STREAM_LOG_H_
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+
+#include "absl/time/time.h"
+#include "aistreams/proto/packet.pb.h"
+#include "aistreams/proto/stream.pb.h"
+
+namespace aistreams {
+
+// A StreamLog holds the packets of one stream in memory.
+//
+// Every appended packet is assigned the next offset, counting up from 0, and
+// the time at which it was appended. Both are recorded in its server metadata.
+// The oldest packets are evicted according to the RetentionOptions.
+//
+// StreamLog is not thread-safe.
+class StreamLog {
+ public:
+  // Options to bound the packets that are retained. A packet is evicted as
+  // soon as any of the limits is exceeded.
+  struct RetentionOptions {
+    // Packets appended longer ago than this are evicted.
+    absl::Duration max_age = absl::InfiniteDuration();
+
+    // The maximum number of packets retained. 0 means no limit.
+    int64_t max_packets = 0;
+
+    // The maximum total payload size retained, in bytes. 0 means no limit.
+    int64_t max_bytes = 0;
+  };
+
+  explicit StreamLog(const RetentionOptions& retention_options);
+
+  // Appends `packet` at time `now` and returns its offset.
+  //
+  // The server timestamps never decrease, even if `now` does.
+  int64_t Append(Packet packet, absl::Time now);
+
+  // Evicts the packets that have exceeded the maximum age at time `now`.
+  void Expire(absl::Time now);
+
+  // Returns the packet at `offset`, or nullptr if it is not retained.
+  //
+  // The packet is shared rather than copied, and remains valid after it is
+  // evicted.
+  std::shared_ptr<const Packet> Get(int64_t offset) const;
+
+  // Returns the offset of the oldest retained packet. This is end_offset()
+  // if no packets are retained.
+  int64_t begin_offset() const { return begin_offset_; }
+
+  // Returns the offset that the next appended packet will be assigned.
+  int64_t end_offset() const {
+    return begin_offset_ + static_cast<int64_t>(packets_.size());
+  }
+
+  // Returns the offset at which a consumer configured with `offset_config`
+  // starts reading.
+  //
+  // A seek by position or time lands on the key frame at or before the packet
+  // sought, so that the consumer can decode from there. Seeks before the
+  // oldest retained packet land on it; seeks past the newest land on
+  // end_offset().
+  int64_t Seek(const OffsetConfig& offset_config) const;
+
+ private:
+  void Evict();
+  int64_t RollBackToKeyFrame(int64_t offset) const;
+
+  RetentionOptions retention_options_;
+  std::deque<std::shared_ptr<const Packet>> packets_;
+  int64_t begin_offset_ = 0;
+  int64_t bytes_ = 0;
+  absl::Time last_timestamp_ = absl::InfinitePast();
+};
+
+}  // namespace aistreams
+
+#endif  // AISTREAMS_SERVER_STREAM_LOG_H_
@@ -0,0 +1,165 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/server/stream_log.h"
+
+#include <string>
+
+#include "absl/time/time.h"
+#include "aistreams/base/packet.h"
+#include "aistreams/port/gtest.h"
+#include "aistreams/proto/packet.pb.h"
+#include "aistreams/proto/stream.pb.h"
+
+namespace aistreams {
+
+namespace {
+
+const absl::Time kStartTime = absl::FromUnixSeconds(1000);
+
+Packet MakeTestPacket(const std::string& payload, bool is_key_frame) {
+  Packet packet = MakePacket(payload).ValueOrDie();
+  if (!is_key_frame) {
+    UnsetPacketFlags(PacketFlags::kIsKeyFrame, &packet);
+  }
+  return packet;
+}
+
+// Appends packets "0" to "<count - 1>" a second apart, where every
+// `key_frame_interval`th packet is a key frame.
+void AppendPackets(int count, int key_frame_interval, StreamLog* log) {
+  for (int i = 0; i < count; ++i) {
+    log->Append(MakeTestPacket(std::to_string(i), i % key_frame_interval == 0),
+                kStartTime + absl::Seconds(i));
+  }
+}
+
+OffsetConfig SpecialOffsetConfig(OffsetConfig::SpecialOffset special_offset) {
+  OffsetConfig offset_config;
+  offset_config.set_special_offset(special_offset);
+  return offset_config;
+}
+
+OffsetConfig SeekPositionConfig(int64_t seek_position) {
+  OffsetConfig offset_config;
+  offset_config.set_seek_position(seek_position);
+  return offset_config;
+}
+
+OffsetConfig SeekTimeConfig(absl::Time seek_time) {
+  OffsetConfig offset_config;
+  offset_config.mutable_seek_time()->set_seconds(absl::ToUnixSeconds(seek_time));
+  return offset_config;
+}
+
+}  // namespace
+
+TEST(StreamLogTest, AppendAssignsOffsetsAndTimestamps) {
+  StreamLog log(StreamLog::RetentionOptions{});
+  EXPECT_EQ(log.begin_offset(), 0);
+  EXPECT_EQ(log.end_offset(), 0);
+  EXPECT_EQ(log.Get(0), nullptr);
+
+  EXPECT_EQ(log.Append(MakeTestPacket("a", true), kStartTime), 0);
+  EXPECT_EQ(log.Append(MakeTestPacket("b", true), kStartTime), 1);
+  EXPECT_EQ(log.end_offset(), 2);
+
+  auto packet = log.Get(1);
+  ASSERT_NE(packet, nullptr);
+  EXPECT_EQ(packet->payload(), "b");
+  EXPECT_EQ(packet->header().server_metadata().offset(), 1);
+
+  // Packets appended at the same time still get increasing timestamps.
+  const auto& first = log.Get(0)->header().server_metadata().timestamp();
+  const auto& second = packet->header().server_metadata().timestamp();
+  EXPECT_EQ(first.seconds(), 1000);
+  EXPECT_EQ(first.nanos(), 0);
+  EXPECT_EQ(second.seconds(), 1000);
+  EXPECT_EQ(second.nanos(), 1);
+}
+
+TEST(StreamLogTest, RetainsMaxPackets) {
+  StreamLog::RetentionOptions retention_options;
+  retention_options.max_packets = 3;
+  StreamLog log(retention_options);
+  AppendPackets(5, 1, &log);
+  EXPECT_EQ(log.begin_offset(), 2);
+  EXPECT_EQ(log.end_offset(), 5);
+  EXPECT_EQ(log.Get(1), nullptr);
+  EXPECT_EQ(log.Get(2)->payload(), "2");
+}
+
+TEST(StreamLogTest, RetainsMaxBytes) {
+  StreamLog::RetentionOptions retention_options;
+  retention_options.max_bytes = 2;
+  StreamLog log(retention_options);
+  AppendPackets(5, 1, &log);
+  EXPECT_EQ(log.begin_offset(), 3);
+  EXPECT_EQ(log.end_offset(), 5);
+}
+
+TEST(StreamLogTest, RetainsMaxAge) {
+  StreamLog::RetentionOptions retention_options;
+  retention_options.max_age = absl::Seconds(2);
+  StreamLog log(retention_options);
+  AppendPackets(5, 1, &log);
+  EXPECT_EQ(log.begin_offset(), 2);
+
+  log.Expire(kStartTime + absl::Seconds(10));
+  EXPECT_EQ(log.begin_offset(), 5);
+  EXPECT_EQ(log.end_offset(), 5);
+}
+
+TEST(StreamLogTest, SeekSpecialOffsets) {
+  StreamLog::RetentionOptions retention_options;
+  retention_options.max_packets = 3;
+  StreamLog log(retention_options);
+  AppendPackets(5, 1, &log);
+  EXPECT_EQ(log.Seek(SpecialOffsetConfig(OffsetConfig::OFFSET_BEGINNING)), 2);
+  EXPECT_EQ(log.Seek(SpecialOffsetConfig(OffsetConfig::OFFSET_END)), 5);
+}
+
+TEST(StreamLogTest, SeekPositionLandsOnKeyFrame) {
+  StreamLog log(StreamLog::RetentionOptions{});
+  AppendPackets(10, 4, &log);
+  EXPECT_EQ(log.Seek(SeekPositionConfig(4)), 4);
+  EXPECT_EQ(log.Seek(SeekPositionConfig(6)), 4);
+  EXPECT_EQ(log.Seek(SeekPositionConfig(9)), 8);
+  EXPECT_EQ(log.Seek(SeekPositionConfig(-1)), 0);
+  EXPECT_EQ(log.Seek(SeekPositionConfig(100)), 10);
+}
+
+TEST(StreamLogTest, SeekPositionStopsAtOldestRetainedPacket) {
+  StreamLog::RetentionOptions retention_options;
+  retention_options.max_packets = 5;
+  StreamLog log(retention_options);
+  AppendPackets(10, 10, &log);
+  EXPECT_EQ(log.Seek(SeekPositionConfig(7)), 5);
+}
+
+TEST(StreamLogTest, SeekTime) {
+  StreamLog log(StreamLog::RetentionOptions{});
+  AppendPackets(10, 2, &log);
+
+  // The latest packet earlier than the seek time is 4, whose key frame is 4.
+  EXPECT_EQ(log.Seek(SeekTimeConfig(kStartTime + absl::Seconds(5))), 4);
+
+  // The latest packet earlier than the seek time is 5, whose key frame is 4.
+  EXPECT_EQ(log.Seek(SeekTimeConfig(kStartTime + absl::Seconds(6))), 4);
+
+  EXPECT_EQ(log.Seek(SeekTimeConfig(kStartTime - absl::Seconds(1))), 0);
+  EXPECT_EQ(log.Seek(SeekTimeConfig(kStartTime + absl::Seconds(100))), 8);
+}
+
+}  // namespace aistreams
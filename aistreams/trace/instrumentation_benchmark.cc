@@ -0,0 +1,37 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aistreams/port/benchmark.h"
+#include "aistreams/proto/packet.pb.h"
+#include "aistreams/trace/instrumentation.h"
+
+namespace aistreams {
+namespace trace {
+namespace {
+
+// The overhead that PacketSender adds to every packet that it sends. The
+// sampling probability is given in basis points: never, 1% and always.
+void BM_Instrument(benchmark::State& state) {
+  const double probability = state.range(0) / 10000.0;
+  PacketHeader packet_header;
+  for (auto _ : state) {
+    Instrument(&packet_header, probability);
+    benchmark::DoNotOptimize(packet_header.trace_context());
+  }
+}
+BENCHMARK(BM_Instrument)->ArgName("basis_points")->Arg(0)->Arg(100)->Arg(10000);
+
+}  // namespace
+}  // namespace trace
+}  // namespace aistreams
@@ -17,9 +17,13 @@
 #ifndef AISTREAMS_UTIL_PRODUCER_CONSUMER_QUEUE_H_
 #define AISTREAMS_UTIL_PRODUCER_CONSUMER_QUEUE_H_
 
+#include <sys/eventfd.h>
+#include <unistd.h>
+
 #include <deque>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
@@ -92,6 +96,20 @@ class ProducerConsumerQueue {
   // returns false and causes no side effects.
   bool TryPop(T& elem, absl::Duration timeout) ABSL_LOCKS_EXCLUDED(mu_);
 
+  // Waits up to `timeout` for the queue to become non-empty. Then removes up to
+  // `max_count` of the oldest elements at once and appends them to `elems`.
+  //
+  // Returns the number of elements removed.
+  int TryPopMany(int max_count, absl::Duration timeout, std::vector<T>* elems)
+      ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Returns a file descriptor that is readable while the queue is non-empty,
+  // so that consumers can wait for the queue in poll, epoll or an event loop.
+  //
+  // The descriptor is created on the first call and is owned by the queue; do
+  // not read from or close it. Returns -1 if it could not be created.
+  int ReadinessFd() ABSL_LOCKS_EXCLUDED(mu_);
+
  private:
   const int capacity_;
   mutable absl::Mutex mu_;
@@ -99,6 +117,12 @@ class ProducerConsumerQueue {
   absl::CondVar cv_not_empty_ ABSL_GUARDED_BY(mu_);
   absl::CondVar cv_not_full_ ABSL_GUARDED_BY(mu_);
 
+  // An eventfd whose counter is non-zero exactly when q_ is non-empty.
+  int readiness_fd_ ABSL_GUARDED_BY(mu_) = -1;
+  bool is_readiness_fd_set_ ABSL_GUARDED_BY(mu_) = false;
+
+  void UpdateReadinessFd() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   bool IsLimitedCapacity() const;
 
   template <typename... Args>
@@ -118,7 +142,11 @@ ProducerConsumerQueue<T>::ProducerConsumerQueue(int capacity)
 }
 
 template <typename T>
-ProducerConsumerQueue<T>::~ProducerConsumerQueue() {}
+ProducerConsumerQueue<T>::~ProducerConsumerQueue() {
+  if (readiness_fd_ >= 0) {
+    close(readiness_fd_);
+  }
+}
 
 template <typename T>
 int ProducerConsumerQueue<T>::count() const {
@@ -191,6 +219,7 @@ template <typename... Args>
 void ProducerConsumerQueue<T>::InternalEmplace(Args&&... args) {
   q_.emplace_back(std::forward<Args>(args)...);
   cv_not_empty_.Signal();
+  UpdateReadinessFd();
 }
 
 template <typename T>
@@ -224,11 +253,59 @@ bool ProducerConsumerQueue<T>::TryPop(T& elem, absl::Duration timeout) {
   }
 }
 
+template <typename T>
+int ProducerConsumerQueue<T>::TryPopMany(int max_count, absl::Duration timeout,
+                                         std::vector<T>* elems) {
+  absl::MutexLock lock(&mu_);
+  absl::Duration time_left = timeout;
+  absl::Time deadline = absl::Now() + time_left;
+  while (q_.empty() && time_left > absl::ZeroDuration()) {
+    cv_not_empty_.WaitWithTimeout(&mu_, time_left);
+    time_left = deadline - absl::Now();
+  }
+  int count = 0;
+  while (count < max_count && !q_.empty()) {
+    elems->emplace_back();
+    InternalPop(elems->back());
+    ++count;
+  }
+  return count;
+}
+
+template <typename T>
+int ProducerConsumerQueue<T>::ReadinessFd() {
+  absl::MutexLock lock(&mu_);
+  if (readiness_fd_ < 0) {
+    readiness_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (readiness_fd_ < 0) {
+      LOG(ERROR) << "Failed to create an eventfd";
+      return -1;
+    }
+    UpdateReadinessFd();
+  }
+  return readiness_fd_;
+}
+
 template <typename T>
 void ProducerConsumerQueue<T>::InternalPop(T& elem) {
   elem = std::move(q_.front());
   q_.pop_front();
   cv_not_full_.Signal();
+  UpdateReadinessFd();
+}
+
+template <typename T>
+void ProducerConsumerQueue<T>::UpdateReadinessFd() {
+  if (readiness_fd_ < 0 || is_readiness_fd_set_ != q_.empty()) {
+    return;
+  }
+  eventfd_t value;
+  if (q_.empty()) {
+    eventfd_read(readiness_fd_, &value);
+  } else {
+    eventfd_write(readiness_fd_, 1);
+  }
+  is_readiness_fd_set_ = !q_.empty();
 }
 
 }  // namespace aistreams
@@ -0,0 +1,108 @@
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "aistreams/port/benchmark.h"
+#include "aistreams/util/producer_consumer_queue.h"
+
+namespace aistreams {
+namespace {
+
+// The number of elements that pass through the queue per iteration.
+constexpr int kElementsPerIteration = 1 << 14;
+
+// Moves kElementsPerIteration ints through a queue of the given capacity from
+// state.range(0) producers to state.range(1) consumers.
+//
+// The threads are started anew for every iteration, which costs little next to
+// the transfers themselves.
+void BM_ProducerConsumerQueue(benchmark::State& state) {
+  const int num_producers = state.range(0);
+  const int num_consumers = state.range(1);
+  const int capacity = state.range(2);
+  for (auto _ : state) {
+    ProducerConsumerQueue<int> queue(capacity);
+    std::atomic<int> elements_to_pop(kElementsPerIteration);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_producers; ++i) {
+      int count = kElementsPerIteration / num_producers;
+      if (i < kElementsPerIteration % num_producers) {
+        ++count;
+      }
+      threads.emplace_back([&queue, count] {
+        for (int j = 0; j < count; ++j) {
+          queue.Emplace(j);
+        }
+      });
+    }
+    for (int i = 0; i < num_consumers; ++i) {
+      threads.emplace_back([&queue, &elements_to_pop] {
+        int elem;
+        while (elements_to_pop.fetch_sub(1) > 0) {
+          queue.Pop(elem);
+          benchmark::DoNotOptimize(elem);
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kElementsPerIteration);
+}
+BENCHMARK(BM_ProducerConsumerQueue)
+    ->ArgNames({"producers", "consumers", "capacity"})
+    ->Args({1, 1, 16})
+    ->Args({1, 1, 1024})
+    ->Args({2, 2, 16})
+    ->Args({4, 1, 16})
+    ->Args({1, 4, 16})
+    ->Args({4, 4, 16})
+    ->Args({4, 4, 1024})
+    ->Args({8, 8, 16})
+    ->UseRealTime();
+
+// Moves kElementsPerIteration ints through the queue in batches of
+// state.range(0) with TryPopMany, from a single producer to a single consumer.
+void BM_ProducerConsumerQueueTryPopMany(benchmark::State& state) {
+  const int batch_size = state.range(0);
+  for (auto _ : state) {
+    ProducerConsumerQueue<int> queue(1024);
+    std::thread producer([&queue] {
+      for (int j = 0; j < kElementsPerIteration; ++j) {
+        queue.Emplace(j);
+      }
+    });
+    std::vector<int> elems;
+    int popped = 0;
+    while (popped < kElementsPerIteration) {
+      elems.clear();
+      popped += queue.TryPopMany(batch_size, absl::InfiniteDuration(), &elems);
+    }
+    producer.join();
+  }
+  state.SetItemsProcessed(state.iterations() * kElementsPerIteration);
+}
+BENCHMARK(BM_ProducerConsumerQueueTryPopMany)
+    ->ArgName("batch_size")
+    ->Arg(1)
+    ->Arg(16)
+    ->Arg(256)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace aistreams
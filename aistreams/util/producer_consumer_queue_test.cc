@@ -14,6 +14,8 @@
 
 #include "aistreams/util/producer_consumer_queue.h"
 
+#include <poll.h>
+
 #include <memory>
 #include <numeric>
 #include <string>
@@ -225,4 +227,49 @@ TEST(ProducerConsumerQueue, TestBlockingProducerAsyncConsumer) {
   EXPECT_EQ(pcqueue.count(), 0);
 }
 
+TEST(ProducerConsumerQueue, TestTryPopMany) {
+  ProducerConsumerQueue<int> pcqueue(10);
+  std::vector<int> popped;
+  EXPECT_EQ(pcqueue.TryPopMany(3, absl::ZeroDuration(), &popped), 0);
+  EXPECT_TRUE(popped.empty());
+
+  for (int i = 0; i < 5; ++i) {
+    pcqueue.Emplace(i);
+  }
+  EXPECT_EQ(pcqueue.TryPopMany(3, absl::ZeroDuration(), &popped), 3);
+  EXPECT_EQ(popped, std::vector<int>({0, 1, 2}));
+  EXPECT_EQ(pcqueue.TryPopMany(3, absl::Seconds(1), &popped), 2);
+  EXPECT_EQ(popped, std::vector<int>({0, 1, 2, 3, 4}));
+  EXPECT_EQ(pcqueue.count(), 0);
+}
+
+TEST(ProducerConsumerQueue, TestReadinessFd) {
+  ProducerConsumerQueue<int> pcqueue(10);
+  pcqueue.Emplace(0);
+  int fd = pcqueue.ReadinessFd();
+  ASSERT_GE(fd, 0);
+  EXPECT_EQ(pcqueue.ReadinessFd(), fd);
+
+  auto is_readable = [fd]() {
+    struct pollfd pfd = {fd, POLLIN, 0};
+    return poll(&pfd, 1, 0) == 1 && (pfd.revents & POLLIN);
+  };
+  EXPECT_TRUE(is_readable());
+
+  pcqueue.Emplace(1);
+  int elem;
+  EXPECT_TRUE(pcqueue.TryPop(elem));
+  EXPECT_TRUE(is_readable());
+  EXPECT_TRUE(pcqueue.TryPop(elem));
+  EXPECT_FALSE(is_readable());
+
+  std::thread producer([&pcqueue]() { pcqueue.Emplace(2); });
+  struct pollfd pfd = {fd, POLLIN, 0};
+  EXPECT_EQ(poll(&pfd, 1, 5000), 1);
+  producer.join();
+  EXPECT_TRUE(pcqueue.TryPop(elem));
+  EXPECT_EQ(elem, 2);
+  EXPECT_FALSE(is_readable());
+}
+
 }  // namespace aistreams